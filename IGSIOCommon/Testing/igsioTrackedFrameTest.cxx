@@ -0,0 +1,346 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "igsioCommon.h"
+#include "igsioTrackedFrame.h"
+#include "vtkIGSIOTrackedFrameList.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkXMLDataElement.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STD includes
+#include <sstream>
+#include <utility>
+
+// C includes
+#include <cmath>
+
+namespace
+{
+  static const double DOUBLE_THRESHOLD = 0.0001;
+
+  //----------------------------------------------------------------------------
+  bool IsTransformEqual(const double* transformA, const double* transformB)
+  {
+    for (int i = 0; i < 16; ++i)
+    {
+      if (fabs(transformA[i] - transformB[i]) > DOUBLE_THRESHOLD)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestFrameTransforms()
+  {
+    double probeToTracker[16] = { 1, 0, 0, 10.5, 0, 0, -1, 20.25, 0, 1, 0, -30, 0, 0, 0, 1 };
+    igsioTransformName probeToTrackerName("Probe", "Tracker");
+
+    igsioTrackedFrame trackedFrame;
+    trackedFrame.SetFrameTransform(probeToTrackerName, probeToTracker);
+    trackedFrame.SetFrameTransformStatus(probeToTrackerName, TOOL_OUT_OF_VIEW);
+
+    // Binary round trip
+    double transform[16] = { 0 };
+    if (trackedFrame.GetFrameTransform(probeToTrackerName, transform) != IGSIO_SUCCESS || !IsTransformEqual(transform, probeToTracker))
+    {
+      LOG_ERROR("Transform read back from the tracked frame does not match the transform that was set");
+      return IGSIO_FAIL;
+    }
+    ToolStatus status = TOOL_OK;
+    if (trackedFrame.GetFrameTransformStatus(probeToTrackerName, status) != IGSIO_SUCCESS || status != TOOL_OUT_OF_VIEW)
+    {
+      LOG_ERROR("Transform status read back from the tracked frame does not match the status that was set");
+      return IGSIO_FAIL;
+    }
+
+    // Text is generated on request
+    if (!trackedFrame.IsFrameFieldDefined("ProbeToTrackerTransform") || !trackedFrame.IsFrameFieldDefined("ProbeToTrackerTransformStatus"))
+    {
+      LOG_ERROR("Transform frame fields are not defined");
+      return IGSIO_FAIL;
+    }
+    if (trackedFrame.GetFrameField("ProbeToTrackerTransformStatus") != igsioCommon::ConvertToolStatusToString(TOOL_OUT_OF_VIEW))
+    {
+      LOG_ERROR("Unexpected transform status text: " << trackedFrame.GetFrameField("ProbeToTrackerTransformStatus"));
+      return IGSIO_FAIL;
+    }
+    std::vector<double> parsedTransform;
+    std::istringstream transformText(trackedFrame.GetFrameField("ProbeToTrackerTransform"));
+    double item(0);
+    while (transformText >> item)
+    {
+      parsedTransform.push_back(item);
+    }
+    if (parsedTransform.size() != 16 || !IsTransformEqual(&parsedTransform[0], probeToTracker))
+    {
+      LOG_ERROR("Unexpected transform text: " << trackedFrame.GetFrameField("ProbeToTrackerTransform"));
+      return IGSIO_FAIL;
+    }
+    const igsioFieldMapType& customFields = trackedFrame.GetCustomFields();
+    igsioFieldMapType::const_iterator fieldIt = customFields.find("ProbeToTrackerTransform");
+    if (fieldIt == customFields.end() || fieldIt->second.second != trackedFrame.GetFrameField("ProbeToTrackerTransform"))
+    {
+      LOG_ERROR("Transform text is not updated in custom fields");
+      return IGSIO_FAIL;
+    }
+    // Iterating by calling GetCustomFields() in each step uses the same map while the fields are not changed
+    size_t numberOfIteratedFields = 0;
+    for (igsioFieldMapType::const_iterator it = trackedFrame.GetCustomFields().begin(); it != trackedFrame.GetCustomFields().end(); ++it)
+    {
+      ++numberOfIteratedFields;
+    }
+    if (&trackedFrame.GetCustomFields() != &customFields || numberOfIteratedFields != customFields.size())
+    {
+      LOG_ERROR("Custom fields are not kept between calls");
+      return IGSIO_FAIL;
+    }
+
+    // Setting the text value updates the binary value
+    trackedFrame.SetFrameField("ProbeToTrackerTransform", "1 0 0 1 0 1 0 2 0 0 1 3 0 0 0 1");
+    double translation[16] = { 1, 0, 0, 1, 0, 1, 0, 2, 0, 0, 1, 3, 0, 0, 0, 1 };
+    if (trackedFrame.GetFrameTransform(probeToTrackerName, transform) != IGSIO_SUCCESS || !IsTransformEqual(transform, translation))
+    {
+      LOG_ERROR("Transform is not updated after setting its frame field");
+      return IGSIO_FAIL;
+    }
+
+    // Copies keep the binary values
+    trackedFrame.SetFrameTransform(probeToTrackerName, probeToTracker);
+    igsioTrackedFrame copiedFrame(trackedFrame);
+    if (copiedFrame.GetFrameTransform(probeToTrackerName, transform) != IGSIO_SUCCESS || !IsTransformEqual(transform, probeToTracker))
+    {
+      LOG_ERROR("Transform is not copied with the tracked frame");
+      return IGSIO_FAIL;
+    }
+
+    // XML serialization contains the transform text
+    std::string xmlData;
+    std::vector<igsioTransformName> requestedTransforms;
+    copiedFrame.GetTrackedFrameInXmlData(xmlData, requestedTransforms);
+    igsioTrackedFrame frameFromXml;
+    frameFromXml.SetTrackedFrameFromXmlData(xmlData);
+    if (frameFromXml.GetFrameTransform(probeToTrackerName, transform) != IGSIO_SUCCESS || !IsTransformEqual(transform, probeToTracker))
+    {
+      LOG_ERROR("Transform is not preserved in XML serialization");
+      return IGSIO_FAIL;
+    }
+
+    // Deleted transforms are not available anymore
+    copiedFrame.DeleteFrameField("ProbeToTrackerTransform");
+    if (copiedFrame.IsFrameTransformNameDefined(probeToTrackerName))
+    {
+      LOG_ERROR("Transform is still defined after deleting its frame field");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestFrameFields()
+  {
+    igsioTrackedFrame frameA;
+    frameA.SetFrameField("ZField", "z");
+    frameA.SetFrameField("AField", "a", FRAMEFIELD_FORCE_SERVER_SEND);
+    frameA.SetFrameField("MField", "m");
+    igsioTrackedFrame frameB;
+    frameB.SetFrameField("MField", "m2");
+
+    // Field names are shared between frames
+    igsioFrameFieldRegistry* registry = igsioFrameFieldRegistry::GetInstance();
+    unsigned int numberOfFields = registry->GetNumberOfFields();
+    igsioFrameFieldId fieldId(0);
+    if (!registry->FindFieldId("MField", fieldId) || registry->GetFieldName(fieldId) != "MField")
+    {
+      LOG_ERROR("Field name is not found in the registry");
+      return IGSIO_FAIL;
+    }
+    if (frameB.IsFrameFieldDefined("UnknownFieldName") || registry->GetNumberOfFields() != numberOfFields)
+    {
+      LOG_ERROR("Looking up an undefined field changed the field name registry");
+      return IGSIO_FAIL;
+    }
+
+    // Fields are listed in alphabetical order
+    std::vector<std::string> fieldNames;
+    frameA.GetFrameFieldNameList(fieldNames);
+    if (fieldNames.size() != 3 || fieldNames[0] != "AField" || fieldNames[1] != "MField" || fieldNames[2] != "ZField")
+    {
+      LOG_ERROR("Unexpected frame field name list");
+      return IGSIO_FAIL;
+    }
+
+    igsioFieldMapType fields = frameA.GetFrameFields();
+    if (fields.size() != 3 || fields["AField"].first != FRAMEFIELD_FORCE_SERVER_SEND || fields["MField"].second != "m")
+    {
+      LOG_ERROR("Unexpected frame field map");
+      return IGSIO_FAIL;
+    }
+    const igsioFrameFieldContainer& fieldContainer = frameA.GetFrameFieldContainer();
+    const igsioFrameFieldContainer::Field* field = fieldContainer.Find("AField");
+    if (fieldContainer.Size() != 3 || field == NULL || field->Flags != FRAMEFIELD_FORCE_SERVER_SEND || field->Value != "a")
+    {
+      LOG_ERROR("Unexpected frame field container");
+      return IGSIO_FAIL;
+    }
+
+    // Names registered after the lock-free name table snapshot was published are found as well
+    for (int i = 0; i < 100; ++i)
+    {
+      std::ostringstream name;
+      name << "RegistryTestField" << i;
+      igsioFrameFieldId id = registry->GetFieldId(name.str());
+      igsioFrameFieldId foundId(0);
+      if (!registry->FindFieldId(name.str(), foundId) || foundId != id || registry->GetFieldName(id) != name.str()
+          || registry->GetFieldId(name.str()) != id)
+      {
+        LOG_ERROR("Inconsistent field name registry entry for " << name.str());
+        return IGSIO_FAIL;
+      }
+    }
+    if (frameB.GetFrameField("MField") != "m2")
+    {
+      LOG_ERROR("Unexpected frame field value: " << frameB.GetFrameField("MField"));
+      return IGSIO_FAIL;
+    }
+
+    if (frameA.DeleteFrameField("MField") != IGSIO_SUCCESS || frameA.IsFrameFieldDefined("MField") || !frameB.IsFrameFieldDefined("MField"))
+    {
+      LOG_ERROR("Frame field deletion failed");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestMoveSemantics()
+  {
+    FrameSizeType frameSize = { 64, 32, 1 };
+    igsioVideoFrame videoFrame;
+    if (videoFrame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Failed to allocate video frame");
+      return IGSIO_FAIL;
+    }
+    void* pixelBuffer = videoFrame.GetScalarPointer();
+
+    // Image buffer is handed over to the tracked frame without copying
+    igsioTrackedFrame trackedFrame;
+    trackedFrame.SetImageData(std::move(videoFrame));
+    if (trackedFrame.GetImageData()->GetScalarPointer() != pixelBuffer || videoFrame.IsImageValid())
+    {
+      LOG_ERROR("Image buffer was not moved into the tracked frame");
+      return IGSIO_FAIL;
+    }
+    if (trackedFrame.GetFrameSize()[0] != frameSize[0] || trackedFrame.GetFrameSize()[1] != frameSize[1])
+    {
+      LOG_ERROR("Frame size is not updated after moving image data into the tracked frame");
+      return IGSIO_FAIL;
+    }
+
+    double probeToTracker[16] = { 1, 0, 0, 10, 0, 1, 0, 20, 0, 0, 1, 30, 0, 0, 0, 1 };
+    igsioTransformName probeToTrackerName("Probe", "Tracker");
+    trackedFrame.SetFrameTransform(probeToTrackerName, probeToTracker);
+    trackedFrame.SetFrameField("CustomField", "custom");
+    trackedFrame.SetTimestamp(12.5);
+
+    // Moved frame keeps image, transforms and fields; source is left empty
+    igsioTrackedFrame movedFrame(std::move(trackedFrame));
+    double transform[16] = { 0 };
+    if (movedFrame.GetImageData()->GetScalarPointer() != pixelBuffer
+        || movedFrame.GetFrameTransform(probeToTrackerName, transform) != IGSIO_SUCCESS || !IsTransformEqual(transform, probeToTracker)
+        || movedFrame.GetFrameField("CustomField") != "custom" || movedFrame.GetTimestamp() != 12.5)
+    {
+      LOG_ERROR("Tracked frame content is not preserved by move construction");
+      return IGSIO_FAIL;
+    }
+    if (trackedFrame.GetImageData()->IsImageValid() || trackedFrame.IsFrameFieldDefined("CustomField") || trackedFrame.IsFrameTransformNameDefined(probeToTrackerName))
+    {
+      LOG_ERROR("Source tracked frame is not empty after move construction");
+      return IGSIO_FAIL;
+    }
+
+    // Frame is handed over to the list without copying the pixels
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    if (trackedFrameList->AddTrackedFrame(std::move(movedFrame)) != IGSIO_SUCCESS || trackedFrameList->GetNumberOfTrackedFrames() != 1)
+    {
+      LOG_ERROR("Failed to move tracked frame into the list");
+      return IGSIO_FAIL;
+    }
+    igsioTrackedFrame* listFrame = trackedFrameList->GetTrackedFrame(0);
+    if (listFrame->GetImageData()->GetScalarPointer() != pixelBuffer || listFrame->GetFrameField("CustomField") != "custom")
+    {
+      LOG_ERROR("Tracked frame content is not preserved when moved into the list");
+      return IGSIO_FAIL;
+    }
+
+    // Move assignment
+    igsioTrackedFrame assignedFrame;
+    assignedFrame = std::move(*listFrame);
+    if (assignedFrame.GetImageData()->GetScalarPointer() != pixelBuffer || listFrame->GetImageData()->IsImageValid())
+    {
+      LOG_ERROR("Image buffer was not moved by move assignment");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkIGSIOLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkIGSIOLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestFrameTransforms() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Tracked frame transform test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestFrameFields() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Tracked frame field test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestMoveSemantics() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Tracked frame move test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test successfully completed");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,1462 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "igsioCommon.h"
+#include "igsioFlipClipKernels.h"
+#include "igsioTrackedFrame.h"
+#include "igsioVideoFrame.h"
+#include "vtkIGSIOAccurateTimer.h"
+#include "vtkIGSIODecodedFrameCache.h"
+#include "vtkIGSIOFrameBufferPool.h"
+#include "vtkIGSIOTrackedFrameList.h"
+
+// VTK includes
+#include <vtkExtractVOI.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkTrivialProducer.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodec.h>
+#include <vtkStreamingVolumeCodecFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+//----------------------------------------------------------------------------
+/*!
+  Codec for testing lazy decoding. Each frame contains a single byte. A keyframe sets all pixels to this value,
+  a P-frame adds it to the pixels of the previously decoded frame. The number of decoded frames is counted.
+*/
+class vtkIGSIOTestDeltaCodec : public vtkStreamingVolumeCodec
+{
+public:
+  static vtkIGSIOTestDeltaCodec* New();
+  virtual vtkStreamingVolumeCodec* CreateCodecInstance() VTK_OVERRIDE { return vtkIGSIOTestDeltaCodec::New(); }
+  vtkTypeMacro(vtkIGSIOTestDeltaCodec, vtkStreamingVolumeCodec);
+
+  virtual std::string GetFourCC() VTK_OVERRIDE { return "TDLT"; }
+  virtual std::string GetParameterDescription(std::string parameterName) VTK_OVERRIDE { return ""; }
+  virtual bool SetParametersFromPresetValue(const std::string& presetValue) VTK_OVERRIDE { return false; }
+
+  static unsigned int NumberOfDecodedFrames;
+
+protected:
+  vtkIGSIOTestDeltaCodec() : Value(0) {}
+
+  virtual bool DecodeFrameInternal(vtkStreamingVolumeFrame* inputFrame, vtkImageData* outputImageData, bool saveDecodedImage = true) VTK_OVERRIDE
+  {
+    unsigned char frameValue = inputFrame->GetFrameData()->GetPointer(0)[0];
+    this->Value = inputFrame->IsKeyFrame() ? frameValue : static_cast<unsigned char>(this->Value + frameValue);
+    NumberOfDecodedFrames++;
+    if (saveDecodedImage)
+    {
+      memset(outputImageData->GetScalarPointer(), this->Value, static_cast<size_t>(outputImageData->GetNumberOfPoints()));
+    }
+    return true;
+  }
+  virtual bool EncodeImageDataInternal(vtkImageData* outputImageData, vtkStreamingVolumeFrame* inputFrame, bool forceKeyFrame) VTK_OVERRIDE { return false; }
+  virtual bool UpdateParameterInternal(std::string parameterValue, std::string parameterName) VTK_OVERRIDE { return false; }
+
+  unsigned char Value;
+};
+
+vtkStandardNewMacro(vtkIGSIOTestDeltaCodec);
+unsigned int vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames = 0;
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  igsioStatus TestCopyOnWrite()
+  {
+    igsioVideoFrame::SetCopyOnWriteEnabled(true);
+    igsioVideoFrame::ResetCopyOnWriteStatistics();
+
+    FrameSizeType frameSize = { 32, 16, 1 };
+    igsioVideoFrame original;
+    if (original.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Failed to allocate video frame");
+      return IGSIO_FAIL;
+    }
+    memset(original.GetScalarPointer(), 7, original.GetFrameSizeInBytes());
+
+    // Copies share the pixels
+    igsioVideoFrame copyA(original);
+    igsioVideoFrame copyB;
+    copyB = original;
+    const igsioVideoFrame& constCopyA = copyA;
+    if (constCopyA.GetScalarPointer() != original.GetImage()->GetScalarPointer() || !original.IsImageShared())
+    {
+      LOG_ERROR("Copy-on-write copy does not share the pixel buffer");
+      return IGSIO_FAIL;
+    }
+    if (igsioVideoFrame::GetNumberOfSharedCopies() != 2 || igsioVideoFrame::GetNumberOfAvoidedCopies() != 2)
+    {
+      LOG_ERROR("Unexpected copy-on-write statistics: shared=" << igsioVideoFrame::GetNumberOfSharedCopies()
+                << ", avoided=" << igsioVideoFrame::GetNumberOfAvoidedCopies());
+      return IGSIO_FAIL;
+    }
+
+    // Writing into a copy detaches it and leaves the others unchanged
+    unsigned char* pixelsB = static_cast<unsigned char*>(copyB.GetScalarPointer());
+    pixelsB[0] = 42;
+    const unsigned char* pixelsOriginal = static_cast<const unsigned char*>(original.GetImage()->GetScalarPointer());
+    const unsigned char* pixelsA = static_cast<const unsigned char*>(constCopyA.GetScalarPointer());
+    if (pixelsOriginal[0] != 7 || pixelsA[0] != 7 || pixelsB[0] != 42 || pixelsB[1] != 7)
+    {
+      LOG_ERROR("Modifying a copy-on-write copy changed the other copies");
+      return IGSIO_FAIL;
+    }
+    if (igsioVideoFrame::GetNumberOfDeferredCopies() != 1 || igsioVideoFrame::GetNumberOfAvoidedCopies() != 1)
+    {
+      LOG_ERROR("Unexpected number of deferred copies: " << igsioVideoFrame::GetNumberOfDeferredCopies());
+      return IGSIO_FAIL;
+    }
+
+    copyA.FillBlank();
+    if (pixelsOriginal[0] != 7 || static_cast<const unsigned char*>(constCopyA.GetScalarPointer())[0] != 0 || copyA.IsImageShared() || original.IsImageShared())
+    {
+      LOG_ERROR("FillBlank on a copy-on-write copy changed the original frame");
+      return IGSIO_FAIL;
+    }
+
+    // Copies are real copies if the mode is disabled
+    igsioVideoFrame::SetCopyOnWriteEnabled(false);
+    igsioVideoFrame deepCopy(original);
+    if (deepCopy.GetImage() == original.GetImage() || original.IsImageShared())
+    {
+      LOG_ERROR("Copy shares the image object while copy-on-write mode is disabled");
+      return IGSIO_FAIL;
+    }
+
+    // Without copy-on-write, references to the image held by others don't change how the frame is modified
+    igsioVideoFrame referencedFrame;
+    referencedFrame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+    vtkSmartPointer<vtkImageData> heldImage = referencedFrame.GetImage();
+    referencedFrame.FillBlank();
+    static_cast<unsigned char*>(referencedFrame.GetScalarPointer())[0] = 5;
+    referencedFrame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+    if (referencedFrame.IsImageShared() || referencedFrame.GetImage() != heldImage.GetPointer()
+        || static_cast<unsigned char*>(heldImage->GetScalarPointer())[0] != 5)
+    {
+      LOG_ERROR("Frame stopped writing into its image because the image is referenced by another object");
+      return IGSIO_FAIL;
+    }
+
+    // Assignment copies into the existing buffer only if nobody else uses it
+    void* referencedFramePixels = referencedFrame.GetScalarPointer();
+    heldImage = NULL;
+    referencedFrame = original;
+    if (referencedFrame.GetScalarPointer() != referencedFramePixels || static_cast<unsigned char*>(referencedFrame.GetScalarPointer())[0] != 7)
+    {
+      LOG_ERROR("Assignment did not copy into the existing pixel buffer of the frame");
+      return IGSIO_FAIL;
+    }
+    vtkSmartPointer<vtkImageData> shallowCopiedImage = vtkSmartPointer<vtkImageData>::New();
+    shallowCopiedImage->ShallowCopy(referencedFrame.GetImage());
+    referencedFrame = copyA;
+    if (static_cast<unsigned char*>(shallowCopiedImage->GetScalarPointer())[0] != 7
+        || static_cast<unsigned char*>(referencedFrame.GetScalarPointer())[0] != 0)
+    {
+      LOG_ERROR("Assignment overwrote the pixels of a shallow copy of the frame's image");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestBufferPool()
+  {
+    vtkSmartPointer<vtkIGSIOFrameBufferPool> pool = vtkSmartPointer<vtkIGSIOFrameBufferPool>::New();
+    FrameSizeType frameSize = { 64, 48, 1 };
+    const unsigned long long frameSizeInBytes = 64 * 48 * 2;
+
+    // The default pool does not keep buffers unless it is enabled
+    unsigned long long defaultPooledBytes = vtkIGSIOFrameBufferPool::GetDefaultInstance()->GetPooledBytes();
+    {
+      igsioVideoFrame frame;
+      frame.AllocateFrame(frameSize, VTK_UNSIGNED_SHORT, 1);
+    }
+    if (vtkIGSIOFrameBufferPool::GetDefaultInstance()->GetMaximumPooledBytes() != 0
+        || vtkIGSIOFrameBufferPool::GetDefaultInstance()->GetPooledBytes() != defaultPooledBytes)
+    {
+      LOG_ERROR("Default buffer pool keeps buffers of deleted frames");
+      return IGSIO_FAIL;
+    }
+
+    // Buffer of a deleted frame is reused by the next frame of the same size
+    void* firstBuffer = NULL;
+    {
+      igsioVideoFrame frame;
+      frame.SetBufferPool(pool);
+      frame.AllocateFrame(frameSize, VTK_UNSIGNED_SHORT, 1);
+      firstBuffer = frame.GetScalarPointer();
+    }
+    if (pool->GetNumberOfMisses() != 1 || pool->GetNumberOfPooledBuffers() != 1 || pool->GetPooledBytes() != frameSizeInBytes)
+    {
+      LOG_ERROR("Buffer of the deleted frame was not returned to the pool");
+      return IGSIO_FAIL;
+    }
+    igsioVideoFrame frame;
+    frame.SetBufferPool(pool);
+    frame.AllocateFrame(frameSize, VTK_UNSIGNED_SHORT, 1);
+    if (pool->GetNumberOfHits() != 1 || frame.GetScalarPointer() != firstBuffer || pool->GetNumberOfPooledBuffers() != 0)
+    {
+      LOG_ERROR("Pooled buffer was not reused");
+      return IGSIO_FAIL;
+    }
+
+    // Different pixel type is a different size class, previous buffer is returned to the pool
+    frame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+    if (pool->GetNumberOfMisses() != 2 || pool->GetNumberOfPooledBuffers() != 1 || frame.GetVTKScalarPixelType() != VTK_UNSIGNED_CHAR)
+    {
+      LOG_ERROR("Reallocated frame did not return its buffer to the pool");
+      return IGSIO_FAIL;
+    }
+
+    // Buffers above the size limit are not kept
+    pool->SetMaximumPooledBytes(frameSizeInBytes);
+    {
+      igsioVideoFrame otherFrame;
+      otherFrame.SetBufferPool(pool);
+      otherFrame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+    }
+    if (pool->GetNumberOfDiscardedBuffers() != 1 || pool->GetPooledBytes() != frameSizeInBytes)
+    {
+      LOG_ERROR("Pool size limit is not respected");
+      return IGSIO_FAIL;
+    }
+
+    // Buffers are only returned to the pool that allocated them
+    vtkSmartPointer<vtkIGSIOFrameBufferPool> firstPool = vtkSmartPointer<vtkIGSIOFrameBufferPool>::New();
+    vtkSmartPointer<vtkIGSIOFrameBufferPool> otherPool = vtkSmartPointer<vtkIGSIOFrameBufferPool>::New();
+    {
+      igsioVideoFrame pooledFrame;
+      pooledFrame.SetBufferPool(firstPool);
+      pooledFrame.AllocateFrame(frameSize, VTK_UNSIGNED_SHORT, 1);
+      igsioVideoFrame otherPoolFrame;
+      otherPoolFrame.SetBufferPool(otherPool);
+      otherPoolFrame = std::move(pooledFrame);
+      igsioVideoFrame reassignedFrame;
+      reassignedFrame.SetBufferPool(firstPool);
+      reassignedFrame.AllocateFrame(frameSize, VTK_UNSIGNED_SHORT, 1);
+      reassignedFrame.SetBufferPool(otherPool);
+    }
+    if (otherPool->GetNumberOfPooledBuffers() != 0 || firstPool->GetNumberOfPooledBuffers() != 0)
+    {
+      LOG_ERROR("Buffer was returned to a pool that did not allocate it");
+      return IGSIO_FAIL;
+    }
+    {
+      igsioVideoFrame pooledFrame;
+      pooledFrame.SetBufferPool(firstPool);
+      pooledFrame.AllocateFrame(frameSize, VTK_UNSIGNED_SHORT, 1);
+      igsioVideoFrame movedFrame(std::move(pooledFrame));
+      if (movedFrame.GetBufferPool() != firstPool)
+      {
+        LOG_ERROR("Frame constructed by move does not use the pool of the moved frame");
+        return IGSIO_FAIL;
+      }
+    }
+    if (firstPool->GetNumberOfPooledBuffers() != 1)
+    {
+      LOG_ERROR("Buffer of a moved frame was not returned to its pool");
+      return IGSIO_FAIL;
+    }
+
+    // Frames of a list with a dedicated pool
+    vtkSmartPointer<vtkIGSIOFrameBufferPool> listPool = vtkSmartPointer<vtkIGSIOFrameBufferPool>::New();
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    trackedFrameList->SetFrameBufferPool(listPool);
+    igsioTrackedFrame trackedFrame;
+    trackedFrame.SetImageData(frame);
+    for (int i = 0; i < 3; ++i)
+    {
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    }
+    trackedFrameList->Clear();
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    if (listPool->GetNumberOfMisses() != 3 || listPool->GetNumberOfHits() != 1 || listPool->GetNumberOfPooledBuffers() != 2)
+    {
+      LOG_ERROR("Tracked frame list does not use its dedicated pool: misses=" << listPool->GetNumberOfMisses()
+                << ", hits=" << listPool->GetNumberOfHits() << ", pooled=" << listPool->GetNumberOfPooledBuffers());
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IsAligned(const void* pointer, size_t alignment)
+  {
+    return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestAlignedAllocation()
+  {
+    vtkSmartPointer<vtkIGSIOFrameBufferPool> pool = vtkSmartPointer<vtkIGSIOFrameBufferPool>::New();
+    pool->SetAllocationMode(vtkIGSIOFrameBufferPool::ALLOCATION_ALIGNED);
+
+    // Odd frame sizes, so that the buffers would not be aligned by chance
+    FrameSizeType frameSize = { 33, 17, 1 };
+    std::vector<igsioVideoFrame> frames(4);
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+      frames[i].SetBufferPool(pool);
+      frames[i].AllocateFrame(frameSize, i % 2 ? VTK_UNSIGNED_CHAR : VTK_FLOAT, static_cast<unsigned int>(i % 3 + 1));
+      if (!IsAligned(frames[i].GetScalarPointer(), vtkIGSIOFrameBufferPool::BUFFER_ALIGNMENT))
+      {
+        LOG_ERROR("Frame buffer is not aligned to cache lines");
+        return IGSIO_FAIL;
+      }
+      memset(frames[i].GetScalarPointer(), 1, frames[i].GetFrameSizeInBytes());
+    }
+
+    // Aligned buffers are pooled and reused like any other buffer
+    void* alignedBuffer = frames[0].GetScalarPointer();
+    frames[0].AllocateFrame(frameSize, VTK_SHORT, 1);
+    frames[0].AllocateFrame(frameSize, VTK_FLOAT, 1);
+    if (frames[0].GetScalarPointer() != alignedBuffer || pool->GetNumberOfHits() != 1)
+    {
+      LOG_ERROR("Aligned buffer was not reused");
+      return IGSIO_FAIL;
+    }
+
+    // Flipping into an allocated frame keeps its buffer
+    igsioVideoFrame flippedFrame;
+    flippedFrame.SetBufferPool(pool);
+    flippedFrame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 2);
+    igsioVideoFrame::FlipInfoType flipInfo;
+    flipInfo.hFlip = true;
+    const std::array<int, 3> noClip = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    if (igsioVideoFrame::FlipClipImage(frames[1].GetImage(), flipInfo, noClip, noClip, flippedFrame.GetImage()) != IGSIO_SUCCESS
+        || !IsAligned(flippedFrame.GetScalarPointer(), vtkIGSIOFrameBufferPool::BUFFER_ALIGNMENT))
+    {
+      LOG_ERROR("Flipping into an aligned frame failed");
+      return IGSIO_FAIL;
+    }
+
+    // Large buffers are aligned to huge pages, small ones to cache lines
+    pool->SetAllocationMode(vtkIGSIOFrameBufferPool::ALLOCATION_HUGE_PAGES);
+    if (pool->GetNumberOfPooledBuffers() != 0)
+    {
+      LOG_ERROR("Pooled buffers were not released when the allocation mode was changed");
+      return IGSIO_FAIL;
+    }
+    FrameSizeType largeFrameSize = { 1024, 1024, 3 };
+    igsioVideoFrame largeFrame;
+    largeFrame.SetBufferPool(pool);
+    largeFrame.AllocateFrame(largeFrameSize, VTK_UNSIGNED_CHAR, 1);
+    igsioVideoFrame smallFrame;
+    smallFrame.SetBufferPool(pool);
+    smallFrame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+    if (!IsAligned(largeFrame.GetScalarPointer(), vtkIGSIOFrameBufferPool::HUGE_PAGE_SIZE)
+        || !IsAligned(smallFrame.GetScalarPointer(), vtkIGSIOFrameBufferPool::BUFFER_ALIGNMENT))
+    {
+      LOG_ERROR("Frame buffers are not aligned in huge page allocation mode");
+      return IGSIO_FAIL;
+    }
+    memset(largeFrame.GetScalarPointer(), 1, largeFrame.GetFrameSizeInBytes());
+
+    // Copies of aligned frames are aligned, too
+    igsioVideoFrame largeFrameCopy;
+    largeFrameCopy.SetBufferPool(pool);
+    largeFrameCopy = largeFrame;
+    if (!IsAligned(largeFrameCopy.GetScalarPointer(), vtkIGSIOFrameBufferPool::HUGE_PAGE_SIZE)
+        || memcmp(largeFrameCopy.GetScalarPointer(), largeFrame.GetScalarPointer(), largeFrame.GetFrameSizeInBytes()) != 0)
+    {
+      LOG_ERROR("Copy of an aligned frame is not aligned");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  /*! Flip and transpose combinations that are processed by the pixel reordering kernels */
+  enum FlipKernelCase
+  {
+    FLIP_X = 0,
+    FLIP_Y,
+    FLIP_XY,
+    FLIP_Z,
+    TRANSPOSE_IJK_TO_KIJ,
+    NUMBER_OF_FLIP_KERNEL_CASES
+  };
+
+  //----------------------------------------------------------------------------
+  igsioVideoFrame::FlipInfoType GetFlipInfo(FlipKernelCase flipCase)
+  {
+    igsioVideoFrame::FlipInfoType flipInfo;
+    flipInfo.hFlip = (flipCase == FLIP_X || flipCase == FLIP_XY);
+    flipInfo.vFlip = (flipCase == FLIP_Y || flipCase == FLIP_XY);
+    flipInfo.eFlip = (flipCase == FLIP_Z);
+    flipInfo.tranpose = (flipCase == TRANSPOSE_IJK_TO_KIJ ? igsioVideoFrame::TRANSPOSE_IJKtoKIJ : igsioVideoFrame::TRANSPOSE_NONE);
+    return flipInfo;
+  }
+
+  //----------------------------------------------------------------------------
+  std::string GetFlipKernelCaseAsString(FlipKernelCase flipCase)
+  {
+    switch (flipCase)
+    {
+      case FLIP_X:
+        return "FlipX";
+      case FLIP_Y:
+        return "FlipY";
+      case FLIP_XY:
+        return "FlipXY";
+      case FLIP_Z:
+        return "FlipZ";
+      case TRANSPOSE_IJK_TO_KIJ:
+        return "TransposeIJKtoKIJ";
+      default:
+        return "Unknown";
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkImageData> CreateTestImage(const int dimensions[3], int scalarType, int numberOfScalarComponents)
+  {
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1);
+    image->AllocateScalars(scalarType, numberOfScalarComponents);
+    unsigned char* pixels = static_cast<unsigned char*>(image->GetScalarPointer());
+    const size_t numberOfBytes = static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2] * numberOfScalarComponents * igsioVideoFrame::GetNumberOfBytesPerScalar(scalarType);
+    for (size_t i = 0; i < numberOfBytes; ++i)
+    {
+      pixels[i] = static_cast<unsigned char>((i * 7 + i / 251) & 0xFF);
+    }
+    return image;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestReverseRow()
+  {
+    const int pixelSizes[5] = { 1, 2, 3, 4, 8 };
+    for (int instructionSet = igsioFlipClipKernels::INSTRUCTION_SET_SCALAR; instructionSet <= igsioFlipClipKernels::INSTRUCTION_SET_NEON; ++instructionSet)
+    {
+      if (!igsioFlipClipKernels::IsInstructionSetSupported(static_cast<igsioFlipClipKernels::InstructionSet>(instructionSet)))
+      {
+        continue;
+      }
+      igsioFlipClipKernels::SetInstructionSet(static_cast<igsioFlipClipKernels::InstructionSet>(instructionSet));
+      for (int sizeIndex = 0; sizeIndex < 5; ++sizeIndex)
+      {
+        const int bytesPerPixel = pixelSizes[sizeIndex];
+        // All row lengths around the vector sizes, buffers have the exact row size so that out-of-row access is detected by memory checkers
+        for (int numberOfPixels = 1; numberOfPixels <= 70; ++numberOfPixels)
+        {
+          std::vector<unsigned char> input(numberOfPixels * bytesPerPixel);
+          for (size_t i = 0; i < input.size(); ++i)
+          {
+            input[i] = static_cast<unsigned char>(i * 7 + 1);
+          }
+          std::vector<unsigned char> output(numberOfPixels * bytesPerPixel, 0);
+          igsioFlipClipKernels::ReverseRow(&input[0], &output[0], numberOfPixels, bytesPerPixel);
+          for (int pixelIndex = 0; pixelIndex < numberOfPixels; ++pixelIndex)
+          {
+            if (memcmp(&input[pixelIndex * bytesPerPixel], &output[(numberOfPixels - 1 - pixelIndex) * bytesPerPixel], bytesPerPixel) != 0)
+            {
+              LOG_ERROR("Reversed row is incorrect at pixel " << pixelIndex << " of " << numberOfPixels << " with "
+                        << igsioFlipClipKernels::GetInstructionSetAsString(igsioFlipClipKernels::GetInstructionSet()) << " kernels, "
+                        << bytesPerPixel << " bytes per pixel");
+              igsioFlipClipKernels::SetInstructionSet(igsioFlipClipKernels::GetBestSupportedInstructionSet());
+              return IGSIO_FAIL;
+            }
+          }
+        }
+      }
+    }
+    igsioFlipClipKernels::SetInstructionSet(igsioFlipClipKernels::GetBestSupportedInstructionSet());
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestFlipClipKernels(bool multiThreaded)
+  {
+    const int scalarTypes[5] = { VTK_UNSIGNED_CHAR, VTK_UNSIGNED_CHAR, VTK_UNSIGNED_SHORT, VTK_FLOAT, VTK_DOUBLE };
+    const int numberOfComponents[5] = { 1, 3, 1, 1, 1 };
+    const int inputDims[3] = { 77, 23, 5 };
+    const std::array<int, 3> clipOrigin = { 3, 2, 1 };
+    const std::array<int, 3> clipSize = { 69, 17, 3 };
+
+    for (int instructionSet = igsioFlipClipKernels::INSTRUCTION_SET_SCALAR; instructionSet <= igsioFlipClipKernels::INSTRUCTION_SET_NEON; ++instructionSet)
+    {
+      if (!igsioFlipClipKernels::IsInstructionSetSupported(static_cast<igsioFlipClipKernels::InstructionSet>(instructionSet)))
+      {
+        continue;
+      }
+      igsioFlipClipKernels::SetInstructionSet(static_cast<igsioFlipClipKernels::InstructionSet>(instructionSet));
+
+      for (int typeIndex = 0; typeIndex < 5; ++typeIndex)
+      {
+        vtkSmartPointer<vtkImageData> inputImage = CreateTestImage(inputDims, scalarTypes[typeIndex], numberOfComponents[typeIndex]);
+        const int bytesPerPixel = igsioVideoFrame::GetNumberOfBytesPerScalar(scalarTypes[typeIndex]) * numberOfComponents[typeIndex];
+        const unsigned char* inputPixels = static_cast<const unsigned char*>(inputImage->GetScalarPointer());
+
+        for (int flipCase = 0; flipCase < NUMBER_OF_FLIP_KERNEL_CASES; ++flipCase)
+        {
+          vtkSmartPointer<vtkImageData> outputImage = vtkSmartPointer<vtkImageData>::New();
+          if (igsioVideoFrame::FlipClipImage(inputImage, GetFlipInfo(static_cast<FlipKernelCase>(flipCase)), clipOrigin, clipSize, outputImage, multiThreaded) != IGSIO_SUCCESS)
+          {
+            LOG_ERROR("FlipClipImage failed");
+            return IGSIO_FAIL;
+          }
+          const unsigned char* outputPixels = static_cast<const unsigned char*>(outputImage->GetScalarPointer());
+          int outputDims[3] = { 0, 0, 0 };
+          outputImage->GetDimensions(outputDims);
+
+          // Compare each output pixel to the corresponding clipped input pixel
+          for (int z = 0; z < clipSize[2]; ++z)
+          {
+            for (int y = 0; y < clipSize[1]; ++y)
+            {
+              for (int x = 0; x < clipSize[0]; ++x)
+              {
+                int outputIndex[3] = { x, y, z };
+                if (flipCase == FLIP_X || flipCase == FLIP_XY)
+                {
+                  outputIndex[0] = clipSize[0] - 1 - x;
+                }
+                if (flipCase == FLIP_Y || flipCase == FLIP_XY)
+                {
+                  outputIndex[1] = clipSize[1] - 1 - y;
+                }
+                if (flipCase == FLIP_Z)
+                {
+                  outputIndex[2] = clipSize[2] - 1 - z;
+                }
+                if (flipCase == TRANSPOSE_IJK_TO_KIJ)
+                {
+                  outputIndex[0] = z;
+                  outputIndex[1] = x;
+                  outputIndex[2] = y;
+                }
+                const size_t inputOffset = ((static_cast<size_t>(clipOrigin[2] + z) * inputDims[1] + clipOrigin[1] + y) * inputDims[0] + clipOrigin[0] + x) * bytesPerPixel;
+                const size_t outputOffset = ((static_cast<size_t>(outputIndex[2]) * outputDims[1] + outputIndex[1]) * outputDims[0] + outputIndex[0]) * bytesPerPixel;
+                if (memcmp(inputPixels + inputOffset, outputPixels + outputOffset, bytesPerPixel) != 0)
+                {
+                  LOG_ERROR(GetFlipKernelCaseAsString(static_cast<FlipKernelCase>(flipCase)) << " result is incorrect at (" << x << "," << y << "," << z << ") with "
+                            << igsioFlipClipKernels::GetInstructionSetAsString(igsioFlipClipKernels::GetInstructionSet()) << " kernels, "
+                            << bytesPerPixel << " bytes per pixel");
+                  return IGSIO_FAIL;
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+
+    igsioFlipClipKernels::SetInstructionSet(igsioFlipClipKernels::GetBestSupportedInstructionSet());
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus BenchmarkFlipClipKernels(int numberOfIterations)
+  {
+    const int scalarTypes[4] = { VTK_UNSIGNED_CHAR, VTK_UNSIGNED_CHAR, VTK_UNSIGNED_SHORT, VTK_FLOAT };
+    const int numberOfComponents[4] = { 1, 3, 1, 1 };
+    const int imageDims[3] = { 640, 480, 1 };
+    const int volumeDims[3] = { 128, 128, 64 };
+    const std::array<int, 3> noClip = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+
+    for (int typeIndex = 0; typeIndex < 4; ++typeIndex)
+    {
+      for (int flipCase = 0; flipCase < NUMBER_OF_FLIP_KERNEL_CASES; ++flipCase)
+      {
+        const int* dims = (flipCase == TRANSPOSE_IJK_TO_KIJ ? volumeDims : imageDims);
+        vtkSmartPointer<vtkImageData> inputImage = CreateTestImage(dims, scalarTypes[typeIndex], numberOfComponents[typeIndex]);
+        vtkSmartPointer<vtkImageData> outputImage = vtkSmartPointer<vtkImageData>::New();
+        const double numberOfMegapixels = static_cast<double>(dims[0]) * dims[1] * dims[2] * numberOfIterations / 1e6;
+
+        for (int instructionSet = igsioFlipClipKernels::INSTRUCTION_SET_SCALAR; instructionSet <= igsioFlipClipKernels::INSTRUCTION_SET_NEON; ++instructionSet)
+        {
+          if (!igsioFlipClipKernels::IsInstructionSetSupported(static_cast<igsioFlipClipKernels::InstructionSet>(instructionSet)))
+          {
+            continue;
+          }
+          igsioFlipClipKernels::SetInstructionSet(static_cast<igsioFlipClipKernels::InstructionSet>(instructionSet));
+          double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+          for (int i = 0; i < numberOfIterations; ++i)
+          {
+            if (igsioVideoFrame::FlipClipImage(inputImage, GetFlipInfo(static_cast<FlipKernelCase>(flipCase)), noClip, noClip, outputImage) != IGSIO_SUCCESS)
+            {
+              LOG_ERROR("FlipClipImage failed");
+              return IGSIO_FAIL;
+            }
+          }
+          double elapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+          LOG_INFO(GetFlipKernelCaseAsString(static_cast<FlipKernelCase>(flipCase)) << " " << igsioVideoFrame::GetStringFromVTKPixelType(scalarTypes[typeIndex])
+                   << " x" << numberOfComponents[typeIndex] << " " << igsioFlipClipKernels::GetInstructionSetAsString(static_cast<igsioFlipClipKernels::InstructionSet>(instructionSet))
+                   << ": " << (elapsedTimeSec > 0 ? numberOfMegapixels / elapsedTimeSec : 0) << " Mpixel/sec");
+        }
+
+        // Multi-threaded, with the best instruction set
+        igsioFlipClipKernels::SetInstructionSet(igsioFlipClipKernels::GetBestSupportedInstructionSet());
+        double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+        for (int i = 0; i < numberOfIterations; ++i)
+        {
+          if (igsioVideoFrame::FlipClipImage(inputImage, GetFlipInfo(static_cast<FlipKernelCase>(flipCase)), noClip, noClip, outputImage, true) != IGSIO_SUCCESS)
+          {
+            LOG_ERROR("Multi-threaded FlipClipImage failed");
+            return IGSIO_FAIL;
+          }
+        }
+        double elapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+        LOG_INFO(GetFlipKernelCaseAsString(static_cast<FlipKernelCase>(flipCase)) << " " << igsioVideoFrame::GetStringFromVTKPixelType(scalarTypes[typeIndex])
+                 << " x" << numberOfComponents[typeIndex] << " multi-threaded: " << (elapsedTimeSec > 0 ? numberOfMegapixels / elapsedTimeSec : 0) << " Mpixel/sec");
+      }
+    }
+
+    igsioFlipClipKernels::SetInstructionSet(igsioFlipClipKernels::GetBestSupportedInstructionSet());
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestClipImage()
+  {
+    const int inputDims[3] = { 77, 23, 5 };
+    const int numberOfClipCases = 4;
+    // Box inside the image, full rows, full slices, box partially outside of the image
+    const std::array<int, 3> clipOrigins[numberOfClipCases] = { { 3, 2, 1 }, { 0, 4, 1 }, { 0, 0, 2 }, { 70, 20, 3 } };
+    const std::array<int, 3> clipSizes[numberOfClipCases] = { { 69, 17, 3 }, { 77, 10, 3 }, { 77, 23, 2 }, { 20, 20, 20 } };
+    const int bytesPerPixel = 3;
+    vtkSmartPointer<vtkImageData> inputImage = CreateTestImage(inputDims, VTK_UNSIGNED_CHAR, bytesPerPixel);
+    const unsigned char* inputPixels = static_cast<const unsigned char*>(inputImage->GetScalarPointer());
+    igsioVideoFrame::FlipInfoType noFlip;
+
+    for (int clipCase = 0; clipCase < numberOfClipCases; ++clipCase)
+    {
+      vtkSmartPointer<vtkImageData> outputImage = vtkSmartPointer<vtkImageData>::New();
+      // Clip twice to check that the output buffer is reused
+      void* previousOutputPixels = NULL;
+      for (int repeat = 0; repeat < 2; ++repeat)
+      {
+        if (igsioVideoFrame::FlipClipImage(inputImage, noFlip, clipOrigins[clipCase], clipSizes[clipCase], outputImage) != IGSIO_SUCCESS)
+        {
+          LOG_ERROR("FlipClipImage failed to clip the image");
+          return IGSIO_FAIL;
+        }
+        if (repeat > 0 && outputImage->GetScalarPointer() != previousOutputPixels)
+        {
+          LOG_ERROR("FlipClipImage reallocated the output image buffer");
+          return IGSIO_FAIL;
+        }
+        previousOutputPixels = outputImage->GetScalarPointer();
+      }
+
+      // The output extent is the clipping box, restricted to the input image (same as vtkExtractVOI)
+      int expectedExtent[6] = { 0, 0, 0, 0, 0, 0 };
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        expectedExtent[2 * axis] = clipOrigins[clipCase][axis];
+        expectedExtent[2 * axis + 1] = std::min(clipOrigins[clipCase][axis] + clipSizes[clipCase][axis], inputDims[axis]) - 1;
+      }
+      int outputExtent[6] = { 0, 0, 0, 0, 0, 0 };
+      outputImage->GetExtent(outputExtent);
+      if (!std::equal(expectedExtent, expectedExtent + 6, outputExtent))
+      {
+        LOG_ERROR("Clipped image extent is incorrect in clipping case " << clipCase);
+        return IGSIO_FAIL;
+      }
+      for (int z = expectedExtent[4]; z <= expectedExtent[5]; ++z)
+      {
+        for (int y = expectedExtent[2]; y <= expectedExtent[3]; ++y)
+        {
+          const size_t inputOffset = ((static_cast<size_t>(z) * inputDims[1] + y) * inputDims[0] + expectedExtent[0]) * bytesPerPixel;
+          const size_t rowSizeBytes = static_cast<size_t>(expectedExtent[1] - expectedExtent[0] + 1) * bytesPerPixel;
+          if (memcmp(inputPixels + inputOffset, outputImage->GetScalarPointer(expectedExtent[0], y, z), rowSizeBytes) != 0)
+          {
+            LOG_ERROR("Clipped image is incorrect in clipping case " << clipCase << " at row (" << y << "," << z << ")");
+            return IGSIO_FAIL;
+          }
+        }
+      }
+    }
+
+    // No clipping: deep copy by default, shared pixels if shallow copy is allowed
+    const std::array<int, 3> noClip = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    vtkSmartPointer<vtkImageData> outputImage = vtkSmartPointer<vtkImageData>::New();
+    if (igsioVideoFrame::FlipClipImage(inputImage, noFlip, noClip, noClip, outputImage) != IGSIO_SUCCESS
+        || outputImage->GetScalarPointer() == inputImage->GetScalarPointer()
+        || memcmp(outputImage->GetScalarPointer(), inputPixels, static_cast<size_t>(inputDims[0]) * inputDims[1] * inputDims[2] * bytesPerPixel) != 0)
+    {
+      LOG_ERROR("FlipClipImage failed to copy the image");
+      return IGSIO_FAIL;
+    }
+    if (igsioVideoFrame::FlipClipImage(inputImage, noFlip, noClip, noClip, outputImage, false, true) != IGSIO_SUCCESS
+        || outputImage->GetScalarPointer() != inputImage->GetScalarPointer())
+    {
+      LOG_ERROR("FlipClipImage did not share the pixels of the input image");
+      return IGSIO_FAIL;
+    }
+    // Clipping into an output that shares the input pixels must not overwrite the input
+    if (igsioVideoFrame::FlipClipImage(inputImage, noFlip, clipOrigins[0], clipSizes[0], outputImage) != IGSIO_SUCCESS
+        || outputImage->GetScalarPointer() == inputImage->GetScalarPointer())
+    {
+      LOG_ERROR("FlipClipImage wrote the clipped image into the input image");
+      return IGSIO_FAIL;
+    }
+
+    // Copying into an output that shares its pixels with another image must not overwrite that image
+    vtkSmartPointer<vtkImageData> otherInputImage = vtkSmartPointer<vtkImageData>::New();
+    otherInputImage->DeepCopy(inputImage);
+    const size_t inputSizeBytes = static_cast<size_t>(inputDims[0]) * inputDims[1] * inputDims[2] * bytesPerPixel;
+    memset(otherInputImage->GetScalarPointer(), 0x5A, inputSizeBytes);
+    std::vector<unsigned char> originalInputPixels(inputPixels, inputPixels + inputSizeBytes);
+    if (igsioVideoFrame::FlipClipImage(inputImage, noFlip, noClip, noClip, outputImage, false, true) != IGSIO_SUCCESS
+        || igsioVideoFrame::FlipClipImage(otherInputImage, noFlip, noClip, noClip, outputImage) != IGSIO_SUCCESS
+        || memcmp(inputImage->GetScalarPointer(), &originalInputPixels[0], inputSizeBytes) != 0
+        || memcmp(outputImage->GetScalarPointer(), otherInputImage->GetScalarPointer(), inputSizeBytes) != 0)
+    {
+      LOG_ERROR("FlipClipImage overwrote the pixels of an image that shared the output buffer");
+      return IGSIO_FAIL;
+    }
+    vtkSmartPointer<vtkImageData> sharingImage = vtkSmartPointer<vtkImageData>::New();
+    if (igsioVideoFrame::FlipClipImage(inputImage, noFlip, clipOrigins[0], clipSizes[0], outputImage) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("FlipClipImage failed to clip the image");
+      return IGSIO_FAIL;
+    }
+    sharingImage->ShallowCopy(outputImage);
+    unsigned char* sharedPixels = static_cast<unsigned char*>(sharingImage->GetScalarPointer());
+    int sharedDims[3] = { 0, 0, 0 };
+    sharingImage->GetDimensions(sharedDims);
+    std::vector<unsigned char> originalSharedPixels(sharedPixels, sharedPixels + static_cast<size_t>(sharedDims[0]) * sharedDims[1] * sharedDims[2] * bytesPerPixel);
+    if (igsioVideoFrame::FlipClipImage(otherInputImage, noFlip, clipOrigins[0], clipSizes[0], outputImage) != IGSIO_SUCCESS
+        || outputImage->GetScalarPointer() == sharingImage->GetScalarPointer()
+        || memcmp(sharedPixels, &originalSharedPixels[0], originalSharedPixels.size()) != 0)
+    {
+      LOG_ERROR("FlipClipImage overwrote the pixels of a shallow copy of the output image");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus BenchmarkClipImage(int numberOfIterations)
+  {
+    // Small frames, where the per-frame overhead dominates
+    const int imageDims[3] = { 128, 128, 1 };
+    const std::array<int, 3> clipOrigin = { 16, 16, 0 };
+    const std::array<int, 3> clipSize = { 96, 96, 1 };
+    const std::array<int, 3> noClip = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    const int numberOfFrames = 100 * numberOfIterations;
+    vtkSmartPointer<vtkImageData> inputImage = CreateTestImage(imageDims, VTK_UNSIGNED_CHAR, 1);
+    vtkSmartPointer<vtkImageData> outputImage = vtkSmartPointer<vtkImageData>::New();
+    igsioVideoFrame::FlipInfoType noFlip;
+
+    // Reference: VTK pipeline based clipping and deep copy
+    double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      vtkSmartPointer<vtkExtractVOI> extract = vtkSmartPointer<vtkExtractVOI>::New();
+      vtkSmartPointer<vtkTrivialProducer> tp = vtkSmartPointer<vtkTrivialProducer>::New();
+      tp->SetOutput(inputImage);
+      extract->SetInputConnection(tp->GetOutputPort());
+      extract->SetVOI(clipOrigin[0], clipOrigin[0] + clipSize[0] - 1, clipOrigin[1], clipOrigin[1] + clipSize[1] - 1, clipOrigin[2], clipOrigin[2] + clipSize[2] - 1);
+      extract->SetOutput(outputImage);
+      extract->Update();
+    }
+    double pipelineClipTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+
+    startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      outputImage->DeepCopy(inputImage);
+    }
+    double deepCopyTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+
+    // FlipClipImage: strided copy and shared pixels
+    outputImage = vtkSmartPointer<vtkImageData>::New();
+    startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      if (igsioVideoFrame::FlipClipImage(inputImage, noFlip, clipOrigin, clipSize, outputImage) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("FlipClipImage failed");
+        return IGSIO_FAIL;
+      }
+    }
+    double clipTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+
+    outputImage = vtkSmartPointer<vtkImageData>::New();
+    startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      if (igsioVideoFrame::FlipClipImage(inputImage, noFlip, noClip, noClip, outputImage) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("FlipClipImage failed");
+        return IGSIO_FAIL;
+      }
+    }
+    double copyTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+
+    startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      if (igsioVideoFrame::FlipClipImage(inputImage, noFlip, noClip, noClip, outputImage, false, true) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("FlipClipImage failed");
+        return IGSIO_FAIL;
+      }
+    }
+    double shallowCopyTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+
+    const double usecPerFrame = 1e6 / numberOfFrames;
+    LOG_INFO("Clip " << imageDims[0] << "x" << imageDims[1] << " frame: vtkExtractVOI " << pipelineClipTimeSec * usecPerFrame << " usec/frame, strided copy " << clipTimeSec * usecPerFrame << " usec/frame");
+    LOG_INFO("Copy " << imageDims[0] << "x" << imageDims[1] << " frame: DeepCopy " << deepCopyTimeSec * usecPerFrame << " usec/frame, strided copy " << copyTimeSec * usecPerFrame
+             << " usec/frame, shallow copy " << shallowCopyTimeSec * usecPerFrame << " usec/frame");
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Reference implementation of window/level and rescale conversion, in double precision */
+  template<class ScalarType>
+  void ScaleToUnsignedCharReference(const ScalarType* input, size_t numberOfValues, double minimum, double window, std::vector<unsigned char>& output)
+  {
+    output.resize(numberOfValues);
+    for (size_t i = 0; i < numberOfValues; ++i)
+    {
+      double value = (window > 0 ? (static_cast<double>(input[i]) - minimum) * 255.0 / window : 0.0);
+      output[i] = static_cast<unsigned char>(std::min(std::max(value, 0.0), 255.0) + 0.5);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template<class ScalarType>
+  igsioStatus TestScaleToUnsignedChar(int scalarType, bool multiThreaded)
+  {
+    // Odd number of values, so the scalar remainder of the vectorized kernels is used as well
+    const int imageDims[3] = { 101, 37, 3 };
+    const size_t numberOfValues = static_cast<size_t>(imageDims[0]) * imageDims[1] * imageDims[2];
+    vtkSmartPointer<vtkImageData> inputImage = vtkSmartPointer<vtkImageData>::New();
+    inputImage->SetExtent(0, imageDims[0] - 1, 0, imageDims[1] - 1, 0, imageDims[2] - 1);
+    inputImage->AllocateScalars(scalarType, 1);
+    ScalarType* inputValues = static_cast<ScalarType*>(inputImage->GetScalarPointer());
+    const double minimumValue = std::max<double>(std::numeric_limits<ScalarType>::lowest(), -3000.0);
+    const double maximumValue = std::min<double>(std::numeric_limits<ScalarType>::max(), 3000.0);
+    for (size_t i = 0; i < numberOfValues; ++i)
+    {
+      inputValues[i] = static_cast<ScalarType>(minimumValue + (maximumValue - minimumValue) * ((i * 7919) % 1000) / 999.0);
+    }
+
+    igsioVideoFrame::PixelConversionInfoType windowLevel;
+    windowLevel.mode = igsioVideoFrame::PIXEL_CONVERSION_WINDOW_LEVEL;
+    windowLevel.window = (maximumValue - minimumValue) / 3.0;
+    windowLevel.level = minimumValue + (maximumValue - minimumValue) / 2.0;
+    igsioVideoFrame::PixelConversionInfoType rescale;
+    rescale.mode = igsioVideoFrame::PIXEL_CONVERSION_RESCALE;
+
+    std::vector<unsigned char> expectedWindowLevel;
+    ScaleToUnsignedCharReference(inputValues, numberOfValues, windowLevel.level - windowLevel.window / 2.0, windowLevel.window, expectedWindowLevel);
+    std::vector<unsigned char> expectedRescale;
+    ScaleToUnsignedCharReference(inputValues, numberOfValues, minimumValue, maximumValue - minimumValue, expectedRescale);
+
+    for (int instructionSet = igsioFlipClipKernels::INSTRUCTION_SET_SCALAR; instructionSet <= igsioFlipClipKernels::INSTRUCTION_SET_NEON; ++instructionSet)
+    {
+      if (!igsioFlipClipKernels::IsInstructionSetSupported(static_cast<igsioFlipClipKernels::InstructionSet>(instructionSet)))
+      {
+        continue;
+      }
+      igsioFlipClipKernels::SetInstructionSet(static_cast<igsioFlipClipKernels::InstructionSet>(instructionSet));
+      for (int conversion = 0; conversion < 2; ++conversion)
+      {
+        vtkSmartPointer<vtkImageData> outputImage = vtkSmartPointer<vtkImageData>::New();
+        if (igsioVideoFrame::ConvertPixelType(inputImage, conversion == 0 ? windowLevel : rescale, outputImage, multiThreaded) != IGSIO_SUCCESS
+            || outputImage->GetScalarType() != VTK_UNSIGNED_CHAR || outputImage->GetNumberOfScalarComponents() != 1)
+        {
+          LOG_ERROR("ConvertPixelType failed for " << igsioVideoFrame::GetStringFromVTKPixelType(scalarType));
+          return IGSIO_FAIL;
+        }
+        const std::vector<unsigned char>& expected = (conversion == 0 ? expectedWindowLevel : expectedRescale);
+        const unsigned char* outputValues = static_cast<const unsigned char*>(outputImage->GetScalarPointer());
+        for (size_t i = 0; i < numberOfValues; ++i)
+        {
+          // Single precision computation may round differently by one gray level
+          if (abs(static_cast<int>(outputValues[i]) - static_cast<int>(expected[i])) > 1)
+          {
+            LOG_ERROR((conversion == 0 ? "Window/level" : "Rescale") << " conversion of " << igsioVideoFrame::GetStringFromVTKPixelType(scalarType)
+                      << " is incorrect at value " << i << " with " << igsioFlipClipKernels::GetInstructionSetAsString(igsioFlipClipKernels::GetInstructionSet())
+                      << " kernels: " << static_cast<int>(outputValues[i]) << " (expected " << static_cast<int>(expected[i]) << ")");
+            return IGSIO_FAIL;
+          }
+        }
+      }
+    }
+
+    igsioFlipClipKernels::SetInstructionSet(igsioFlipClipKernels::GetBestSupportedInstructionSet());
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestConvertPixelType(bool multiThreaded)
+  {
+    if (TestScaleToUnsignedChar<vtkTypeUInt16>(VTK_UNSIGNED_SHORT, multiThreaded) != IGSIO_SUCCESS
+        || TestScaleToUnsignedChar<vtkTypeInt16>(VTK_SHORT, multiThreaded) != IGSIO_SUCCESS
+        || TestScaleToUnsignedChar<vtkTypeFloat32>(VTK_FLOAT, multiThreaded) != IGSIO_SUCCESS
+        || TestScaleToUnsignedChar<vtkTypeFloat64>(VTK_DOUBLE, multiThreaded) != IGSIO_SUCCESS
+        || TestScaleToUnsignedChar<vtkTypeUInt8>(VTK_UNSIGNED_CHAR, multiThreaded) != IGSIO_SUCCESS)
+    {
+      return IGSIO_FAIL;
+    }
+
+    // RGB to gray and back, using frames (output buffers are taken from the buffer pool)
+    FrameSizeType frameSize = { 61, 17, 1 };
+    const int numberOfPixels = frameSize[0] * frameSize[1];
+    igsioVideoFrame rgbFrame;
+    rgbFrame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 3);
+    rgbFrame.SetImageType(US_IMG_RGB_COLOR);
+    unsigned char* rgbPixels = static_cast<unsigned char*>(rgbFrame.GetScalarPointer());
+    for (int i = 0; i < numberOfPixels * 3; ++i)
+    {
+      rgbPixels[i] = static_cast<unsigned char>((i * 37) & 0xFF);
+    }
+
+    igsioVideoFrame::PixelConversionInfoType rgbToGray;
+    rgbToGray.mode = igsioVideoFrame::PIXEL_CONVERSION_RGB_TO_GRAY;
+    igsioVideoFrame grayFrame;
+    if (rgbFrame.ConvertPixelType(rgbToGray, grayFrame, multiThreaded) != IGSIO_SUCCESS || grayFrame.GetNumberOfBytesPerPixel() != 1 || grayFrame.GetImageType() != US_IMG_BRIGHTNESS)
+    {
+      LOG_ERROR("RGB to gray conversion failed");
+      return IGSIO_FAIL;
+    }
+    const unsigned char* grayPixels = static_cast<const unsigned char*>(grayFrame.GetImage()->GetScalarPointer());
+    for (int i = 0; i < numberOfPixels; ++i)
+    {
+      int expectedGray = (77 * rgbPixels[3 * i] + 150 * rgbPixels[3 * i + 1] + 29 * rgbPixels[3 * i + 2] + 128) / 256;
+      if (grayPixels[i] != expectedGray)
+      {
+        LOG_ERROR("RGB to gray conversion is incorrect at pixel " << i);
+        return IGSIO_FAIL;
+      }
+    }
+
+    igsioVideoFrame::PixelConversionInfoType grayToRgb;
+    grayToRgb.mode = igsioVideoFrame::PIXEL_CONVERSION_GRAY_TO_RGB;
+    if (grayFrame.ConvertPixelType(grayToRgb, rgbFrame, multiThreaded) != IGSIO_SUCCESS || rgbFrame.GetNumberOfBytesPerPixel() != 3 || rgbFrame.GetImageType() != US_IMG_RGB_COLOR)
+    {
+      LOG_ERROR("Gray to RGB conversion failed");
+      return IGSIO_FAIL;
+    }
+    rgbPixels = static_cast<unsigned char*>(rgbFrame.GetScalarPointer());
+    for (int i = 0; i < numberOfPixels; ++i)
+    {
+      if (rgbPixels[3 * i] != grayPixels[i] || rgbPixels[3 * i + 1] != grayPixels[i] || rgbPixels[3 * i + 2] != grayPixels[i])
+      {
+        LOG_ERROR("Gray to RGB conversion is incorrect at pixel " << i);
+        return IGSIO_FAIL;
+      }
+    }
+
+    // Converting into an output image that shares its pixels with another image must not overwrite that image
+    vtkSmartPointer<vtkImageData> grayImage = vtkSmartPointer<vtkImageData>::New();
+    if (igsioVideoFrame::ConvertPixelType(rgbFrame.GetImage(), rgbToGray, grayImage, multiThreaded) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("RGB to gray image conversion failed");
+      return IGSIO_FAIL;
+    }
+    vtkSmartPointer<vtkImageData> sharingImage = vtkSmartPointer<vtkImageData>::New();
+    sharingImage->ShallowCopy(grayImage);
+    unsigned char* sharedPixels = static_cast<unsigned char*>(sharingImage->GetScalarPointer());
+    std::vector<unsigned char> originalSharedPixels(sharedPixels, sharedPixels + numberOfPixels);
+    memset(rgbFrame.GetScalarPointer(), 0, numberOfPixels * 3);
+    if (igsioVideoFrame::ConvertPixelType(rgbFrame.GetImage(), rgbToGray, grayImage, multiThreaded) != IGSIO_SUCCESS
+        || grayImage->GetScalarPointer() == sharingImage->GetScalarPointer()
+        || memcmp(sharedPixels, &originalSharedPixels[0], numberOfPixels) != 0)
+    {
+      LOG_ERROR("Pixel type conversion overwrote the pixels of a shallow copy of the output image");
+      return IGSIO_FAIL;
+    }
+
+    // Invalid conversions
+    if (grayFrame.ConvertPixelType(rgbToGray, rgbFrame) == IGSIO_SUCCESS)
+    {
+      LOG_ERROR("RGB to gray conversion of a gray image did not fail");
+      return IGSIO_FAIL;
+    }
+    igsioVideoFrame::PixelConversionInfoType zeroWindow;
+    zeroWindow.mode = igsioVideoFrame::PIXEL_CONVERSION_WINDOW_LEVEL;
+    zeroWindow.window = 0.0;
+    if (grayFrame.ConvertPixelType(zeroWindow, rgbFrame) == IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Window/level conversion with zero window did not fail");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus BenchmarkConvertPixelType(int numberOfIterations)
+  {
+    const int scalarTypes[3] = { VTK_UNSIGNED_SHORT, VTK_SHORT, VTK_FLOAT };
+    const int imageDims[3] = { 640, 480, 1 };
+    const double numberOfMegapixels = static_cast<double>(imageDims[0]) * imageDims[1] * imageDims[2] * numberOfIterations / 1e6;
+    igsioVideoFrame::PixelConversionInfoType windowLevel;
+    windowLevel.mode = igsioVideoFrame::PIXEL_CONVERSION_WINDOW_LEVEL;
+    windowLevel.window = 40.0;
+    windowLevel.level = 120.0;
+
+    for (int typeIndex = 0; typeIndex < 3; ++typeIndex)
+    {
+      vtkSmartPointer<vtkImageData> inputImage = CreateTestImage(imageDims, scalarTypes[typeIndex], 1);
+      if (scalarTypes[typeIndex] == VTK_FLOAT)
+      {
+        // Random bytes may be NaN or infinite, use finite values
+        float* values = static_cast<float*>(inputImage->GetScalarPointer());
+        for (int i = 0; i < imageDims[0] * imageDims[1] * imageDims[2]; ++i)
+        {
+          values[i] = static_cast<float>(i % 251);
+        }
+      }
+      vtkSmartPointer<vtkImageData> outputImage = vtkSmartPointer<vtkImageData>::New();
+      for (int instructionSet = igsioFlipClipKernels::INSTRUCTION_SET_SCALAR; instructionSet <= igsioFlipClipKernels::INSTRUCTION_SET_NEON + 1; ++instructionSet)
+      {
+        // The last round is multi-threaded, with the best instruction set
+        const bool multiThreaded = (instructionSet > igsioFlipClipKernels::INSTRUCTION_SET_NEON);
+        igsioFlipClipKernels::InstructionSet currentInstructionSet = (multiThreaded ? igsioFlipClipKernels::GetBestSupportedInstructionSet() : static_cast<igsioFlipClipKernels::InstructionSet>(instructionSet));
+        if (!igsioFlipClipKernels::IsInstructionSetSupported(currentInstructionSet))
+        {
+          continue;
+        }
+        igsioFlipClipKernels::SetInstructionSet(currentInstructionSet);
+        double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+        for (int i = 0; i < numberOfIterations; ++i)
+        {
+          if (igsioVideoFrame::ConvertPixelType(inputImage, windowLevel, outputImage, multiThreaded) != IGSIO_SUCCESS)
+          {
+            LOG_ERROR("ConvertPixelType failed");
+            return IGSIO_FAIL;
+          }
+        }
+        double elapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+        LOG_INFO("Window/level " << igsioVideoFrame::GetStringFromVTKPixelType(scalarTypes[typeIndex]) << " to unsigned char "
+                 << (multiThreaded ? std::string("multi-threaded") : igsioFlipClipKernels::GetInstructionSetAsString(currentInstructionSet))
+                 << ": " << (elapsedTimeSec > 0 ? numberOfMegapixels / elapsedTimeSec : 0) << " Mpixel/sec");
+      }
+    }
+
+    igsioFlipClipKernels::SetInstructionSet(igsioFlipClipKernels::GetBestSupportedInstructionSet());
+    return IGSIO_SUCCESS;
+  }
+
+  const int DECODE_TEST_FRAME_SIZE[3] = { 16, 8, 1 };
+  const unsigned long long DECODE_TEST_FRAME_SIZE_IN_BYTES = 16 * 8;
+
+  //----------------------------------------------------------------------------
+  /*! Create a stream of encoded frames. Frame i contains value i+1, a keyframe is inserted every keyFrameInterval frames. */
+  std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > CreateEncodedStream(int numberOfFrames, int keyFrameInterval, std::vector<unsigned char>& expectedPixelValues)
+  {
+    std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > stream;
+    expectedPixelValues.clear();
+    unsigned char pixelValue = 0;
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      unsigned char frameValue = static_cast<unsigned char>(i + 1);
+      vtkSmartPointer<vtkUnsignedCharArray> frameData = vtkSmartPointer<vtkUnsignedCharArray>::New();
+      frameData->SetNumberOfTuples(1);
+      frameData->GetPointer(0)[0] = frameValue;
+
+      vtkSmartPointer<vtkStreamingVolumeFrame> frame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+      frame->SetCodecFourCC("TDLT");
+      frame->SetDimensions(DECODE_TEST_FRAME_SIZE[0], DECODE_TEST_FRAME_SIZE[1], DECODE_TEST_FRAME_SIZE[2]);
+      frame->SetNumberOfComponents(1);
+      frame->SetFrameData(frameData);
+      if (i % keyFrameInterval == 0)
+      {
+        frame->SetFrameType(vtkStreamingVolumeFrame::IFrame);
+        pixelValue = frameValue;
+      }
+      else
+      {
+        frame->SetFrameType(vtkStreamingVolumeFrame::PFrame);
+        frame->SetPreviousFrame(stream.back());
+        pixelValue = static_cast<unsigned char>(pixelValue + frameValue);
+      }
+      stream.push_back(frame);
+      expectedPixelValues.push_back(pixelValue);
+    }
+    return stream;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus CheckDecodedImage(vtkImageData* image, unsigned char expectedPixelValue)
+  {
+    if (image == NULL)
+    {
+      LOG_ERROR("Frame was not decoded");
+      return IGSIO_FAIL;
+    }
+    const unsigned char* pixels = static_cast<const unsigned char*>(image->GetScalarPointer());
+    for (unsigned long long i = 0; i < DECODE_TEST_FRAME_SIZE_IN_BYTES; ++i)
+    {
+      if (pixels[i] != expectedPixelValue)
+      {
+        LOG_ERROR("Decoded pixel mismatch: " << static_cast<int>(pixels[i]) << " (expected " << static_cast<int>(expectedPixelValue) << ")");
+        return IGSIO_FAIL;
+      }
+    }
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  struct ConcurrentDecodeInfo
+  {
+    const igsioVideoFrame* Frame;
+    vtkImageData* Images[4];
+  };
+
+  //----------------------------------------------------------------------------
+  VTK_THREAD_RETURN_TYPE ConcurrentDecodeThreadFunction(void* ptr)
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(ptr);
+    ConcurrentDecodeInfo* info = static_cast<ConcurrentDecodeInfo*>(threadInfo->UserData);
+    info->Images[threadInfo->ThreadID] = info->Frame->GetImage();
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestLazyDecode()
+  {
+    vtkStreamingVolumeCodecFactory::GetInstance()->RegisterStreamingCodec(vtkSmartPointer<vtkIGSIOTestDeltaCodec>::New());
+
+    const int numberOfFrames = 20;
+    const int keyFrameInterval = 10;
+    std::vector<unsigned char> expectedPixelValues;
+    std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > stream = CreateEncodedStream(numberOfFrames, keyFrameInterval, expectedPixelValues);
+
+    // Frames are not decoded until their image is requested
+    vtkSmartPointer<vtkIGSIODecodedFrameCache> cache = vtkSmartPointer<vtkIGSIODecodedFrameCache>::New();
+    std::vector<igsioVideoFrame> frames(numberOfFrames);
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      frames[i].SetDecodedFrameCache(cache);
+      frames[i].SetEncodedFrame(stream[i]);
+    }
+    vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames = 0;
+    FrameSizeType frameSize = { 0, 0, 0 };
+    frames[0].GetFrameSize(frameSize);
+    if (vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames != 0 || frameSize[0] != DECODE_TEST_FRAME_SIZE[0] || frames[0].GetVTKScalarPixelType() != VTK_UNSIGNED_CHAR)
+    {
+      LOG_ERROR("Frame properties of an encoded frame are not available without decoding");
+      return IGSIO_FAIL;
+    }
+
+    // Sequential access decodes each frame once
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      if (CheckDecodedImage(frames[i].GetImage(), expectedPixelValues[i]) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("Sequential decoding failed at frame " << i);
+        return IGSIO_FAIL;
+      }
+    }
+    if (vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames != numberOfFrames || cache->GetNumberOfDecodedFrames() != numberOfFrames
+        || cache->GetNumberOfCachedImages() != numberOfFrames || cache->GetCachedBytes() != numberOfFrames * DECODE_TEST_FRAME_SIZE_IN_BYTES)
+    {
+      LOG_ERROR("Sequential decoding decoded " << vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames << " frames (expected " << numberOfFrames << ")");
+      return IGSIO_FAIL;
+    }
+
+    // The decoded image is kept by the frame and shared by copies through the cache
+    const igsioVideoFrame& decodedFrame = frames[5];
+    igsioVideoFrame frameCopy(decodedFrame);
+    frameCopy.SetDecodedFrameCache(cache);
+    if (decodedFrame.GetImage() != decodedFrame.GetImage() || frameCopy.GetImage() != decodedFrame.GetImage()
+        || decodedFrame.GetScalarPointer() != decodedFrame.GetImage()->GetScalarPointer() || vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames != numberOfFrames)
+    {
+      LOG_ERROR("Decoded image was not reused");
+      return IGSIO_FAIL;
+    }
+
+    // Random access within the memory budget: a cold P-frame is decoded from its keyframe,
+    // then the next frame continues from the last decoded frame
+    cache->Clear();
+    cache->ResetStatistics();
+    cache->SetMaximumCachedBytes(3 * DECODE_TEST_FRAME_SIZE_IN_BYTES);
+    vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames = 0;
+    vtkSmartPointer<vtkImageData> image = cache->GetDecodedImage(stream[15]);
+    if (CheckDecodedImage(image, expectedPixelValues[15]) != IGSIO_SUCCESS || vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames != 6
+        || cache->GetNumberOfCachedImages() != 3 || cache->GetCachedBytes() > cache->GetMaximumCachedBytes())
+    {
+      LOG_ERROR("Decoding from the keyframe failed");
+      return IGSIO_FAIL;
+    }
+    if (CheckDecodedImage(cache->GetDecodedImage(stream[16]), expectedPixelValues[16]) != IGSIO_SUCCESS || vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames != 7)
+    {
+      LOG_ERROR("Decoding did not continue from the last decoded frame");
+      return IGSIO_FAIL;
+    }
+    // Recently decoded frames of the chain are in the cache, older ones are evicted
+    if (CheckDecodedImage(cache->GetDecodedImage(stream[14]), expectedPixelValues[14]) != IGSIO_SUCCESS || vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames != 7
+        || cache->GetNumberOfHits() != 1)
+    {
+      LOG_ERROR("Frame decoded along the chain was not cached");
+      return IGSIO_FAIL;
+    }
+    if (CheckDecodedImage(cache->GetDecodedImage(stream[12]), expectedPixelValues[12]) != IGSIO_SUCCESS || vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames != 10)
+    {
+      LOG_ERROR("Evicted frame was not decoded again from the keyframe");
+      return IGSIO_FAIL;
+    }
+
+    // Evicted images remain valid for their users
+    cache->SetMaximumCachedBytes(0);
+    if (cache->GetNumberOfCachedImages() != 0 || cache->GetCachedBytes() != 0 || CheckDecodedImage(image, expectedPixelValues[15]) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Evicted image was invalidated");
+      return IGSIO_FAIL;
+    }
+
+    // Interleaved access of two streams: each stream has its own decoder, so nothing is decoded twice
+    // even without caching images. With a single decoder each access restarts from the keyframe.
+    std::vector<unsigned char> otherExpectedPixelValues;
+    std::vector<vtkSmartPointer<vtkStreamingVolumeFrame> > otherStream = CreateEncodedStream(numberOfFrames, keyFrameInterval, otherExpectedPixelValues);
+    for (unsigned int numberOfDecoders = 2; numberOfDecoders > 0; --numberOfDecoders)
+    {
+      cache->Clear();
+      cache->SetMaximumNumberOfDecoders(numberOfDecoders);
+      vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames = 0;
+      for (int i = 0; i < numberOfFrames; ++i)
+      {
+        if (CheckDecodedImage(cache->GetDecodedImage(stream[i]), expectedPixelValues[i]) != IGSIO_SUCCESS
+            || CheckDecodedImage(cache->GetDecodedImage(otherStream[i]), otherExpectedPixelValues[i]) != IGSIO_SUCCESS)
+        {
+          LOG_ERROR("Interleaved decoding failed at frame " << i << " with " << numberOfDecoders << " decoders");
+          return IGSIO_FAIL;
+        }
+      }
+      LOG_INFO("Interleaved decoding of 2x" << numberOfFrames << " frames with " << numberOfDecoders << " decoders: "
+               << vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames << " frames decoded");
+      bool expectedNumberOfDecodedFrames = (numberOfDecoders == 2 ? vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames == 2 * numberOfFrames
+                                            : vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames > 2 * numberOfFrames);
+      if (!expectedNumberOfDecodedFrames)
+      {
+        LOG_ERROR("Unexpected number of decoded frames with " << numberOfDecoders << " decoders");
+        return IGSIO_FAIL;
+      }
+    }
+
+    // Changing the encoded frame drops the decoded image
+    igsioVideoFrame frame;
+    frame.SetDecodedFrameCache(cache);
+    frame.SetEncodedFrame(stream[0]);
+    vtkSmartPointer<vtkImageData> firstImage = frame.GetImage();
+    frame.SetEncodedFrame(stream[10]);
+    if (CheckDecodedImage(firstImage, expectedPixelValues[0]) != IGSIO_SUCCESS || frame.GetImage() == firstImage
+        || CheckDecodedImage(frame.GetImage(), expectedPixelValues[10]) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Decoded image was not updated after changing the encoded frame");
+      return IGSIO_FAIL;
+    }
+
+    // A moved frame keeps its decoded image, it is not decoded again
+    vtkImageData* decodedImage = frame.GetImage();
+    vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames = 0;
+    igsioVideoFrame movedFrame(std::move(frame));
+    if (movedFrame.GetImage() != decodedImage || vtkIGSIOTestDeltaCodec::NumberOfDecodedFrames != 0 || frame.GetImage() != NULL)
+    {
+      LOG_ERROR("Decoded image was not moved with the encoded frame");
+      return IGSIO_FAIL;
+    }
+
+    // The cache does not keep the encoded frames (and so their chain of previous frames) alive,
+    // only the decoder keeps a reference to the last decoded frame until the decoder is removed
+    cache->Clear();
+    cache->SetMaximumCachedBytes(numberOfFrames * DECODE_TEST_FRAME_SIZE_IN_BYTES);
+    std::vector<int> referenceCounts;
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      referenceCounts.push_back(stream[i]->GetReferenceCount());
+    }
+    if (CheckDecodedImage(cache->GetDecodedImage(stream[19]), expectedPixelValues[19]) != IGSIO_SUCCESS || cache->GetNumberOfCachedImages() == 0)
+    {
+      LOG_ERROR("Decoding the end of the stream failed");
+      return IGSIO_FAIL;
+    }
+    for (int i = 0; i < numberOfFrames - 1; ++i)
+    {
+      if (stream[i]->GetReferenceCount() != referenceCounts[i])
+      {
+        LOG_ERROR("Decoded frame cache holds a reference to encoded frame " << i);
+        return IGSIO_FAIL;
+      }
+    }
+    cache->Clear();
+    if (stream[19]->GetReferenceCount() != referenceCounts[19])
+    {
+      LOG_ERROR("Decoded frame cache holds a reference to the last decoded frame after clearing");
+      return IGSIO_FAIL;
+    }
+
+    // A modified encoded frame is not served from the cache
+    cache->GetDecodedImage(stream[19]);
+    cache->ResetStatistics();
+    cache->GetDecodedImage(stream[19]);
+    stream[19]->Modified();
+    if (CheckDecodedImage(cache->GetDecodedImage(stream[19]), expectedPixelValues[19]) != IGSIO_SUCCESS
+        || cache->GetNumberOfHits() != 1 || cache->GetNumberOfMisses() != 1)
+    {
+      LOG_ERROR("Cached image of a modified encoded frame was reused");
+      return IGSIO_FAIL;
+    }
+
+    // Concurrent first access of a shared frame decodes a single image
+    igsioVideoFrame sharedFrame;
+    sharedFrame.SetDecodedFrameCache(cache);
+    sharedFrame.SetEncodedFrame(stream[7]);
+    ConcurrentDecodeInfo info;
+    info.Frame = &sharedFrame;
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    threader->SetNumberOfThreads(4);
+    threader->SetSingleMethod(ConcurrentDecodeThreadFunction, &info);
+    threader->SingleMethodExecute();
+    for (int i = 0; i < 4; ++i)
+    {
+      if (info.Images[i] != sharedFrame.GetImage() || CheckDecodedImage(info.Images[i], expectedPixelValues[7]) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("Concurrent decoding returned a different image in thread " << i);
+        return IGSIO_FAIL;
+      }
+    }
+
+    return IGSIO_SUCCESS;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkIGSIOLogger::LOG_LEVEL_UNDEFINED;
+  int numberOfBenchmarkIterations = 20;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--numberOfBenchmarkIterations", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfBenchmarkIterations, "Number of times each image is flipped in the flip kernel benchmark (default: 20)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkIGSIOLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestCopyOnWrite() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Video frame copy-on-write test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestBufferPool() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Video frame buffer pool test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestAlignedAllocation() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Aligned frame allocation test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestReverseRow() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Row reversal kernel test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestFlipClipKernels(false) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Flip kernel test failed");
+    return EXIT_FAILURE;
+  }
+
+  // Use multiple threads even for the small test images
+  unsigned long long multiThreadingThresholdBytes = igsioVideoFrame::GetFlipClipMultiThreadingThresholdBytes();
+  igsioVideoFrame::SetFlipClipMultiThreadingThresholdBytes(0);
+  if (TestFlipClipKernels(true) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Multi-threaded flip kernel test failed");
+    return EXIT_FAILURE;
+  }
+  igsioVideoFrame::SetFlipClipMultiThreadingThresholdBytes(multiThreadingThresholdBytes);
+
+  if (BenchmarkFlipClipKernels(numberOfBenchmarkIterations) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Flip kernel benchmark failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestClipImage() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Clip image test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (BenchmarkClipImage(numberOfBenchmarkIterations) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Clip image benchmark failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestConvertPixelType(false) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Pixel type conversion test failed");
+    return EXIT_FAILURE;
+  }
+
+  // Use multiple threads even for the small test images
+  multiThreadingThresholdBytes = igsioVideoFrame::GetPixelConversionMultiThreadingThresholdBytes();
+  igsioVideoFrame::SetPixelConversionMultiThreadingThresholdBytes(0);
+  if (TestConvertPixelType(true) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Multi-threaded pixel type conversion test failed");
+    return EXIT_FAILURE;
+  }
+  igsioVideoFrame::SetPixelConversionMultiThreadingThresholdBytes(multiThreadingThresholdBytes);
+
+  if (BenchmarkConvertPixelType(numberOfBenchmarkIterations) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Pixel type conversion benchmark failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestLazyDecode() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Lazy decode test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test successfully completed");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,827 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "igsioCommon.h"
+#include "igsioTrackedFrame.h"
+#include "igsioTransformTable.h"
+#include "vtkIGSIOAccurateTimer.h"
+#include "vtkIGSIOTrackedFrameList.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtkSmartPointer.h>
+#include <vtkTransform.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STD includes
+#include <algorithm>
+#include <math.h>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  igsioStatus TestUniqueTimestampValidation()
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    trackedFrameList->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP);
+
+    igsioTrackedFrame trackedFrame;
+    for (int i = 0; i < 10; ++i)
+    {
+      trackedFrame.SetTimestamp(i);
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    }
+
+    // Duplicate timestamp is rejected
+    trackedFrame.SetTimestamp(5);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 10)
+    {
+      LOG_ERROR("Frame with duplicate timestamp was added to the list");
+      return IGSIO_FAIL;
+    }
+
+    // Timestamp can be used again after the frame is removed
+    trackedFrameList->RemoveTrackedFrame(5);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 10)
+    {
+      LOG_ERROR("Frame was not added after the frame with the same timestamp was removed");
+      return IGSIO_FAIL;
+    }
+    trackedFrameList->RemoveTrackedFrameRange(0, 2);
+    trackedFrame.SetTimestamp(1);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    trackedFrame.SetTimestamp(3);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 8)
+    {
+      LOG_ERROR("Unexpected number of frames after removing a range of frames: " << trackedFrameList->GetNumberOfTrackedFrames());
+      return IGSIO_FAIL;
+    }
+
+    // Timestamps that are modified in the list are taken into account without explicit invalidation
+    trackedFrameList->GetTrackedFrame(0)->SetTimestamp(100.0);
+    trackedFrame.SetTimestamp(100.0);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 8)
+    {
+      LOG_ERROR("Frame with duplicate timestamp was added to the list after a timestamp was modified in the list");
+      return IGSIO_FAIL;
+    }
+    // The old timestamp of the modified frame can be used again
+    trackedFrameList->GetTrackedFrame(1)->SetFrameField("Timestamp", "200");
+    trackedFrame.SetTimestamp(4.0);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    trackedFrame.SetTimestamp(200.0);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 9)
+    {
+      LOG_ERROR("Unexpected number of frames after a timestamp was modified in the list: " << trackedFrameList->GetNumberOfTrackedFrames());
+      return IGSIO_FAIL;
+    }
+    // Removing a frame with a modified timestamp keeps the index consistent
+    trackedFrameList->RemoveTrackedFrame(0);
+    trackedFrame.SetTimestamp(100.0);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 9)
+    {
+      LOG_ERROR("Frame was not added after the frame with a modified timestamp was removed");
+      return IGSIO_FAIL;
+    }
+
+    trackedFrameList->Clear();
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 1)
+    {
+      LOG_ERROR("Frame was not added to a cleared list");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestTransformInterpolation()
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    igsioTransformName probeToTracker("Probe", "Tracker");
+
+    // Probe rotates around Z by 0, 90, 180 degrees and translates along X by 0, 10, 20 mm
+    igsioTrackedFrame trackedFrame;
+    for (int i = 0; i < 3; ++i)
+    {
+      vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
+      transform->Translate(i * 10.0, 0, 0);
+      transform->RotateZ(i * 90.0);
+      trackedFrame.SetTimestamp(10.0 + i);
+      trackedFrame.SetFrameTransform(probeToTracker, transform->GetMatrix());
+      trackedFrame.SetFrameTransformStatus(probeToTracker, i == 2 ? TOOL_MISSING : TOOL_OK);
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    }
+
+    unsigned int frameIndex(0);
+    if (trackedFrameList->FindFrameIndexByTimestamp(10.4, frameIndex) != IGSIO_SUCCESS || frameIndex != 0
+        || trackedFrameList->FindFrameIndexByTimestamp(10.6, frameIndex) != IGSIO_SUCCESS || frameIndex != 1
+        || trackedFrameList->FindFrameIndexByTimestamp(100.0, frameIndex) != IGSIO_SUCCESS || frameIndex != 2)
+    {
+      LOG_ERROR("Closest frame was not found by timestamp");
+      return IGSIO_FAIL;
+    }
+
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    ToolStatus status(TOOL_INVALID);
+    if (trackedFrameList->GetInterpolatedTransform(probeToTracker, 10.5, matrix, &status) != IGSIO_SUCCESS || status != TOOL_OK)
+    {
+      LOG_ERROR("Failed to interpolate transform");
+      return IGSIO_FAIL;
+    }
+    // Halfway: 45 degrees rotation, 5 mm translation
+    const double cos45 = sqrt(0.5);
+    if (fabs(matrix->GetElement(0, 0) - cos45) > 1e-6 || fabs(matrix->GetElement(1, 0) - cos45) > 1e-6
+        || fabs(matrix->GetElement(0, 3) - 5.0) > 1e-6 || fabs(matrix->GetElement(1, 3)) > 1e-6)
+    {
+      LOG_ERROR("Unexpected interpolated transform: rotation " << matrix->GetElement(0, 0) << ", " << matrix->GetElement(1, 0)
+                << ", translation " << matrix->GetElement(0, 3));
+      return IGSIO_FAIL;
+    }
+
+    // Invalid neighbor makes the interpolated transform invalid
+    if (trackedFrameList->GetInterpolatedTransform(probeToTracker, 11.5, matrix, &status) != IGSIO_SUCCESS || status != TOOL_MISSING)
+    {
+      LOG_ERROR("Interpolated transform status does not reflect the invalid neighbor frame");
+      return IGSIO_FAIL;
+    }
+
+    // Out of range
+    if (trackedFrameList->GetInterpolatedTransform(probeToTracker, 9.0, matrix) == IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Transform interpolation succeeded outside of the time range of the list");
+      return IGSIO_FAIL;
+    }
+
+    // Out of order frame: sorted index is rebuilt
+    trackedFrame.SetTimestamp(9.0);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    if (trackedFrameList->FindFrameIndexByTimestamp(9.1, frameIndex) != IGSIO_SUCCESS || frameIndex != 3)
+    {
+      LOG_ERROR("Frame added out of timestamp order was not found");
+      return IGSIO_FAIL;
+    }
+
+    // Timestamp modified in the list: the frame is found at its new time
+    trackedFrameList->GetTrackedFrame(3)->SetTimestamp(12.5);
+    if (trackedFrameList->FindFrameIndexByTimestamp(12.4, frameIndex) != IGSIO_SUCCESS || frameIndex != 3
+        || trackedFrameList->FindFrameIndexByTimestamp(9.1, frameIndex) != IGSIO_SUCCESS || frameIndex != 0)
+    {
+      LOG_ERROR("Frame was not found by its modified timestamp");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  struct ConcurrentLookupInfo
+  {
+    vtkIGSIOTrackedFrameList* TrackedFrameList;
+    int NumberOfFrames;
+    int NumberOfErrors[16];
+  };
+
+  //----------------------------------------------------------------------------
+  VTK_THREAD_RETURN_TYPE ConcurrentLookupThreadFunction(void* arg)
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    ConcurrentLookupInfo* info = static_cast<ConcurrentLookupInfo*>(threadInfo->UserData);
+    for (int i = threadInfo->ThreadID; i < info->NumberOfFrames; i += threadInfo->NumberOfThreads)
+    {
+      // Frames are added in reverse timestamp order, so frame i has timestamp (NumberOfFrames - 1 - i)
+      unsigned int frameIndex(0);
+      if (info->TrackedFrameList->FindFrameIndexByTimestamp(info->NumberOfFrames - 1 - i + 0.1, frameIndex) != IGSIO_SUCCESS
+          || frameIndex != static_cast<unsigned int>(i))
+      {
+        info->NumberOfErrors[threadInfo->ThreadID]++;
+      }
+    }
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestConcurrentTimestampLookup()
+  {
+    const int numberOfFrames = 1000;
+    const int numberOfThreads = 4;
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    igsioTrackedFrame trackedFrame;
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      trackedFrame.SetTimestamp(numberOfFrames - 1 - i);
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    }
+
+    // The sorted index is not valid (frames were added in reverse order), all threads try to build it at the same time
+    ConcurrentLookupInfo info;
+    info.TrackedFrameList = trackedFrameList;
+    info.NumberOfFrames = numberOfFrames;
+    std::fill(info.NumberOfErrors, info.NumberOfErrors + numberOfThreads, 0);
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(ConcurrentLookupThreadFunction, &info);
+    threader->SingleMethodExecute();
+
+    for (int threadIndex = 0; threadIndex < numberOfThreads; ++threadIndex)
+    {
+      if (info.NumberOfErrors[threadIndex] > 0)
+      {
+        LOG_ERROR("Frames were not found by timestamp in thread " << threadIndex << ": " << info.NumberOfErrors[threadIndex] << " errors");
+        return IGSIO_FAIL;
+      }
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestRingBufferMode()
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    trackedFrameList->SetMaximumNumberOfFrames(5);
+
+    igsioTrackedFrame trackedFrame;
+    FrameSizeType frameSize = { 16, 16, 1 };
+    trackedFrame.GetImageData()->AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+    const unsigned long long frameSizeInBytes = 16 * 16;
+
+    // Oldest frames are evicted when the list is full
+    void* evictedFramePixels = NULL;
+    for (int i = 0; i < 12; ++i)
+    {
+      if (i == 11)
+      {
+        evictedFramePixels = trackedFrameList->GetTrackedFrame(0)->GetImageData()->GetScalarPointer();
+      }
+      trackedFrame.SetTimestamp(i);
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    }
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 5 || trackedFrameList->GetTrackedFrame(0)->GetTimestamp() != 7.0
+        || trackedFrameList->GetNumberOfEvictedFrames() != 7 || trackedFrameList->GetFrameMemoryBytes() != 5 * frameSizeInBytes)
+    {
+      LOG_ERROR("Unexpected list content in ring buffer mode: " << trackedFrameList->GetNumberOfTrackedFrames() << " frames, "
+                << trackedFrameList->GetNumberOfEvictedFrames() << " evicted, " << trackedFrameList->GetFrameMemoryBytes() << " bytes");
+      return IGSIO_FAIL;
+    }
+
+    // Pixel buffer of the evicted frame is reused by the added frame
+    if (trackedFrameList->GetTrackedFrame(4)->GetImageData()->GetScalarPointer() != evictedFramePixels)
+    {
+      LOG_ERROR("Pixel buffer of the evicted frame was not reused");
+      return IGSIO_FAIL;
+    }
+
+    // Timestamp lookup remains valid while frames are evicted
+    unsigned int frameIndex(0);
+    if (trackedFrameList->FindFrameIndexByTimestamp(9.2, frameIndex) != IGSIO_SUCCESS || frameIndex != 2)
+    {
+      LOG_ERROR("Frame was not found by timestamp after eviction: index " << frameIndex);
+      return IGSIO_FAIL;
+    }
+    trackedFrame.SetTimestamp(12);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    if (trackedFrameList->FindFrameIndexByTimestamp(9.2, frameIndex) != IGSIO_SUCCESS || frameIndex != 1)
+    {
+      LOG_ERROR("Frame was not found by timestamp after eviction: index " << frameIndex);
+      return IGSIO_FAIL;
+    }
+
+    // Byte budget
+    trackedFrameList->SetMaximumNumberOfFrames(0);
+    trackedFrameList->SetMaximumFrameMemoryBytes(3 * frameSizeInBytes);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 3 || trackedFrameList->GetTrackedFrame(0)->GetTimestamp() != 10.0)
+    {
+      LOG_ERROR("Memory limit is not applied to the frames already in the list");
+      return IGSIO_FAIL;
+    }
+    trackedFrame.SetTimestamp(13);
+    trackedFrameList->AddTrackedFrame(igsioTrackedFrame(trackedFrame), vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 3 || trackedFrameList->GetFrameMemoryBytes() != 3 * frameSizeInBytes)
+    {
+      LOG_ERROR("Memory limit is not respected when adding frames");
+      return IGSIO_FAIL;
+    }
+
+    // The most recent frame is kept even if it does not fit into the limit
+    trackedFrameList->SetMaximumFrameMemoryBytes(frameSizeInBytes / 2);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 1 || trackedFrameList->GetTrackedFrame(0)->GetTimestamp() != 13.0)
+    {
+      LOG_ERROR("The most recent frame was not kept");
+      return IGSIO_FAIL;
+    }
+
+    // Frame without pixel data does not keep the pixels of the evicted frame
+    trackedFrameList->SetMaximumFrameMemoryBytes(0);
+    trackedFrameList->SetMaximumNumberOfFrames(1);
+    igsioTrackedFrame imagelessFrame;
+    imagelessFrame.SetTimestamp(14);
+    trackedFrameList->AddTrackedFrame(&imagelessFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 1 || trackedFrameList->GetTrackedFrame(0)->GetTimestamp() != 14.0
+        || trackedFrameList->GetTrackedFrame(0)->GetImageData()->GetFrameSizeInBytes() != 0 || trackedFrameList->GetFrameMemoryBytes() != 0)
+    {
+      LOG_ERROR("Frame without pixel data was added with the pixels of the evicted frame");
+      return IGSIO_FAIL;
+    }
+
+    // Pixel data that is allocated after the frame is added is included in the memory usage
+    trackedFrameList->GetTrackedFrame(0)->GetImageData()->AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1);
+    if (trackedFrameList->GetFrameMemoryBytes() != frameSizeInBytes)
+    {
+      LOG_ERROR("Pixel data allocated after the frame was added is not included in the memory usage");
+      return IGSIO_FAIL;
+    }
+    trackedFrameList->SetMaximumNumberOfFrames(0);
+    trackedFrameList->SetMaximumFrameMemoryBytes(frameSizeInBytes + frameSizeInBytes / 2);
+    trackedFrame.SetTimestamp(15);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 1 || trackedFrameList->GetTrackedFrame(0)->GetTimestamp() != 15.0)
+    {
+      LOG_ERROR("Memory limit is not respected for pixel data allocated after the frame was added");
+      return IGSIO_FAIL;
+    }
+
+    // Memory usage follows reallocation and removal of frames
+    trackedFrameList->SetMaximumFrameMemoryBytes(0);
+    trackedFrame.SetTimestamp(16);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    FrameSizeType largerFrameSize = { 32, 16, 1 };
+    trackedFrameList->GetTrackedFrame(1)->GetImageData()->AllocateFrame(largerFrameSize, VTK_UNSIGNED_CHAR, 1);
+    if (trackedFrameList->GetFrameMemoryBytes() != 3 * frameSizeInBytes)
+    {
+      LOG_ERROR("Reallocated frame is not included in the memory usage: " << trackedFrameList->GetFrameMemoryBytes() << " bytes");
+      return IGSIO_FAIL;
+    }
+    trackedFrameList->RemoveTrackedFrame(0);
+    if (trackedFrameList->GetFrameMemoryBytes() != 2 * frameSizeInBytes)
+    {
+      LOG_ERROR("Removed frame is still included in the memory usage: " << trackedFrameList->GetFrameMemoryBytes() << " bytes");
+      return IGSIO_FAIL;
+    }
+    trackedFrameList->Clear();
+    if (trackedFrameList->GetFrameMemoryBytes() != 0)
+    {
+      LOG_ERROR("Memory usage is not zero after clearing the list: " << trackedFrameList->GetFrameMemoryBytes() << " bytes");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestFrameViews()
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    igsioTrackedFrame trackedFrame;
+    for (int i = 0; i < 10; ++i)
+    {
+      trackedFrame.SetTimestamp(i);
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    }
+
+    const vtkIGSIOTrackedFrameList::TrackedFrameListType& frames = trackedFrameList->GetTrackedFrameList();
+    vtkIGSIOTrackedFrameList::FrameView allFrames = trackedFrameList->GetFrameView();
+    if (allFrames.size() != 10 || allFrames[3] != frames[3] || allFrames[3] != trackedFrameList->GetTrackedFrame(3))
+    {
+      LOG_ERROR("View of all frames does not refer to the frames of the list");
+      return IGSIO_FAIL;
+    }
+
+    // Every 3rd frame of frames 2..9
+    vtkIGSIOTrackedFrameList::FrameView subsampled = trackedFrameList->GetFrameView(2, 100, 3);
+    const double expectedTimestamps[3] = { 2, 5, 8 };
+    unsigned int numberOfFrames = 0;
+    for (vtkIGSIOTrackedFrameList::FrameView::const_iterator frameIt = subsampled.begin(); frameIt != subsampled.end(); ++frameIt)
+    {
+      if (numberOfFrames >= 3 || (*frameIt)->GetTimestamp() != expectedTimestamps[numberOfFrames])
+      {
+        LOG_ERROR("Unexpected frame in subsampled view at position " << numberOfFrames);
+        return IGSIO_FAIL;
+      }
+      numberOfFrames++;
+    }
+    if (numberOfFrames != 3 || subsampled.size() != 3 || subsampled.GetFrameIndexInList(2) != 8)
+    {
+      LOG_ERROR("Unexpected number of frames in subsampled view: " << numberOfFrames);
+      return IGSIO_FAIL;
+    }
+
+    // Views of views
+    vtkIGSIOTrackedFrameList::FrameView nested = allFrames.GetSubRange(1, 8).GetSubsampled(2).GetSubRange(1, 2);
+    if (nested.size() != 2 || nested[0]->GetTimestamp() != 3 || nested[1]->GetTimestamp() != 5)
+    {
+      LOG_ERROR("Unexpected frames in nested view");
+      return IGSIO_FAIL;
+    }
+    if (!trackedFrameList->GetFrameView(20, 5).empty())
+    {
+      LOG_ERROR("View of an out-of-range interval is not empty");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestTransformTable()
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    igsioTransformName probeToTracker("Probe", "Tracker");
+    const unsigned int numberOfFrames = 50;
+    for (unsigned int i = 0; i < numberOfFrames; ++i)
+    {
+      igsioTrackedFrame trackedFrame;
+      trackedFrame.SetTimestamp(i * 0.1);
+      // Transform is missing from every 10th frame
+      if (i % 10 != 5)
+      {
+        vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+        matrix->SetElement(0, 3, i);
+        trackedFrame.SetFrameTransform(probeToTracker, matrix);
+        trackedFrame.SetFrameTransformStatus(probeToTracker, i % 2 == 0 ? TOOL_OK : TOOL_OUT_OF_VIEW);
+      }
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    }
+
+    igsioTransformTable table;
+    if (table.Build(trackedFrameList, probeToTracker, 4) != IGSIO_SUCCESS || table.GetNumberOfFrames() != numberOfFrames)
+    {
+      LOG_ERROR("Failed to build transform table");
+      return IGSIO_FAIL;
+    }
+
+    const double* timestamps = table.GetTimestamps();
+    const double* matrices = table.GetMatrices();
+    const ToolStatus* statuses = table.GetStatuses();
+    for (unsigned int i = 0; i < numberOfFrames; ++i)
+    {
+      bool defined = (i % 10 != 5);
+      ToolStatus expectedStatus = !defined ? TOOL_INVALID : (i % 2 == 0 ? TOOL_OK : TOOL_OUT_OF_VIEW);
+      double expectedTranslation = defined ? i : 0.0;
+      if (timestamps[i] != trackedFrameList->GetTrackedFrame(i)->GetTimestamp() || statuses[i] != expectedStatus
+          || matrices[16 * i + 3] != expectedTranslation || matrices[16 * i + 15] != 1.0)
+      {
+        LOG_ERROR("Unexpected transform table content at frame " << i);
+        return IGSIO_FAIL;
+      }
+    }
+    if (table.GetNumberOfValidFrames() != 25)
+    {
+      LOG_ERROR("Unexpected number of valid frames in transform table: " << table.GetNumberOfValidFrames());
+      return IGSIO_FAIL;
+    }
+
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    if (table.GetMatrix(12, matrix) != IGSIO_SUCCESS || matrix->GetElement(0, 3) != 12.0)
+    {
+      LOG_ERROR("Failed to get matrix from transform table");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  void SetProbePose(igsioTrackedFrame& trackedFrame, const igsioTransformName& transformName, double translationX, double rotationZDeg)
+  {
+    vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
+    transform->Translate(translationX, 0, 0);
+    transform->RotateZ(rotationZDeg);
+    trackedFrame.SetFrameTransform(transformName, transform->GetMatrix());
+    trackedFrame.SetFrameTransformStatus(transformName, TOOL_OK);
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestPoseIndexValidation()
+  {
+    igsioTransformName probeToTracker("Probe", "Tracker");
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    trackedFrameList->SetValidationRequirements(REQUIRE_CHANGED_TRANSFORM);
+    trackedFrameList->SetFrameTransformNameForValidation(probeToTracker);
+    trackedFrameList->SetMinRequiredTranslationDifferenceMm(1.0);
+    trackedFrameList->SetMinRequiredAngleDifferenceDeg(1.0);
+    trackedFrameList->SetNumberOfUniqueFrames(5);
+    trackedFrameList->ValidatePoseAgainstAllFramesOn();
+
+    // Forward sweep
+    igsioTrackedFrame trackedFrame;
+    for (int i = 0; i < 20; ++i)
+    {
+      SetProbePose(trackedFrame, probeToTracker, i * 2.0, 0);
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    }
+    // Backward sweep close to the already acquired poses, older than NumberOfUniqueFrames
+    for (int i = 19; i >= 0; --i)
+    {
+      SetProbePose(trackedFrame, probeToTracker, i * 2.0 + 0.3, 0.5);
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    }
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 20)
+    {
+      LOG_ERROR("Frames at already acquired poses were added: " << trackedFrameList->GetNumberOfTrackedFrames() << " frames in the list");
+      return IGSIO_FAIL;
+    }
+
+    // Same position, different orientation
+    SetProbePose(trackedFrame, probeToTracker, 0.0, 10.0);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 21)
+    {
+      LOG_ERROR("Frame with changed orientation was not added");
+      return IGSIO_FAIL;
+    }
+
+    // Pose of a removed frame is not in the index anymore
+    trackedFrameList->RemoveTrackedFrame(0);
+    SetProbePose(trackedFrame, probeToTracker, 0.2, 0);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 21)
+    {
+      LOG_ERROR("Frame at the pose of a removed frame was not added");
+      return IGSIO_FAIL;
+    }
+
+    // Changed tolerance: index is rebuilt
+    trackedFrameList->SetMinRequiredTranslationDifferenceMm(3.0);
+    SetProbePose(trackedFrame, probeToTracker, 5.0, 0);
+    trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    if (trackedFrameList->GetNumberOfTrackedFrames() != 21)
+    {
+      LOG_ERROR("Frame within the changed tolerance was added");
+      return IGSIO_FAIL;
+    }
+
+    // Encoder positions
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> encoderFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    encoderFrameList->SetValidationRequirements(REQUIRE_CHANGED_ENCODER_POSITION);
+    encoderFrameList->SetMinRequiredTranslationDifferenceMm(1.0);
+    encoderFrameList->SetMinRequiredAngleDifferenceDeg(1.0);
+    encoderFrameList->SetNumberOfUniqueFrames(2);
+    encoderFrameList->ValidatePoseAgainstAllFramesOn();
+    const double probePositions[6] = { 0.0, 5.0, 10.0, 15.0, 0.5, 7.0 };
+    for (int i = 0; i < 6; ++i)
+    {
+      igsioTrackedFrame encoderFrame;
+      encoderFrame.SetFrameField("ProbePosition", igsioCommon::ToString<double>(probePositions[i]));
+      encoderFrame.SetFrameField("ProbeRotation", "0");
+      encoderFrame.SetFrameField("TemplatePosition", "0");
+      encoderFrameList->AddTrackedFrame(&encoderFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    }
+    if (encoderFrameList->GetNumberOfTrackedFrames() != 5)
+    {
+      LOG_ERROR("Unexpected number of frames after encoder position validation: " << encoderFrameList->GetNumberOfTrackedFrames());
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  void SetBatchValidationRequirements(vtkIGSIOTrackedFrameList* trackedFrameList, const igsioTransformName& transformName)
+  {
+    trackedFrameList->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP | REQUIRE_TRACKING_OK | REQUIRE_SPEED_BELOW_THRESHOLD);
+    trackedFrameList->SetFrameTransformNameForValidation(transformName);
+    trackedFrameList->SetMaxAllowedTranslationSpeedMmPerSec(50.0);
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestBatchValidation(int numberOfFrames)
+  {
+    igsioTransformName probeToTracker("Probe", "Tracker");
+
+    // Input: every 7th frame has invalid status, every 11th frame repeats the previous timestamp,
+    // every 13th frame jumps away (too fast), then the next frame jumps back
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> inputList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    igsioTrackedFrame trackedFrame;
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      trackedFrame.SetTimestamp(i % 11 == 10 ? i - 1 : i);
+      SetProbePose(trackedFrame, probeToTracker, (i % 13 == 12 ? 1000.0 : i * 10.0), 0);
+      trackedFrame.SetFrameTransformStatus(probeToTracker, i % 7 == 6 ? TOOL_INVALID : TOOL_OK);
+      inputList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    }
+
+    // Reference: add the frames one by one
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> referenceList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    SetBatchValidationRequirements(referenceList, probeToTracker);
+    for (unsigned int i = 0; i < inputList->GetNumberOfTrackedFrames(); ++i)
+    {
+      referenceList->AddTrackedFrame(inputList->GetTrackedFrame(i), vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    }
+
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> batchList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    SetBatchValidationRequirements(batchList, probeToTracker);
+    batchList->SetNumberOfValidationThreads(4);
+    if (batchList->AddTrackedFrameList(inputList, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Failed to add tracked frame list");
+      return IGSIO_FAIL;
+    }
+
+    if (batchList->GetNumberOfTrackedFrames() != referenceList->GetNumberOfTrackedFrames())
+    {
+      LOG_ERROR("Batch validation accepted " << batchList->GetNumberOfTrackedFrames() << " frames, expected " << referenceList->GetNumberOfTrackedFrames());
+      return IGSIO_FAIL;
+    }
+    for (unsigned int i = 0; i < batchList->GetNumberOfTrackedFrames(); ++i)
+    {
+      if (batchList->GetTrackedFrame(i)->GetTimestamp() != referenceList->GetTrackedFrame(i)->GetTimestamp())
+      {
+        LOG_ERROR("Frame " << i << " differs from the frame added by single frame validation");
+        return IGSIO_FAIL;
+      }
+    }
+
+    const long requirements[3] = { REQUIRE_UNIQUE_TIMESTAMP, REQUIRE_TRACKING_OK, REQUIRE_SPEED_BELOW_THRESHOLD };
+    unsigned int numberOfFailedValidations = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+      if (batchList->GetNumberOfFailedValidations(requirements[i]) != referenceList->GetNumberOfFailedValidations(requirements[i])
+          || batchList->GetNumberOfFailedValidations(requirements[i]) == 0)
+      {
+        LOG_ERROR("Unexpected number of failed validations for requirement " << requirements[i] << ": " << batchList->GetNumberOfFailedValidations(requirements[i])
+                  << ", expected " << referenceList->GetNumberOfFailedValidations(requirements[i]));
+        return IGSIO_FAIL;
+      }
+      numberOfFailedValidations += batchList->GetNumberOfFailedValidations(requirements[i]);
+    }
+    if (numberOfFailedValidations + batchList->GetNumberOfTrackedFrames() != inputList->GetNumberOfTrackedFrames())
+    {
+      LOG_ERROR("Number of failed validations does not match the number of skipped frames");
+      return IGSIO_FAIL;
+    }
+    LOG_INFO("Batch validation skipped " << numberOfFailedValidations << " of " << inputList->GetNumberOfTrackedFrames() << " frames");
+
+    batchList->ResetValidationStatistics();
+    if (batchList->GetNumberOfFailedValidations(REQUIRE_TRACKING_OK) != 0)
+    {
+      LOG_ERROR("Validation statistics are not reset");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus BenchmarkPoseIndexValidation(int numberOfFrames)
+  {
+    igsioTransformName probeToTracker("Probe", "Tracker");
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    trackedFrameList->SetValidationRequirements(REQUIRE_CHANGED_TRANSFORM);
+    trackedFrameList->SetFrameTransformNameForValidation(probeToTracker);
+    trackedFrameList->SetMinRequiredTranslationDifferenceMm(0.5);
+    trackedFrameList->SetMinRequiredAngleDifferenceDeg(0.5);
+    trackedFrameList->ValidatePoseAgainstAllFramesOn();
+
+    igsioTrackedFrame trackedFrame;
+    double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      SetProbePose(trackedFrame, probeToTracker, i * 1.0, 0);
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME);
+    }
+    double elapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+    LOG_INFO("Added " << numberOfFrames << " frames with pose validation against all frames in " << elapsedTimeSec << " sec");
+
+    if (trackedFrameList->GetNumberOfTrackedFrames() != static_cast<unsigned int>(numberOfFrames))
+    {
+      LOG_ERROR("Unexpected number of frames: " << trackedFrameList->GetNumberOfTrackedFrames());
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus BenchmarkUniqueTimestampValidation(int numberOfFrames)
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    trackedFrameList->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP);
+
+    igsioTrackedFrame trackedFrame;
+    double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (int i = 0; i < numberOfFrames; ++i)
+    {
+      trackedFrame.SetTimestamp(i * 0.033);
+      if (trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME_AND_REPORT_ERROR) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("Failed to add frame " << i);
+        return IGSIO_FAIL;
+      }
+    }
+    double elapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+    LOG_INFO("Added " << numberOfFrames << " frames with unique timestamp validation in " << elapsedTimeSec << " sec");
+
+    if (trackedFrameList->GetNumberOfTrackedFrames() != static_cast<unsigned int>(numberOfFrames))
+    {
+      LOG_ERROR("Unexpected number of frames: " << trackedFrameList->GetNumberOfTrackedFrames());
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkIGSIOLogger::LOG_LEVEL_UNDEFINED;
+  int numberOfBenchmarkFrames = 100000;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--numberOfBenchmarkFrames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfBenchmarkFrames, "Number of frames added to the list in benchmarks (default: 100000)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkIGSIOLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestUniqueTimestampValidation() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Unique timestamp validation test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestTransformInterpolation() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Transform interpolation test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestConcurrentTimestampLookup() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Concurrent timestamp lookup test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestRingBufferMode() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Ring buffer mode test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestFrameViews() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Frame view test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestTransformTable() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Transform table test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestPoseIndexValidation() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Pose index validation test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestBatchValidation(1000) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Batch validation test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (BenchmarkPoseIndexValidation(numberOfBenchmarkFrames / 10) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Pose index validation benchmark failed");
+    return EXIT_FAILURE;
+  }
+
+  if (BenchmarkUniqueTimestampValidation(numberOfBenchmarkFrames) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Unique timestamp validation benchmark failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test successfully completed");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,191 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+// Local includes
+#include "igsioCommon.h"
+#include "igsioTrackedFrame.h"
+#include "vtkIGSIOTrackedFrameList.h"
+#include "vtkIGSIOTrackedFrameQueue.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STD includes
+#include <thread>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  igsioTrackedFrame* CreateFrame(double timestamp)
+  {
+    igsioTrackedFrame* trackedFrame = new igsioTrackedFrame();
+    trackedFrame->SetTimestamp(timestamp);
+    return trackedFrame;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestBackPressurePolicies()
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameQueue> queue = vtkSmartPointer<vtkIGSIOTrackedFrameQueue>::New();
+    queue->SetCapacity(3);
+
+    // Producer gives up waiting for space after the timeout
+    for (int i = 0; i < 3; ++i)
+    {
+      queue->Push(CreateFrame(i));
+    }
+    if (queue->Push(CreateFrame(3), 0.01) == IGSIO_SUCCESS || queue->GetNumberOfProducerWaits() != 1)
+    {
+      LOG_ERROR("Frame was pushed into a full queue");
+      return IGSIO_FAIL;
+    }
+
+    queue->SetBackPressurePolicy(vtkIGSIOTrackedFrameQueue::DROP_NEWEST);
+    if (queue->Push(CreateFrame(3)) == IGSIO_SUCCESS || queue->GetNumberOfDroppedFrames() != 1)
+    {
+      LOG_ERROR("New frame was not dropped from a full queue");
+      return IGSIO_FAIL;
+    }
+
+    queue->SetBackPressurePolicy(vtkIGSIOTrackedFrameQueue::DROP_OLDEST);
+    igsioTrackedFrame movedFrame;
+    movedFrame.SetTimestamp(4);
+    if (queue->Push(std::move(movedFrame)) != IGSIO_SUCCESS || queue->GetNumberOfDroppedFrames() != 2)
+    {
+      LOG_ERROR("Oldest frame was not dropped from a full queue");
+      return IGSIO_FAIL;
+    }
+
+    // Remaining frames come out in order
+    double expectedTimestamps[3] = { 1, 2, 4 };
+    for (int i = 0; i < 3; ++i)
+    {
+      igsioTrackedFrame* trackedFrame = queue->TryPop();
+      if (trackedFrame == NULL || trackedFrame->GetTimestamp() != expectedTimestamps[i])
+      {
+        LOG_ERROR("Unexpected frame popped from the queue at position " << i);
+        delete trackedFrame;
+        return IGSIO_FAIL;
+      }
+      delete trackedFrame;
+    }
+    if (queue->TryPop() != NULL || queue->GetHighWaterMark() != 3)
+    {
+      LOG_ERROR("Unexpected queue state after popping all frames");
+      return IGSIO_FAIL;
+    }
+
+    // Closed queue releases the consumer and rejects frames
+    queue->Close();
+    if (queue->Pop() != NULL || queue->Push(CreateFrame(5)) == IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Closed queue accepted a frame");
+      return IGSIO_FAIL;
+    }
+
+    // Frames are moved to a list without copying
+    queue->Open();
+    igsioTrackedFrame* queuedFrame = CreateFrame(6);
+    queue->Push(queuedFrame);
+    queue->Push(CreateFrame(7));
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    if (queue->PopAllToTrackedFrameList(trackedFrameList) != IGSIO_SUCCESS || trackedFrameList->GetNumberOfTrackedFrames() != 2
+        || trackedFrameList->GetTrackedFrame(0) != queuedFrame || queue->GetNumberOfFrames() != 0)
+    {
+      LOG_ERROR("Frames were not moved from the queue to the list");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus TestProducerConsumer(int numberOfFrames)
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameQueue> queue = vtkSmartPointer<vtkIGSIOTrackedFrameQueue>::New();
+    queue->SetCapacity(8);
+
+    std::thread producer([&queue, numberOfFrames]()
+    {
+      for (int i = 0; i < numberOfFrames; ++i)
+      {
+        queue->Push(CreateFrame(i));
+      }
+      queue->Close();
+    });
+
+    // Consumer: frames must arrive in order, none of them lost
+    igsioStatus status = IGSIO_SUCCESS;
+    int numberOfReceivedFrames = 0;
+    igsioTrackedFrame* trackedFrame = NULL;
+    while ((trackedFrame = queue->Pop()) != NULL)
+    {
+      if (trackedFrame->GetTimestamp() != numberOfReceivedFrames)
+      {
+        LOG_ERROR("Frame received out of order: " << trackedFrame->GetTimestamp() << ", expected " << numberOfReceivedFrames);
+        status = IGSIO_FAIL;
+      }
+      numberOfReceivedFrames++;
+      delete trackedFrame;
+    }
+    producer.join();
+
+    if (numberOfReceivedFrames != numberOfFrames || queue->GetNumberOfDroppedFrames() != 0)
+    {
+      LOG_ERROR("Received " << numberOfReceivedFrames << " frames out of " << numberOfFrames);
+      return IGSIO_FAIL;
+    }
+    LOG_INFO("Passed " << numberOfFrames << " frames between threads, high-water mark: " << queue->GetHighWaterMark()
+             << ", producer waits: " << queue->GetNumberOfProducerWaits());
+
+    return status;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkIGSIOLogger::LOG_LEVEL_UNDEFINED;
+  int numberOfFrames = 10000;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--numberOfFrames", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfFrames, "Number of frames passed from the producer to the consumer thread (default: 10000)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkIGSIOLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestBackPressurePolicies() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Back-pressure policy test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestProducerConsumer(numberOfFrames) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Producer-consumer test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test successfully completed");
+  return EXIT_SUCCESS;
+}
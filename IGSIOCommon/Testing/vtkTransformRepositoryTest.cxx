@@ -12,21 +12,590 @@
 #include "vtkMatrix4x4.h"
 #include "vtkIGSIOTransformRepository.h"
 #include "igsioTrackedFrame.h"
+#include "vtkIGSIOTrackedFrameList.h"
 #include <vtkXMLDataElement.h>
 #include "igsioXmlUtils.h"
 
 #include "igsioMath.h"
+#include "vtkIGSIOAccurateTimer.h"
 #include "vtkXMLUtilities.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /*! Set up the coordinate frames of a typical tracked ultrasound and navigation setup (10 coordinate frames) */
+  void SetUpBenchmarkCoordinateFrames(vtkIGSIOTransformRepository* transformRepository)
+  {
+    const char* transformNames[][2] =
+    {
+      { "Image", "Probe" },
+      { "TransducerOriginPixel", "Image" },
+      { "Probe", "Tracker" },
+      { "Reference", "Tracker" },
+      { "Stylus", "Tracker" },
+      { "StylusTip", "Stylus" },
+      { "Needle", "Tracker" },
+      { "NeedleTip", "Needle" },
+      { "Ras", "Reference" }
+    };
+    for (size_t i = 0; i < sizeof(transformNames) / sizeof(transformNames[0]); ++i)
+    {
+      vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      matrix->SetElement(0, 3, static_cast<double>(i));
+      transformRepository->SetTransform(igsioTransformName(transformNames[i][0], transformNames[i][1]), matrix);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus CompareTransformQueryResult(vtkIGSIOTransformRepository* transformRepository, vtkIGSIOTransformRepository::TransformQuery& query)
+  {
+    vtkSmartPointer<vtkMatrix4x4> expected = vtkSmartPointer<vtkMatrix4x4>::New();
+    ToolStatus expectedStatus = TOOL_OK; // not set by GetTransform for identity transforms
+    if (transformRepository->GetTransform(query.GetTransformName(), expected, &expectedStatus) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Failed to get " << query.GetTransformName().GetTransformName() << " transform");
+      return IGSIO_FAIL;
+    }
+    double actual[16];
+    ToolStatus actualStatus = TOOL_INVALID;
+    if (transformRepository->GetTransform(query, actual, &actualStatus) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Failed to get " << query.GetTransformName().GetTransformName() << " transform from compiled query");
+      return IGSIO_FAIL;
+    }
+    if (actualStatus != expectedStatus)
+    {
+      LOG_ERROR("Compiled query status mismatch for " << query.GetTransformName().GetTransformName() << ": " << actualStatus << " (expected " << expectedStatus << ")");
+      return IGSIO_FAIL;
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+      if (fabs(actual[i] - expected->GetElement(i / 4, i % 4)) > 1e-9)
+      {
+        LOG_ERROR("Compiled query result mismatch for " << query.GetTransformName().GetTransformName() << " at element " << i
+                  << ": " << actual[i] << " (expected " << expected->GetElement(i / 4, i % 4) << ")");
+        return IGSIO_FAIL;
+      }
+    }
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Check that compiled transform queries give the same result as GetTransform with the transform name */
+  igsioStatus TestCompiledTransformQuery()
+  {
+    vtkSmartPointer<vtkIGSIOTransformRepository> transformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+    SetUpBenchmarkCoordinateFrames(transformRepository);
+
+    // Rigid and non-rigid (scaled, as image to probe calibrations) transforms
+    vtkSmartPointer<vtkTransform> imageToProbe = vtkSmartPointer<vtkTransform>::New();
+    imageToProbe->Translate(10, -20, 5);
+    imageToProbe->RotateWXYZ(30, 1, 2, 3);
+    imageToProbe->Scale(0.2, 0.25, 0.3);
+    transformRepository->SetTransform(igsioTransformName("Image", "Probe"), imageToProbe->GetMatrix());
+    vtkSmartPointer<vtkTransform> referenceToTracker = vtkSmartPointer<vtkTransform>::New();
+    referenceToTracker->RotateWXYZ(-70, 0.3, 0.1, 1);
+    referenceToTracker->Translate(100, 40, -300);
+    transformRepository->SetTransform(igsioTransformName("Reference", "Tracker"), referenceToTracker->GetMatrix());
+
+    const char* transformNames[][2] =
+    {
+      { "Image", "Reference" },
+      { "Reference", "Image" },
+      { "StylusTip", "Ras" },
+      { "Ras", "NeedleTip" },
+      { "Probe", "Tracker" },
+      { "Image", "Image" }
+    };
+    const int numberOfTransforms = sizeof(transformNames) / sizeof(transformNames[0]);
+    vtkIGSIOTransformRepository::TransformQuery queries[numberOfTransforms];
+    for (int i = 0; i < numberOfTransforms; ++i)
+    {
+      if (transformRepository->CompileTransformQuery(igsioTransformName(transformNames[i][0], transformNames[i][1]), queries[i]) != IGSIO_SUCCESS
+          || CompareTransformQueryResult(transformRepository, queries[i]) != IGSIO_SUCCESS)
+      {
+        return IGSIO_FAIL;
+      }
+    }
+
+    // Matrix and status updates are used without recompiling the queries
+    vtkSmartPointer<vtkTransform> probeToTracker = vtkSmartPointer<vtkTransform>::New();
+    probeToTracker->RotateWXYZ(45, 1, 0, 0);
+    probeToTracker->Translate(3, 4, 5);
+    transformRepository->SetTransform(igsioTransformName("Probe", "Tracker"), probeToTracker->GetMatrix(), TOOL_OUT_OF_VIEW);
+    for (int i = 0; i < numberOfTransforms; ++i)
+    {
+      if (CompareTransformQueryResult(transformRepository, queries[i]) != IGSIO_SUCCESS)
+      {
+        return IGSIO_FAIL;
+      }
+    }
+
+    // Deleting a transform of the path makes the query fail, adding it back makes it work again
+    transformRepository->DeleteTransform(igsioTransformName("Probe", "Tracker"));
+    ToolStatus status = TOOL_OK;
+    double matrixElements[16];
+    if (transformRepository->GetTransform(queries[0], matrixElements, &status) == IGSIO_SUCCESS || status != TOOL_PATH_NOT_FOUND)
+    {
+      LOG_ERROR("Compiled query did not detect that a transform has been deleted from its path");
+      return IGSIO_FAIL;
+    }
+    transformRepository->SetTransform(igsioTransformName("Tracker", "Probe"), probeToTracker->GetMatrix());
+    for (int i = 0; i < numberOfTransforms; ++i)
+    {
+      if (CompareTransformQueryResult(transformRepository, queries[i]) != IGSIO_SUCCESS)
+      {
+        return IGSIO_FAIL;
+      }
+    }
+
+    // A query cannot be used with another repository
+    vtkSmartPointer<vtkIGSIOTransformRepository> otherTransformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+    if (otherTransformRepository->GetTransform(queries[0], matrixElements) == IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Compiled query was accepted by another transform repository");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus CompareMatrixElements(const double* actual, vtkMatrix4x4* expected, const std::string& description)
+  {
+    for (int i = 0; i < 16; ++i)
+    {
+      if (fabs(actual[i] - expected->GetElement(i / 4, i % 4)) > 1e-9)
+      {
+        LOG_ERROR(description << " mismatch at element " << i << ": " << actual[i] << " (expected " << expected->GetElement(i / 4, i % 4) << ")");
+        return IGSIO_FAIL;
+      }
+    }
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Check that transforms computed from the transform history are the same as transforms set frame by frame */
+  igsioStatus TestTransformHistory()
+  {
+    const int numberOfFrames = 20;
+    const double firstTimestamp = 100.0;
+    const double frameTime = 0.1;
+
+    // Frames are added in reverse order to check that the history is sorted by time
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    for (int frameIndex = numberOfFrames - 1; frameIndex >= 0; --frameIndex)
+    {
+      igsioTrackedFrame trackedFrame;
+      trackedFrame.SetTimestamp(firstTimestamp + frameIndex * frameTime);
+      vtkSmartPointer<vtkTransform> probeToTracker = vtkSmartPointer<vtkTransform>::New();
+      probeToTracker->Translate(frameIndex, 10, -2 * frameIndex);
+      probeToTracker->RotateWXYZ(3 * frameIndex, 1, 1, 0);
+      trackedFrame.SetFrameTransform(igsioTransformName("Probe", "Tracker"), probeToTracker->GetMatrix());
+      trackedFrame.SetFrameTransformStatus(igsioTransformName("Probe", "Tracker"), frameIndex == 5 ? TOOL_OUT_OF_VIEW : TOOL_OK);
+      // Stored as TrackerToReference, while the repository has ReferenceToTracker
+      vtkSmartPointer<vtkTransform> trackerToReference = vtkSmartPointer<vtkTransform>::New();
+      trackerToReference->RotateWXYZ(-2 * frameIndex, 0, 0, 1);
+      trackerToReference->Translate(0, 0.5 * frameIndex, 30);
+      trackedFrame.SetFrameTransform(igsioTransformName("Tracker", "Reference"), trackerToReference->GetMatrix());
+      trackedFrame.SetFrameTransformStatus(igsioTransformName("Tracker", "Reference"), TOOL_OK);
+      trackedFrameList->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::ADD_INVALID_FRAME);
+    }
+
+    vtkSmartPointer<vtkTransform> imageToProbe = vtkSmartPointer<vtkTransform>::New();
+    imageToProbe->Translate(10, -20, 5);
+    imageToProbe->Scale(0.2, 0.25, 0.3);
+
+    vtkSmartPointer<vtkIGSIOTransformRepository> historyRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+    historyRepository->SetTransform(igsioTransformName("Image", "Probe"), imageToProbe->GetMatrix());
+    historyRepository->SetTransform(igsioTransformName("Reference", "Tracker"), vtkSmartPointer<vtkMatrix4x4>::New());
+    if (historyRepository->SetTransformHistory(trackedFrameList) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Failed to set transform history");
+      return IGSIO_FAIL;
+    }
+    double startTime(0);
+    double endTime(0);
+    if (historyRepository->GetTransformHistoryTimeRange(startTime, endTime) != IGSIO_SUCCESS
+        || startTime != firstTimestamp || fabs(endTime - (firstTimestamp + (numberOfFrames - 1) * frameTime)) > 1e-9)
+    {
+      LOG_ERROR("Unexpected transform history time range: " << startTime << " - " << endTime);
+      return IGSIO_FAIL;
+    }
+
+    // The transform at each frame time is the same as after setting the frame transforms
+    vtkSmartPointer<vtkIGSIOTransformRepository> frameRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+    frameRepository->SetTransform(igsioTransformName("Image", "Probe"), imageToProbe->GetMatrix());
+    vtkSmartPointer<vtkMatrix4x4> expected = vtkSmartPointer<vtkMatrix4x4>::New();
+    double actual[16];
+    for (unsigned int frameIndex = 0; frameIndex < trackedFrameList->GetNumberOfTrackedFrames(); ++frameIndex)
+    {
+      igsioTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(frameIndex);
+      frameRepository->SetTransforms(*trackedFrame);
+      const char* transformNames[][2] = { { "Image", "Reference" }, { "Reference", "Probe" }, { "Tracker", "Image" } };
+      for (int i = 0; i < 3; ++i)
+      {
+        igsioTransformName transformName(transformNames[i][0], transformNames[i][1]);
+        ToolStatus expectedStatus(TOOL_INVALID);
+        ToolStatus actualStatus(TOOL_INVALID);
+        // Query slightly off the frame time, the closest frame is used
+        double queryTime = trackedFrame->GetTimestamp() + (frameIndex % 2 == 0 ? 0.3 : -0.3) * frameTime;
+        queryTime = std::max(startTime, std::min(endTime, queryTime));
+        if (frameRepository->GetTransform(transformName, expected, &expectedStatus) != IGSIO_SUCCESS
+            || historyRepository->GetTransformAtTime(transformName, queryTime, actual, &actualStatus) != IGSIO_SUCCESS
+            || CompareMatrixElements(actual, expected, transformName.GetTransformName() + " from history") != IGSIO_SUCCESS
+            || actualStatus != expectedStatus)
+        {
+          LOG_ERROR("Failed to get " << transformName.GetTransformName() << " from transform history at time " << queryTime);
+          return IGSIO_FAIL;
+        }
+      }
+    }
+
+    // Interpolation between frames
+    double midTime = firstTimestamp + 7.5 * frameTime;
+    double interpolatedProbeToTracker[16];
+    if (trackedFrameList->GetInterpolatedTransform(igsioTransformName("Probe", "Tracker"), midTime, interpolatedProbeToTracker) != IGSIO_SUCCESS
+        || historyRepository->GetTransformAtTime(igsioTransformName("Tracker", "Probe"), midTime, actual, NULL, true) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Failed to get interpolated transform");
+      return IGSIO_FAIL;
+    }
+    expected->DeepCopy(interpolatedProbeToTracker);
+    expected->Invert();
+    if (CompareMatrixElements(actual, expected, "Interpolated TrackerToProbe") != IGSIO_SUCCESS)
+    {
+      return IGSIO_FAIL;
+    }
+
+    // Out of the time range of the history
+    if (historyRepository->GetTransformAtTime(igsioTransformName("Image", "Reference"), endTime + 1.0, actual) == IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Getting a transform out of the time range of the history did not fail");
+      return IGSIO_FAIL;
+    }
+
+    // Transforms without history don't need time range
+    historyRepository->ClearTransformHistory();
+    if (historyRepository->GetTransformAtTime(igsioTransformName("Image", "Probe"), endTime + 1.0, actual) != IGSIO_SUCCESS
+        || historyRepository->GetTransformHistoryTimeRange(startTime, endTime) == IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Unexpected result after clearing the transform history");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Check that getting transforms by coordinate frame IDs gives the same result as by transform names */
+  igsioStatus TestCoordinateFrameIds()
+  {
+    vtkSmartPointer<vtkIGSIOTransformRepository> transformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+    SetUpBenchmarkCoordinateFrames(transformRepository);
+    vtkSmartPointer<vtkTransform> imageToProbe = vtkSmartPointer<vtkTransform>::New();
+    imageToProbe->Translate(10, -20, 5);
+    imageToProbe->RotateWXYZ(30, 1, 2, 3);
+    imageToProbe->Scale(0.2, 0.25, 0.3);
+    transformRepository->SetTransform(igsioTransformName("Image", "Probe"), imageToProbe->GetMatrix());
+    transformRepository->SetTransformStatus(igsioTransformName("Stylus", "Tracker"), TOOL_OUT_OF_VIEW);
+
+    if (transformRepository->GetCoordinateFrameId("Unknown") != -1 || !transformRepository->GetCoordinateFrameName(100).empty())
+    {
+      LOG_ERROR("Unknown coordinate frame has an ID or name");
+      return IGSIO_FAIL;
+    }
+
+    const char* transformNames[][2] =
+    {
+      { "Image", "Reference" },
+      { "Ras", "Image" },
+      { "StylusTip", "NeedleTip" },
+      { "Tracker", "Probe" },
+      { "Ras", "Ras" }
+    };
+    const int numberOfTransforms = sizeof(transformNames) / sizeof(transformNames[0]);
+    vtkSmartPointer<vtkMatrix4x4> expected = vtkSmartPointer<vtkMatrix4x4>::New();
+    double actual[16];
+    for (int i = 0; i < numberOfTransforms; ++i)
+    {
+      igsioTransformName transformName(transformNames[i][0], transformNames[i][1]);
+      int fromId = transformRepository->GetCoordinateFrameId(transformNames[i][0]);
+      int toId = transformRepository->GetCoordinateFrameId(transformNames[i][1]);
+      if (fromId < 0 || toId < 0 || transformRepository->GetCoordinateFrameName(fromId) != transformNames[i][0])
+      {
+        LOG_ERROR("Invalid coordinate frame IDs for " << transformName.GetTransformName() << ": " << fromId << ", " << toId);
+        return IGSIO_FAIL;
+      }
+      ToolStatus expectedStatus = TOOL_UNKNOWN;
+      ToolStatus actualStatus = TOOL_UNKNOWN;
+      if (transformRepository->GetTransform(transformName, expected, &expectedStatus) != IGSIO_SUCCESS
+          || transformRepository->GetTransform(fromId, toId, actual, &actualStatus) != IGSIO_SUCCESS
+          || CompareMatrixElements(actual, expected, transformName.GetTransformName() + " by coordinate frame IDs") != IGSIO_SUCCESS
+          || actualStatus != expectedStatus)
+      {
+        LOG_ERROR("Failed to get " << transformName.GetTransformName() << " by coordinate frame IDs");
+        return IGSIO_FAIL;
+      }
+    }
+
+    // IDs don't change when transforms are deleted and added back
+    int needleTipId = transformRepository->GetCoordinateFrameId("NeedleTip");
+    int trackerId = transformRepository->GetCoordinateFrameId("Tracker");
+    transformRepository->DeleteTransform(igsioTransformName("NeedleTip", "Needle"));
+    ToolStatus status = TOOL_OK;
+    if (transformRepository->GetCoordinateFrameId("NeedleTip") != needleTipId
+        || transformRepository->GetTransform(needleTipId, trackerId, actual, &status) == IGSIO_SUCCESS || status != TOOL_PATH_NOT_FOUND)
+    {
+      LOG_ERROR("Unexpected result of getting a deleted transform by coordinate frame IDs");
+      return IGSIO_FAIL;
+    }
+    transformRepository->SetTransform(igsioTransformName("Needle", "NeedleTip"), imageToProbe->GetMatrix());
+    if (transformRepository->GetCoordinateFrameId("NeedleTip") != needleTipId
+        || transformRepository->GetTransform(igsioTransformName("NeedleTip", "Tracker"), expected) != IGSIO_SUCCESS
+        || transformRepository->GetTransform(needleTipId, trackerId, actual) != IGSIO_SUCCESS
+        || CompareMatrixElements(actual, expected, "NeedleTipToTracker by coordinate frame IDs") != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Failed to get NeedleTipToTracker by coordinate frame IDs after adding the transform back");
+      return IGSIO_FAIL;
+    }
+
+    // Invalid IDs
+    if (transformRepository->GetTransform(-1, trackerId, actual) == IGSIO_SUCCESS || transformRepository->GetTransform(trackerId, 100, actual) == IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Getting a transform by invalid coordinate frame IDs did not fail");
+      return IGSIO_FAIL;
+    }
+
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Measure the time of GetTransform calls with and without the transform path cache.
+    In each iteration the tracker transforms are updated (as for each acquired frame) and
+    the transforms that are typically needed for each frame are queried.
+  */
+  igsioStatus BenchmarkGetTransform(int numberOfIterations)
+  {
+    const char* queriedTransformNames[][2] =
+    {
+      { "Image", "Reference" },
+      { "Image", "Ras" },
+      { "StylusTip", "Ras" },
+      { "NeedleTip", "Image" }
+    };
+    const int numberOfQueriedTransforms = sizeof(queriedTransformNames) / sizeof(queriedTransformNames[0]);
+
+    // Modes: 0 = path cache disabled, 1 = path cache enabled, 2 = compiled transform queries, 3 = coordinate frame IDs
+    const int numberOfModes = 4;
+    double timePerQueryUsec[numberOfModes] = { 0, 0, 0, 0 };
+    vtkSmartPointer<vtkMatrix4x4> results[numberOfModes][numberOfQueriedTransforms];
+    for (int mode = 0; mode < numberOfModes; ++mode)
+    {
+      vtkSmartPointer<vtkIGSIOTransformRepository> transformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+      transformRepository->SetTransformPathCacheEnabled(mode != 0);
+      SetUpBenchmarkCoordinateFrames(transformRepository);
+
+      vtkIGSIOTransformRepository::TransformQuery queries[numberOfQueriedTransforms];
+      for (int i = 0; i < numberOfQueriedTransforms; ++i)
+      {
+        if (transformRepository->CompileTransformQuery(igsioTransformName(queriedTransformNames[i][0], queriedTransformNames[i][1]), queries[i]) != IGSIO_SUCCESS)
+        {
+          LOG_ERROR("Failed to compile " << queriedTransformNames[i][0] << "To" << queriedTransformNames[i][1] << " transform query");
+          return IGSIO_FAIL;
+        }
+      }
+      int coordinateFrameIds[numberOfQueriedTransforms][2];
+      for (int i = 0; i < numberOfQueriedTransforms; ++i)
+      {
+        coordinateFrameIds[i][0] = transformRepository->GetCoordinateFrameId(queriedTransformNames[i][0]);
+        coordinateFrameIds[i][1] = transformRepository->GetCoordinateFrameId(queriedTransformNames[i][1]);
+      }
+
+      vtkSmartPointer<vtkMatrix4x4> probeToTracker = vtkSmartPointer<vtkMatrix4x4>::New();
+      vtkSmartPointer<vtkMatrix4x4> result = vtkSmartPointer<vtkMatrix4x4>::New();
+      double resultElements[16];
+      double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+      for (int iteration = 0; iteration < numberOfIterations; ++iteration)
+      {
+        probeToTracker->SetElement(1, 3, iteration);
+        transformRepository->SetTransform(igsioTransformName("Probe", "Tracker"), probeToTracker);
+        for (int i = 0; i < numberOfQueriedTransforms; ++i)
+        {
+          ToolStatus status = TOOL_INVALID;
+          igsioStatus getStatus(IGSIO_FAIL);
+          switch (mode)
+          {
+            case 2:
+              getStatus = transformRepository->GetTransform(queries[i], resultElements, &status);
+              break;
+            case 3:
+              getStatus = transformRepository->GetTransform(coordinateFrameIds[i][0], coordinateFrameIds[i][1], resultElements, &status);
+              break;
+            default:
+              getStatus = transformRepository->GetTransform(igsioTransformName(queriedTransformNames[i][0], queriedTransformNames[i][1]), result, &status);
+          }
+          if (getStatus != IGSIO_SUCCESS || status != TOOL_OK)
+          {
+            LOG_ERROR("Failed to get " << queriedTransformNames[i][0] << "To" << queriedTransformNames[i][1] << " transform");
+            return IGSIO_FAIL;
+          }
+        }
+      }
+      double elapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+      timePerQueryUsec[mode] = elapsedTimeSec * 1e6 / (static_cast<double>(numberOfIterations) * numberOfQueriedTransforms);
+
+      // Keep the last results for comparison
+      for (int i = 0; i < numberOfQueriedTransforms; ++i)
+      {
+        results[mode][i] = vtkSmartPointer<vtkMatrix4x4>::New();
+        if (mode == 2)
+        {
+          transformRepository->GetTransform(queries[i], results[mode][i]);
+        }
+        else if (mode == 3)
+        {
+          transformRepository->GetTransform(coordinateFrameIds[i][0], coordinateFrameIds[i][1], resultElements);
+          results[mode][i]->DeepCopy(resultElements);
+        }
+        else
+        {
+          transformRepository->GetTransform(igsioTransformName(queriedTransformNames[i][0], queriedTransformNames[i][1]), results[mode][i]);
+        }
+      }
+      if (mode == 1 && transformRepository->GetNumberOfCachedTransformPaths() != numberOfQueriedTransforms)
+      {
+        LOG_ERROR("Unexpected number of cached transform paths: " << transformRepository->GetNumberOfCachedTransformPaths());
+        return IGSIO_FAIL;
+      }
+    }
+
+    for (int mode = 1; mode < numberOfModes; ++mode)
+    {
+      for (int i = 0; i < numberOfQueriedTransforms; ++i)
+      {
+        if (igsioMath::GetPositionDifference(results[0][i], results[mode][i]) > 1e-6 || igsioMath::GetOrientationDifference(results[0][i], results[mode][i]) > 1e-6)
+        {
+          LOG_ERROR("Mismatch between transforms computed with and without the path cache, compiled query or coordinate frame IDs");
+          return IGSIO_FAIL;
+        }
+      }
+    }
+
+    LOG_INFO("GetTransform in a 10 coordinate frame graph: " << timePerQueryUsec[0] << " usec/query without path cache, "
+             << timePerQueryUsec[1] << " usec/query with path cache, " << timePerQueryUsec[2] << " usec/query with compiled query, "
+             << timePerQueryUsec[3] << " usec/query with coordinate frame IDs");
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Measure reader throughput while a writer thread updates the tracker transforms at 1 kHz.
+    The writer sets ProbeToTracker and StylusToTracker to the same translation in each tracked frame, so readers
+    must always get zero translation in ProbeToStylus (otherwise they would see a partially updated frame).
+  */
+  igsioStatus BenchmarkConcurrentAccess(int numberOfWriterUpdates, int numberOfReaderThreads)
+  {
+    vtkSmartPointer<vtkIGSIOTransformRepository> transformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+    SetUpBenchmarkCoordinateFrames(transformRepository);
+    transformRepository->SetTransform(igsioTransformName("Probe", "Tracker"), vtkSmartPointer<vtkMatrix4x4>::New());
+    transformRepository->SetTransform(igsioTransformName("Stylus", "Tracker"), vtkSmartPointer<vtkMatrix4x4>::New());
+
+    std::atomic<bool> writerFinished(false);
+    std::atomic<bool> inconsistentResult(false);
+    std::vector<long long> numberOfReads(numberOfReaderThreads, 0);
+    std::vector<std::thread> readers;
+    for (int readerIndex = 0; readerIndex < numberOfReaderThreads; ++readerIndex)
+    {
+      readers.push_back(std::thread([&, readerIndex]()
+      {
+        vtkIGSIOTransformRepository::TransformQuery probeToStylusQuery;
+        transformRepository->CompileTransformQuery(igsioTransformName("Probe", "Stylus"), probeToStylusQuery);
+        vtkSmartPointer<vtkMatrix4x4> imageToRas = vtkSmartPointer<vtkMatrix4x4>::New();
+        double probeToStylus[16];
+        while (!writerFinished)
+        {
+          // Alternate between queries by name and compiled queries
+          if (transformRepository->GetTransform(igsioTransformName("Image", "Ras"), imageToRas) != IGSIO_SUCCESS
+              || transformRepository->GetTransform(probeToStylusQuery, probeToStylus) != IGSIO_SUCCESS
+              || probeToStylus[3] != 0.0)
+          {
+            inconsistentResult = true;
+          }
+          numberOfReads[readerIndex] += 2;
+        }
+      }));
+    }
+
+    igsioTrackedFrame trackedFrame;
+    vtkSmartPointer<vtkMatrix4x4> toolToTracker = vtkSmartPointer<vtkMatrix4x4>::New();
+    double maximumUpdateTimeSec = 0;
+    double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+    std::chrono::steady_clock::time_point nextUpdateTime = std::chrono::steady_clock::now();
+    for (int update = 0; update < numberOfWriterUpdates; ++update)
+    {
+      toolToTracker->SetElement(0, 3, update + 1);
+      trackedFrame.SetFrameTransform(igsioTransformName("Probe", "Tracker"), toolToTracker);
+      trackedFrame.SetFrameTransformStatus(igsioTransformName("Probe", "Tracker"), TOOL_OK);
+      trackedFrame.SetFrameTransform(igsioTransformName("Stylus", "Tracker"), toolToTracker);
+      trackedFrame.SetFrameTransformStatus(igsioTransformName("Stylus", "Tracker"), TOOL_OK);
+
+      double updateStartTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+      if (transformRepository->SetTransforms(trackedFrame) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("Failed to set transforms");
+        writerFinished = true;
+        break;
+      }
+      maximumUpdateTimeSec = std::max(maximumUpdateTimeSec, vtkIGSIOAccurateTimer::GetSystemTime() - updateStartTimeSec);
+
+      nextUpdateTime += std::chrono::milliseconds(1);
+      std::this_thread::sleep_until(nextUpdateTime);
+    }
+    double elapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+    writerFinished = true;
+    for (std::vector<std::thread>::iterator reader = readers.begin(); reader != readers.end(); ++reader)
+    {
+      reader->join();
+    }
+
+    if (inconsistentResult)
+    {
+      LOG_ERROR("Readers got a failed or partially updated transform while the writer was updating the transforms");
+      return IGSIO_FAIL;
+    }
+
+    long long totalNumberOfReads = 0;
+    for (int readerIndex = 0; readerIndex < numberOfReaderThreads; ++readerIndex)
+    {
+      totalNumberOfReads += numberOfReads[readerIndex];
+    }
+    LOG_INFO("Concurrent access: " << numberOfWriterUpdates << " updates in " << elapsedTimeSec << " sec (max update time: "
+             << maximumUpdateTimeSec * 1e6 << " usec), " << numberOfReaderThreads << " reader threads: "
+             << totalNumberOfReads / elapsedTimeSec << " queries/sec");
+    return IGSIO_SUCCESS;
+  }
+}
+
 int main(int argc, char** argv)
 {
   // Parse command-line arguments
   bool printHelp(false);
   int verboseLevel(vtkIGSIOLogger::LOG_LEVEL_UNDEFINED);
+  int numberOfBenchmarkIterations(1000);
+  int numberOfReaderThreads(4);
   vtksys::CommandLineArguments args;
   args.Initialize(argc, argv);
   args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
   args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--numberOfBenchmarkIterations", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfBenchmarkIterations, "Number of simulated frames in the GetTransform benchmarks (default: 1000)");
+  args.AddArgument("--numberOfReaderThreads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfReaderThreads, "Number of threads that get transforms in the concurrent access benchmark (default: 4)");
   if (!args.Parse())
   {
     std::cerr << "Problem parsing arguments" << std::endl;
@@ -273,6 +842,19 @@ int main(int argc, char** argv)
   }
 
 
+  // Transforms between identical coordinate frames are always valid
+  isValid = false;
+  if (transformRepository->GetTransformValid(igsioTransformName("Stylus", "Stylus"), isValid) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Cannot get StylusToStylus transform valid status");
+    return EXIT_FAILURE;
+  }
+  if (!isValid)
+  {
+    LOG_ERROR("The StylusToStylus transform should be valid");
+    return EXIT_FAILURE;
+  }
+
   /////////////////////////////////////////////////////////////////////////////
   // Check if non-existing transforms are handled properly
   if (transformRepository->GetTransformValid(igsioTransformName("Probe", "StylusNonExisting"), isValid) == IGSIO_SUCCESS)
@@ -363,11 +945,24 @@ int main(int argc, char** argv)
     LOG_ERROR("Only the inverse of the transform has been set, delete should not have been allowed");
     return EXIT_FAILURE;
   }
+  if (transformRepository->DeleteTransform(igsioTransformName("Probe", "TrackerNonExisting")) == IGSIO_SUCCESS
+      || transformRepository->DeleteTransform(igsioTransformName("ProbeNonExisting", "Tracker")) == IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Deleting a transform between non-existing coordinate frames should have failed");
+    return EXIT_FAILURE;
+  }
   if (transformRepository->DeleteTransform(igsioTransformName("Probe", "Tracker")) != IGSIO_SUCCESS)
   {
     LOG_ERROR("Transform delete failed");
     return EXIT_FAILURE;
   }
+  if (transformRepository->GetNumberOfCachedTransformPaths() != 0
+      || transformRepository->GetTransform(tnProbeToTracker, mxProbeToTrackerRead, &toolStatus) == IGSIO_SUCCESS
+      || toolStatus != TOOL_PATH_NOT_FOUND)
+  {
+    LOG_ERROR("Cached path of a deleted transform is still used");
+    return EXIT_FAILURE;
+  }
 
   /////////////////////////////////////////////////////////////////////////////
   // Check circle detection - after delete
@@ -386,6 +981,46 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  /////////////////////////////////////////////////////////////////////////////
+  // Compiled transform queries
+  if (TestCompiledTransformQuery() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Compiled transform query test failed");
+    return EXIT_FAILURE;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Transforms by coordinate frame IDs
+  if (TestCoordinateFrameIds() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Coordinate frame ID test failed");
+    return EXIT_FAILURE;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Transforms at any time of a recorded sequence
+  if (TestTransformHistory() != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Transform history test failed");
+    return EXIT_FAILURE;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Compare performance with and without the transform path cache and compiled queries
+  if (BenchmarkGetTransform(numberOfBenchmarkIterations) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("GetTransform benchmark failed");
+    return EXIT_FAILURE;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Readers and a 1 kHz writer in parallel
+  if (BenchmarkConcurrentAccess(numberOfBenchmarkIterations, numberOfReaderThreads) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Concurrent access benchmark failed");
+    return EXIT_FAILURE;
+  }
+
   LOG_INFO("Test successfully completed");
   return EXIT_SUCCESS;
 }
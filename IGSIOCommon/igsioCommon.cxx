@@ -208,13 +208,13 @@ std::string igsioTransformName::GetTransformName() const
 }
 
 //-------------------------------------------------------
-std::string igsioTransformName::From() const
+const std::string& igsioTransformName::From() const
 {
   return this->m_From;
 }
 
 //-------------------------------------------------------
-std::string igsioTransformName::To() const
+const std::string& igsioTransformName::To() const
 {
   return this->m_To;
 }
@@ -1154,6 +1154,7 @@ VTKIGSIOCOMMON_EXPORT igsioStatus igsioCommon::DrawScanLines(int* inputImageExte
   {
     LOG_DEBUG("Processing frame " << frameIndex);
     igsioTrackedFrame* frame = trackedFrameList->GetTrackedFrame(frameIndex);
+    frame->GetImageData()->MakeImageWritable();
     igsioCommon::DrawScanLines(inputImageExtent, colour, scanLineEndPoints, frame->GetImageData()->GetImage());
   }
 
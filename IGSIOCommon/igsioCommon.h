@@ -21,6 +21,7 @@
 #include <float.h>
 
 // STL includes
+#include <algorithm>
 #include <array>
 #include <limits>
 #include <list>
@@ -676,6 +677,19 @@ namespace igsioCommon
   */
   VTKIGSIOCOMMON_EXPORT igsioStatus RobustFwrite(FILE* fileHandle, void* data, size_t dataSize, size_t& writtenSize);
 
+  /*!
+    Get the range of items [firstItem, lastItem) that a thread processes if numberOfItems items are split
+    into contiguous blocks of equal size between numberOfThreads threads (e.g., in a vtkMultiThreader single method).
+    The range of the last threads may be shorter or empty.
+  */
+  template<typename T>
+  void GetThreadItemRange(int threadId, int numberOfThreads, T numberOfItems, T& firstItem, T& lastItem)
+  {
+    const T itemsPerThread = (numberOfItems + numberOfThreads - 1) / numberOfThreads;
+    firstItem = std::min(static_cast<T>(threadId) * itemsPerThread, numberOfItems);
+    lastItem = std::min(firstItem + itemsPerThread, numberOfItems);
+  }
+
   VTKIGSIOCOMMON_EXPORT std::string GetIGSIOVersionString();
 
   //----------------------------------------------------------------------------
@@ -777,10 +791,10 @@ public:
   std::string GetTransformName() const;
 
   /*! Return 'From' coordinate frame name, give a warning if it's not capitalized and capitalize it*/
-  std::string From() const;
+  const std::string& From() const;
 
   /*! Return 'To' coordinate frame name, give a warning if it's not capitalized and capitalize it */
-  std::string To() const;
+  const std::string& To() const;
 
   /*! Clear the 'From' and 'To' fields */
   void Clear();
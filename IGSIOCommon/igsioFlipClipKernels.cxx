@@ -0,0 +1,520 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// IGSIO includes
+#include "igsioFlipClipKernels.h"
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define IGSIO_FLIP_CLIP_SSE2
+  #include <emmintrin.h>
+  #if defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1800)
+    #define IGSIO_FLIP_CLIP_AVX2
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+      #include <intrin.h>
+      #define IGSIO_TARGET_AVX2
+    #else
+      #define IGSIO_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+  #endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #define IGSIO_FLIP_CLIP_NEON
+  #include <arm_neon.h>
+#endif
+
+namespace
+{
+  /*! Number of pixels along each side of a tile in tiled transposition */
+  const int TRANSPOSE_TILE_SIZE = 16;
+
+  //----------------------------------------------------------------------------
+  std::atomic<int>& GetCurrentInstructionSet()
+  {
+    static std::atomic<int> currentInstructionSet(igsioFlipClipKernels::GetBestSupportedInstructionSet());
+    return currentInstructionSet;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IsSimdPixelSize(int bytesPerPixel)
+  {
+    return bytesPerPixel == 1 || bytesPerPixel == 2 || bytesPerPixel == 4 || bytesPerPixel == 8;
+  }
+
+  //----------------------------------------------------------------------------
+  template<int BytesPerPixel>
+  void ReverseRowScalar(const unsigned char* input, unsigned char* output, int numberOfPixels)
+  {
+    unsigned char* outputPixel = output + (numberOfPixels - 1) * BytesPerPixel;
+    for (int i = 0; i < numberOfPixels; ++i)
+    {
+      memcpy(outputPixel, input, BytesPerPixel);
+      input += BytesPerPixel;
+      outputPixel -= BytesPerPixel;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void ReverseRowScalar(const unsigned char* input, unsigned char* output, int numberOfPixels, int bytesPerPixel)
+  {
+    switch (bytesPerPixel)
+    {
+      case 1:
+        ReverseRowScalar<1>(input, output, numberOfPixels);
+        return;
+      case 2:
+        ReverseRowScalar<2>(input, output, numberOfPixels);
+        return;
+      case 3:
+        ReverseRowScalar<3>(input, output, numberOfPixels);
+        return;
+      case 4:
+        ReverseRowScalar<4>(input, output, numberOfPixels);
+        return;
+      case 8:
+        ReverseRowScalar<8>(input, output, numberOfPixels);
+        return;
+    }
+    unsigned char* outputPixel = output + (numberOfPixels - 1) * bytesPerPixel;
+    for (int i = 0; i < numberOfPixels; ++i)
+    {
+      memcpy(outputPixel, input, bytesPerPixel);
+      input += bytesPerPixel;
+      outputPixel -= bytesPerPixel;
+    }
+  }
+
+#ifdef IGSIO_FLIP_CLIP_SSE2
+  //----------------------------------------------------------------------------
+  template<int BytesPerPixel> __m128i ReverseVectorSSE2(__m128i v);
+
+  template<> __m128i ReverseVectorSSE2<8>(__m128i v)
+  {
+    return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+  }
+
+  template<> __m128i ReverseVectorSSE2<4>(__m128i v)
+  {
+    return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+  }
+
+  template<> __m128i ReverseVectorSSE2<2>(__m128i v)
+  {
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+    return ReverseVectorSSE2<8>(v);
+  }
+
+  template<> __m128i ReverseVectorSSE2<1>(__m128i v)
+  {
+    // Swap the bytes in each 16-bit word, then reverse the words
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    return ReverseVectorSSE2<2>(v);
+  }
+
+  //----------------------------------------------------------------------------
+  template<int BytesPerPixel>
+  void ReverseRowSSE2(const unsigned char* input, unsigned char* output, int numberOfPixels)
+  {
+    const int pixelsPerVector = 16 / BytesPerPixel;
+    int i = 0;
+    for (; i + pixelsPerVector <= numberOfPixels; i += pixelsPerVector)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * BytesPerPixel));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + (numberOfPixels - i - pixelsPerVector) * BytesPerPixel), ReverseVectorSSE2<BytesPerPixel>(v));
+    }
+    // Remaining pixels go to the beginning of the output row
+    ReverseRowScalar<BytesPerPixel>(input + i * BytesPerPixel, output, numberOfPixels - i);
+  }
+#endif
+
+#ifdef IGSIO_FLIP_CLIP_AVX2
+  /*! Byte shuffle masks that reverse the order of 1, 2, 4 and 8 byte pixels within each 128-bit lane */
+  struct LaneReverseMaskTable
+  {
+    LaneReverseMaskTable()
+    {
+      const int pixelSizes[4] = { 1, 2, 4, 8 };
+      for (int maskIndex = 0; maskIndex < 4; ++maskIndex)
+      {
+        const int bytesPerPixel = pixelSizes[maskIndex];
+        const int pixelsPerLane = 16 / bytesPerPixel;
+        for (int byteIndex = 0; byteIndex < 32; ++byteIndex)
+        {
+          int lanePixelIndex = (byteIndex % 16) / bytesPerPixel;
+          int sourceByteIndex = (pixelsPerLane - 1 - lanePixelIndex) * bytesPerPixel + byteIndex % bytesPerPixel;
+          this->Masks[maskIndex][byteIndex] = static_cast<unsigned char>(sourceByteIndex);
+        }
+      }
+    }
+    unsigned char Masks[4][32];
+  };
+
+  //----------------------------------------------------------------------------
+  const unsigned char* GetLaneReverseMask(int bytesPerPixel)
+  {
+    static const LaneReverseMaskTable table;
+    switch (bytesPerPixel)
+    {
+      case 1:
+        return table.Masks[0];
+      case 2:
+        return table.Masks[1];
+      case 4:
+        return table.Masks[2];
+      default:
+        return table.Masks[3];
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool IsAVX2SupportedByCPU()
+  {
+#if defined(_MSC_VER)
+    int cpuInfo[4] = { 0, 0, 0, 0 };
+    __cpuid(cpuInfo, 1);
+    const bool osUsesXSave = (cpuInfo[2] & (1 << 27)) != 0;
+    const bool cpuHasAVX = (cpuInfo[2] & (1 << 28)) != 0;
+    if (!osUsesXSave || !cpuHasAVX)
+    {
+      return false;
+    }
+    // The operating system must save the AVX registers on context switch
+    if ((_xgetbv(0) & 0x6) != 0x6)
+    {
+      return false;
+    }
+    __cpuidex(cpuInfo, 7, 0);
+    return (cpuInfo[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+  IGSIO_TARGET_AVX2 void ReverseRowAVX2(const unsigned char* input, unsigned char* output, int numberOfPixels, int bytesPerPixel)
+  {
+    // Reverse the pixels within each 128-bit lane, then swap the lanes
+    const __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(GetLaneReverseMask(bytesPerPixel)));
+    const int pixelsPerVector = 32 / bytesPerPixel;
+    int i = 0;
+    for (; i + pixelsPerVector <= numberOfPixels; i += pixelsPerVector)
+    {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i * bytesPerPixel));
+      v = _mm256_shuffle_epi8(v, mask);
+      v = _mm256_permute2x128_si256(v, v, 0x01);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + (numberOfPixels - i - pixelsPerVector) * bytesPerPixel), v);
+    }
+    // Remaining pixels go to the beginning of the output row
+    ReverseRowScalar(input + i * bytesPerPixel, output, numberOfPixels - i, bytesPerPixel);
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Reverse a row of 3-byte (e.g., RGB) pixels using SSSE3 byte shuffle (every AVX2 capable CPU supports SSSE3).
+    5 pixels (15 bytes) are reversed in each 16-byte vector. The extra byte of each store is written right before
+    the reversed pixels, where it is overwritten by the next vector or the remaining pixels.
+  */
+  IGSIO_TARGET_AVX2 void ReverseRow3BytePixelsSSSE3(const unsigned char* input, unsigned char* output, int numberOfPixels)
+  {
+    const __m128i mask = _mm_setr_epi8(-128, 12, 13, 14, 9, 10, 11, 6, 7, 8, 3, 4, 5, 0, 1, 2);
+    int i = 0;
+    // At least one pixel has to remain, so that both the 16-byte load and store stay within the row
+    for (; i + 6 <= numberOfPixels; i += 5)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 3));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + (numberOfPixels - i - 5) * 3 - 1), _mm_shuffle_epi8(v, mask));
+    }
+    // Remaining pixels go to the beginning of the output row
+    ReverseRowScalar<3>(input + i * 3, output, numberOfPixels - i);
+  }
+#endif
+
+#ifdef IGSIO_FLIP_CLIP_NEON
+  //----------------------------------------------------------------------------
+  template<int BytesPerPixel> uint8x16_t ReverseVectorNEON(uint8x16_t v);
+
+  template<> uint8x16_t ReverseVectorNEON<8>(uint8x16_t v)
+  {
+    return vextq_u8(v, v, 8);
+  }
+
+  template<> uint8x16_t ReverseVectorNEON<4>(uint8x16_t v)
+  {
+    return ReverseVectorNEON<8>(vreinterpretq_u8_u32(vrev64q_u32(vreinterpretq_u32_u8(v))));
+  }
+
+  template<> uint8x16_t ReverseVectorNEON<2>(uint8x16_t v)
+  {
+    return ReverseVectorNEON<8>(vreinterpretq_u8_u16(vrev64q_u16(vreinterpretq_u16_u8(v))));
+  }
+
+  template<> uint8x16_t ReverseVectorNEON<1>(uint8x16_t v)
+  {
+    return ReverseVectorNEON<8>(vrev64q_u8(v));
+  }
+
+  //----------------------------------------------------------------------------
+  template<int BytesPerPixel>
+  void ReverseRowNEON(const unsigned char* input, unsigned char* output, int numberOfPixels)
+  {
+    const int pixelsPerVector = 16 / BytesPerPixel;
+    int i = 0;
+    for (; i + pixelsPerVector <= numberOfPixels; i += pixelsPerVector)
+    {
+      uint8x16_t v = vld1q_u8(input + i * BytesPerPixel);
+      vst1q_u8(output + (numberOfPixels - i - pixelsPerVector) * BytesPerPixel, ReverseVectorNEON<BytesPerPixel>(v));
+    }
+    // Remaining pixels go to the beginning of the output row
+    ReverseRowScalar<BytesPerPixel>(input + i * BytesPerPixel, output, numberOfPixels - i);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Reverse a row of 3-byte (e.g., RGB) pixels: the bytes are de-interleaved into 3 vectors of 16 pixels, which are reversed separately */
+  void ReverseRow3BytePixelsNEON(const unsigned char* input, unsigned char* output, int numberOfPixels)
+  {
+    int i = 0;
+    for (; i + 16 <= numberOfPixels; i += 16)
+    {
+      uint8x16x3_t v = vld3q_u8(input + i * 3);
+      v.val[0] = ReverseVectorNEON<1>(v.val[0]);
+      v.val[1] = ReverseVectorNEON<1>(v.val[1]);
+      v.val[2] = ReverseVectorNEON<1>(v.val[2]);
+      vst3q_u8(output + (numberOfPixels - i - 16) * 3, v);
+    }
+    // Remaining pixels go to the beginning of the output row
+    ReverseRowScalar<3>(input + i * 3, output, numberOfPixels - i);
+  }
+#endif
+
+  //----------------------------------------------------------------------------
+  template<int BytesPerPixel>
+  void TransposeTiled(const unsigned char* input, long long inputRowStrideBytes, unsigned char* output, long long outputRowStrideBytes,
+                      int numberOfInputRows, int numberOfInputColumns, int bytesPerPixel)
+  {
+    const int pixelSize = (BytesPerPixel > 0 ? BytesPerPixel : bytesPerPixel);
+    // Process the image in small tiles so that both the input and the output rows of a tile stay in the cache
+    for (int firstRow = 0; firstRow < numberOfInputRows; firstRow += TRANSPOSE_TILE_SIZE)
+    {
+      const int lastRow = std::min(firstRow + TRANSPOSE_TILE_SIZE, numberOfInputRows);
+      for (int firstColumn = 0; firstColumn < numberOfInputColumns; firstColumn += TRANSPOSE_TILE_SIZE)
+      {
+        const int lastColumn = std::min(firstColumn + TRANSPOSE_TILE_SIZE, numberOfInputColumns);
+        for (int row = firstRow; row < lastRow; ++row)
+        {
+          const unsigned char* inputPixel = input + row * inputRowStrideBytes + firstColumn * pixelSize;
+          unsigned char* outputPixel = output + firstColumn * outputRowStrideBytes + row * pixelSize;
+          for (int column = firstColumn; column < lastColumn; ++column)
+          {
+            memcpy(outputPixel, inputPixel, BytesPerPixel > 0 ? BytesPerPixel : pixelSize);
+            inputPixel += pixelSize;
+            outputPixel += outputRowStrideBytes;
+          }
+        }
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+igsioFlipClipKernels::InstructionSet igsioFlipClipKernels::GetInstructionSet()
+{
+  return static_cast<InstructionSet>(GetCurrentInstructionSet().load());
+}
+
+//----------------------------------------------------------------------------
+igsioFlipClipKernels::InstructionSet igsioFlipClipKernels::GetBestSupportedInstructionSet()
+{
+  if (IsInstructionSetSupported(INSTRUCTION_SET_AVX2))
+  {
+    return INSTRUCTION_SET_AVX2;
+  }
+  if (IsInstructionSetSupported(INSTRUCTION_SET_SSE2))
+  {
+    return INSTRUCTION_SET_SSE2;
+  }
+  if (IsInstructionSetSupported(INSTRUCTION_SET_NEON))
+  {
+    return INSTRUCTION_SET_NEON;
+  }
+  return INSTRUCTION_SET_SCALAR;
+}
+
+//----------------------------------------------------------------------------
+bool igsioFlipClipKernels::IsInstructionSetSupported(InstructionSet instructionSet)
+{
+  switch (instructionSet)
+  {
+    case INSTRUCTION_SET_SCALAR:
+      return true;
+    case INSTRUCTION_SET_SSE2:
+#ifdef IGSIO_FLIP_CLIP_SSE2
+      return true;
+#else
+      return false;
+#endif
+    case INSTRUCTION_SET_AVX2:
+    {
+#ifdef IGSIO_FLIP_CLIP_AVX2
+      static const bool isAVX2Supported = IsAVX2SupportedByCPU();
+      return isAVX2Supported;
+#else
+      return false;
+#endif
+    }
+    case INSTRUCTION_SET_NEON:
+#ifdef IGSIO_FLIP_CLIP_NEON
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus igsioFlipClipKernels::SetInstructionSet(InstructionSet instructionSet)
+{
+  if (!IsInstructionSetSupported(instructionSet))
+  {
+    LOG_ERROR("Instruction set " << GetInstructionSetAsString(instructionSet) << " is not supported on this computer");
+    return IGSIO_FAIL;
+  }
+  GetCurrentInstructionSet() = instructionSet;
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+std::string igsioFlipClipKernels::GetInstructionSetAsString(InstructionSet instructionSet)
+{
+  switch (instructionSet)
+  {
+    case INSTRUCTION_SET_SCALAR:
+      return "Scalar";
+    case INSTRUCTION_SET_SSE2:
+      return "SSE2";
+    case INSTRUCTION_SET_AVX2:
+      return "AVX2";
+    case INSTRUCTION_SET_NEON:
+      return "NEON";
+  }
+  return "Unknown";
+}
+
+//----------------------------------------------------------------------------
+void igsioFlipClipKernels::ReverseRow(const unsigned char* input, unsigned char* output, int numberOfPixels, int bytesPerPixel)
+{
+  if (numberOfPixels <= 0)
+  {
+    return;
+  }
+  if (bytesPerPixel == 3)
+  {
+    switch (GetInstructionSet())
+    {
+#ifdef IGSIO_FLIP_CLIP_AVX2
+      case INSTRUCTION_SET_AVX2:
+        ReverseRow3BytePixelsSSSE3(input, output, numberOfPixels);
+        return;
+#endif
+#ifdef IGSIO_FLIP_CLIP_NEON
+      case INSTRUCTION_SET_NEON:
+        ReverseRow3BytePixelsNEON(input, output, numberOfPixels);
+        return;
+#endif
+      default:
+        ReverseRowScalar<3>(input, output, numberOfPixels);
+        return;
+    }
+  }
+  if (!IsSimdPixelSize(bytesPerPixel))
+  {
+    ReverseRowScalar(input, output, numberOfPixels, bytesPerPixel);
+    return;
+  }
+
+  switch (GetInstructionSet())
+  {
+#ifdef IGSIO_FLIP_CLIP_AVX2
+    case INSTRUCTION_SET_AVX2:
+      ReverseRowAVX2(input, output, numberOfPixels, bytesPerPixel);
+      return;
+#endif
+#ifdef IGSIO_FLIP_CLIP_SSE2
+    case INSTRUCTION_SET_SSE2:
+      switch (bytesPerPixel)
+      {
+        case 1:
+          ReverseRowSSE2<1>(input, output, numberOfPixels);
+          return;
+        case 2:
+          ReverseRowSSE2<2>(input, output, numberOfPixels);
+          return;
+        case 4:
+          ReverseRowSSE2<4>(input, output, numberOfPixels);
+          return;
+        default:
+          ReverseRowSSE2<8>(input, output, numberOfPixels);
+          return;
+      }
+#endif
+#ifdef IGSIO_FLIP_CLIP_NEON
+    case INSTRUCTION_SET_NEON:
+      switch (bytesPerPixel)
+      {
+        case 1:
+          ReverseRowNEON<1>(input, output, numberOfPixels);
+          return;
+        case 2:
+          ReverseRowNEON<2>(input, output, numberOfPixels);
+          return;
+        case 4:
+          ReverseRowNEON<4>(input, output, numberOfPixels);
+          return;
+        default:
+          ReverseRowNEON<8>(input, output, numberOfPixels);
+          return;
+      }
+#endif
+    default:
+      ReverseRowScalar(input, output, numberOfPixels, bytesPerPixel);
+      return;
+  }
+}
+
+//----------------------------------------------------------------------------
+void igsioFlipClipKernels::Transpose(const unsigned char* input, long long inputRowStrideBytes, unsigned char* output, long long outputRowStrideBytes,
+                                     int numberOfInputRows, int numberOfInputColumns, int bytesPerPixel)
+{
+  switch (bytesPerPixel)
+  {
+    case 1:
+      TransposeTiled<1>(input, inputRowStrideBytes, output, outputRowStrideBytes, numberOfInputRows, numberOfInputColumns, bytesPerPixel);
+      return;
+    case 2:
+      TransposeTiled<2>(input, inputRowStrideBytes, output, outputRowStrideBytes, numberOfInputRows, numberOfInputColumns, bytesPerPixel);
+      return;
+    case 3:
+      TransposeTiled<3>(input, inputRowStrideBytes, output, outputRowStrideBytes, numberOfInputRows, numberOfInputColumns, bytesPerPixel);
+      return;
+    case 4:
+      TransposeTiled<4>(input, inputRowStrideBytes, output, outputRowStrideBytes, numberOfInputRows, numberOfInputColumns, bytesPerPixel);
+      return;
+    case 8:
+      TransposeTiled<8>(input, inputRowStrideBytes, output, outputRowStrideBytes, numberOfInputRows, numberOfInputColumns, bytesPerPixel);
+      return;
+    default:
+      TransposeTiled<0>(input, inputRowStrideBytes, output, outputRowStrideBytes, numberOfInputRows, numberOfInputColumns, bytesPerPixel);
+      return;
+  }
+}
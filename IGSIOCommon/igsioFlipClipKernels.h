@@ -0,0 +1,81 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __igsioFlipClipKernels_h
+#define __igsioFlipClipKernels_h
+
+#include "vtkigsiocommon_export.h"
+
+// IGSIO includes
+#include "igsioCommon.h"
+
+// STL includes
+#include <string>
+
+/*!
+  \class igsioFlipClipKernels
+  \brief Pixel reordering kernels used by igsioVideoFrame::FlipClipImage
+
+  The kernels work on raw pixel bytes, a pixel is a group of bytesPerPixel bytes (scalar size * number of components).
+  Row reversal (horizontal flip) has SSE2, AVX2 and NEON implementations for 1, 2, 4 and 8 byte pixels. 3-byte pixels (e.g., RGB)
+  are reversed by an SSSE3 byte shuffle if the AVX2 instruction set is used and by de-interleaving loads and stores with NEON,
+  other pixel sizes use the scalar implementation. Transposition is done in cache-friendly tiles.
+
+  The instruction set is selected at runtime: the best one that is supported by both the build and the CPU is used.
+  It can be overridden by SetInstructionSet (for testing and benchmarking).
+
+  \ingroup PlusLibCommon
+*/
+class VTKIGSIOCOMMON_EXPORT igsioFlipClipKernels
+{
+public:
+  enum InstructionSet
+  {
+    INSTRUCTION_SET_SCALAR = 0,
+    INSTRUCTION_SET_SSE2,
+    INSTRUCTION_SET_AVX2,
+    INSTRUCTION_SET_NEON
+  };
+
+  /*! Get the instruction set that is used by the kernels */
+  static InstructionSet GetInstructionSet();
+
+  /*! Get the best instruction set that is supported by this build and the CPU */
+  static InstructionSet GetBestSupportedInstructionSet();
+
+  /*! Check if an instruction set is supported by this build and the CPU */
+  static bool IsInstructionSetSupported(InstructionSet instructionSet);
+
+  /*! Set the instruction set that is used by the kernels. Fails if the instruction set is not supported. */
+  static igsioStatus SetInstructionSet(InstructionSet instructionSet);
+
+  static std::string GetInstructionSetAsString(InstructionSet instructionSet);
+
+  /*!
+    Copy a row of pixels in reverse pixel order. Input and output must not overlap.
+    \param input First pixel of the input row
+    \param output First pixel of the output row
+    \param numberOfPixels Number of pixels in the row
+    \param bytesPerPixel Size of a pixel in bytes
+  */
+  static void ReverseRow(const unsigned char* input, unsigned char* output, int numberOfPixels, int bytesPerPixel);
+
+  /*!
+    Transpose a 2D block of pixels: output pixel (row=c, column=r) is input pixel (row=r, column=c).
+    Input and output must not overlap.
+    \param input First pixel of the input
+    \param inputRowStrideBytes Distance between the first pixels of consecutive input rows, in bytes
+    \param output First pixel of the output
+    \param outputRowStrideBytes Distance between the first pixels of consecutive output rows, in bytes
+    \param numberOfInputRows Number of input rows (number of output columns)
+    \param numberOfInputColumns Number of input columns (number of output rows)
+    \param bytesPerPixel Size of a pixel in bytes
+  */
+  static void Transpose(const unsigned char* input, long long inputRowStrideBytes, unsigned char* output, long long outputRowStrideBytes,
+                        int numberOfInputRows, int numberOfInputColumns, int bytesPerPixel);
+};
+
+#endif
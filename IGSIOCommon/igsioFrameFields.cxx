@@ -0,0 +1,266 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// IGSIO includes
+#include "igsioFrameFields.h"
+#include "vtkIGSIORecursiveCriticalSection.h"
+
+// STL includes
+#include <algorithm>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  bool FieldIdLess(const igsioFrameFieldContainer::Field& field, igsioFrameFieldId fieldId)
+  {
+    return field.Id < fieldId;
+  }
+
+  //----------------------------------------------------------------------------
+  bool FieldNameLess(const igsioFrameFieldContainer::Field* fieldA, const igsioFrameFieldContainer::Field* fieldB)
+  {
+    return fieldA->GetName() < fieldB->GetName();
+  }
+}
+
+//----------------------------------------------------------------------------
+// ************************* igsioFrameFieldRegistry *************************
+//----------------------------------------------------------------------------
+igsioFrameFieldRegistry::igsioFrameFieldRegistry()
+  : CurrentSnapshot(NULL)
+  , Mutex(vtkIGSIOSimpleRecursiveCriticalSection::New())
+{
+}
+
+//----------------------------------------------------------------------------
+igsioFrameFieldRegistry::~igsioFrameFieldRegistry()
+{
+  this->Mutex->Delete();
+  this->Mutex = NULL;
+}
+
+//----------------------------------------------------------------------------
+igsioFrameFieldRegistry* igsioFrameFieldRegistry::GetInstance()
+{
+  static igsioFrameFieldRegistry instance;
+  return &instance;
+}
+
+//----------------------------------------------------------------------------
+igsioFrameFieldId igsioFrameFieldRegistry::GetFieldId(const std::string& fieldName)
+{
+  const NameTableSnapshot* snapshot = this->CurrentSnapshot.load(std::memory_order_acquire);
+  if (snapshot != NULL)
+  {
+    std::unordered_map<std::string, igsioFrameFieldId>::const_iterator snapshotIdIt = snapshot->FieldIds.find(fieldName);
+    if (snapshotIdIt != snapshot->FieldIds.end())
+    {
+      return snapshotIdIt->second;
+    }
+  }
+
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> registryGuard(this->Mutex);
+  std::unordered_map<std::string, igsioFrameFieldId>::const_iterator idIt = this->FieldIds.find(fieldName);
+  if (idIt != this->FieldIds.end())
+  {
+    return idIt->second;
+  }
+  igsioFrameFieldId fieldId = static_cast<igsioFrameFieldId>(this->FieldNames.size());
+  this->FieldNames.push_back(fieldName);
+  this->FieldIds[fieldName] = fieldId;
+  this->UpdateSnapshot();
+  return fieldId;
+}
+
+//----------------------------------------------------------------------------
+void igsioFrameFieldRegistry::UpdateSnapshot()
+{
+  const NameTableSnapshot* snapshot = this->CurrentSnapshot.load(std::memory_order_relaxed);
+  size_t numberOfSnapshotNames = (snapshot != NULL ? snapshot->FieldNames.size() : 0);
+  if (this->FieldNames.size() < numberOfSnapshotNames + numberOfSnapshotNames / 4 + 1)
+  {
+    return;
+  }
+
+  std::unique_ptr<NameTableSnapshot> newSnapshot(new NameTableSnapshot);
+  newSnapshot->FieldIds = this->FieldIds;
+  newSnapshot->FieldNames.reserve(this->FieldNames.size());
+  for (std::deque<std::string>::const_iterator nameIt = this->FieldNames.begin(); nameIt != this->FieldNames.end(); ++nameIt)
+  {
+    newSnapshot->FieldNames.push_back(&(*nameIt));
+  }
+  this->CurrentSnapshot.store(newSnapshot.get(), std::memory_order_release);
+  this->Snapshots.push_back(std::move(newSnapshot));
+}
+
+//----------------------------------------------------------------------------
+bool igsioFrameFieldRegistry::FindFieldId(const std::string& fieldName, igsioFrameFieldId& fieldId)
+{
+  const NameTableSnapshot* snapshot = this->CurrentSnapshot.load(std::memory_order_acquire);
+  if (snapshot != NULL)
+  {
+    std::unordered_map<std::string, igsioFrameFieldId>::const_iterator snapshotIdIt = snapshot->FieldIds.find(fieldName);
+    if (snapshotIdIt != snapshot->FieldIds.end())
+    {
+      fieldId = snapshotIdIt->second;
+      return true;
+    }
+  }
+
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> registryGuard(this->Mutex);
+  std::unordered_map<std::string, igsioFrameFieldId>::const_iterator idIt = this->FieldIds.find(fieldName);
+  if (idIt == this->FieldIds.end())
+  {
+    return false;
+  }
+  fieldId = idIt->second;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+const std::string& igsioFrameFieldRegistry::GetFieldName(igsioFrameFieldId fieldId)
+{
+  const NameTableSnapshot* snapshot = this->CurrentSnapshot.load(std::memory_order_acquire);
+  if (snapshot != NULL && fieldId < snapshot->FieldNames.size())
+  {
+    return *(snapshot->FieldNames[fieldId]);
+  }
+
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> registryGuard(this->Mutex);
+  if (fieldId >= this->FieldNames.size())
+  {
+    LOG_ERROR("Invalid frame field identifier: " << fieldId);
+    static const std::string emptyName;
+    return emptyName;
+  }
+  return this->FieldNames[fieldId];
+}
+
+//----------------------------------------------------------------------------
+unsigned int igsioFrameFieldRegistry::GetNumberOfFields()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> registryGuard(this->Mutex);
+  return static_cast<unsigned int>(this->FieldNames.size());
+}
+
+//----------------------------------------------------------------------------
+// ************************* igsioFrameFieldContainer ************************
+//----------------------------------------------------------------------------
+const std::string& igsioFrameFieldContainer::Field::GetName() const
+{
+  return igsioFrameFieldRegistry::GetInstance()->GetFieldName(this->Id);
+}
+
+//----------------------------------------------------------------------------
+igsioFrameFieldContainer::Field* igsioFrameFieldContainer::Find(igsioFrameFieldId fieldId)
+{
+  iterator fieldIt = std::lower_bound(this->Fields.begin(), this->Fields.end(), fieldId, FieldIdLess);
+  if (fieldIt == this->Fields.end() || fieldIt->Id != fieldId)
+  {
+    return NULL;
+  }
+  return &(*fieldIt);
+}
+
+//----------------------------------------------------------------------------
+const igsioFrameFieldContainer::Field* igsioFrameFieldContainer::Find(igsioFrameFieldId fieldId) const
+{
+  const_iterator fieldIt = std::lower_bound(this->Fields.begin(), this->Fields.end(), fieldId, FieldIdLess);
+  if (fieldIt == this->Fields.end() || fieldIt->Id != fieldId)
+  {
+    return NULL;
+  }
+  return &(*fieldIt);
+}
+
+//----------------------------------------------------------------------------
+igsioFrameFieldContainer::Field* igsioFrameFieldContainer::Find(const std::string& fieldName)
+{
+  igsioFrameFieldId fieldId(0);
+  if (!igsioFrameFieldRegistry::GetInstance()->FindFieldId(fieldName, fieldId))
+  {
+    return NULL;
+  }
+  return this->Find(fieldId);
+}
+
+//----------------------------------------------------------------------------
+const igsioFrameFieldContainer::Field* igsioFrameFieldContainer::Find(const std::string& fieldName) const
+{
+  igsioFrameFieldId fieldId(0);
+  if (!igsioFrameFieldRegistry::GetInstance()->FindFieldId(fieldName, fieldId))
+  {
+    return NULL;
+  }
+  return this->Find(fieldId);
+}
+
+//----------------------------------------------------------------------------
+igsioFrameFieldContainer::Field& igsioFrameFieldContainer::Insert(igsioFrameFieldId fieldId)
+{
+  iterator fieldIt = std::lower_bound(this->Fields.begin(), this->Fields.end(), fieldId, FieldIdLess);
+  if (fieldIt == this->Fields.end() || fieldIt->Id != fieldId)
+  {
+    Field field;
+    field.Id = fieldId;
+    field.Flags = FRAMEFIELD_NONE;
+    fieldIt = this->Fields.insert(fieldIt, field);
+  }
+  return *fieldIt;
+}
+
+//----------------------------------------------------------------------------
+igsioFrameFieldContainer::Field& igsioFrameFieldContainer::Insert(const std::string& fieldName)
+{
+  return this->Insert(igsioFrameFieldRegistry::GetInstance()->GetFieldId(fieldName));
+}
+
+//----------------------------------------------------------------------------
+bool igsioFrameFieldContainer::Erase(igsioFrameFieldId fieldId)
+{
+  iterator fieldIt = std::lower_bound(this->Fields.begin(), this->Fields.end(), fieldId, FieldIdLess);
+  if (fieldIt == this->Fields.end() || fieldIt->Id != fieldId)
+  {
+    return false;
+  }
+  this->Fields.erase(fieldIt);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool igsioFrameFieldContainer::Erase(const std::string& fieldName)
+{
+  igsioFrameFieldId fieldId(0);
+  if (!igsioFrameFieldRegistry::GetInstance()->FindFieldId(fieldName, fieldId))
+  {
+    return false;
+  }
+  return this->Erase(fieldId);
+}
+
+//----------------------------------------------------------------------------
+void igsioFrameFieldContainer::GetFieldsSortedByName(std::vector<const Field*>& sortedFields) const
+{
+  sortedFields.clear();
+  sortedFields.reserve(this->Fields.size());
+  for (const_iterator fieldIt = this->Fields.begin(); fieldIt != this->Fields.end(); ++fieldIt)
+  {
+    sortedFields.push_back(&(*fieldIt));
+  }
+  std::sort(sortedFields.begin(), sortedFields.end(), FieldNameLess);
+}
+
+//----------------------------------------------------------------------------
+void igsioFrameFieldContainer::GetFieldMap(igsioFieldMapType& fieldMap) const
+{
+  fieldMap.clear();
+  for (const_iterator fieldIt = this->Fields.begin(); fieldIt != this->Fields.end(); ++fieldIt)
+  {
+    std::pair<igsioFrameFieldFlags, std::string>& mapValue = fieldMap[fieldIt->GetName()];
+    mapValue.first = fieldIt->Flags;
+    mapValue.second = fieldIt->Value;
+  }
+}
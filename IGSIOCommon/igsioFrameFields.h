@@ -0,0 +1,165 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __igsioFrameFields_h
+#define __igsioFrameFields_h
+
+#include "vtkigsiocommon_export.h"
+
+// IGSIO includes
+#include "igsioCommon.h"
+
+// STL includes
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class vtkIGSIOSimpleRecursiveCriticalSection;
+
+/*! Integer identifier of a frame field name, see igsioFrameFieldRegistry */
+typedef unsigned int igsioFrameFieldId;
+
+/*!
+  \class igsioFrameFieldRegistry
+  \brief Process-wide table of frame field names
+
+  Tracked frames of a recording typically have the same set of field names (e.g., ProbeToTrackerTransform,
+  ProbeToTrackerTransformStatus, Timestamp). Instead of storing a copy of each name in every frame,
+  names are stored only once in this registry and frames refer to them by an integer identifier.
+  Names are never removed from the registry, therefore a returned identifier and name reference
+  remain valid until the end of the process.
+
+  The class is thread-safe. Lookups of names that are already registered read an immutable
+  snapshot of the name table and do not lock. The snapshot is republished when the number of names
+  that are not in it grows by a fixed fraction, so only recently added names are looked up with locking.
+
+  \ingroup PlusLibCommon
+*/
+class VTKIGSIOCOMMON_EXPORT igsioFrameFieldRegistry
+{
+public:
+  /*! Get the singleton instance */
+  static igsioFrameFieldRegistry* GetInstance();
+
+  /*! Get identifier of a field name. If the name is not registered yet then it is added to the registry. */
+  igsioFrameFieldId GetFieldId(const std::string& fieldName);
+
+  /*!
+    Get identifier of a field name without adding it to the registry.
+    \return true, if the name is registered; false, if the name is unknown (no frame can have such field)
+  */
+  bool FindFieldId(const std::string& fieldName, igsioFrameFieldId& fieldId);
+
+  /*! Get the field name that belongs to an identifier */
+  const std::string& GetFieldName(igsioFrameFieldId fieldId);
+
+  /*! Get the number of registered field names */
+  unsigned int GetNumberOfFields();
+
+protected:
+  igsioFrameFieldRegistry();
+  ~igsioFrameFieldRegistry();
+
+  /*! Immutable copy of the name table, read without locking */
+  struct NameTableSnapshot
+  {
+    std::unordered_map<std::string, igsioFrameFieldId> FieldIds;
+    /*! Pointers to the names in FieldNames, indexed by field identifier */
+    std::vector<const std::string*> FieldNames;
+  };
+
+  /*! Publish a new snapshot if enough names have been added since the last one. Must be called with the mutex locked. */
+  void UpdateSnapshot();
+
+  /*! Field names, indexed by field identifier. Deque is used to keep references to existing names valid when new names are added. */
+  std::deque<std::string> FieldNames;
+  /*! Field identifiers, indexed by field name */
+  std::unordered_map<std::string, igsioFrameFieldId> FieldIds;
+
+  /*! Most recently published snapshot */
+  std::atomic<const NameTableSnapshot*> CurrentSnapshot;
+  /*!
+    All published snapshots. Readers may still use an old snapshot after a new one is published, so snapshots are only
+    deleted with the registry. Each snapshot is larger than the previous one by a fixed fraction, so they take O(number of names) memory in total.
+  */
+  std::vector<std::unique_ptr<NameTableSnapshot> > Snapshots;
+
+  vtkIGSIOSimpleRecursiveCriticalSection* Mutex;
+
+private:
+  igsioFrameFieldRegistry(const igsioFrameFieldRegistry&);
+  void operator=(const igsioFrameFieldRegistry&);
+};
+
+/*!
+  \class igsioFrameFieldContainer
+  \brief Compact storage of the fields of a tracked frame
+
+  Fields are stored in a vector sorted by field identifier, which makes lookups a binary search
+  in a contiguous array. Field names are only stored in the igsioFrameFieldRegistry.
+  Looking up a field by name never adds the name to the registry.
+
+  \ingroup PlusLibCommon
+*/
+class VTKIGSIOCOMMON_EXPORT igsioFrameFieldContainer
+{
+public:
+  /*! A single frame field */
+  struct Field
+  {
+    igsioFrameFieldId Id;
+    igsioFrameFieldFlags Flags;
+    std::string Value;
+
+    /*! Name of the field (stored in the registry) */
+    const std::string& GetName() const;
+  };
+  typedef std::vector<Field> FieldListType;
+  typedef FieldListType::iterator iterator;
+  typedef FieldListType::const_iterator const_iterator;
+
+public:
+  /*! Get field by identifier. Returns NULL if the field is not defined. */
+  Field* Find(igsioFrameFieldId fieldId);
+  const Field* Find(igsioFrameFieldId fieldId) const;
+
+  /*! Get field by name. Returns NULL if the field is not defined. */
+  Field* Find(const std::string& fieldName);
+  const Field* Find(const std::string& fieldName) const;
+
+  /*! Get field by identifier. The field is added (with empty value) if it is not defined yet. */
+  Field& Insert(igsioFrameFieldId fieldId);
+
+  /*! Get field by name. The field is added (with empty value) if it is not defined yet. */
+  Field& Insert(const std::string& fieldName);
+
+  /*! Remove a field. Returns false if the field was not defined. */
+  bool Erase(igsioFrameFieldId fieldId);
+  bool Erase(const std::string& fieldName);
+
+  /*! Get fields in alphabetical order of field names */
+  void GetFieldsSortedByName(std::vector<const Field*>& sortedFields) const;
+
+  /*! Copy all fields into a name-indexed map */
+  void GetFieldMap(igsioFieldMapType& fieldMap) const;
+
+  void Clear() { this->Fields.clear(); }
+  bool Empty() const { return this->Fields.empty(); }
+  size_t Size() const { return this->Fields.size(); }
+
+  iterator begin() { return this->Fields.begin(); }
+  iterator end() { return this->Fields.end(); }
+  const_iterator begin() const { return this->Fields.begin(); }
+  const_iterator end() const { return this->Fields.end(); }
+
+protected:
+  FieldListType Fields;
+};
+
+#endif
@@ -90,6 +90,44 @@ void igsioMath::Slerp(double* result, double t, double* from, double* to, bool a
   }
 }
 
+//----------------------------------------------------------------------------
+void igsioMath::InterpolateRigidTransform(const double matrixBefore[16], const double matrixAfter[16], double weightAfter, double outMatrix[16])
+{
+  // Rotation
+  double rotationBefore[3][3] = { { 0 } };
+  double rotationAfter[3][3] = { { 0 } };
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int col = 0; col < 3; ++col)
+    {
+      rotationBefore[row][col] = matrixBefore[row * 4 + col];
+      rotationAfter[row][col] = matrixAfter[row * 4 + col];
+    }
+  }
+  double quaternionBefore[4] = { 0 };
+  double quaternionAfter[4] = { 0 };
+  vtkMath::Matrix3x3ToQuaternion(rotationBefore, quaternionBefore);
+  vtkMath::Matrix3x3ToQuaternion(rotationAfter, quaternionAfter);
+  double interpolatedQuaternion[4] = { 0 };
+  igsioMath::Slerp(interpolatedQuaternion, weightAfter, quaternionBefore, quaternionAfter);
+  double interpolatedRotation[3][3] = { { 0 } };
+  vtkMath::QuaternionToMatrix3x3(interpolatedQuaternion, interpolatedRotation);
+
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int col = 0; col < 3; ++col)
+    {
+      outMatrix[row * 4 + col] = interpolatedRotation[row][col];
+    }
+    // Translation
+    outMatrix[row * 4 + 3] = matrixBefore[row * 4 + 3] * (1.0 - weightAfter) + matrixAfter[row * 4 + 3] * weightAfter;
+  }
+  outMatrix[12] = 0.0;
+  outMatrix[13] = 0.0;
+  outMatrix[14] = 0.0;
+  outMatrix[15] = 1.0;
+}
+
 //----------------------------------------------------------------------------
 igsioStatus igsioMath::ConstrainRotationToTwoAxes(double downVector_Sensor[3], int notRotatingAxisIndex, vtkMatrix4x4* sensorToSouthWestDownTransform)
 {
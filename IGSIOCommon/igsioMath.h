@@ -52,6 +52,16 @@ public:
   */
   static void Slerp(double* result, double t, double* from, double* to, bool adjustSign = true);
 
+  /*!
+  Interpolate between two rigid transforms. Rotation is interpolated by spherical linear interpolation
+  of quaternions, translation is interpolated linearly.
+  \param matrixBefore Input transform (16 elements, row-major)
+  \param matrixAfter Input transform (16 elements, row-major)
+  \param weightAfter Value between 0 and 1 (0 means the result is the same as matrixBefore)
+  \param outMatrix Interpolated transform (16 elements, row-major), it must not be the same as the inputs
+  */
+  static void InterpolateRigidTransform(const double matrixBefore[16], const double matrixAfter[16], double weightAfter, double outMatrix[16]);
+
   /*
   This function constrain an orientation in 3DOF to 2DOF (rotation around two axes)
   This function is given a rotation axis vector ("down" vector, in the sensor coordinate system;
@@ -0,0 +1,387 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// IGSIO includes
+#include "igsioFlipClipKernels.h"
+#include "igsioPixelConversionKernels.h"
+
+// VTK includes
+#include <vtkSetGet.h>
+#include <vtkType.h>
+
+// STL includes
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define IGSIO_PIXEL_CONVERSION_SSE2
+  #include <emmintrin.h>
+  #if defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1800)
+    #define IGSIO_PIXEL_CONVERSION_AVX2
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+      #define IGSIO_TARGET_AVX2
+    #else
+      #define IGSIO_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+  #endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #define IGSIO_PIXEL_CONVERSION_NEON
+  #include <arm_neon.h>
+#endif
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  inline unsigned char ClampRoundToUnsignedChar(float value)
+  {
+    // Same operation order as in the vectorized kernels: clamp, add 0.5, truncate (NaN gives 0)
+    if (!(value > 0.f))
+    {
+      return 0;
+    }
+    if (value > 255.f)
+    {
+      value = 255.f;
+    }
+    return static_cast<unsigned char>(value + 0.5f);
+  }
+
+  //----------------------------------------------------------------------------
+  template<class ScalarType>
+  void ScaleToUnsignedCharScalar(const ScalarType* input, unsigned char* output, long long numberOfValues, float scale, float shift)
+  {
+    for (long long i = 0; i < numberOfValues; ++i)
+    {
+      output[i] = ClampRoundToUnsignedChar(static_cast<float>(input[i]) * scale + shift);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template<class ScalarType>
+  void GetRangeScalar(const ScalarType* input, long long numberOfValues, double range[2])
+  {
+    ScalarType minimum = input[0];
+    ScalarType maximum = input[0];
+    for (long long i = 1; i < numberOfValues; ++i)
+    {
+      if (input[i] < minimum)
+      {
+        minimum = input[i];
+      }
+      if (input[i] > maximum)
+      {
+        maximum = input[i];
+      }
+    }
+    range[0] = static_cast<double>(minimum);
+    range[1] = static_cast<double>(maximum);
+  }
+
+  //----------------------------------------------------------------------------
+  template<int NumberOfInputComponents>
+  void RGBToGrayScalar(const unsigned char* input, unsigned char* output, long long numberOfPixels)
+  {
+    for (long long i = 0; i < numberOfPixels; ++i)
+    {
+      const unsigned char* pixel = input + i * NumberOfInputComponents;
+      output[i] = static_cast<unsigned char>((77 * pixel[0] + 150 * pixel[1] + 29 * pixel[2] + 128) >> 8);
+    }
+  }
+
+#ifdef IGSIO_PIXEL_CONVERSION_SSE2
+  //----------------------------------------------------------------------------
+  /*! Load 16 values and convert them to float */
+  inline void LoadFloatsSSE2(const float* input, __m128 values[4])
+  {
+    values[0] = _mm_loadu_ps(input);
+    values[1] = _mm_loadu_ps(input + 4);
+    values[2] = _mm_loadu_ps(input + 8);
+    values[3] = _mm_loadu_ps(input + 12);
+  }
+
+  inline void LoadFloatsSSE2(const unsigned short* input, __m128 values[4])
+  {
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < 2; ++i)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 8 * i));
+      values[2 * i] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+      values[2 * i + 1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+    }
+  }
+
+  inline void LoadFloatsSSE2(const short* input, __m128 values[4])
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      // Sign extension: put the value in the upper half of the 32-bit word and shift it down
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 8 * i));
+      values[2 * i] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+      values[2 * i + 1] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template<class ScalarType>
+  void ScaleToUnsignedCharSSE2(const ScalarType* input, unsigned char* output, long long numberOfValues, float scale, float shift)
+  {
+    const __m128 scaleVector = _mm_set1_ps(scale);
+    const __m128 shiftVector = _mm_set1_ps(shift);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 maximum = _mm_set1_ps(255.f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    long long i = 0;
+    for (; i + 16 <= numberOfValues; i += 16)
+    {
+      __m128 values[4];
+      LoadFloatsSSE2(input + i, values);
+      __m128i integers[4];
+      for (int k = 0; k < 4; ++k)
+      {
+        // _mm_max_ps returns the second operand if the first one is NaN
+        __m128 v = _mm_add_ps(_mm_mul_ps(values[k], scaleVector), shiftVector);
+        v = _mm_add_ps(_mm_min_ps(_mm_max_ps(v, zero), maximum), half);
+        integers[k] = _mm_cvttps_epi32(v);
+      }
+      __m128i packed = _mm_packus_epi16(_mm_packs_epi32(integers[0], integers[1]), _mm_packs_epi32(integers[2], integers[3]));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+    }
+    ScaleToUnsignedCharScalar(input + i, output + i, numberOfValues - i, scale, shift);
+  }
+#endif
+
+#ifdef IGSIO_PIXEL_CONVERSION_AVX2
+  //----------------------------------------------------------------------------
+  /*! Load 32 values and convert them to float */
+  IGSIO_TARGET_AVX2 inline void LoadFloatsAVX2(const float* input, __m256 values[4])
+  {
+    for (int k = 0; k < 4; ++k)
+    {
+      values[k] = _mm256_loadu_ps(input + 8 * k);
+    }
+  }
+
+  IGSIO_TARGET_AVX2 inline void LoadFloatsAVX2(const unsigned short* input, __m256 values[4])
+  {
+    for (int k = 0; k < 4; ++k)
+    {
+      values[k] = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 8 * k))));
+    }
+  }
+
+  IGSIO_TARGET_AVX2 inline void LoadFloatsAVX2(const short* input, __m256 values[4])
+  {
+    for (int k = 0; k < 4; ++k)
+    {
+      values[k] = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 8 * k))));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template<class ScalarType>
+  IGSIO_TARGET_AVX2 void ScaleToUnsignedCharAVX2(const ScalarType* input, unsigned char* output, long long numberOfValues, float scale, float shift)
+  {
+    const __m256 scaleVector = _mm256_set1_ps(scale);
+    const __m256 shiftVector = _mm256_set1_ps(shift);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 maximum = _mm256_set1_ps(255.f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    // Packing works within 128-bit lanes, this permutation restores the order of the 4-byte groups
+    const __m256i laneOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    long long i = 0;
+    for (; i + 32 <= numberOfValues; i += 32)
+    {
+      __m256 values[4];
+      LoadFloatsAVX2(input + i, values);
+      __m256i integers[4];
+      for (int k = 0; k < 4; ++k)
+      {
+        __m256 v = _mm256_add_ps(_mm256_mul_ps(values[k], scaleVector), shiftVector);
+        v = _mm256_add_ps(_mm256_min_ps(_mm256_max_ps(v, zero), maximum), half);
+        integers[k] = _mm256_cvttps_epi32(v);
+      }
+      __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(integers[0], integers[1]), _mm256_packs_epi32(integers[2], integers[3]));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_permutevar8x32_epi32(packed, laneOrder));
+    }
+    ScaleToUnsignedCharScalar(input + i, output + i, numberOfValues - i, scale, shift);
+  }
+#endif
+
+#ifdef IGSIO_PIXEL_CONVERSION_NEON
+  //----------------------------------------------------------------------------
+  /*! Load 16 values and convert them to float */
+  inline void LoadFloatsNEON(const float* input, float32x4_t values[4])
+  {
+    for (int k = 0; k < 4; ++k)
+    {
+      values[k] = vld1q_f32(input + 4 * k);
+    }
+  }
+
+  inline void LoadFloatsNEON(const unsigned short* input, float32x4_t values[4])
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      uint16x8_t v = vld1q_u16(input + 8 * i);
+      values[2 * i] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+      values[2 * i + 1] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(v)));
+    }
+  }
+
+  inline void LoadFloatsNEON(const short* input, float32x4_t values[4])
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      int16x8_t v = vld1q_s16(input + 8 * i);
+      values[2 * i] = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+      values[2 * i + 1] = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template<class ScalarType>
+  void ScaleToUnsignedCharNEON(const ScalarType* input, unsigned char* output, long long numberOfValues, float scale, float shift)
+  {
+    const float32x4_t scaleVector = vdupq_n_f32(scale);
+    const float32x4_t shiftVector = vdupq_n_f32(shift);
+    const float32x4_t zero = vdupq_n_f32(0.f);
+    const float32x4_t maximum = vdupq_n_f32(255.f);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    long long i = 0;
+    for (; i + 16 <= numberOfValues; i += 16)
+    {
+      float32x4_t values[4];
+      LoadFloatsNEON(input + i, values);
+      uint32x4_t integers[4];
+      for (int k = 0; k < 4; ++k)
+      {
+        // NaN stays NaN through min/max and is converted to 0
+        float32x4_t v = vaddq_f32(vmulq_f32(values[k], scaleVector), shiftVector);
+        v = vaddq_f32(vminq_f32(vmaxq_f32(v, zero), maximum), half);
+        integers[k] = vcvtq_u32_f32(v);
+      }
+      uint16x8_t low = vcombine_u16(vmovn_u32(integers[0]), vmovn_u32(integers[1]));
+      uint16x8_t high = vcombine_u16(vmovn_u32(integers[2]), vmovn_u32(integers[3]));
+      vst1q_u8(output + i, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+    }
+    ScaleToUnsignedCharScalar(input + i, output + i, numberOfValues - i, scale, shift);
+  }
+#endif
+
+  //----------------------------------------------------------------------------
+  /*! Scale using the best available implementation for the scalar type */
+  template<class ScalarType>
+  void ScaleToUnsignedCharVectorized(const ScalarType* input, unsigned char* output, long long numberOfValues, float scale, float shift)
+  {
+    switch (igsioFlipClipKernels::GetInstructionSet())
+    {
+#ifdef IGSIO_PIXEL_CONVERSION_AVX2
+      case igsioFlipClipKernels::INSTRUCTION_SET_AVX2:
+        ScaleToUnsignedCharAVX2(input, output, numberOfValues, scale, shift);
+        return;
+#endif
+#ifdef IGSIO_PIXEL_CONVERSION_SSE2
+      case igsioFlipClipKernels::INSTRUCTION_SET_SSE2:
+        ScaleToUnsignedCharSSE2(input, output, numberOfValues, scale, shift);
+        return;
+#endif
+#ifdef IGSIO_PIXEL_CONVERSION_NEON
+      case igsioFlipClipKernels::INSTRUCTION_SET_NEON:
+        ScaleToUnsignedCharNEON(input, output, numberOfValues, scale, shift);
+        return;
+#endif
+      default:
+        ScaleToUnsignedCharScalar(input, output, numberOfValues, scale, shift);
+        return;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+bool igsioPixelConversionKernels::IsScaleToUnsignedCharSupported(igsioCommon::VTKScalarPixelType inputScalarType)
+{
+  switch (inputScalarType)
+  {
+    vtkTemplateMacro(return true);
+    default:
+      return false;
+  }
+}
+
+//----------------------------------------------------------------------------
+igsioStatus igsioPixelConversionKernels::ScaleToUnsignedChar(const void* input, igsioCommon::VTKScalarPixelType inputScalarType, unsigned char* output, long long numberOfValues, float scale, float shift)
+{
+  if (numberOfValues <= 0)
+  {
+    return IGSIO_SUCCESS;
+  }
+  // Vectorized implementations
+  if (inputScalarType == VTK_UNSIGNED_SHORT)
+  {
+    ScaleToUnsignedCharVectorized(static_cast<const unsigned short*>(input), output, numberOfValues, scale, shift);
+    return IGSIO_SUCCESS;
+  }
+  if (inputScalarType == VTK_SHORT)
+  {
+    ScaleToUnsignedCharVectorized(static_cast<const short*>(input), output, numberOfValues, scale, shift);
+    return IGSIO_SUCCESS;
+  }
+  if (inputScalarType == VTK_FLOAT)
+  {
+    ScaleToUnsignedCharVectorized(static_cast<const float*>(input), output, numberOfValues, scale, shift);
+    return IGSIO_SUCCESS;
+  }
+  switch (inputScalarType)
+  {
+    vtkTemplateMacro(ScaleToUnsignedCharScalar(static_cast<const VTK_TT*>(input), output, numberOfValues, scale, shift); return IGSIO_SUCCESS);
+    default:
+      LOG_ERROR("Pixel conversion to unsigned char is not supported for scalar type " << inputScalarType);
+      return IGSIO_FAIL;
+  }
+}
+
+//----------------------------------------------------------------------------
+igsioStatus igsioPixelConversionKernels::GetRange(const void* input, igsioCommon::VTKScalarPixelType inputScalarType, long long numberOfValues, double range[2])
+{
+  if (numberOfValues <= 0)
+  {
+    LOG_ERROR("Unable to compute the range of pixel values - there are no values");
+    return IGSIO_FAIL;
+  }
+  switch (inputScalarType)
+  {
+    vtkTemplateMacro(GetRangeScalar(static_cast<const VTK_TT*>(input), numberOfValues, range); return IGSIO_SUCCESS);
+    default:
+      LOG_ERROR("Unable to compute the range of pixel values - unsupported scalar type " << inputScalarType);
+      return IGSIO_FAIL;
+  }
+}
+
+//----------------------------------------------------------------------------
+void igsioPixelConversionKernels::RGBToGray(const unsigned char* input, int numberOfInputComponents, unsigned char* output, long long numberOfPixels)
+{
+  if (numberOfInputComponents == 4)
+  {
+    RGBToGrayScalar<4>(input, output, numberOfPixels);
+  }
+  else
+  {
+    RGBToGrayScalar<3>(input, output, numberOfPixels);
+  }
+}
+
+//----------------------------------------------------------------------------
+void igsioPixelConversionKernels::GrayToRGB(const unsigned char* input, unsigned char* output, long long numberOfPixels)
+{
+  for (long long i = 0; i < numberOfPixels; ++i)
+  {
+    output[3 * i] = input[i];
+    output[3 * i + 1] = input[i];
+    output[3 * i + 2] = input[i];
+  }
+}
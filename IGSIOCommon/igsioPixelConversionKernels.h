@@ -0,0 +1,56 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __igsioPixelConversionKernels_h
+#define __igsioPixelConversionKernels_h
+
+#include "vtkigsiocommon_export.h"
+
+// IGSIO includes
+#include "igsioCommon.h"
+
+/*!
+  \class igsioPixelConversionKernels
+  \brief Pixel value conversion kernels used by igsioVideoFrame::ConvertPixelType
+
+  Scaling to 8-bit (window/level and linear rescale) has SSE2, AVX2 and NEON implementations for unsigned short,
+  short and float input. Other scalar types and the RGB/gray conversions use scalar implementations that the compiler
+  can auto-vectorize. All implementations clamp, round and convert the values the same way, so the results are identical
+  (except where the compiler fuses the scalar multiply-add, which may change the rounding by one gray level).
+
+  The kernels use the instruction set that is selected in igsioFlipClipKernels (see igsioFlipClipKernels::SetInstructionSet).
+
+  \ingroup PlusLibCommon
+*/
+class VTKIGSIOCOMMON_EXPORT igsioPixelConversionKernels
+{
+public:
+  /*! Check if ScaleToUnsignedChar supports the scalar type */
+  static bool IsScaleToUnsignedCharSupported(igsioCommon::VTKScalarPixelType inputScalarType);
+
+  /*!
+    Compute output = clamp(round(input * scale + shift), 0, 255) for each value. The computation is done in single precision.
+    \param input First input value
+    \param inputScalarType VTK scalar type of the input values
+    \param output First output value
+    \param numberOfValues Number of values (number of pixels * number of components)
+  */
+  static igsioStatus ScaleToUnsignedChar(const void* input, igsioCommon::VTKScalarPixelType inputScalarType, unsigned char* output, long long numberOfValues, float scale, float shift);
+
+  /*! Get the minimum and maximum of the values. Fails for unsupported scalar types or if numberOfValues is not positive. */
+  static igsioStatus GetRange(const void* input, igsioCommon::VTKScalarPixelType inputScalarType, long long numberOfValues, double range[2]);
+
+  /*!
+    Convert RGB (or RGBA, the alpha channel is ignored) pixels to gray using the ITU-R BT.601 luma weights
+    in fixed point: gray = (77 * R + 150 * G + 29 * B + 128) / 256
+  */
+  static void RGBToGray(const unsigned char* input, int numberOfInputComponents, unsigned char* output, long long numberOfPixels);
+
+  /*! Convert gray pixels to RGB by replicating the gray value in all three components */
+  static void GrayToRGB(const unsigned char* input, unsigned char* output, long long numberOfPixels);
+};
+
+#endif
@@ -0,0 +1,275 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// IGSIO includes
+#include "igsioPoseIndex.h"
+
+// VTK includes
+#include <vtkMath.h>
+
+// STL includes
+#include <algorithm>
+#include <math.h>
+
+//----------------------------------------------------------------------------
+bool igsioPoseIndex::CellKey::operator==(const CellKey& other) const
+{
+  return this->Index[0] == other.Index[0] && this->Index[1] == other.Index[1] && this->Index[2] == other.Index[2];
+}
+
+//----------------------------------------------------------------------------
+size_t igsioPoseIndex::CellKeyHash::operator()(const CellKey& key) const
+{
+  // Multiply by large primes and combine (spatial hashing)
+  return static_cast<size_t>(key.Index[0] * 73856093LL) ^ static_cast<size_t>(key.Index[1] * 19349663LL) ^ static_cast<size_t>(key.Index[2] * 83492791LL);
+}
+
+//----------------------------------------------------------------------------
+igsioPoseIndex::igsioPoseIndex()
+  : Type(TRANSFORM_POSE)
+  , TranslationToleranceMm(0.0)
+  , AngleToleranceDeg(0.0)
+  , MinRotationCosine(1.0)
+{
+  this->CellSize[0] = this->CellSize[1] = this->CellSize[2] = 1.0;
+}
+
+//----------------------------------------------------------------------------
+igsioPoseIndex::~igsioPoseIndex()
+{
+}
+
+//----------------------------------------------------------------------------
+void igsioPoseIndex::Initialize(PoseType poseType, double translationToleranceMm, double angleToleranceDeg)
+{
+  this->Clear();
+  this->Type = poseType;
+  this->TranslationToleranceMm = translationToleranceMm;
+  this->AngleToleranceDeg = angleToleranceDeg;
+  if (!this->IsEnabled())
+  {
+    return;
+  }
+
+  this->CellSize[0] = translationToleranceMm;
+  this->CellSize[1] = translationToleranceMm;
+  // Encoder poses: probe position, template position, probe rotation
+  this->CellSize[2] = (poseType == ENCODER_POSE ? angleToleranceDeg : translationToleranceMm);
+  this->MinRotationCosine = cos(vtkMath::RadiansFromDegrees(std::min(angleToleranceDeg, 180.0)));
+}
+
+//----------------------------------------------------------------------------
+igsioPoseIndex::PoseType igsioPoseIndex::GetPoseType() const
+{
+  return this->Type;
+}
+
+//----------------------------------------------------------------------------
+double igsioPoseIndex::GetTranslationToleranceMm() const
+{
+  return this->TranslationToleranceMm;
+}
+
+//----------------------------------------------------------------------------
+double igsioPoseIndex::GetAngleToleranceDeg() const
+{
+  return this->AngleToleranceDeg;
+}
+
+//----------------------------------------------------------------------------
+bool igsioPoseIndex::IsEnabled() const
+{
+  // If the threshold is zero then poses are different for sure, no need to store them
+  return this->TranslationToleranceMm > 0 && this->AngleToleranceDeg > 0;
+}
+
+//----------------------------------------------------------------------------
+igsioPoseIndex::CellKey igsioPoseIndex::GetCellKey(const double coordinates[3]) const
+{
+  CellKey key;
+  for (int i = 0; i < 3; ++i)
+  {
+    key.Index[i] = static_cast<long long>(floor(coordinates[i] / this->CellSize[i]));
+  }
+  return key;
+}
+
+//----------------------------------------------------------------------------
+void igsioPoseIndex::AddPoseEntry(const PoseEntry& entry)
+{
+  if (!this->IsEnabled())
+  {
+    return;
+  }
+  this->RemovePose(entry.TrackedFrame);
+  CellKey key = this->GetCellKey(entry.Coordinates);
+  this->Cells[key].push_back(entry);
+  this->FrameCells[entry.TrackedFrame] = key;
+}
+
+//----------------------------------------------------------------------------
+void igsioPoseIndex::AddTransformPose(const igsioTrackedFrame* trackedFrame, const double matrix[16])
+{
+  if (this->Type != TRANSFORM_POSE)
+  {
+    LOG_ERROR("igsioPoseIndex::AddTransformPose failed: the index does not store transform poses");
+    return;
+  }
+  PoseEntry entry;
+  entry.TrackedFrame = trackedFrame;
+  for (int row = 0; row < 3; ++row)
+  {
+    entry.Coordinates[row] = matrix[row * 4 + 3];
+    for (int col = 0; col < 3; ++col)
+    {
+      entry.Rotation[row * 3 + col] = matrix[row * 4 + col];
+    }
+  }
+  this->AddPoseEntry(entry);
+}
+
+//----------------------------------------------------------------------------
+void igsioPoseIndex::AddEncoderPose(const igsioTrackedFrame* trackedFrame, double probePosition, double probeRotation, double templatePosition)
+{
+  if (this->Type != ENCODER_POSE)
+  {
+    LOG_ERROR("igsioPoseIndex::AddEncoderPose failed: the index does not store encoder poses");
+    return;
+  }
+  PoseEntry entry;
+  entry.TrackedFrame = trackedFrame;
+  entry.Coordinates[0] = probePosition;
+  entry.Coordinates[1] = templatePosition;
+  entry.Coordinates[2] = probeRotation;
+  this->AddPoseEntry(entry);
+}
+
+//----------------------------------------------------------------------------
+void igsioPoseIndex::RemovePose(const igsioTrackedFrame* trackedFrame)
+{
+  std::unordered_map<const igsioTrackedFrame*, CellKey>::iterator frameCellIt = this->FrameCells.find(trackedFrame);
+  if (frameCellIt == this->FrameCells.end())
+  {
+    return;
+  }
+  CellMapType::iterator cellIt = this->Cells.find(frameCellIt->second);
+  if (cellIt != this->Cells.end())
+  {
+    std::vector<PoseEntry>& entries = cellIt->second;
+    for (std::vector<PoseEntry>::iterator entryIt = entries.begin(); entryIt != entries.end(); ++entryIt)
+    {
+      if (entryIt->TrackedFrame == trackedFrame)
+      {
+        entries.erase(entryIt);
+        break;
+      }
+    }
+    if (entries.empty())
+    {
+      this->Cells.erase(cellIt);
+    }
+  }
+  this->FrameCells.erase(frameCellIt);
+}
+
+//----------------------------------------------------------------------------
+bool igsioPoseIndex::ContainsSimilarTransformPose(const double matrix[16]) const
+{
+  PoseEntry queryEntry;
+  queryEntry.TrackedFrame = NULL;
+  for (int row = 0; row < 3; ++row)
+  {
+    queryEntry.Coordinates[row] = matrix[row * 4 + 3];
+    for (int col = 0; col < 3; ++col)
+    {
+      queryEntry.Rotation[row * 3 + col] = matrix[row * 4 + col];
+    }
+  }
+  return this->ContainsSimilarPose(queryEntry);
+}
+
+//----------------------------------------------------------------------------
+bool igsioPoseIndex::ContainsSimilarEncoderPose(double probePosition, double probeRotation, double templatePosition) const
+{
+  PoseEntry queryEntry;
+  queryEntry.TrackedFrame = NULL;
+  queryEntry.Coordinates[0] = probePosition;
+  queryEntry.Coordinates[1] = templatePosition;
+  queryEntry.Coordinates[2] = probeRotation;
+  return this->ContainsSimilarPose(queryEntry);
+}
+
+//----------------------------------------------------------------------------
+bool igsioPoseIndex::ContainsSimilarPose(const PoseEntry& queryEntry) const
+{
+  if (!this->IsEnabled() || this->Cells.empty())
+  {
+    return false;
+  }
+
+  // Similar poses differ by less than one cell size along each axis, so they are in the neighbor cells
+  CellKey queryKey = this->GetCellKey(queryEntry.Coordinates);
+  CellKey key;
+  for (key.Index[0] = queryKey.Index[0] - 1; key.Index[0] <= queryKey.Index[0] + 1; ++key.Index[0])
+  {
+    for (key.Index[1] = queryKey.Index[1] - 1; key.Index[1] <= queryKey.Index[1] + 1; ++key.Index[1])
+    {
+      for (key.Index[2] = queryKey.Index[2] - 1; key.Index[2] <= queryKey.Index[2] + 1; ++key.Index[2])
+      {
+        CellMapType::const_iterator cellIt = this->Cells.find(key);
+        if (cellIt == this->Cells.end())
+        {
+          continue;
+        }
+        for (std::vector<PoseEntry>::const_iterator entryIt = cellIt->second.begin(); entryIt != cellIt->second.end(); ++entryIt)
+        {
+          if (this->IsSimilar(queryEntry, *entryIt))
+          {
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+bool igsioPoseIndex::IsSimilar(const PoseEntry& entryA, const PoseEntry& entryB) const
+{
+  if (this->Type == ENCODER_POSE)
+  {
+    double positionDifference = fabs(entryA.Coordinates[0] - entryB.Coordinates[0]) + fabs(entryA.Coordinates[1] - entryB.Coordinates[1]);
+    double rotationDifference = fabs(entryA.Coordinates[2] - entryB.Coordinates[2]);
+    return positionDifference < this->TranslationToleranceMm && rotationDifference < this->AngleToleranceDeg;
+  }
+
+  double squaredDistance = vtkMath::Distance2BetweenPoints(entryA.Coordinates, entryB.Coordinates);
+  if (squaredDistance >= this->TranslationToleranceMm * this->TranslationToleranceMm)
+  {
+    return false;
+  }
+  // Rotation angle between the orientations: cos(angle) = (trace(A * B^T) - 1) / 2
+  double trace = 0.0;
+  for (int i = 0; i < 9; ++i)
+  {
+    trace += entryA.Rotation[i] * entryB.Rotation[i];
+  }
+  return (trace - 1.0) / 2.0 > this->MinRotationCosine;
+}
+
+//----------------------------------------------------------------------------
+void igsioPoseIndex::Clear()
+{
+  this->Cells.clear();
+  this->FrameCells.clear();
+}
+
+//----------------------------------------------------------------------------
+unsigned int igsioPoseIndex::GetNumberOfPoses() const
+{
+  return static_cast<unsigned int>(this->FrameCells.size());
+}
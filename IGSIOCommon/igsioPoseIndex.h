@@ -0,0 +1,119 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __igsioPoseIndex_h
+#define __igsioPoseIndex_h
+
+#include "vtkigsiocommon_export.h"
+
+// IGSIO includes
+#include "igsioCommon.h"
+
+// STL includes
+#include <unordered_map>
+#include <vector>
+
+class igsioTrackedFrame;
+
+/*!
+  \class igsioPoseIndex
+  \brief Spatial index of tracked frame poses for finding frames acquired at a similar pose
+
+  Poses are stored in a hash grid. The cell size is the translation tolerance along the position axes
+  (and the angle tolerance along the rotation axis for encoder poses), so all poses that may be within
+  the tolerance of a queried pose are in the 3x3x3 neighborhood of the queried cell. The number of exact comparisons
+  depends on the local pose density and not on the total number of indexed poses.
+
+  Two kinds of poses are supported, selected in Initialize:
+  - TRANSFORM_POSE: rigid transform matrix. Poses are similar if the translation difference (Euclidean distance)
+    is less than the translation tolerance and the rotation angle between them is less than the angle tolerance.
+  - ENCODER_POSE: stepper encoder values. Poses are similar if the sum of the probe and template position differences
+    is less than the translation tolerance and the probe rotation difference is less than the angle tolerance.
+
+  If any of the tolerances is not positive then poses are never similar (same as in TrackedFrameTransformFinder).
+
+  \ingroup PlusLibCommon
+*/
+class VTKIGSIOCOMMON_EXPORT igsioPoseIndex
+{
+public:
+  enum PoseType
+  {
+    TRANSFORM_POSE = 0,
+    ENCODER_POSE
+  };
+
+  igsioPoseIndex();
+  virtual ~igsioPoseIndex();
+
+  /*! Set the kind of stored poses and the similarity tolerances. Removes all poses from the index. */
+  void Initialize(PoseType poseType, double translationToleranceMm, double angleToleranceDeg);
+
+  PoseType GetPoseType() const;
+  double GetTranslationToleranceMm() const;
+  double GetAngleToleranceDeg() const;
+
+  /*! Add the pose of a frame given by a transform matrix (16 values, row-major). Only for TRANSFORM_POSE index. */
+  void AddTransformPose(const igsioTrackedFrame* trackedFrame, const double matrix[16]);
+
+  /*! Add the pose of a frame given by stepper encoder values. Only for ENCODER_POSE index. */
+  void AddEncoderPose(const igsioTrackedFrame* trackedFrame, double probePosition, double probeRotation, double templatePosition);
+
+  /*! Remove the pose of a frame from the index. Does nothing if the frame is not in the index. */
+  void RemovePose(const igsioTrackedFrame* trackedFrame);
+
+  /*! Check if the index contains a pose that is similar to the transform (16 values, row-major) */
+  bool ContainsSimilarTransformPose(const double matrix[16]) const;
+
+  /*! Check if the index contains a pose that is similar to the encoder values */
+  bool ContainsSimilarEncoderPose(double probePosition, double probeRotation, double templatePosition) const;
+
+  /*! Remove all poses */
+  void Clear();
+
+  /*! Get the number of poses in the index */
+  unsigned int GetNumberOfPoses() const;
+
+protected:
+  struct CellKey
+  {
+    long long Index[3];
+    bool operator==(const CellKey& other) const;
+  };
+  struct CellKeyHash
+  {
+    size_t operator()(const CellKey& key) const;
+  };
+
+  /*! Pose stored in the index. Coordinates are the position (or encoder values), Rotation is only used for transform poses. */
+  struct PoseEntry
+  {
+    const igsioTrackedFrame* TrackedFrame;
+    double Coordinates[3];
+    double Rotation[9];
+  };
+
+  typedef std::unordered_map<CellKey, std::vector<PoseEntry>, CellKeyHash> CellMapType;
+
+  CellKey GetCellKey(const double coordinates[3]) const;
+  void AddPoseEntry(const PoseEntry& entry);
+  bool ContainsSimilarPose(const PoseEntry& queryEntry) const;
+  bool IsSimilar(const PoseEntry& entryA, const PoseEntry& entryB) const;
+  bool IsEnabled() const;
+
+  PoseType Type;
+  double TranslationToleranceMm;
+  double AngleToleranceDeg;
+  /*! Cell size along each coordinate axis */
+  double CellSize[3];
+  /*! Minimum cosine of the rotation angle for similar transform poses (precomputed from the angle tolerance) */
+  double MinRotationCosine;
+
+  CellMapType Cells;
+  std::unordered_map<const igsioTrackedFrame*, CellKey> FrameCells;
+};
+
+#endif
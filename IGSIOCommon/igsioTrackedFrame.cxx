@@ -18,6 +18,7 @@ See License.txt for details.
 
 // STD includes
 #include <algorithm>
+#include <utility>
 
 //----------------------------------------------------------------------------
 // ************************* TrackedFrame ************************************
@@ -28,6 +29,51 @@ const std::string igsioTrackedFrame::TransformPostfix = "Transform";
 const std::string igsioTrackedFrame::TransformStatusPostfix = "TransformStatus";
 const int FLOATING_POINT_PRECISION = 16; // Number of digits used when writing transforms and timestamps
 
+namespace
+{
+  //----------------------------------------------------------------------------
+  std::string ConvertTransformToString(const double transform[16])
+  {
+    std::ostringstream strTransform;
+    for (int i = 0; i < 16; ++i)
+    {
+      strTransform << std::setprecision(FLOATING_POINT_PRECISION) << transform[ i ] << " ";
+    }
+    return strTransform.str();
+  }
+
+  //----------------------------------------------------------------------------
+  igsioStatus ConvertStringToTransform(const std::string& transformStr, double transform[16])
+  {
+    std::istringstream transformFieldValue(transformStr);
+    double item;
+    int i = 0;
+    while (i < 16 && transformFieldValue >> item)
+    {
+      transform[i++] = item;
+    }
+    return (i == 16 ? IGSIO_SUCCESS : IGSIO_FAIL);
+  }
+
+  //----------------------------------------------------------------------------
+  // Get the name of the transform field that a status field belongs to (ProbeToTrackerTransformStatus -> ProbeToTrackerTransform)
+  std::string GetTransformFieldNameOfStatus(const std::string& statusFieldName)
+  {
+    return statusFieldName.substr(0, statusFieldName.length() - igsioTrackedFrame::TransformStatusPostfix.length() + igsioTrackedFrame::TransformPostfix.length());
+  }
+}
+
+//----------------------------------------------------------------------------
+igsioTrackedFrame::FrameTransformEntry::FrameTransformEntry()
+  : Status(TOOL_INVALID)
+  , MatrixValid(false)
+  , StatusValid(false)
+  , MatrixTextStale(false)
+  , StatusTextStale(false)
+{
+  vtkMatrix4x4::Identity(this->Matrix);
+}
+
 //----------------------------------------------------------------------------
 igsioTrackedFrame::igsioTrackedFrame()
 {
@@ -36,6 +82,7 @@ igsioTrackedFrame::igsioTrackedFrame()
   this->FrameSize[1] = 0;
   this->FrameSize[2] = 1; // single-slice frame by default
   this->FiducialPointsCoordinatePx = NULL;
+  this->TransformFrameFieldsStale = false;
 }
 
 //----------------------------------------------------------------------------
@@ -52,6 +99,7 @@ igsioTrackedFrame::igsioTrackedFrame(const igsioTrackedFrame& frame)
   this->FrameSize[1] = 0;
   this->FrameSize[2] = 1; // single-slice frame by default
   this->FiducialPointsCoordinatePx = NULL;
+  this->TransformFrameFieldsStale = false;
 
   *this = frame;
 }
@@ -66,8 +114,11 @@ igsioTrackedFrame& igsioTrackedFrame::operator=(igsioTrackedFrame const& tracked
   }
 
   this->FrameFields = trackedFrame.FrameFields;
+  this->FrameTransforms = trackedFrame.FrameTransforms;
+  this->TransformFrameFieldsStale = trackedFrame.TransformFrameFieldsStale;
   this->ImageData = trackedFrame.ImageData;
   this->Timestamp = trackedFrame.Timestamp;
+  this->TimestampModified();
   this->FrameSize[0] = trackedFrame.FrameSize[0];
   this->FrameSize[1] = trackedFrame.FrameSize[1];
   this->FrameSize[2] = trackedFrame.FrameSize[2];
@@ -76,6 +127,54 @@ igsioTrackedFrame& igsioTrackedFrame::operator=(igsioTrackedFrame const& tracked
   return *this;
 }
 
+//----------------------------------------------------------------------------
+igsioTrackedFrame::igsioTrackedFrame(igsioTrackedFrame&& frame)
+{
+  this->Timestamp = 0;
+  this->FrameSize[0] = 0;
+  this->FrameSize[1] = 0;
+  this->FrameSize[2] = 1; // single-slice frame by default
+  this->FiducialPointsCoordinatePx = NULL;
+  this->TransformFrameFieldsStale = false;
+
+  *this = std::move(frame);
+}
+
+//----------------------------------------------------------------------------
+igsioTrackedFrame& igsioTrackedFrame::operator=(igsioTrackedFrame&& trackedFrame)
+{
+  // Handle self-assignment
+  if (this == &trackedFrame)
+  {
+    return *this;
+  }
+
+  this->FrameFields = std::move(trackedFrame.FrameFields);
+  this->FrameTransforms = std::move(trackedFrame.FrameTransforms);
+  this->TransformFrameFieldsStale = trackedFrame.TransformFrameFieldsStale;
+  this->ImageData = std::move(trackedFrame.ImageData);
+  this->Timestamp = trackedFrame.Timestamp;
+  this->TimestampModified();
+  this->FrameSize[0] = trackedFrame.FrameSize[0];
+  this->FrameSize[1] = trackedFrame.FrameSize[1];
+  this->FrameSize[2] = trackedFrame.FrameSize[2];
+
+  // Take over the reference of the source frame
+  this->SetFiducialPointsCoordinatePx(NULL);
+  this->FiducialPointsCoordinatePx = trackedFrame.FiducialPointsCoordinatePx;
+  trackedFrame.FiducialPointsCoordinatePx = NULL;
+
+  // Leave the source frame in a valid, empty state
+  trackedFrame.FrameFields.Clear();
+  trackedFrame.FrameTransforms.clear();
+  trackedFrame.TransformFrameFieldsStale = false;
+  trackedFrame.FrameSize[0] = 0;
+  trackedFrame.FrameSize[1] = 0;
+  trackedFrame.FrameSize[2] = 1;
+
+  return *this;
+}
+
 //----------------------------------------------------------------------------
 igsioStatus igsioTrackedFrame::GetTrackedFrameInXmlData(std::string& strXmlData, const std::vector<igsioTransformName>& requestedTransforms) const
 {
@@ -124,36 +223,40 @@ igsioStatus igsioTrackedFrame::PrintToXML(vtkXMLDataElement* trackedFrame, const
     trackedFrame->SetVectorAttribute("FrameSize", 3, frameSizeSigned);
   }
 
-  for (igsioFieldMapType::const_iterator fieldIter = this->FrameFields.begin(); fieldIter != this->FrameFields.end(); ++fieldIter)
+  // Fields are written in alphabetical order
+  std::vector<const igsioFrameFieldContainer::Field*> sortedFields;
+  this->FrameFields.GetFieldsSortedByName(sortedFields);
+  for (std::vector<const igsioFrameFieldContainer::Field*>::const_iterator fieldIter = sortedFields.begin(); fieldIter != sortedFields.end(); ++fieldIter)
   {
+    const std::string& fieldName = (*fieldIter)->GetName();
     // Only use requested transforms mechanism if the vector is not empty
-    if (!requestedTransforms.empty() && (igsioTrackedFrame::IsTransform(fieldIter->first) || igsioTrackedFrame::IsTransformStatus(fieldIter->first)))
+    if (!requestedTransforms.empty() && (igsioTrackedFrame::IsTransform(fieldName) || igsioTrackedFrame::IsTransformStatus(fieldName)))
     {
-      if (igsioTrackedFrame::IsTransformStatus(fieldIter->first))
+      if (igsioTrackedFrame::IsTransformStatus(fieldName))
       {
         continue;
       }
-      if (std::find(requestedTransforms.begin(), requestedTransforms.end(), igsioTransformName(fieldIter->first)) == requestedTransforms.end())
+      if (std::find(requestedTransforms.begin(), requestedTransforms.end(), igsioTransformName(fieldName)) == requestedTransforms.end())
       {
         continue;
       }
-      auto statusName = fieldIter->first;
-      statusName = statusName.substr(0, fieldIter->first.length() - TransformPostfix.length());
+      auto statusName = fieldName;
+      statusName = statusName.substr(0, fieldName.length() - TransformPostfix.length());
       statusName = statusName.append(TransformStatusPostfix);
       vtkSmartPointer<vtkXMLDataElement> customField = vtkSmartPointer<vtkXMLDataElement>::New();
-      auto iter = this->FrameFields.find(statusName);
-      if (iter != this->FrameFields.end())
+      const igsioFrameFieldContainer::Field* statusField = this->FrameFields.Find(statusName);
+      if (statusField != NULL)
       {
         customField->SetName("FrameField");
         customField->SetAttribute("Name", statusName.c_str());
-        customField->SetAttribute("Value", iter->second.second.c_str());
+        customField->SetAttribute("Value", this->GetFrameFieldText(*statusField).c_str());
         trackedFrame->AddNestedElement(customField);
       }
     }
     vtkSmartPointer<vtkXMLDataElement> customField = vtkSmartPointer<vtkXMLDataElement>::New();
     customField->SetName("FrameField");
-    customField->SetAttribute("Name", fieldIter->first.c_str());
-    customField->SetAttribute("Value", fieldIter->second.second.c_str());
+    customField->SetAttribute("Name", fieldName.c_str());
+    customField->SetAttribute("Value", this->GetFrameFieldText(**fieldIter).c_str());
     trackedFrame->AddNestedElement(customField);
   }
 
@@ -302,6 +405,15 @@ void igsioTrackedFrame::SetImageData(const igsioVideoFrame& value)
   this->ImageData.GetFrameSize(this->FrameSize);
 }
 
+//----------------------------------------------------------------------------
+void igsioTrackedFrame::SetImageData(igsioVideoFrame&& value)
+{
+  this->ImageData = std::move(value);
+
+  // Update our cached frame size
+  this->ImageData.GetFrameSize(this->FrameSize);
+}
+
 //----------------------------------------------------------------------------
 igsioVideoFrame* igsioTrackedFrame::GetImageData()
 {
@@ -312,10 +424,23 @@ igsioVideoFrame* igsioTrackedFrame::GetImageData()
 void igsioTrackedFrame::SetTimestamp(double value)
 {
   this->Timestamp = value;
+  this->TimestampModified();
   std::ostringstream strTimestamp;
   strTimestamp << std::setprecision(FLOATING_POINT_PRECISION) << this->Timestamp;
-  this->FrameFields["Timestamp"].first = FRAMEFIELD_NONE;
-  this->FrameFields["Timestamp"].second = strTimestamp.str();
+  static const igsioFrameFieldId timestampFieldId = igsioFrameFieldRegistry::GetInstance()->GetFieldId("Timestamp");
+  igsioFrameFieldContainer::Field& timestampField = this->FrameFields.Insert(timestampFieldId);
+  timestampField.Flags = FRAMEFIELD_NONE;
+  timestampField.Value = strTimestamp.str();
+}
+
+//----------------------------------------------------------------------------
+void igsioTrackedFrame::TimestampModified()
+{
+  if (this->TimestampChangeCounter != NULL)
+  {
+    // Atomic, as frames may be modified while the list reads the counter in another thread
+    (*this->TimestampChangeCounter)++;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -391,11 +516,28 @@ void igsioTrackedFrame::SetFrameField(std::string name, std::string value, igsio
     else
     {
       this->Timestamp = timestamp;
+      this->TimestampModified();
     }
   }
+  else if (igsioTrackedFrame::IsTransform(name))
+  {
+    // Keep the binary copy of the transform in sync with the new text value
+    FrameTransformEntry& entry = this->GetFrameTransformEntry(name);
+    entry.MatrixValid = (ConvertStringToTransform(value, entry.Matrix) == IGSIO_SUCCESS);
+    entry.MatrixTextStale = false;
+  }
+  else if (igsioTrackedFrame::IsTransformStatus(name))
+  {
+    // Key of the entry is the transform field name (status field name without the "Status" postfix)
+    FrameTransformEntry& entry = this->GetFrameTransformEntry(GetTransformFieldNameOfStatus(name));
+    entry.Status = igsioCommon::ConvertStringToToolStatus(value);
+    entry.StatusValid = !value.empty();
+    entry.StatusTextStale = false;
+  }
 
-  this->FrameFields[name].first = flags;
-  this->FrameFields[name].second = value;
+  igsioFrameFieldContainer::Field& field = this->FrameFields.Insert(name);
+  field.Flags = flags;
+  field.Value = value;
 }
 
 //----------------------------------------------------------------------------
@@ -407,15 +549,87 @@ std::string igsioTrackedFrame::GetFrameField(const char* fieldName) const
     return "";
   }
 
-  igsioFieldMapType::const_iterator fieldIterator;
-  fieldIterator = this->FrameFields.find(fieldName);
-  if (fieldIterator != this->FrameFields.end())
+  const igsioFrameFieldContainer::Field* field = this->FrameFields.Find(std::string(fieldName));
+  if (field != NULL)
   {
-    return fieldIterator->second.second;
+    return this->GetFrameFieldText(*field);
   }
   return "";
 }
 
+//----------------------------------------------------------------------------
+const igsioTrackedFrame::FrameTransformEntry* igsioTrackedFrame::FindFrameTransformEntry(const std::string& transformFieldName) const
+{
+  igsioFrameFieldId transformFieldId(0);
+  if (!igsioFrameFieldRegistry::GetInstance()->FindFieldId(transformFieldName, transformFieldId))
+  {
+    return NULL;
+  }
+  FrameTransformMapType::const_iterator entryIt = this->FrameTransforms.find(transformFieldId);
+  if (entryIt == this->FrameTransforms.end())
+  {
+    return NULL;
+  }
+  return &(entryIt->second);
+}
+
+//----------------------------------------------------------------------------
+igsioTrackedFrame::FrameTransformEntry& igsioTrackedFrame::GetFrameTransformEntry(const std::string& transformFieldName)
+{
+  return this->FrameTransforms[igsioFrameFieldRegistry::GetInstance()->GetFieldId(transformFieldName)];
+}
+
+//----------------------------------------------------------------------------
+std::string igsioTrackedFrame::GetFrameFieldText(const igsioFrameFieldContainer::Field& field) const
+{
+  if (!this->TransformFrameFieldsStale)
+  {
+    // all text values are up-to-date
+    return field.Value;
+  }
+
+  const std::string& fieldName = field.GetName();
+  if (igsioTrackedFrame::IsTransform(fieldName))
+  {
+    FrameTransformMapType::const_iterator entryIt = this->FrameTransforms.find(field.Id);
+    if (entryIt != this->FrameTransforms.end() && entryIt->second.MatrixTextStale)
+    {
+      return ConvertTransformToString(entryIt->second.Matrix);
+    }
+  }
+  else if (igsioTrackedFrame::IsTransformStatus(fieldName))
+  {
+    const FrameTransformEntry* entry = this->FindFrameTransformEntry(GetTransformFieldNameOfStatus(fieldName));
+    if (entry != NULL && entry->StatusTextStale)
+    {
+      return igsioCommon::ConvertToolStatusToString(entry->Status);
+    }
+  }
+
+  return field.Value;
+}
+
+//----------------------------------------------------------------------------
+void igsioTrackedFrame::UpdateTransformFrameFields()
+{
+  if (!this->TransformFrameFieldsStale)
+  {
+    return;
+  }
+
+  for (igsioFrameFieldContainer::iterator fieldIt = this->FrameFields.begin(); fieldIt != this->FrameFields.end(); ++fieldIt)
+  {
+    fieldIt->Value = this->GetFrameFieldText(*fieldIt);
+  }
+  for (FrameTransformMapType::iterator entryIt = this->FrameTransforms.begin(); entryIt != this->FrameTransforms.end(); ++entryIt)
+  {
+    entryIt->second.MatrixTextStale = false;
+    entryIt->second.StatusTextStale = false;
+  }
+
+  this->TransformFrameFieldsStale = false;
+}
+
 //----------------------------------------------------------------------------
 std::string igsioTrackedFrame::GetFrameField(const std::string& fieldName) const
 {
@@ -431,10 +645,41 @@ igsioStatus igsioTrackedFrame::DeleteFrameField(const char* fieldName)
     return IGSIO_FAIL;
   }
 
-  igsioFieldMapType::iterator field = this->FrameFields.find(fieldName);
-  if (field != this->FrameFields.end())
+  std::string name(fieldName);
+  if (this->FrameFields.Erase(name))
   {
-    this->FrameFields.erase(field);
+    if (igsioTrackedFrame::IsTransform(name) || igsioTrackedFrame::IsTransformStatus(name))
+    {
+      bool isStatus = igsioTrackedFrame::IsTransformStatus(name);
+      if (isStatus)
+      {
+        name = GetTransformFieldNameOfStatus(name);
+      }
+      igsioFrameFieldId transformFieldId(0);
+      FrameTransformMapType::iterator entryIt = this->FrameTransforms.end();
+      if (igsioFrameFieldRegistry::GetInstance()->FindFieldId(name, transformFieldId))
+      {
+        entryIt = this->FrameTransforms.find(transformFieldId);
+      }
+      if (entryIt != this->FrameTransforms.end())
+      {
+        FrameTransformEntry& entry = entryIt->second;
+        if (isStatus)
+        {
+          entry.StatusValid = false;
+          entry.StatusTextStale = false;
+        }
+        else
+        {
+          entry.MatrixValid = false;
+          entry.MatrixTextStale = false;
+        }
+        if (!entry.MatrixValid && !entry.StatusValid)
+        {
+          this->FrameTransforms.erase(entryIt);
+        }
+      }
+    }
     return IGSIO_SUCCESS;
   }
   LOG_DEBUG("Failed to delete frame field - could find field " << fieldName);
@@ -474,9 +719,7 @@ bool igsioTrackedFrame::IsFrameFieldDefined(const char* fieldName)
     return false;
   }
 
-  igsioFieldMapType::iterator fieldIterator;
-  fieldIterator = this->FrameFields.find(fieldName);
-  if (fieldIterator != this->FrameFields.end())
+  if (this->FrameFields.Find(std::string(fieldName)) != NULL)
   {
     // field is found
     return true;
@@ -501,6 +744,13 @@ igsioStatus igsioTrackedFrame::GetFrameTransform(const igsioTransformName& frame
     transformName.append(TransformPostfix);
   }
 
+  const FrameTransformEntry* entry = this->FindFrameTransformEntry(transformName);
+  if (entry != NULL && entry->MatrixValid)
+  {
+    std::copy(entry->Matrix, entry->Matrix + 16, transform);
+    return IGSIO_SUCCESS;
+  }
+
   std::string frameTransformStr = GetFrameField(transformName);
   if (frameTransformStr.empty())
   {
@@ -508,7 +758,7 @@ igsioStatus igsioTrackedFrame::GetFrameTransform(const igsioTransformName& frame
     return IGSIO_FAIL;
   }
 
-  // Find default frame transform
+  // Field value could not be stored as a binary matrix (e.g., it has fewer than 16 elements), parse what is available
   std::istringstream transformFieldValue(frameTransformStr);
   double item;
   int i = 0;
@@ -550,6 +800,13 @@ igsioStatus igsioTrackedFrame::GetFrameTransformStatus(const igsioTransformName&
     transformStatusName.append(TransformStatusPostfix);
   }
 
+  const FrameTransformEntry* entry = this->FindFrameTransformEntry(GetTransformFieldNameOfStatus(transformStatusName));
+  if (entry != NULL && entry->StatusValid)
+  {
+    status = entry->Status;
+    return IGSIO_SUCCESS;
+  }
+
   std::string strStatus = this->GetFrameField(transformStatusName);
   if (strStatus.empty())
   {
@@ -582,9 +839,13 @@ igsioStatus igsioTrackedFrame::SetFrameTransformStatus(const igsioTransformName&
     transformStatusName.append(TransformStatusPostfix);
   }
 
-  std::string strStatus = igsioCommon::ConvertToolStatusToString(status);
-
-  this->SetFrameField(transformStatusName, strStatus);
+  // Store the status in binary form, text is generated when it is needed
+  FrameTransformEntry& entry = this->GetFrameTransformEntry(GetTransformFieldNameOfStatus(transformStatusName));
+  entry.Status = status;
+  entry.StatusValid = true;
+  entry.StatusTextStale = true;
+  this->FrameFields.Insert(transformStatusName).Flags = FRAMEFIELD_NONE;
+  this->TransformFrameFieldsStale = true;
 
   return IGSIO_SUCCESS;
 }
@@ -592,12 +853,6 @@ igsioStatus igsioTrackedFrame::SetFrameTransformStatus(const igsioTransformName&
 //----------------------------------------------------------------------------
 igsioStatus igsioTrackedFrame::SetFrameTransform(const igsioTransformName& frameTransformName, double transform[16])
 {
-  std::ostringstream strTransform;
-  for (int i = 0; i < 16; ++i)
-  {
-    strTransform << std::setprecision(FLOATING_POINT_PRECISION) << transform[ i ] << " ";
-  }
-
   std::string transformName;
   if (frameTransformName.GetTransformName(transformName) != IGSIO_SUCCESS)
   {
@@ -611,7 +866,13 @@ igsioStatus igsioTrackedFrame::SetFrameTransform(const igsioTransformName& frame
     transformName.append(TransformPostfix);
   }
 
-  SetFrameField(transformName, strTransform.str());
+  // Store the matrix in binary form, text is generated when it is needed
+  FrameTransformEntry& entry = this->GetFrameTransformEntry(transformName);
+  std::copy(transform, transform + 16, entry.Matrix);
+  entry.MatrixValid = true;
+  entry.MatrixTextStale = true;
+  this->FrameFields.Insert(transformName).Flags = FRAMEFIELD_NONE;
+  this->TransformFrameFieldsStale = true;
 
   return IGSIO_SUCCESS;
 }
@@ -661,6 +922,19 @@ std::string igsioTrackedFrame::ConvertFieldStatusToString(TrackedFrameFieldStatu
 //----------------------------------------------------------------------------
 const igsioFieldMapType& igsioTrackedFrame::GetCustomFields()
 {
+  igsioFieldMapType customFields = this->GetFrameFields();
+  if (customFields != this->CustomFields)
+  {
+    // Only replace the map if it has changed, to keep references and iterators of the previous calls valid
+    this->CustomFields.swap(customFields);
+  }
+  return this->CustomFields;
+}
+
+//----------------------------------------------------------------------------
+const igsioFrameFieldContainer& igsioTrackedFrame::GetFrameFieldContainer()
+{
+  this->UpdateTransformFrameFields();
   return this->FrameFields;
 }
 
@@ -668,9 +942,11 @@ const igsioFieldMapType& igsioTrackedFrame::GetCustomFields()
 void igsioTrackedFrame::GetFrameFieldNameList(std::vector<std::string>& fieldNames) const
 {
   fieldNames.clear();
-  for (igsioFieldMapType::const_iterator it = this->FrameFields.begin(); it != this->FrameFields.end(); it++)
+  std::vector<const igsioFrameFieldContainer::Field*> sortedFields;
+  this->FrameFields.GetFieldsSortedByName(sortedFields);
+  for (std::vector<const igsioFrameFieldContainer::Field*>::const_iterator it = sortedFields.begin(); it != sortedFields.end(); it++)
   {
-    fieldNames.push_back(it->first);
+    fieldNames.push_back((*it)->GetName());
   }
 }
 
@@ -678,12 +954,15 @@ void igsioTrackedFrame::GetFrameFieldNameList(std::vector<std::string>& fieldNam
 void igsioTrackedFrame::GetFrameTransformNameList(std::vector<igsioTransformName>& transformNames) const
 {
   transformNames.clear();
-  for (igsioFieldMapType::const_iterator it = this->FrameFields.begin(); it != this->FrameFields.end(); it++)
+  std::vector<const igsioFrameFieldContainer::Field*> sortedFields;
+  this->FrameFields.GetFieldsSortedByName(sortedFields);
+  for (std::vector<const igsioFrameFieldContainer::Field*>::const_iterator it = sortedFields.begin(); it != sortedFields.end(); it++)
   {
-    if (igsioTrackedFrame::IsTransform(it->first))
+    const std::string& fieldName = (*it)->GetName();
+    if (igsioTrackedFrame::IsTransform(fieldName))
     {
       igsioTransformName trName;
-      trName.SetTransformName(it->first.substr(0, it->first.length() - TransformPostfix.length()).c_str());
+      trName.SetTransformName(fieldName.substr(0, fieldName.length() - TransformPostfix.length()).c_str());
       transformNames.push_back(trName);
     }
   }
@@ -692,7 +971,14 @@ void igsioTrackedFrame::GetFrameTransformNameList(std::vector<igsioTransformName
 //----------------------------------------------------------------------------
 igsioFieldMapType igsioTrackedFrame::GetFrameFields() const
 {
-  return this->FrameFields;
+  igsioFieldMapType frameFields;
+  for (igsioFrameFieldContainer::const_iterator it = this->FrameFields.begin(); it != this->FrameFields.end(); ++it)
+  {
+    std::pair<igsioFrameFieldFlags, std::string>& field = frameFields[it->GetName()];
+    field.first = it->Flags;
+    field.second = this->GetFrameFieldText(*it);
+  }
+  return frameFields;
 }
 
 //----------------------------------------------------------------------------
@@ -10,8 +10,13 @@
 #include "vtkigsiocommon_export.h"
 
 #include "igsioCommon.h"
+#include "igsioFrameFields.h"
 #include "igsioVideoFrame.h"
 
+// STL includes
+#include <atomic>
+#include <memory>
+
 class vtkMatrix4x4;
 class vtkPoints;
 
@@ -22,6 +27,8 @@ class vtkPoints;
 */
 class VTKIGSIOCOMMON_EXPORT igsioTrackedFrame
 {
+  friend class vtkIGSIOTrackedFrameList;
+
 public:
   static const char* FIELD_FRIENDLY_DEVICE_NAME;
 
@@ -35,10 +42,18 @@ public:
   igsioTrackedFrame(const igsioTrackedFrame& frame);
   igsioTrackedFrame& operator=(igsioTrackedFrame const& trackedFrame);
 
+  /*! Move constructor. Image buffer, fields and transforms are taken over without copying, the source frame is left empty. */
+  igsioTrackedFrame(igsioTrackedFrame&& frame);
+  /*! Move assignment. Image buffer, fields and transforms are taken over without copying, the source frame is left empty. */
+  igsioTrackedFrame& operator=(igsioTrackedFrame&& trackedFrame);
+
 public:
   /*! Set image data */
   void SetImageData(const igsioVideoFrame& value);
 
+  /*! Set image data by taking over the image buffer of the passed frame (pixels are not copied) */
+  void SetImageData(igsioVideoFrame&& value);
+
   /*! Get image data */
   igsioVideoFrame* GetImageData();
 
@@ -133,10 +148,18 @@ public:
   /*! Convert from field status enum to field status string */
   static std::string ConvertFieldStatusToString(TrackedFrameFieldStatus status);
 
-  /*! Return all custom fields in a map */
+  /*!
+    Return all custom fields in a map.
+    The map is stored in the frame and only replaced when the fields have changed, so the returned reference
+    (and iterators of the map) remain valid until the fields are changed.
+    Deprecated: the name-indexed map is built on each call to detect changes. Use GetFrameFieldContainer or GetFrameFieldNameList instead.
+  */
   const igsioFieldMapType& GetCustomFields();
   igsioFieldMapType GetFrameFields() const;
 
+  /*! Get all frame fields without copying them (text of frame transforms is updated before returning) */
+  const igsioFrameFieldContainer& GetFrameFieldContainer();
+
   /*! Returns true if the input string ends with "Transform", else false */
   static bool IsTransform(std::string str);
 
@@ -153,17 +176,67 @@ public:
     return (Timestamp == data.Timestamp);
   }
 
+protected:
+  /*!
+    Binary copy of a frame transform and its status. Transforms are kept in this form so that
+    setting and getting them does not require formatting and parsing text. The text value
+    in FrameFields is only generated when it is requested (e.g., for XML or sequence file headers).
+  */
+  struct FrameTransformEntry
+  {
+    FrameTransformEntry();
+    double Matrix[16];
+    ToolStatus Status;
+    bool MatrixValid;       // Matrix contains the transform value
+    bool StatusValid;       // Status contains the transform status value
+    bool MatrixTextStale;   // text in FrameFields does not reflect Matrix yet
+    bool StatusTextStale;   // text in FrameFields does not reflect Status yet
+  };
+  /*! Frame transforms, the key is the identifier of the transform frame field name (e.g., ProbeToTrackerTransform) */
+  typedef std::map<igsioFrameFieldId, FrameTransformEntry> FrameTransformMapType;
+
+  /*! Get the transform entry that belongs to a transform field name. Returns NULL if the frame has no such transform. */
+  const FrameTransformEntry* FindFrameTransformEntry(const std::string& transformFieldName) const;
+
+  /*! Get the transform entry that belongs to a transform field name. The entry is created if it does not exist yet. */
+  FrameTransformEntry& GetFrameTransformEntry(const std::string& transformFieldName);
+
+  /*! Get the text value of a frame field. Text is generated for transforms and statuses that have not been converted yet. */
+  std::string GetFrameFieldText(const igsioFrameFieldContainer::Field& field) const;
+
+  /*! Write the text value of all transforms and statuses that have not been converted yet into FrameFields */
+  void UpdateTransformFrameFields();
+
+  /*! Notify the tracked frame list that owns this frame that the timestamp has been changed */
+  void TimestampModified();
+
 protected:
   igsioVideoFrame ImageData;
   double Timestamp;
 
-  igsioFieldMapType FrameFields;
+  igsioFrameFieldContainer FrameFields;
+  /*! Name-indexed copy of the frame fields returned by GetCustomFields */
+  igsioFieldMapType CustomFields;
+
+  FrameTransformMapType FrameTransforms;
+  bool TransformFrameFieldsStale; // true if text of any of the FrameTransforms has to be written into FrameFields
 
   mutable FrameSizeType FrameSize;      // Cached value is updated from underlying image data when accessed
   mutable std::string   EncodingFourCC; // Cached value is updated from underlying image data when accessed
 
   /*! Stores segmented fiducial point pixel coordinates */
   vtkPoints* FiducialPointsCoordinatePx;
+
+  /*! Counter of timestamp changes, shared by a tracked frame list and its frames */
+  typedef std::shared_ptr<std::atomic<unsigned long> > TimestampChangeCounterType;
+
+  /*!
+    Timestamp change counter of the tracked frame list that owns this frame (NULL if the frame is not in a list).
+    Incremented whenever the timestamp changes so that the list can tell that its timestamp indices are out of date.
+    The counter is shared, so it remains valid even if the frame outlives the list.
+    It is not copied by assignment, as it belongs to the frame object and not to its content.
+  */
+  TimestampChangeCounterType TimestampChangeCounter;
 };
 
 //----------------------------------------------------------------------------
@@ -0,0 +1,186 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// IGSIO includes
+#include "igsioTrackedFrame.h"
+#include "igsioTransformTable.h"
+#include "vtkIGSIOTrackedFrameList.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+
+// STL includes
+#include <algorithm>
+
+namespace
+{
+  const double IDENTITY_MATRIX[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+  /*! Shared data of the threads that build the table */
+  struct BuildThreadFunctionInfoStruct
+  {
+    vtkIGSIOTrackedFrameList* TrackedFrameList;
+    igsioTransformName TransformName;
+    double* Timestamps;
+    double* Matrices;
+    ToolStatus* Statuses;
+    unsigned int NumberOfFrames;
+  };
+}
+
+//----------------------------------------------------------------------------
+igsioTransformTable::igsioTransformTable()
+{
+}
+
+//----------------------------------------------------------------------------
+igsioTransformTable::~igsioTransformTable()
+{
+}
+
+//----------------------------------------------------------------------------
+igsioStatus igsioTransformTable::Build(vtkIGSIOTrackedFrameList* trackedFrameList, const igsioTransformName& transformName, int numberOfThreads /*=0*/)
+{
+  this->Clear();
+  if (trackedFrameList == NULL)
+  {
+    LOG_ERROR("Unable to build transform table - tracked frame list is NULL");
+    return IGSIO_FAIL;
+  }
+  if (!transformName.IsValid())
+  {
+    LOG_ERROR("Unable to build transform table - transform name is invalid");
+    return IGSIO_FAIL;
+  }
+
+  this->TransformName = transformName;
+  unsigned int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
+  if (numberOfFrames == 0)
+  {
+    return IGSIO_SUCCESS;
+  }
+  this->Timestamps.resize(numberOfFrames);
+  this->Matrices.resize(16 * numberOfFrames);
+  this->Statuses.resize(numberOfFrames);
+
+  BuildThreadFunctionInfoStruct str;
+  str.TrackedFrameList = trackedFrameList;
+  str.TransformName = transformName;
+  str.Timestamps = &this->Timestamps[0];
+  str.Matrices = &this->Matrices[0];
+  str.Statuses = &this->Statuses[0];
+  str.NumberOfFrames = numberOfFrames;
+
+  // Each thread processes a contiguous block of frames and writes into its own part of the arrays
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  if (numberOfThreads <= 0)
+  {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  }
+  numberOfThreads = std::min(numberOfThreads, static_cast<int>(numberOfFrames));
+  threader->SetNumberOfThreads(std::max(numberOfThreads, 1));
+  threader->SetSingleMethod(BuildThreadFunction, &str);
+  threader->SingleMethodExecute();
+
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE igsioTransformTable::BuildThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  BuildThreadFunctionInfoStruct* str = static_cast<BuildThreadFunctionInfoStruct*>(threadInfo->UserData);
+
+  unsigned int firstFrameIndex(0);
+  unsigned int lastFrameIndex(0);
+  igsioCommon::GetThreadItemRange(threadInfo->ThreadID, threadInfo->NumberOfThreads, str->NumberOfFrames, firstFrameIndex, lastFrameIndex);
+
+  for (unsigned int frameIndex = firstFrameIndex; frameIndex < lastFrameIndex; ++frameIndex)
+  {
+    igsioTrackedFrame* trackedFrame = str->TrackedFrameList->GetTrackedFrame(frameIndex);
+    double* matrix = str->Matrices + 16 * frameIndex;
+    str->Timestamps[frameIndex] = trackedFrame->GetTimestamp();
+    str->Statuses[frameIndex] = TOOL_INVALID;
+    if (!trackedFrame->IsFrameTransformNameDefined(str->TransformName)
+        || trackedFrame->GetFrameTransform(str->TransformName, matrix) != IGSIO_SUCCESS)
+    {
+      std::copy(IDENTITY_MATRIX, IDENTITY_MATRIX + 16, matrix);
+      continue;
+    }
+    trackedFrame->GetFrameTransformStatus(str->TransformName, str->Statuses[frameIndex]);
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void igsioTransformTable::Clear()
+{
+  this->TransformName = igsioTransformName();
+  this->Timestamps.clear();
+  this->Matrices.clear();
+  this->Statuses.clear();
+}
+
+//----------------------------------------------------------------------------
+const igsioTransformName& igsioTransformTable::GetTransformName() const
+{
+  return this->TransformName;
+}
+
+//----------------------------------------------------------------------------
+unsigned int igsioTransformTable::GetNumberOfFrames() const
+{
+  return static_cast<unsigned int>(this->Timestamps.size());
+}
+
+//----------------------------------------------------------------------------
+unsigned int igsioTransformTable::GetNumberOfValidFrames() const
+{
+  return static_cast<unsigned int>(std::count(this->Statuses.begin(), this->Statuses.end(), TOOL_OK));
+}
+
+//----------------------------------------------------------------------------
+const double* igsioTransformTable::GetTimestamps() const
+{
+  return this->Timestamps.empty() ? NULL : &this->Timestamps[0];
+}
+
+//----------------------------------------------------------------------------
+const double* igsioTransformTable::GetMatrices() const
+{
+  return this->Matrices.empty() ? NULL : &this->Matrices[0];
+}
+
+//----------------------------------------------------------------------------
+const ToolStatus* igsioTransformTable::GetStatuses() const
+{
+  return this->Statuses.empty() ? NULL : &this->Statuses[0];
+}
+
+//----------------------------------------------------------------------------
+const double* igsioTransformTable::GetMatrix(unsigned int frameIndex) const
+{
+  if (frameIndex >= this->GetNumberOfFrames())
+  {
+    LOG_ERROR("igsioTransformTable::GetMatrix requested a non-existing frame (frame index=" << frameIndex << ")");
+    return NULL;
+  }
+  return &this->Matrices[16 * frameIndex];
+}
+
+//----------------------------------------------------------------------------
+igsioStatus igsioTransformTable::GetMatrix(unsigned int frameIndex, vtkMatrix4x4* matrix) const
+{
+  const double* elements = this->GetMatrix(frameIndex);
+  if (elements == NULL || matrix == NULL)
+  {
+    return IGSIO_FAIL;
+  }
+  matrix->DeepCopy(elements);
+  return IGSIO_SUCCESS;
+}
@@ -0,0 +1,90 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __igsioTransformTable_h
+#define __igsioTransformTable_h
+
+#include "vtkigsiocommon_export.h"
+
+// IGSIO includes
+#include "igsioCommon.h"
+
+// VTK includes
+#include <vtkMultiThreader.h>
+
+// STL includes
+#include <vector>
+
+class vtkIGSIOTrackedFrameList;
+class vtkMatrix4x4;
+
+/*!
+  \class igsioTransformTable
+  \brief Values of one frame transform for all frames of a tracked frame list, stored in contiguous arrays
+
+  Batch algorithms that process the poses of all frames (speed validation, extent computation, calibration)
+  can build the table once and then loop over plain arrays, instead of looking up the transform
+  in each frame and creating a vtkMatrix4x4 for each frame.
+
+  The table is stored as structure of arrays: timestamps (one value per frame), matrices (16 values per frame,
+  row-major, the matrix of frame i starts at element 16*i) and transform status (one value per frame).
+  If the transform is not defined in a frame then its matrix is identity and its status is TOOL_INVALID.
+
+  The table is a snapshot, it is not updated when the tracked frame list changes.
+
+  \ingroup PlusLibCommon
+*/
+class VTKIGSIOCOMMON_EXPORT igsioTransformTable
+{
+public:
+  igsioTransformTable();
+  virtual ~igsioTransformTable();
+
+  /*!
+    Extract the transform from all frames of a tracked frame list. Frames are processed in parallel.
+    \param trackedFrameList Input frames
+    \param transformName Name of the transform to extract
+    \param numberOfThreads Number of threads to use. 0 means the VTK default number of threads.
+  */
+  igsioStatus Build(vtkIGSIOTrackedFrameList* trackedFrameList, const igsioTransformName& transformName, int numberOfThreads = 0);
+
+  /*! Remove all values from the table */
+  void Clear();
+
+  /*! Get the name of the transform stored in the table */
+  const igsioTransformName& GetTransformName() const;
+
+  /*! Get the number of frames in the table */
+  unsigned int GetNumberOfFrames() const;
+
+  /*! Get the number of frames that have TOOL_OK transform status */
+  unsigned int GetNumberOfValidFrames() const;
+
+  /*! Frame timestamps, one value per frame */
+  const double* GetTimestamps() const;
+
+  /*! Transform matrices, 16 values (row-major 4x4 matrix) per frame */
+  const double* GetMatrices() const;
+
+  /*! Transform status, one value per frame */
+  const ToolStatus* GetStatuses() const;
+
+  /*! Get the transform matrix of a frame (16 values, row-major) */
+  const double* GetMatrix(unsigned int frameIndex) const;
+
+  /*! Copy the transform matrix of a frame to a vtkMatrix4x4 */
+  igsioStatus GetMatrix(unsigned int frameIndex, vtkMatrix4x4* matrix) const;
+
+protected:
+  static VTK_THREAD_RETURN_TYPE BuildThreadFunction(void* arg);
+
+  igsioTransformName TransformName;
+  std::vector<double> Timestamps;
+  std::vector<double> Matrices;
+  std::vector<ToolStatus> Statuses;
+};
+
+#endif
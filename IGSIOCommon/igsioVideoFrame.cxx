@@ -6,25 +6,31 @@ See License.txt for details.
 
 // Local includes
 //#include "PlusConfigure.h"
+#include "igsioFlipClipKernels.h"
+#include "igsioPixelConversionKernels.h"
 #include "igsioVideoFrame.h"
+#include "vtkIGSIODecodedFrameCache.h"
+#include "vtkIGSIORecursiveCriticalSection.h"
 #include <iostream>
 
 // VTK includes
 #include <vtkBMPReader.h>
-#include <vtkExtractVOI.h>
 #include <vtkImageData.h>
 #include <vtkImageImport.h>
 #include <vtkImageReader.h>
+#include <vtkMultiThreader.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
 #include <vtkPNMReader.h>
 #include <vtkSmartPointer.h>
 #include <vtkTIFFReader.h>
-#include <vtkTrivialProducer.h>
 #include <vtkUnsignedCharArray.h>
 
 // STL includes
 #include <algorithm>
+#include <atomic>
 #include <string>
+#include <utility>
 
 // vtkAddon includes
 #include <vtkStreamingVolumeCodec.h>
@@ -35,6 +41,42 @@ See License.txt for details.
 
 namespace
 {
+  // Copy-on-write mode and statistics, shared by all video frames
+  std::atomic<bool> CopyOnWriteEnabled(false);
+  std::atomic<unsigned long long> NumberOfSharedCopies(0);
+  std::atomic<unsigned long long> NumberOfDeferredCopies(0);
+
+  // Minimum output size for multi-threaded flip and clip
+  std::atomic<unsigned long long> FlipClipMultiThreadingThresholdBytes(4 * 1024 * 1024);
+
+  // Minimum output size for multi-threaded pixel type conversion
+  std::atomic<unsigned long long> PixelConversionMultiThreadingThresholdBytes(4 * 1024 * 1024);
+
+  //----------------------------------------------------------------------------
+  /*! Lock for setting the decoded image of const frames (frames are decoded outside of the lock, frames
+      that are already decoded are returned without locking) */
+  vtkIGSIOSimpleRecursiveCriticalSection* GetDecodedFrameMutex()
+  {
+    static vtkIGSIOSimpleRecursiveCriticalSection decodedFrameMutex;
+    return &decodedFrameMutex;
+  }
+
+  //----------------------------------------------------------------------------
+  bool IsFrameAllocated(vtkImageData* image, const FrameSizeType& imageSize, igsioCommon::VTKScalarPixelType pixType, unsigned int numberOfScalarComponents)
+  {
+    if (image == NULL || image->GetPointData()->GetScalars() == NULL)
+    {
+      return false;
+    }
+    int imageExtents[6] = { 0, 0, 0, 0, 0, 0 };
+    image->GetExtent(imageExtents);
+    return (imageSize[0] == imageExtents[1] - imageExtents[0] + 1 &&
+            imageSize[1] == imageExtents[3] - imageExtents[2] + 1 &&
+            imageSize[2] == imageExtents[5] - imageExtents[4] + 1 &&
+            image->GetScalarType() == pixType &&
+            image->GetNumberOfScalarComponents() == numberOfScalarComponents);
+  }
+
   //----------------------------------------------------------------------------
   template<class ScalarType>
   igsioStatus FlipClipImageGeneric(vtkImageData* inputImage, const igsioVideoFrame::FlipInfoType& flipInfo, const std::array<int, 3>& clipRectangleOrigin, const std::array<int, 3>& clipRectangleSize, vtkImageData* outputImage)
@@ -341,31 +383,334 @@ namespace
 
     return IGSIO_SUCCESS;
   }
+
+  //----------------------------------------------------------------------------
+  bool IsFlipClipKernelSupported(const igsioVideoFrame::FlipInfoType& flipInfo)
+  {
+    if (flipInfo.doubleRow || flipInfo.doubleColumn)
+    {
+      return false;
+    }
+    if (flipInfo.tranpose == igsioVideoFrame::TRANSPOSE_IJKtoKIJ)
+    {
+      return !flipInfo.hFlip && !flipInfo.vFlip && !flipInfo.eFlip;
+    }
+    // Elevational flip is only supported alone
+    return (flipInfo.hFlip || flipInfo.vFlip) ? !flipInfo.eFlip : flipInfo.eFlip;
+  }
+
+  /*! Parameters of reordering the pixels of a clipped input image using the pixel reordering kernels */
+  struct FlipClipKernelInfoStruct
+  {
+    igsioVideoFrame::FlipInfoType FlipInfo;
+    /*! First unclipped input pixel */
+    const unsigned char* Input;
+    unsigned char* Output;
+    int BytesPerPixel;
+    int OutputDimensions[3];
+    long long InputRowStrideBytes;
+    long long InputImageStrideBytes;
+    long long OutputRowStrideBytes;
+    long long OutputImageStrideBytes;
+  };
+
+  //----------------------------------------------------------------------------
+  /*!
+    Number of independent work items: output slices for transposition, input rows for flipping.
+    Work items can be processed in any order, also in parallel.
+  */
+  int GetNumberOfFlipClipWorkItems(const FlipClipKernelInfoStruct& info)
+  {
+    if (info.FlipInfo.tranpose == igsioVideoFrame::TRANSPOSE_IJKtoKIJ)
+    {
+      return info.OutputDimensions[2];
+    }
+    return info.OutputDimensions[1] * info.OutputDimensions[2];
+  }
+
+  //----------------------------------------------------------------------------
+  void FlipClipKernelWorkItems(const FlipClipKernelInfoStruct& info, int firstWorkItem, int lastWorkItem)
+  {
+    const int outputWidth(info.OutputDimensions[0]);
+    const int outputHeight(info.OutputDimensions[1]);
+    const int outputDepth(info.OutputDimensions[2]);
+
+    if (info.FlipInfo.tranpose == igsioVideoFrame::TRANSPOSE_IJKtoKIJ)
+    {
+      // Output slice y is the transpose of input row y of all the input slices
+      for (int y = firstWorkItem; y < lastWorkItem; ++y)
+      {
+        igsioFlipClipKernels::Transpose(info.Input + y * info.InputRowStrideBytes, info.InputImageStrideBytes, info.Output + y * info.OutputImageStrideBytes, info.OutputRowStrideBytes,
+                                        outputWidth, outputHeight, info.BytesPerPixel);
+      }
+      return;
+    }
+
+    for (int workItem = firstWorkItem; workItem < lastWorkItem; ++workItem)
+    {
+      const int z = workItem / outputHeight;
+      const int y = workItem % outputHeight;
+      const unsigned char* inputRow = info.Input + z * info.InputImageStrideBytes + y * info.InputRowStrideBytes;
+      const int outputRow = (info.FlipInfo.vFlip ? outputHeight - 1 - y : y);
+      const int outputSlice = (info.FlipInfo.eFlip ? outputDepth - 1 - z : z);
+      unsigned char* output = info.Output + outputSlice * info.OutputImageStrideBytes + outputRow * info.OutputRowStrideBytes;
+      if (info.FlipInfo.hFlip)
+      {
+        igsioFlipClipKernels::ReverseRow(inputRow, output, outputWidth, info.BytesPerPixel);
+      }
+      else
+      {
+        memcpy(output, inputRow, outputWidth * info.BytesPerPixel);
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  VTK_THREAD_RETURN_TYPE FlipClipKernelThreadFunction(void* arg)
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    const FlipClipKernelInfoStruct* info = static_cast<const FlipClipKernelInfoStruct*>(threadInfo->UserData);
+
+    // Each thread processes a contiguous slab of the output
+    int firstWorkItem(0);
+    int lastWorkItem(0);
+    igsioCommon::GetThreadItemRange(threadInfo->ThreadID, threadInfo->NumberOfThreads, GetNumberOfFlipClipWorkItems(*info), firstWorkItem, lastWorkItem);
+    FlipClipKernelWorkItems(*info, firstWorkItem, lastWorkItem);
+
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Flip and/or transpose using the vectorized pixel reordering kernels.
+    Same result as FlipClipImageGeneric for the cases accepted by IsFlipClipKernelSupported.
+    If multi-threading is requested and the output is larger than the threshold then the output is split into slabs
+    that are processed in parallel.
+  */
+  igsioStatus FlipClipImageKernel(vtkImageData* inputImage, const igsioVideoFrame::FlipInfoType& flipInfo, const std::array<int, 3>& clipRectangleOrigin, vtkImageData* outputImage, bool multiThreaded)
+  {
+    FlipClipKernelInfoStruct info;
+    info.FlipInfo = flipInfo;
+    info.BytesPerPixel = igsioVideoFrame::GetNumberOfBytesPerScalar(inputImage->GetScalarType()) * inputImage->GetNumberOfScalarComponents();
+    outputImage->GetDimensions(info.OutputDimensions);
+
+    vtkIdType pixelIncrement(0);
+    vtkIdType inputRowIncrement(0);
+    vtkIdType inputImageIncrement(0);
+    inputImage->GetIncrements(pixelIncrement, inputRowIncrement, inputImageIncrement);
+    vtkIdType outputRowIncrement(0);
+    vtkIdType outputImageIncrement(0);
+    outputImage->GetIncrements(pixelIncrement, outputRowIncrement, outputImageIncrement);
+
+    // Increments are in scalars, the kernels work with bytes
+    const vtkIdType bytesPerScalar = info.BytesPerPixel / inputImage->GetNumberOfScalarComponents();
+    info.InputRowStrideBytes = inputRowIncrement * bytesPerScalar;
+    info.InputImageStrideBytes = inputImageIncrement * bytesPerScalar;
+    info.OutputRowStrideBytes = outputRowIncrement * bytesPerScalar;
+    info.OutputImageStrideBytes = outputImageIncrement * bytesPerScalar;
+
+    info.Input = static_cast<const unsigned char*>(inputImage->GetScalarPointer())
+                 + clipRectangleOrigin[2] * info.InputImageStrideBytes + clipRectangleOrigin[1] * info.InputRowStrideBytes + clipRectangleOrigin[0] * info.BytesPerPixel;
+    info.Output = static_cast<unsigned char*>(outputImage->GetScalarPointer());
+
+    const int numberOfWorkItems = GetNumberOfFlipClipWorkItems(info);
+    const unsigned long long outputSizeBytes = static_cast<unsigned long long>(info.OutputImageStrideBytes) * info.OutputDimensions[2];
+    if (!multiThreaded || outputSizeBytes < FlipClipMultiThreadingThresholdBytes || numberOfWorkItems < 2)
+    {
+      FlipClipKernelWorkItems(info, 0, numberOfWorkItems);
+      return IGSIO_SUCCESS;
+    }
+
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    threader->SetNumberOfThreads(std::min(vtkMultiThreader::GetGlobalDefaultNumberOfThreads(), numberOfWorkItems));
+    threader->SetSingleMethod(FlipClipKernelThreadFunction, &info);
+    threader->SingleMethodExecute();
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Copy a box of pixels, given by an extent in the index space of the input image, into the output image.
+    The output gets the extent, origin and spacing of the box (same result as vtkExtractVOI), its pixel buffer is reused
+    if it already has the right size and it is not shared with any other image (e.g., after a shallow copy).
+    Rows (and slices) that are contiguous in the input are copied with a single memcpy.
+  */
+  igsioStatus CopyImageExtent(vtkImageData* inputImage, const int extent[6], vtkImageData* outputImage)
+  {
+    const int scalarType = inputImage->GetScalarType();
+    const int numberOfScalarComponents = inputImage->GetNumberOfScalarComponents();
+    int outputExtent[6] = {0, -1, 0, -1, 0, -1};
+    outputImage->GetExtent(outputExtent);
+    vtkDataArray* outputScalars = outputImage->GetPointData()->GetScalars();
+    if (!std::equal(extent, extent + 6, outputExtent)
+        || outputScalars == NULL
+        || outputScalars->GetReferenceCount() != 1
+        || outputImage->GetScalarType() != scalarType
+        || outputImage->GetNumberOfScalarComponents() != numberOfScalarComponents)
+    {
+      outputImage->SetExtent(extent[0], extent[1], extent[2], extent[3], extent[4], extent[5]);
+      outputImage->AllocateScalars(scalarType, numberOfScalarComponents);
+    }
+    outputImage->SetOrigin(inputImage->GetOrigin());
+    outputImage->SetSpacing(inputImage->GetSpacing());
+
+    const vtkIdType bytesPerScalar = igsioVideoFrame::GetNumberOfBytesPerScalar(scalarType);
+    vtkIdType pixelIncrement(0);
+    vtkIdType inputRowIncrement(0);
+    vtkIdType inputImageIncrement(0);
+    inputImage->GetIncrements(pixelIncrement, inputRowIncrement, inputImageIncrement);
+    const size_t inputRowStrideBytes = inputRowIncrement * bytesPerScalar;
+    const size_t inputImageStrideBytes = inputImageIncrement * bytesPerScalar;
+
+    const int numberOfRows = extent[3] - extent[2] + 1;
+    const int numberOfSlices = extent[5] - extent[4] + 1;
+    const size_t rowSizeBytes = static_cast<size_t>(extent[1] - extent[0] + 1) * numberOfScalarComponents * bytesPerScalar;
+    const size_t sliceSizeBytes = rowSizeBytes * numberOfRows;
+
+    const unsigned char* input = static_cast<const unsigned char*>(inputImage->GetScalarPointer(extent[0], extent[2], extent[4]));
+    unsigned char* output = static_cast<unsigned char*>(outputImage->GetScalarPointer());
+    if (rowSizeBytes == inputRowStrideBytes)
+    {
+      if (sliceSizeBytes == inputImageStrideBytes)
+      {
+        // The whole box is contiguous in the input
+        memcpy(output, input, sliceSizeBytes * numberOfSlices);
+        return IGSIO_SUCCESS;
+      }
+      for (int z = 0; z < numberOfSlices; ++z)
+      {
+        memcpy(output + z * sliceSizeBytes, input + z * inputImageStrideBytes, sliceSizeBytes);
+      }
+      return IGSIO_SUCCESS;
+    }
+    for (int z = 0; z < numberOfSlices; ++z)
+    {
+      const unsigned char* inputRow = input + z * inputImageStrideBytes;
+      for (int y = 0; y < numberOfRows; ++y, inputRow += inputRowStrideBytes, output += rowSizeBytes)
+      {
+        memcpy(output, inputRow, rowSizeBytes);
+      }
+    }
+    return IGSIO_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Shared parameters of the pixel type conversion threads */
+  struct PixelConversionInfoStruct
+  {
+    igsioVideoFrame::PixelConversionMode Mode;
+    const unsigned char* Input;
+    igsioCommon::VTKScalarPixelType InputScalarType;
+    unsigned int NumberOfInputScalarComponents;
+    int InputBytesPerPixel;
+    unsigned char* Output;
+    int OutputBytesPerPixel;
+    long long NumberOfPixels;
+    float Scale;
+    float Shift;
+  };
+
+  //----------------------------------------------------------------------------
+  /*! Number of pixels converted by each thread is a multiple of this, so threads do not write into the same cache line */
+  const long long PIXEL_CONVERSION_BLOCK_SIZE = 64;
+
+  //----------------------------------------------------------------------------
+  unsigned int GetNumberOfConvertedScalarComponents(igsioVideoFrame::PixelConversionMode mode, unsigned int numberOfInputScalarComponents)
+  {
+    switch (mode)
+    {
+      case igsioVideoFrame::PIXEL_CONVERSION_RGB_TO_GRAY:
+        return 1;
+      case igsioVideoFrame::PIXEL_CONVERSION_GRAY_TO_RGB:
+        return 3;
+      default:
+        return numberOfInputScalarComponents;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void ConvertPixels(const PixelConversionInfoStruct& info, long long firstPixel, long long numberOfPixels)
+  {
+    const unsigned char* input = info.Input + firstPixel * info.InputBytesPerPixel;
+    unsigned char* output = info.Output + firstPixel * info.OutputBytesPerPixel;
+    switch (info.Mode)
+    {
+      case igsioVideoFrame::PIXEL_CONVERSION_RGB_TO_GRAY:
+        igsioPixelConversionKernels::RGBToGray(input, info.NumberOfInputScalarComponents, output, numberOfPixels);
+        return;
+      case igsioVideoFrame::PIXEL_CONVERSION_GRAY_TO_RGB:
+        igsioPixelConversionKernels::GrayToRGB(input, output, numberOfPixels);
+        return;
+      default:
+        // The scalar type is already validated
+        igsioPixelConversionKernels::ScaleToUnsignedChar(input, info.InputScalarType, output, numberOfPixels * info.NumberOfInputScalarComponents, info.Scale, info.Shift);
+        return;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  VTK_THREAD_RETURN_TYPE PixelConversionThreadFunction(void* arg)
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    const PixelConversionInfoStruct* info = static_cast<const PixelConversionInfoStruct*>(threadInfo->UserData);
+
+    // Each thread converts a contiguous block of pixels
+    const long long numberOfBlocks = (info->NumberOfPixels + PIXEL_CONVERSION_BLOCK_SIZE - 1) / PIXEL_CONVERSION_BLOCK_SIZE;
+    long long firstBlock(0);
+    long long lastBlock(0);
+    igsioCommon::GetThreadItemRange(threadInfo->ThreadID, threadInfo->NumberOfThreads, numberOfBlocks, firstBlock, lastBlock);
+    const long long firstPixel = std::min(firstBlock * PIXEL_CONVERSION_BLOCK_SIZE, info->NumberOfPixels);
+    const long long lastPixel = std::min(lastBlock * PIXEL_CONVERSION_BLOCK_SIZE, info->NumberOfPixels);
+    ConvertPixels(*info, firstPixel, lastPixel - firstPixel);
+
+    return VTK_THREAD_RETURN_VALUE;
+  }
 }
 
 //----------------------------------------------------------------------------
 igsioVideoFrame::igsioVideoFrame()
   : Image(NULL)
+  , ImageCopyOnWrite(false)
   , EncodedFrame(NULL)
+  , FrameDecoded(false)
   , ImageType(US_IMG_BRIGHTNESS)
   , ImageOrientation(US_IMG_ORIENT_MF)
+  , CountedFrameMemoryBytes(0)
 {
 }
 
 //----------------------------------------------------------------------------
 igsioVideoFrame::igsioVideoFrame(const igsioVideoFrame& videoItem)
   : Image(NULL)
+  , ImageCopyOnWrite(false)
   , EncodedFrame(NULL)
+  , FrameDecoded(false)
   , ImageType(US_IMG_BRIGHTNESS)
   , ImageOrientation(US_IMG_ORIENT_MF)
+  , CountedFrameMemoryBytes(0)
 {
   *this = videoItem;
 }
 
+//----------------------------------------------------------------------------
+igsioVideoFrame::igsioVideoFrame(igsioVideoFrame&& videoItem)
+  : Image(NULL)
+  , ImageCopyOnWrite(false)
+  , EncodedFrame(NULL)
+  , FrameDecoded(false)
+  , ImageType(US_IMG_BRIGHTNESS)
+  , ImageOrientation(US_IMG_ORIENT_MF)
+  , BufferPool(videoItem.BufferPool)
+  , CountedFrameMemoryBytes(0)
+{
+  *this = std::move(videoItem);
+}
+
 //----------------------------------------------------------------------------
 igsioVideoFrame::~igsioVideoFrame()
 {
-  DELETE_IF_NOT_NULL(this->Image);
+  this->ReleaseImage();
+  this->SetFrameMemoryCounter(NULL);
 }
 
 //----------------------------------------------------------------------------
@@ -380,9 +725,22 @@ igsioVideoFrame& igsioVideoFrame::operator=(igsioVideoFrame const& videoItem)
   this->ImageType = videoItem.ImageType;
   this->ImageOrientation = videoItem.ImageOrientation;
 
-  // Copy the pixels. Don't use image duplicator, because that wouldn't reuse the existing buffer
-  if (videoItem.GetFrameSizeInBytes() > 0)
+  if (CopyOnWriteEnabled && videoItem.Image != NULL && !videoItem.IsFrameEncoded() && videoItem.GetFrameSizeInBytes() > 0)
+  {
+    // Share the image object, pixels are copied when any of the frames is modified
+    if (this->Image != videoItem.Image)
+    {
+      videoItem.Image->Register(NULL);
+      this->ReleaseImage();
+      this->Image = videoItem.Image;
+    }
+    this->ImageCopyOnWrite = true;
+    videoItem.ImageCopyOnWrite = true;
+    ++NumberOfSharedCopies;
+  }
+  else if (videoItem.GetFrameSizeInBytes() > 0)
   {
+    // Copy the pixels. Don't use image duplicator, because that wouldn't reuse the existing buffer
     FrameSizeType frameSize = {0, 0, 0};
     videoItem.GetFrameSize(frameSize);
 
@@ -394,17 +752,62 @@ igsioVideoFrame& igsioVideoFrame::operator=(igsioVideoFrame const& videoItem)
 
     if (!videoItem.IsFrameEncoded())
     {
+      if (this->Image != NULL && !this->IsImageExclusivelyOwned())
+      {
+        // The pixels are used by other frames or images (e.g., by vtkImageData::ShallowCopy), copy into a new buffer instead
+        this->ReleaseImage();
+      }
       if (this->AllocateFrame(frameSize, videoItem.GetVTKScalarPixelType(), numberOfScalarComponents) != IGSIO_SUCCESS)
       {
         LOG_ERROR("Failed to allocate memory for the new frame in the buffer!");
       }
       else
       {
-        this->Image->DeepCopy(videoItem.Image);
+        // Copy into the allocated buffer (vtkImageData::DeepCopy would replace it with a newly allocated one)
+        this->Image->CopyStructure(videoItem.Image);
+        memcpy(this->Image->GetScalarPointer(), videoItem.Image->GetScalarPointer(), this->GetFrameSizeInBytes());
       }
     }
   }
   this->SetEncodedFrame(videoItem.GetEncodedFrame());
+  this->UpdateFrameMemoryCounter();
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------
+igsioVideoFrame& igsioVideoFrame::operator=(igsioVideoFrame&& videoItem)
+{
+  // Handle self-assignment
+  if (this == &videoItem)
+  {
+    return *this;
+  }
+
+  this->ImageType = videoItem.ImageType;
+  this->ImageOrientation = videoItem.ImageOrientation;
+
+  // Take over the image object, the pixels are not copied
+  this->ReleaseImage();
+  this->Image = videoItem.Image;
+  this->ImageCopyOnWrite = videoItem.ImageCopyOnWrite;
+  // A pool only takes back buffers that it has allocated, so the buffer is not returned to any pool if the pools differ
+  this->PooledBuffer = (videoItem.GetBufferPool() == this->GetBufferPool() ? videoItem.PooledBuffer : NULL);
+  videoItem.Image = NULL;
+  videoItem.ImageCopyOnWrite = false;
+  videoItem.PooledBuffer = NULL;
+
+  this->EncodedFrame = std::move(videoItem.EncodedFrame);
+  this->DecodedFrame = std::move(videoItem.DecodedFrame);
+  this->FrameDecoded = videoItem.FrameDecoded.load();
+  this->Codec = std::move(videoItem.Codec);
+  videoItem.EncodedFrame = NULL;
+  videoItem.DecodedFrame = NULL;
+  videoItem.FrameDecoded = false;
+  videoItem.Codec = NULL;
+
+  this->UpdateFrameMemoryCounter();
+  videoItem.UpdateFrameMemoryCounter();
 
   return *this;
 }
@@ -431,6 +834,10 @@ igsioStatus igsioVideoFrame::FillBlank()
     LOG_ERROR("Unable to fill image to blank, image data is NULL.");
     return IGSIO_FAIL;
   }
+  if (this->MakeImageWritable() != IGSIO_SUCCESS)
+  {
+    return IGSIO_FAIL;
+  }
 
   memset(this->GetScalarPointer(), 0, this->GetFrameSizeInBytes());
 
@@ -445,19 +852,10 @@ igsioStatus igsioVideoFrame::AllocateFrame(vtkImageData* image, const FrameSizeT
     LOG_WARNING("Single slice images should have a dimension of z=1");
   }
 
-  if (image != NULL)
+  if (IsFrameAllocated(image, imageSize, pixType, numberOfScalarComponents))
   {
-    int imageExtents[6] = { 0, 0, 0, 0, 0, 0 };
-    image->GetExtent(imageExtents);
-    if (imageSize[0] == imageExtents[1] - imageExtents[0] + 1 &&
-        imageSize[1] == imageExtents[3] - imageExtents[2] + 1 &&
-        imageSize[2] == imageExtents[5] - imageExtents[4] + 1 &&
-        image->GetScalarType() == pixType &&
-        image->GetNumberOfScalarComponents() == numberOfScalarComponents)
-    {
-      // already allocated, no change
-      return IGSIO_SUCCESS;
-    }
+    // already allocated, no change
+    return IGSIO_SUCCESS;
   }
 
   image->SetExtent(0, imageSize[0] - 1, 0, imageSize[1] - 1, 0, imageSize[2] - 1);
@@ -469,12 +867,128 @@ igsioStatus igsioVideoFrame::AllocateFrame(vtkImageData* image, const FrameSizeT
 //----------------------------------------------------------------------------
 igsioStatus igsioVideoFrame::AllocateFrame(const FrameSizeType& imageSize, igsioCommon::VTKScalarPixelType pixType, unsigned int numberOfScalarComponents)
 {
-  if (this->GetImage() == NULL)
+  if (this->IsImageShared())
+  {
+    // Pixels of a shared image are going to be overwritten, so there is no need to copy them
+    this->ReleaseImage();
+  }
+  if (this->Image == NULL)
   {
     this->SetImageData(vtkImageData::New());
   }
-  igsioStatus allocStatus = igsioVideoFrame::AllocateFrame(this->GetImage(), imageSize, pixType, numberOfScalarComponents);
-  return allocStatus;
+  if (IsFrameAllocated(this->Image, imageSize, pixType, numberOfScalarComponents))
+  {
+    // already allocated, no change
+    return IGSIO_SUCCESS;
+  }
+  if (imageSize[0] > 0 && imageSize[1] > 0 && imageSize[2] == 0)
+  {
+    LOG_WARNING("Single slice images should have a dimension of z=1");
+  }
+
+  // Return the current buffer to the pool and get a new one in the requested size
+  this->ReleasePooledBuffer();
+  vtkIdType numberOfPixels = static_cast<vtkIdType>(imageSize[0]) * imageSize[1] * imageSize[2];
+  vtkSmartPointer<vtkDataArray> buffer = this->GetBufferPool()->AcquireBuffer(pixType, numberOfScalarComponents, numberOfPixels);
+  if (buffer == NULL)
+  {
+    LOG_ERROR("Failed to allocate pixel buffer for the video frame");
+    return IGSIO_FAIL;
+  }
+  this->Image->SetExtent(0, imageSize[0] - 1, 0, imageSize[1] - 1, 0, imageSize[2] - 1);
+  this->Image->GetPointData()->SetScalars(buffer);
+  this->PooledBuffer = buffer;
+  this->UpdateFrameMemoryCounter();
+
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void igsioVideoFrame::SetBufferPool(vtkIGSIOFrameBufferPool* bufferPool)
+{
+  if (this->PooledBuffer != NULL && bufferPool != this->BufferPool.GetPointer())
+  {
+    // The current buffer was allocated by the previous pool, the new pool must not take it
+    this->PooledBuffer = NULL;
+  }
+  this->BufferPool = bufferPool;
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIOFrameBufferPool* igsioVideoFrame::GetBufferPool() const
+{
+  if (this->BufferPool == NULL)
+  {
+    return vtkIGSIOFrameBufferPool::GetDefaultInstance();
+  }
+  return this->BufferPool;
+}
+
+//----------------------------------------------------------------------------
+void igsioVideoFrame::ReleaseImage()
+{
+  this->ReleasePooledBuffer();
+  DELETE_IF_NOT_NULL(this->Image);
+  this->ImageCopyOnWrite = false;
+  this->UpdateFrameMemoryCounter();
+}
+
+//----------------------------------------------------------------------------
+void igsioVideoFrame::ReleasePooledBuffer()
+{
+  // The buffer can be reused if only this frame's image refers to it
+  if (this->PooledBuffer != NULL && this->Image != NULL
+      && this->Image->GetPointData()->GetScalars() == this->PooledBuffer.GetPointer()
+      && this->IsImageExclusivelyOwned())
+  {
+    this->Image->GetPointData()->SetScalars(NULL);
+    this->GetBufferPool()->ReleaseBuffer(this->PooledBuffer);
+  }
+  this->PooledBuffer = NULL;
+}
+
+//----------------------------------------------------------------------------
+bool igsioVideoFrame::IsImageExclusivelyOwned() const
+{
+  if (this->Image == NULL || this->Image->GetReferenceCount() != 1)
+  {
+    return false;
+  }
+  vtkDataArray* scalars = this->Image->GetPointData()->GetScalars();
+  if (scalars == NULL)
+  {
+    return true;
+  }
+  // The scalars are referenced by the image and by PooledBuffer if they were taken from the buffer pool
+  return scalars->GetReferenceCount() == (scalars == this->PooledBuffer.GetPointer() ? 2 : 1);
+}
+
+//----------------------------------------------------------------------------
+void igsioVideoFrame::SetFrameMemoryCounter(const FrameMemoryCounterType& frameMemoryCounter)
+{
+  if (this->FrameMemoryCounter != NULL)
+  {
+    (*this->FrameMemoryCounter) -= this->CountedFrameMemoryBytes;
+  }
+  this->CountedFrameMemoryBytes = 0;
+  this->FrameMemoryCounter = frameMemoryCounter;
+  this->UpdateFrameMemoryCounter();
+}
+
+//----------------------------------------------------------------------------
+void igsioVideoFrame::UpdateFrameMemoryCounter()
+{
+  if (this->FrameMemoryCounter == NULL)
+  {
+    return;
+  }
+  unsigned long long frameMemoryBytes = this->GetFrameSizeInBytes();
+  if (frameMemoryBytes != this->CountedFrameMemoryBytes)
+  {
+    (*this->FrameMemoryCounter) += frameMemoryBytes;
+    (*this->FrameMemoryCounter) -= this->CountedFrameMemoryBytes;
+    this->CountedFrameMemoryBytes = frameMemoryBytes;
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -538,7 +1052,18 @@ igsioStatus igsioVideoFrame::ShallowCopyFrom(vtkImageData* frame)
     LOG_ERROR("Failed to shallow copy from vtk image data - input frame is NULL!");
     return IGSIO_FAIL;
   }
+  if (this->IsImageShared())
+  {
+    // Don't modify the image object of other frames
+    this->ReleaseImage();
+    this->SetImageData(vtkImageData::New());
+  }
+  else
+  {
+    this->ReleasePooledBuffer();
+  }
   this->Image->ShallowCopy(frame);
+  this->UpdateFrameMemoryCounter();
   return IGSIO_SUCCESS;
 }
 
@@ -613,6 +1138,33 @@ void* igsioVideoFrame::GetScalarPointer() const
     return NULL;
   }
 
+  // Encoded frames are decoded on first access
+  vtkImageData* image = this->GetImage();
+  if (image == NULL)
+  {
+    return NULL;
+  }
+  return image->GetScalarPointer();
+}
+
+//----------------------------------------------------------------------------
+void* igsioVideoFrame::GetScalarPointer()
+{
+  if (!this->IsImageValid())
+  {
+    LOG_ERROR("Cannot get buffer pointer, the buffer hasn't been created yet");
+    return NULL;
+  }
+  if (this->Image == NULL)
+  {
+    LOG_ERROR("Cannot get buffer pointer for writing, the frame contains encoded data only");
+    return NULL;
+  }
+  if (this->MakeImageWritable() != IGSIO_SUCCESS)
+  {
+    return NULL;
+  }
+
   return this->Image->GetScalarPointer();
 }
 
@@ -692,10 +1244,14 @@ bool igsioVideoFrame::IsFrameEncoded() const
 //----------------------------------------------------------------------------
 igsioCommon::VTKScalarPixelType igsioVideoFrame::GetVTKScalarPixelType() const
 {
-  if (this->Image == NULL || !this->IsImageValid())
+  if (!this->IsImageValid())
   {
     return VTK_UNSIGNED_CHAR;
   }
+  if (this->Image == NULL)
+  {
+    return this->EncodedFrame->GetVTKScalarType();
+  }
   return this->Image->GetScalarType();
 }
 
@@ -872,7 +1428,8 @@ igsioStatus igsioVideoFrame::GetOrientedClippedImage(vtkImageData* inUsImage,
     US_IMAGE_TYPE inUsImageType,
     vtkImageData* outUsOrientedImage,
     const std::array<int, 3>& clipRectangleOrigin,
-    const std::array<int, 3>& clipRectangleSize)
+    const std::array<int, 3>& clipRectangleSize,
+    bool multiThreaded /*=false*/)
 {
   if (inUsImage == NULL)
   {
@@ -886,7 +1443,7 @@ igsioStatus igsioVideoFrame::GetOrientedClippedImage(vtkImageData* inUsImage,
     return IGSIO_FAIL;
   }
 
-  return igsioVideoFrame::FlipClipImage(inUsImage, flipInfo, clipRectangleOrigin, clipRectangleSize, outUsOrientedImage);
+  return igsioVideoFrame::FlipClipImage(inUsImage, flipInfo, clipRectangleOrigin, clipRectangleSize, outUsOrientedImage, multiThreaded);
 }
 
 //----------------------------------------------------------------------------
@@ -907,10 +1464,15 @@ igsioStatus igsioVideoFrame::GetOrientedClippedImage(unsigned char* imageDataPtr
     const FrameSizeType& inputFrameSizeInPx,
     igsioVideoFrame& outBufferItem,
     const std::array<int, 3>& clipRectangleOrigin,
-    const std::array<int, 3>& clipRectangleSize)
+    const std::array<int, 3>& clipRectangleSize,
+    bool multiThreaded /*=false*/)
 {
+  if (outBufferItem.MakeImageWritable() != IGSIO_SUCCESS)
+  {
+    return IGSIO_FAIL;
+  }
   return igsioVideoFrame::GetOrientedClippedImage(imageDataPtr, flipInfo, inUsImageType, inUsImagePixelType,
-         numberOfScalarComponents, inputFrameSizeInPx, outBufferItem.GetImage(), clipRectangleOrigin, clipRectangleSize);
+         numberOfScalarComponents, inputFrameSizeInPx, outBufferItem.GetImage(), clipRectangleOrigin, clipRectangleSize, multiThreaded);
 }
 
 //----------------------------------------------------------------------------
@@ -922,7 +1484,8 @@ igsioStatus igsioVideoFrame::GetOrientedClippedImage(unsigned char* imageDataPtr
     const FrameSizeType& inputFrameSizeInPx,
     vtkImageData* outUsOrientedImage,
     const std::array<int, 3>& clipRectangleOrigin,
-    const std::array<int, 3>& clipRectangleSize)
+    const std::array<int, 3>& clipRectangleSize,
+    bool multiThreaded /*=false*/)
 {
   if (imageDataPtr == NULL)
   {
@@ -956,7 +1519,7 @@ igsioStatus igsioVideoFrame::GetOrientedClippedImage(unsigned char* imageDataPtr
   inUsImage->Update();
 
   igsioStatus result = igsioVideoFrame::GetOrientedClippedImage(inUsImage->GetOutput(), flipInfo, inUsImageType,
-                       outUsOrientedImage, clipRectangleOrigin, clipRectangleSize);
+                       outUsOrientedImage, clipRectangleOrigin, clipRectangleSize, multiThreaded);
 
   return result;
 }
@@ -966,7 +1529,9 @@ igsioStatus igsioVideoFrame::FlipClipImage(vtkImageData* inUsImage,
     const igsioVideoFrame::FlipInfoType& flipInfo,
     const std::array<int, 3>& clipRectangleOrigin,
     const std::array<int, 3>& clipRectangleSize,
-    vtkImageData* outUsOrientedImage)
+    vtkImageData* outUsOrientedImage,
+    bool multiThreaded /*=false*/,
+    bool allowShallowCopy /*=false*/)
 {
   if (inUsImage == NULL)
   {
@@ -982,28 +1547,49 @@ igsioStatus igsioVideoFrame::FlipClipImage(vtkImageData* inUsImage,
 
   if (!flipInfo.hFlip && !flipInfo.vFlip && !flipInfo.eFlip && flipInfo.tranpose == TRANSPOSE_NONE)
   {
-    if (igsioCommon::IsClippingRequested(clipRectangleOrigin, clipRectangleSize))
+    // No flip or transpose, only copy the (clipped) pixels, without setting up a VTK pipeline
+    if (inUsImage->GetPointData()->GetScalars() == NULL && inUsImage != outUsOrientedImage)
     {
-      // No flip or transpose, but clipping requested, let vtk do the heavy lifting
-      vtkSmartPointer<vtkExtractVOI> extract = vtkSmartPointer<vtkExtractVOI>::New();
-      vtkSmartPointer<vtkTrivialProducer> tp = vtkSmartPointer<vtkTrivialProducer>::New();
-      tp->SetOutput(inUsImage);
-      extract->SetInputConnection(tp->GetOutputPort());
-      extract->SetVOI(
-        clipRectangleOrigin[0], clipRectangleOrigin[0] + clipRectangleSize[0] - 1,
-        clipRectangleOrigin[1], clipRectangleOrigin[1] + clipRectangleSize[1] - 1,
-        clipRectangleOrigin[2], clipRectangleOrigin[2] + clipRectangleSize[2] - 1
-      );
-      extract->SetOutput(outUsOrientedImage);
-      extract->Update();
+      // No pixels to copy
+      outUsOrientedImage->DeepCopy(inUsImage);
       return IGSIO_SUCCESS;
     }
-    else
+    int inExtents[6] = {0, -1, 0, -1, 0, -1};
+    inUsImage->GetExtent(inExtents);
+    int extent[6] = {inExtents[0], inExtents[1], inExtents[2], inExtents[3], inExtents[4], inExtents[5]};
+    bool clippingRequested = igsioCommon::IsClippingRequested(clipRectangleOrigin, clipRectangleSize);
+    if (clippingRequested)
     {
-      // no flip, clip or transpose
-      outUsOrientedImage->DeepCopy(inUsImage);
+      // Restrict the clipping box to the input image, same as vtkExtractVOI
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        extent[2 * axis] = std::max(clipRectangleOrigin[axis], inExtents[2 * axis]);
+        extent[2 * axis + 1] = std::min(clipRectangleOrigin[axis] + clipRectangleSize[axis] - 1, inExtents[2 * axis + 1]);
+      }
+      clippingRequested = !std::equal(extent, extent + 6, inExtents);
+    }
+    if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+      LOG_ERROR("Failed to clip image - the clipping region is outside of the image. Origin=[" << clipRectangleOrigin[0] << "," << clipRectangleOrigin[1] << "," << clipRectangleOrigin[2] <<
+                "]. Size=[" << clipRectangleSize[0] << "," << clipRectangleSize[1] << "," << clipRectangleSize[2] << "].");
+      return IGSIO_FAIL;
+    }
+    if (inUsImage == outUsOrientedImage)
+    {
+      if (clippingRequested)
+      {
+        LOG_ERROR("Failed to clip image - input and output image must be different");
+        return IGSIO_FAIL;
+      }
+      return IGSIO_SUCCESS;
+    }
+    if (!clippingRequested && allowShallowCopy)
+    {
+      // The output is identical to the input, share the pixel buffer
+      outUsOrientedImage->ShallowCopy(inUsImage);
       return IGSIO_SUCCESS;
     }
+    return CopyImageExtent(inUsImage, extent, outUsOrientedImage);
   }
 
   // Validate output image is correct dimensions to receive final oriented and/or clipped result
@@ -1071,6 +1657,11 @@ igsioStatus igsioVideoFrame::FlipClipImage(vtkImageData* inUsImage,
     outUsOrientedImage->AllocateScalars(inUsImage->GetScalarType(), inUsImage->GetNumberOfScalarComponents());
   }
 
+  if (IsFlipClipKernelSupported(flipInfo))
+  {
+    return FlipClipImageKernel(inUsImage, flipInfo, finalClipOrigin, outUsOrientedImage, multiThreaded);
+  }
+
   int numberOfBytesPerScalar = igsioVideoFrame::GetNumberOfBytesPerScalar(inUsImage->GetScalarType());
 
   igsioStatus status(IGSIO_FAIL);
@@ -1181,9 +1772,317 @@ int igsioVideoFrame::GetNumberOfBytesPerScalar(igsioCommon::VTKScalarPixelType p
 //----------------------------------------------------------------------------
 vtkImageData* igsioVideoFrame::GetImage() const
 {
+  if (this->Image == NULL && this->EncodedFrame != NULL)
+  {
+    // DecodedFrame is not changed by const methods once the flag is set
+    if (this->FrameDecoded.load(std::memory_order_acquire))
+    {
+      return this->DecodedFrame;
+    }
+    // If multiple threads decode the same frame at the same time then the first decoded image is kept
+    vtkSmartPointer<vtkImageData> decodedFrame = this->GetDecodedFrameCache()->GetDecodedImage(this->EncodedFrame);
+    igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> decodedFrameGuard(GetDecodedFrameMutex());
+    if (!this->FrameDecoded.load(std::memory_order_relaxed) && decodedFrame != NULL)
+    {
+      this->DecodedFrame = decodedFrame;
+      this->FrameDecoded.store(true, std::memory_order_release);
+    }
+    return this->DecodedFrame;
+  }
   return this->Image;
 }
 
+//----------------------------------------------------------------------------
+void igsioVideoFrame::SetDecodedFrameCache(vtkIGSIODecodedFrameCache* decodedFrameCache)
+{
+  this->DecodedFrameCache = decodedFrameCache;
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIODecodedFrameCache* igsioVideoFrame::GetDecodedFrameCache() const
+{
+  if (this->DecodedFrameCache == NULL)
+  {
+    return vtkIGSIODecodedFrameCache::GetDefaultInstance();
+  }
+  return this->DecodedFrameCache;
+}
+
+//----------------------------------------------------------------------------
+void igsioVideoFrame::SetCopyOnWriteEnabled(bool enabled)
+{
+  CopyOnWriteEnabled = enabled;
+}
+
+//----------------------------------------------------------------------------
+bool igsioVideoFrame::GetCopyOnWriteEnabled()
+{
+  return CopyOnWriteEnabled;
+}
+
+//----------------------------------------------------------------------------
+void igsioVideoFrame::SetFlipClipMultiThreadingThresholdBytes(unsigned long long thresholdBytes)
+{
+  FlipClipMultiThreadingThresholdBytes = thresholdBytes;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long igsioVideoFrame::GetFlipClipMultiThreadingThresholdBytes()
+{
+  return FlipClipMultiThreadingThresholdBytes;
+}
+
+//----------------------------------------------------------------------------
+void igsioVideoFrame::SetPixelConversionMultiThreadingThresholdBytes(unsigned long long thresholdBytes)
+{
+  PixelConversionMultiThreadingThresholdBytes = thresholdBytes;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long igsioVideoFrame::GetPixelConversionMultiThreadingThresholdBytes()
+{
+  return PixelConversionMultiThreadingThresholdBytes;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus igsioVideoFrame::ConvertPixelType(const void* inputPixels,
+    igsioCommon::VTKScalarPixelType inputScalarType,
+    unsigned int numberOfInputScalarComponents,
+    long long numberOfPixels,
+    const PixelConversionInfoType& conversionInfo,
+    unsigned char* outputPixels,
+    bool multiThreaded /*=false*/)
+{
+  if (inputPixels == NULL || outputPixels == NULL)
+  {
+    LOG_ERROR("Failed to convert pixel type - input or output buffer is null");
+    return IGSIO_FAIL;
+  }
+  if (numberOfPixels <= 0)
+  {
+    return IGSIO_SUCCESS;
+  }
+
+  PixelConversionInfoStruct info;
+  info.Mode = conversionInfo.mode;
+  info.Input = static_cast<const unsigned char*>(inputPixels);
+  info.InputScalarType = inputScalarType;
+  info.NumberOfInputScalarComponents = numberOfInputScalarComponents;
+  info.InputBytesPerPixel = igsioVideoFrame::GetNumberOfBytesPerScalar(inputScalarType) * numberOfInputScalarComponents;
+  info.Output = outputPixels;
+  info.OutputBytesPerPixel = GetNumberOfConvertedScalarComponents(conversionInfo.mode, numberOfInputScalarComponents);
+  info.NumberOfPixels = numberOfPixels;
+  info.Scale = 1.0f;
+  info.Shift = 0.0f;
+
+  switch (conversionInfo.mode)
+  {
+    case PIXEL_CONVERSION_WINDOW_LEVEL:
+    case PIXEL_CONVERSION_RESCALE:
+    {
+      if (!igsioPixelConversionKernels::IsScaleToUnsignedCharSupported(inputScalarType))
+      {
+        LOG_ERROR("Failed to convert pixel type - unsupported input scalar type: " << igsioVideoFrame::GetStringFromVTKPixelType(inputScalarType));
+        return IGSIO_FAIL;
+      }
+      double minimum = conversionInfo.level - conversionInfo.window / 2.0;
+      double window = conversionInfo.window;
+      if (conversionInfo.mode == PIXEL_CONVERSION_RESCALE)
+      {
+        double range[2] = {0.0, 0.0};
+        if (igsioPixelConversionKernels::GetRange(inputPixels, inputScalarType, numberOfPixels * numberOfInputScalarComponents, range) != IGSIO_SUCCESS)
+        {
+          return IGSIO_FAIL;
+        }
+        minimum = range[0];
+        window = range[1] - range[0];
+      }
+      else if (window <= 0.0)
+      {
+        LOG_ERROR("Failed to convert pixel type - window must be positive (window=" << conversionInfo.window << ")");
+        return IGSIO_FAIL;
+      }
+      // Constant image is mapped to 0
+      double scale = (window > 0.0 ? 255.0 / window : 0.0);
+      info.Scale = static_cast<float>(scale);
+      info.Shift = static_cast<float>(-minimum * scale);
+      break;
+    }
+    case PIXEL_CONVERSION_RGB_TO_GRAY:
+      if (inputScalarType != VTK_UNSIGNED_CHAR || (numberOfInputScalarComponents != 3 && numberOfInputScalarComponents != 4))
+      {
+        LOG_ERROR("Failed to convert pixel type - RGB to gray conversion requires unsigned char RGB or RGBA input");
+        return IGSIO_FAIL;
+      }
+      break;
+    case PIXEL_CONVERSION_GRAY_TO_RGB:
+      if (inputScalarType != VTK_UNSIGNED_CHAR || numberOfInputScalarComponents != 1)
+      {
+        LOG_ERROR("Failed to convert pixel type - gray to RGB conversion requires unsigned char single component input");
+        return IGSIO_FAIL;
+      }
+      break;
+    default:
+      LOG_ERROR("Failed to convert pixel type - unknown conversion mode: " << conversionInfo.mode);
+      return IGSIO_FAIL;
+  }
+
+  const unsigned long long outputSizeBytes = static_cast<unsigned long long>(numberOfPixels) * info.OutputBytesPerPixel;
+  if (!multiThreaded || outputSizeBytes < PixelConversionMultiThreadingThresholdBytes || numberOfPixels < 2 * PIXEL_CONVERSION_BLOCK_SIZE)
+  {
+    ConvertPixels(info, 0, numberOfPixels);
+    return IGSIO_SUCCESS;
+  }
+
+  const long long numberOfBlocks = (numberOfPixels + PIXEL_CONVERSION_BLOCK_SIZE - 1) / PIXEL_CONVERSION_BLOCK_SIZE;
+  vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+  threader->SetNumberOfThreads(static_cast<int>(std::min<long long>(vtkMultiThreader::GetGlobalDefaultNumberOfThreads(), numberOfBlocks)));
+  threader->SetSingleMethod(PixelConversionThreadFunction, &info);
+  threader->SingleMethodExecute();
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus igsioVideoFrame::ConvertPixelType(vtkImageData* inputImage,
+    const PixelConversionInfoType& conversionInfo,
+    vtkImageData* outputImage,
+    bool multiThreaded /*=false*/)
+{
+  if (inputImage == NULL || outputImage == NULL)
+  {
+    LOG_ERROR("Failed to convert pixel type - input or output image is null");
+    return IGSIO_FAIL;
+  }
+  if (inputImage == outputImage)
+  {
+    LOG_ERROR("Failed to convert pixel type - input and output image must be different");
+    return IGSIO_FAIL;
+  }
+  vtkDataArray* inputScalars = inputImage->GetPointData()->GetScalars();
+  if (inputScalars == NULL)
+  {
+    LOG_ERROR("Failed to convert pixel type - input image has no pixels");
+    return IGSIO_FAIL;
+  }
+
+  const unsigned int numberOfInputScalarComponents = inputImage->GetNumberOfScalarComponents();
+  const unsigned int numberOfOutputScalarComponents = GetNumberOfConvertedScalarComponents(conversionInfo.mode, numberOfInputScalarComponents);
+  int extent[6] = {0, -1, 0, -1, 0, -1};
+  inputImage->GetExtent(extent);
+  int outputExtent[6] = {0, -1, 0, -1, 0, -1};
+  outputImage->GetExtent(outputExtent);
+  vtkDataArray* outputScalars = outputImage->GetPointData()->GetScalars();
+  if (!std::equal(extent, extent + 6, outputExtent)
+      || outputScalars == NULL
+      || outputScalars->GetReferenceCount() != 1
+      || outputImage->GetScalarType() != VTK_UNSIGNED_CHAR
+      || outputImage->GetNumberOfScalarComponents() != static_cast<int>(numberOfOutputScalarComponents))
+  {
+    outputImage->SetExtent(extent);
+    outputImage->AllocateScalars(VTK_UNSIGNED_CHAR, numberOfOutputScalarComponents);
+  }
+  outputImage->SetOrigin(inputImage->GetOrigin());
+  outputImage->SetSpacing(inputImage->GetSpacing());
+
+  int dimensions[3] = {0, 0, 0};
+  inputImage->GetDimensions(dimensions);
+  const long long numberOfPixels = static_cast<long long>(dimensions[0]) * dimensions[1] * dimensions[2];
+  return igsioVideoFrame::ConvertPixelType(inputImage->GetScalarPointer(), inputImage->GetScalarType(), numberOfInputScalarComponents, numberOfPixels,
+         conversionInfo, static_cast<unsigned char*>(outputImage->GetScalarPointer()), multiThreaded);
+}
+
+//----------------------------------------------------------------------------
+igsioStatus igsioVideoFrame::ConvertPixelType(const PixelConversionInfoType& conversionInfo, igsioVideoFrame& outputFrame, bool multiThreaded /*=false*/) const
+{
+  if (&outputFrame == this)
+  {
+    LOG_ERROR("Failed to convert pixel type - input and output frame must be different");
+    return IGSIO_FAIL;
+  }
+  if (this->Image == NULL || this->Image->GetPointData()->GetScalars() == NULL)
+  {
+    LOG_ERROR("Failed to convert pixel type - the frame has no pixels");
+    return IGSIO_FAIL;
+  }
+
+  FrameSizeType frameSize = {0, 0, 0};
+  this->GetFrameSize(frameSize);
+  const unsigned int numberOfInputScalarComponents = this->Image->GetNumberOfScalarComponents();
+  if (outputFrame.AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, GetNumberOfConvertedScalarComponents(conversionInfo.mode, numberOfInputScalarComponents)) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Failed to convert pixel type - unable to allocate the output frame");
+    return IGSIO_FAIL;
+  }
+  outputFrame.SetImageOrientation(this->ImageOrientation);
+  switch (conversionInfo.mode)
+  {
+    case PIXEL_CONVERSION_RGB_TO_GRAY:
+      outputFrame.SetImageType(US_IMG_BRIGHTNESS);
+      break;
+    case PIXEL_CONVERSION_GRAY_TO_RGB:
+      outputFrame.SetImageType(US_IMG_RGB_COLOR);
+      break;
+    default:
+      outputFrame.SetImageType(this->ImageType);
+      break;
+  }
+
+  const long long numberOfPixels = static_cast<long long>(frameSize[0]) * frameSize[1] * frameSize[2];
+  return igsioVideoFrame::ConvertPixelType(this->GetScalarPointer(), this->Image->GetScalarType(), numberOfInputScalarComponents, numberOfPixels,
+         conversionInfo, static_cast<unsigned char*>(outputFrame.GetScalarPointer()), multiThreaded);
+}
+
+//----------------------------------------------------------------------------
+unsigned long long igsioVideoFrame::GetNumberOfSharedCopies()
+{
+  return NumberOfSharedCopies;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long igsioVideoFrame::GetNumberOfDeferredCopies()
+{
+  return NumberOfDeferredCopies;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long igsioVideoFrame::GetNumberOfAvoidedCopies()
+{
+  unsigned long long sharedCopies = NumberOfSharedCopies;
+  unsigned long long deferredCopies = NumberOfDeferredCopies;
+  return (sharedCopies > deferredCopies ? sharedCopies - deferredCopies : 0);
+}
+
+//----------------------------------------------------------------------------
+void igsioVideoFrame::ResetCopyOnWriteStatistics()
+{
+  NumberOfSharedCopies = 0;
+  NumberOfDeferredCopies = 0;
+}
+
+//----------------------------------------------------------------------------
+bool igsioVideoFrame::IsImageShared() const
+{
+  return (this->Image != NULL && this->ImageCopyOnWrite && this->Image->GetReferenceCount() > 1);
+}
+
+//----------------------------------------------------------------------------
+igsioStatus igsioVideoFrame::MakeImageWritable()
+{
+  if (!this->IsImageShared())
+  {
+    return IGSIO_SUCCESS;
+  }
+
+  vtkImageData* unsharedImage = vtkImageData::New();
+  unsharedImage->DeepCopy(this->Image);
+  this->ReleaseImage();
+  this->Image = unsharedImage;
+  this->UpdateFrameMemoryCounter();
+  ++NumberOfDeferredCopies;
+
+  return IGSIO_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 vtkStreamingVolumeFrame* igsioVideoFrame::GetEncodedFrame() const
 {
@@ -1194,12 +2093,19 @@ vtkStreamingVolumeFrame* igsioVideoFrame::GetEncodedFrame() const
 void igsioVideoFrame::SetImageData(vtkImageData* imageData)
 {
   this->Image = imageData;
+  this->UpdateFrameMemoryCounter();
 }
 
 //----------------------------------------------------------------------------
 void igsioVideoFrame::SetEncodedFrame(vtkStreamingVolumeFrame* encodedFrame)
 {
+  if (this->EncodedFrame != encodedFrame)
+  {
+    this->DecodedFrame = NULL;
+    this->FrameDecoded = false;
+  }
   this->EncodedFrame = encodedFrame;
+  this->UpdateFrameMemoryCounter();
 }
 
 //----------------------------------------------------------------------------
@@ -15,11 +15,17 @@ See License.txt for details.
 
 // IGSIO includes
 #include "igsioCommon.h"
+#include "vtkIGSIOFrameBufferPool.h"
 #include "vtkigsiocommon_export.h"
 
 // vtkAddon includes
 #include <vtkStreamingVolumeFrame.h>
 
+// STL includes
+#include <atomic>
+#include <memory>
+
+class vtkIGSIODecodedFrameCache;
 class vtkStreamingVolumeCodec;
 
 /*!
@@ -33,6 +39,8 @@ functions to get/set its content from ITK and VTK images and byte arrays.
 */
 class VTKIGSIOCOMMON_EXPORT igsioVideoFrame
 {
+  friend class vtkIGSIOTrackedFrameList;
+
 public:
   enum TransposeType
   {
@@ -52,6 +60,22 @@ public:
     bool doubleRow; // keep pairs of pixel rows together (for RF_I_LINE_Q_LINE encoded images)
   };
 
+  enum PixelConversionMode
+  {
+    PIXEL_CONVERSION_WINDOW_LEVEL, // any scalar type to unsigned char, values in [level-window/2, level+window/2] are mapped to [0, 255]
+    PIXEL_CONVERSION_RESCALE, // any scalar type to unsigned char, the range of the values in the image is mapped to [0, 255]
+    PIXEL_CONVERSION_RGB_TO_GRAY, // unsigned char RGB or RGBA to unsigned char gray
+    PIXEL_CONVERSION_GRAY_TO_RGB // unsigned char gray to unsigned char RGB
+  };
+
+  struct PixelConversionInfoType
+  {
+    PixelConversionInfoType() : mode(PIXEL_CONVERSION_RESCALE), window(256.0), level(127.5) {};
+    PixelConversionMode mode;
+    double window; // width of the mapped input value range (only for PIXEL_CONVERSION_WINDOW_LEVEL)
+    double level; // center of the mapped input value range (only for PIXEL_CONVERSION_WINDOW_LEVEL)
+  };
+
   /*! Constructor */
   igsioVideoFrame();
 
@@ -64,11 +88,28 @@ public:
   /*! Equality operator */
   igsioVideoFrame& operator=(igsioVideoFrame const& videoItem);
 
+  /*! Move constructor. Takes over the pixel buffer and the encoded frame, the source frame is left empty. */
+  igsioVideoFrame(igsioVideoFrame&& videoItem);
+
+  /*! Move assignment. Takes over the pixel buffer and the encoded frame, the source frame is left empty. */
+  igsioVideoFrame& operator=(igsioVideoFrame&& videoItem);
+
   /*! Allocate memory for the image. The image object must be already created. */
   static igsioStatus AllocateFrame(vtkImageData* image, const FrameSizeType& imageSize, igsioCommon::VTKScalarPixelType vtkScalarPixelType, unsigned int numberOfScalarComponents);
-  /*! Allocate memory for the image. */
+  /*! Allocate memory for the image. The pixel buffer is taken from the buffer pool of the frame. */
   igsioStatus AllocateFrame(const FrameSizeType& imageSize, igsioCommon::VTKScalarPixelType vtkScalarPixelType, unsigned int numberOfScalarComponents);
 
+  /*!
+    Set the pool that pixel buffers are taken from in AllocateFrame and returned to when the frame is deleted
+    or reallocated. If NULL then the default pool is used. The pool is not copied when the frame is copied or assigned,
+    a frame that is constructed by moving another frame uses the pool of that frame. Pools only take back the buffers
+    that they have allocated: after changing the pool, or moving a frame into a frame with a different pool,
+    the current buffer is freed instead of being returned to a pool.
+  */
+  void SetBufferPool(vtkIGSIOFrameBufferPool* bufferPool);
+  /*! Get the pool that pixel buffers are taken from (the default pool if no pool is set) */
+  vtkIGSIOFrameBufferPool* GetBufferPool() const;
+
   /*! Return the pixel type using VTK enums. */
   igsioCommon::VTKScalarPixelType GetVTKScalarPixelType() const;
 
@@ -118,15 +159,64 @@ public:
 
   bool IsFrameEncoded() const;
 
-  /*! Get the pointer to the pixel buffer */
+  /*! Get the pointer to the pixel buffer for reading */
   void* GetScalarPointer() const;
 
+  /*!
+    Get the pointer to the pixel buffer for writing.
+    If the image is shared with other frames (see copy-on-write mode) then the pixels are copied first.
+  */
+  void* GetScalarPointer();
+
   /*! Get the pixel buffer size in bytes */
   unsigned long GetFrameSizeInBytes() const;
 
-  /*! Get the VTK image, does not copy the pixel buffer */
+  /*!
+    Get the VTK image, does not copy the pixel buffer.
+    In copy-on-write mode the image may be shared with other frames, call MakeImageWritable() before modifying it.
+    If the frame contains encoded data only then the frame is decoded on first access (using the decoded frame cache)
+    and the decoded image is kept until the encoded frame is changed. The decoded image is read-only: it is shared
+    with the cache and with other frames, so it must not be modified (copy it, e.g., by DeepCopyFrom, to make changes).
+    Can be called from multiple threads at the same time (but not while the frame is being modified).
+  */
   vtkImageData* GetImage() const;
 
+  /*!
+    Set the cache that encoded frames are decoded with in GetImage(). If NULL then the default cache is used.
+    The cache is not copied when the frame is copied.
+  */
+  void SetDecodedFrameCache(vtkIGSIODecodedFrameCache* decodedFrameCache);
+  /*! Get the cache that encoded frames are decoded with (the default cache if no cache is set) */
+  vtkIGSIODecodedFrameCache* GetDecodedFrameCache() const;
+
+  /*!
+    Enable copy-on-write mode for all video frames. When enabled, copying a frame (copy constructor,
+    operator=, DeepCopy) does not copy the pixels but the copies share the same image object.
+    The pixels are copied only when one of the copies is about to be modified (GetScalarPointer for write,
+    FillBlank, MakeImageWritable, orient/clip output). Disabled by default.
+  */
+  static void SetCopyOnWriteEnabled(bool enabled);
+  static bool GetCopyOnWriteEnabled();
+
+  /*! Number of frame copies that shared the pixel buffer instead of copying it */
+  static unsigned long long GetNumberOfSharedCopies();
+  /*! Number of shared pixel buffers that had to be copied later because a frame was modified */
+  static unsigned long long GetNumberOfDeferredCopies();
+  /*! Number of pixel buffer copies that were avoided by copy-on-write (shared copies - deferred copies) */
+  static unsigned long long GetNumberOfAvoidedCopies();
+  /*! Reset copy-on-write statistics */
+  static void ResetCopyOnWriteStatistics();
+
+  /*!
+    Return true if the image object has been shared with other frames by copy-on-write and it is still referenced by others.
+    Images of frames that have never shared their image (e.g., copy-on-write mode is disabled) are never considered shared,
+    so references held by other objects don't change how these frames are modified.
+  */
+  bool IsImageShared() const;
+
+  /*! Make sure the image object is not shared with any other frame by copy-on-write, copy the pixels if needed */
+  igsioStatus MakeImageWritable();
+
   /*! Get the encoded frame data */
   vtkStreamingVolumeFrame* GetEncodedFrame() const;
 
@@ -163,6 +253,7 @@ public:
   \param outUsOrientedImage the output image to populate with clipped and oriented data
   \param clipRectangleOrigin the clipping origin relative to the inUsImage data origin
   \param clipRectangleSize the size of the clipping space, a value of NO_CLIP in either [0],[1] or [2] indicates no clipping performed, in inputImage space
+  \param multiThreaded if true then large images are processed in multiple threads
   */
   static igsioStatus GetOrientedClippedImage(unsigned char* imageDataPtr,
       FlipInfoType flipInfo,
@@ -172,7 +263,8 @@ public:
       const FrameSizeType& inputFrameSizeInPx,
       vtkImageData* outUsOrientedImage,
       const std::array<int, 3>& clipRectangleOrigin,
-      const std::array<int, 3>& clipRectangleSize);
+      const std::array<int, 3>& clipRectangleSize,
+      bool multiThreaded = false);
 
   /*! Convert oriented image to MF oriented ultrasound image and perform any requested clipping
   \param imageDataPtr the source data to analyze for possible clipping and reorienting
@@ -184,6 +276,7 @@ public:
   \param outBufferItem the output video frame to populate with clipped and oriented data
   \param clipRectangleOrigin the clipping origin relative to the inUsImage data origin
   \param clipRectangleSize the size of the clipping space, a value of NO_CLIP in either [0],[1] or [2] indicates no clipping performed, in inputImage space
+  \param multiThreaded if true then large images are processed in multiple threads
   */
   static igsioStatus GetOrientedClippedImage(unsigned char* imageDataPtr,
       FlipInfoType flipInfo,
@@ -193,7 +286,8 @@ public:
       const FrameSizeType& inputFrameSizeInPx,
       igsioVideoFrame& outBufferItem,
       const std::array<int, 3>& clipRectangleOrigin,
-      const std::array<int, 3>& clipRectangleSize);
+      const std::array<int, 3>& clipRectangleSize,
+      bool multiThreaded = false);
 
   /*! Convert oriented image to MF oriented ultrasound image and perform any requested clipping
   \param inUsImage the source image to analyze for possible clipping and reorienting
@@ -202,24 +296,77 @@ public:
   \param outUsOrientedImage the output image to populate with clipped and oriented data
   \param clipRectangleOrigin the clipping origin relative to the inUsImage data origin
   \param clipRectangleSize the size of the clipping space, a value of NO_CLIP in either [0],[1] or [2] indicates no clipping performed, in inputImage space
+  \param multiThreaded if true then large images are processed in multiple threads
   */
   static igsioStatus GetOrientedClippedImage(vtkImageData* inUsImage,
       FlipInfoType flipInfo,
       US_IMAGE_TYPE inUsImageType,
       vtkImageData* outUsOrientedImage,
       const std::array<int, 3>& clipRectangleOrigin,
-      const std::array<int, 3>& clipRectangleSize);
+      const std::array<int, 3>& clipRectangleSize,
+      bool multiThreaded = false);
 
   /*!
   Flip a 2D image along one or two axes. This is a performance optimized version of flipping that does not use ITK filters
   \param clipRectangleOrigin the clipping origin relative to the inUsImage data origin
   \param clipRectangleSize the size of the clipping space, a value of NO_CLIP in either [0],[1] or [2] indicates no clipping performed
+  \param multiThreaded if true and the output image is larger than the multi-threading threshold then the output is split
+    into slabs that are processed in parallel (only for flips and transposition without double row or column mode)
+  \param allowShallowCopy if true and no flip, transposition or clipping is needed then the output shares the pixel buffer
+    of the input instead of copying it (modifying the output pixels modifies the input)
   */
   static igsioStatus FlipClipImage(vtkImageData* inUsImage,
                                    const FlipInfoType& flipInfo,
                                    const std::array<int, 3>& clipRectangleOrigin,
                                    const std::array<int, 3>& clipRectangleSize,
-                                   vtkImageData* outUsOrientedImage);
+                                   vtkImageData* outUsOrientedImage,
+                                   bool multiThreaded = false,
+                                   bool allowShallowCopy = false);
+
+  /*! Minimum output image size (in bytes) for using multiple threads in multi-threaded FlipClipImage. Default: 4MB. */
+  static void SetFlipClipMultiThreadingThresholdBytes(unsigned long long thresholdBytes);
+  static unsigned long long GetFlipClipMultiThreadingThresholdBytes();
+
+  /*!
+    Convert pixel values to another pixel type or number of components. Window/level and rescale convert each scalar
+    component to unsigned char (the number of components is kept), RGB to gray and gray to RGB convert unsigned char images.
+    \param inputPixels first pixel of the input, pixels are stored contiguously
+    \param inputScalarType scalar type of the input
+    \param numberOfInputScalarComponents number of scalar components of the input
+    \param numberOfPixels number of pixels in the input and in the output
+    \param outputPixels first pixel of the output, provided by the caller (unsigned char, 3 components for gray to RGB,
+      1 component for RGB to gray, the number of input components otherwise)
+    \param multiThreaded if true and the output is larger than the multi-threading threshold then the pixels are
+      split into blocks that are converted in parallel
+  */
+  static igsioStatus ConvertPixelType(const void* inputPixels,
+                                      igsioCommon::VTKScalarPixelType inputScalarType,
+                                      unsigned int numberOfInputScalarComponents,
+                                      long long numberOfPixels,
+                                      const PixelConversionInfoType& conversionInfo,
+                                      unsigned char* outputPixels,
+                                      bool multiThreaded = false);
+
+  /*!
+    Convert pixel values of an image (see the raw buffer version for details). The output image gets the extent, origin
+    and spacing of the input, its pixel buffer is reused if it already has the right size and it is not shared with
+    any other image (e.g., after a shallow copy).
+  */
+  static igsioStatus ConvertPixelType(vtkImageData* inputImage,
+                                      const PixelConversionInfoType& conversionInfo,
+                                      vtkImageData* outputImage,
+                                      bool multiThreaded = false);
+
+  /*!
+    Convert pixel values of this frame into another frame (see the raw buffer version for details).
+    The output pixel buffer is taken from the buffer pool of the output frame. The image orientation is copied,
+    the image type is set to RGB color or brightness for gray/RGB conversions and copied otherwise.
+  */
+  igsioStatus ConvertPixelType(const PixelConversionInfoType& conversionInfo, igsioVideoFrame& outputFrame, bool multiThreaded = false) const;
+
+  /*! Minimum output size (in bytes) for using multiple threads in multi-threaded ConvertPixelType. Default: 4MB. */
+  static void SetPixelConversionMultiThreadingThresholdBytes(unsigned long long thresholdBytes);
+  static unsigned long long GetPixelConversionMultiThreadingThresholdBytes();
 
   /*! Return true if the image data is valid (e.g. not NULL) */
   bool IsImageValid() const
@@ -248,13 +395,52 @@ public:
 protected:
   void SetImageData(vtkImageData* imageData);
 
+  /*! Delete the image. The pixel buffer is returned to the buffer pool if nobody else uses it. */
+  void ReleaseImage();
+
+  /*! Return the pixel buffer to the buffer pool if it was taken from the pool and nobody else uses it */
+  void ReleasePooledBuffer();
+
+  /*! Returns true if the image and its pixel buffer are only used by this frame, so the pixels can be overwritten in place */
+  bool IsImageExclusivelyOwned() const;
+
+  /*! Counter of the total pixel data size of the frames of a tracked frame list */
+  typedef std::shared_ptr<std::atomic<unsigned long long> > FrameMemoryCounterType;
+
+  /*!
+    Set the counter that the pixel data size of this frame is added to (NULL to remove the frame from the counter).
+    The size of the frame is subtracted from the previous counter.
+  */
+  void SetFrameMemoryCounter(const FrameMemoryCounterType& frameMemoryCounter);
+
+  /*! Update the frame memory counter after the pixel data may have been reallocated */
+  void UpdateFrameMemoryCounter();
+
   vtkImageData* Image;
+  /*! True if Image has been shared with another frame by copy-on-write (the other frame may still use it) */
+  mutable bool ImageCopyOnWrite;
   vtkSmartPointer<vtkStreamingVolumeFrame> EncodedFrame;
-  vtkSmartPointer<vtkImageData> DecodedFrame;
+  /*! Decoded image of EncodedFrame, set on first access by GetImage() */
+  mutable vtkSmartPointer<vtkImageData> DecodedFrame;
+  /*! True if DecodedFrame is set, allows GetImage() to return it without locking */
+  mutable std::atomic<bool> FrameDecoded;
   vtkSmartPointer<vtkStreamingVolumeCodec> Codec;
+  vtkSmartPointer<vtkIGSIODecodedFrameCache> DecodedFrameCache;
 
   US_IMAGE_TYPE ImageType;
   US_IMAGE_ORIENTATION ImageOrientation;
+
+  vtkSmartPointer<vtkIGSIOFrameBufferPool> BufferPool;
+  /*! Pixel buffer of Image that was taken from the buffer pool */
+  vtkSmartPointer<vtkDataArray> PooledBuffer;
+
+  /*!
+    Total pixel data size of the frames of the tracked frame list that contains this frame (NULL if the frame is not in a list).
+    It is not copied by assignment, as it belongs to the frame object and not to its content.
+  */
+  FrameMemoryCounterType FrameMemoryCounter;
+  /*! Pixel data size of this frame that is currently added to FrameMemoryCounter */
+  unsigned long long CountedFrameMemoryBytes;
 };
 
 #endif
@@ -0,0 +1,350 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// IGSIO includes
+#include "vtkIGSIODecodedFrameCache.h"
+#include "vtkIGSIORecursiveCriticalSection.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeCodec.h>
+#include <vtkStreamingVolumeCodecFactory.h>
+
+// STL includes
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+  // Default limit of the decoded image size (a few seconds of typical ultrasound frames)
+  const unsigned long long DEFAULT_MAXIMUM_CACHED_BYTES = 128 * 1024 * 1024;
+
+  // Default number of streams that can be decoded in parallel (e.g., a few video tracks of a sequence)
+  const unsigned int DEFAULT_MAXIMUM_NUMBER_OF_DECODERS = 4;
+}
+
+vtkStandardNewMacro(vtkIGSIODecodedFrameCache);
+
+//----------------------------------------------------------------------------
+vtkIGSIODecodedFrameCache::vtkIGSIODecodedFrameCache()
+  : MaximumCachedBytes(DEFAULT_MAXIMUM_CACHED_BYTES)
+  , MaximumNumberOfDecoders(DEFAULT_MAXIMUM_NUMBER_OF_DECODERS)
+  , CachedBytes(0)
+  , NumberOfHits(0)
+  , NumberOfMisses(0)
+  , NumberOfDecodedFrames(0)
+  , Mutex(vtkIGSIOSimpleRecursiveCriticalSection::New())
+{
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIODecodedFrameCache::~vtkIGSIODecodedFrameCache()
+{
+  this->Clear();
+  this->Mutex->Delete();
+  this->Mutex = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIODecodedFrameCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  os << indent << "MaximumCachedBytes: " << this->MaximumCachedBytes << std::endl;
+  os << indent << "MaximumNumberOfDecoders: " << this->MaximumNumberOfDecoders << std::endl;
+  os << indent << "CachedBytes: " << this->CachedBytes << std::endl;
+  os << indent << "NumberOfCachedImages: " << this->CacheEntries.size() << std::endl;
+  os << indent << "NumberOfDecoders: " << this->Decoders.size() << std::endl;
+  os << indent << "NumberOfHits: " << this->NumberOfHits << std::endl;
+  os << indent << "NumberOfMisses: " << this->NumberOfMisses << std::endl;
+  os << indent << "NumberOfDecodedFrames: " << this->NumberOfDecodedFrames << std::endl;
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIODecodedFrameCache* vtkIGSIODecodedFrameCache::GetDefaultInstance()
+{
+  static vtkSmartPointer<vtkIGSIODecodedFrameCache> defaultInstance = vtkSmartPointer<vtkIGSIODecodedFrameCache>::New();
+  return defaultInstance;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> vtkIGSIODecodedFrameCache::GetDecodedImage(vtkStreamingVolumeFrame* encodedFrame)
+{
+  if (encodedFrame == NULL)
+  {
+    return NULL;
+  }
+
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  CacheEntryListType::iterator entryIt = this->FindCacheEntry(encodedFrame);
+  if (entryIt != this->CacheEntries.end())
+  {
+    // Move to the front of the LRU list
+    this->CacheEntries.splice(this->CacheEntries.begin(), this->CacheEntries, entryIt);
+    this->NumberOfHits++;
+    return entryIt->Image;
+  }
+  this->NumberOfMisses++;
+  return this->DecodeFrame(encodedFrame);
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> vtkIGSIODecodedFrameCache::DecodeFrame(vtkStreamingVolumeFrame* encodedFrame)
+{
+  // Collect the frames that have to be decoded, from the requested frame back to the keyframe
+  // or to the frame that one of the decoders has decoded last
+  std::vector<vtkStreamingVolumeFrame*> framesToDecode;
+  DecoderListType::iterator decoderIt = this->Decoders.end();
+  for (vtkStreamingVolumeFrame* frame = encodedFrame; frame != NULL; frame = frame->GetPreviousFrame())
+  {
+    framesToDecode.push_back(frame);
+    if (frame->IsKeyFrame())
+    {
+      break;
+    }
+    decoderIt = this->FindDecoder(frame->GetPreviousFrame());
+    if (decoderIt != this->Decoders.end())
+    {
+      break;
+    }
+  }
+
+  const std::string fourCC = encodedFrame->GetCodecFourCC();
+  if (decoderIt == this->Decoders.end())
+  {
+    // Decoding starts from the keyframe (or from the first available frame if the keyframe is missing)
+    decoderIt = this->CreateDecoder(fourCC);
+    if (decoderIt == this->Decoders.end())
+    {
+      LOG_ERROR("Failed to decode frame: no codec is available for " << fourCC);
+      return NULL;
+    }
+  }
+  this->Decoders.splice(this->Decoders.begin(), this->Decoders, decoderIt);
+
+  vtkSmartPointer<vtkImageData> decodedImage;
+  for (std::vector<vtkStreamingVolumeFrame*>::reverse_iterator frameIt = framesToDecode.rbegin(); frameIt != framesToDecode.rend(); ++frameIt)
+  {
+    vtkStreamingVolumeFrame* frame = *frameIt;
+    decodedImage = vtkSmartPointer<vtkImageData>::New();
+    decodedImage->SetDimensions(frame->GetDimensions());
+    decodedImage->AllocateScalars(frame->GetVTKScalarType(), frame->GetNumberOfComponents());
+    if (!decoderIt->Codec->DecodeFrame(frame, decodedImage))
+    {
+      LOG_ERROR("Failed to decode " << fourCC << " frame");
+      // The state of the decoder is unknown, it has to restart from a keyframe
+      decoderIt->LastDecodedFrame = NULL;
+      return NULL;
+    }
+    decoderIt->LastDecodedFrame = frame;
+    decoderIt->LastDecodedFrameMTime = frame->GetMTime();
+    this->NumberOfDecodedFrames++;
+    this->AddToCache(frame, decodedImage);
+  }
+
+  return decodedImage;
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIODecodedFrameCache::DecoderListType::iterator vtkIGSIODecodedFrameCache::FindDecoder(vtkStreamingVolumeFrame* lastDecodedFrame)
+{
+  if (lastDecodedFrame == NULL)
+  {
+    return this->Decoders.end();
+  }
+  for (DecoderListType::iterator decoderIt = this->Decoders.begin(); decoderIt != this->Decoders.end(); ++decoderIt)
+  {
+    if (decoderIt->LastDecodedFrame == lastDecodedFrame && decoderIt->LastDecodedFrameMTime == lastDecodedFrame->GetMTime())
+    {
+      return decoderIt;
+    }
+  }
+  return this->Decoders.end();
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIODecodedFrameCache::DecoderListType::iterator vtkIGSIODecodedFrameCache::CreateDecoder(const std::string& fourCC)
+{
+  if (!this->Decoders.empty() && this->Decoders.size() >= this->MaximumNumberOfDecoders)
+  {
+    // Reuse the least recently used decoder of the same codec, decoding a keyframe resets its state
+    for (DecoderListType::reverse_iterator decoderIt = this->Decoders.rbegin(); decoderIt != this->Decoders.rend(); ++decoderIt)
+    {
+      if (decoderIt->FourCC == fourCC)
+      {
+        decoderIt->LastDecodedFrame = NULL;
+        return --(decoderIt.base());
+      }
+    }
+    this->Decoders.pop_back();
+  }
+
+  Decoder decoder;
+  decoder.FourCC = fourCC;
+  decoder.LastDecodedFrame = NULL;
+  decoder.LastDecodedFrameMTime = 0;
+  decoder.Codec = vtkSmartPointer<vtkStreamingVolumeCodec>::Take(vtkStreamingVolumeCodecFactory::GetInstance()->CreateCodecByFourCC(fourCC));
+  if (decoder.Codec == NULL)
+  {
+    return this->Decoders.end();
+  }
+  this->Decoders.push_front(decoder);
+  return this->Decoders.begin();
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIODecodedFrameCache::CacheEntryListType::iterator vtkIGSIODecodedFrameCache::FindCacheEntry(vtkStreamingVolumeFrame* encodedFrame)
+{
+  CacheEntryMapType::iterator entryIt = this->CacheEntryMap.find(encodedFrame);
+  if (entryIt == this->CacheEntryMap.end())
+  {
+    return this->CacheEntries.end();
+  }
+  if (entryIt->second->FrameMTime != encodedFrame->GetMTime())
+  {
+    // The frame has been modified, or it has been deleted and a new frame is created at the same address
+    this->RemoveFromCache(entryIt);
+    return this->CacheEntries.end();
+  }
+  return entryIt->second;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIODecodedFrameCache::AddToCache(vtkStreamingVolumeFrame* encodedFrame, vtkImageData* image)
+{
+  CacheEntryListType::iterator entryIt = this->FindCacheEntry(encodedFrame);
+  if (entryIt != this->CacheEntries.end())
+  {
+    // Already cached (frame in the chain of another frame)
+    this->CacheEntries.splice(this->CacheEntries.begin(), this->CacheEntries, entryIt);
+    return;
+  }
+
+  unsigned long long imageSizeInBytes = static_cast<unsigned long long>(image->GetNumberOfPoints())
+                                        * image->GetNumberOfScalarComponents() * image->GetScalarSize();
+  if (imageSizeInBytes > this->MaximumCachedBytes)
+  {
+    return;
+  }
+  this->EvictImages(this->MaximumCachedBytes - imageSizeInBytes);
+
+  CacheEntry entry;
+  entry.Frame = encodedFrame;
+  entry.FrameMTime = encodedFrame->GetMTime();
+  entry.Image = image;
+  entry.SizeInBytes = imageSizeInBytes;
+  this->CacheEntries.push_front(entry);
+  this->CacheEntryMap[encodedFrame] = this->CacheEntries.begin();
+  this->CachedBytes += imageSizeInBytes;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIODecodedFrameCache::RemoveFromCache(CacheEntryMapType::iterator entryIt)
+{
+  this->CachedBytes -= entryIt->second->SizeInBytes;
+  this->CacheEntries.erase(entryIt->second);
+  this->CacheEntryMap.erase(entryIt);
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIODecodedFrameCache::EvictImages(unsigned long long maximumCachedBytes)
+{
+  while (!this->CacheEntries.empty() && this->CachedBytes > maximumCachedBytes)
+  {
+    // Frame is only used as a key, it may not exist anymore
+    this->RemoveFromCache(this->CacheEntryMap.find(this->CacheEntries.back().Frame));
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIODecodedFrameCache::Clear()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  this->CacheEntryMap.clear();
+  this->CacheEntries.clear();
+  this->CachedBytes = 0;
+  this->Decoders.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIODecodedFrameCache::SetMaximumCachedBytes(unsigned long long maximumCachedBytes)
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  this->MaximumCachedBytes = maximumCachedBytes;
+  this->EvictImages(this->MaximumCachedBytes);
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIODecodedFrameCache::GetMaximumCachedBytes()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  return this->MaximumCachedBytes;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIODecodedFrameCache::SetMaximumNumberOfDecoders(unsigned int maximumNumberOfDecoders)
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  this->MaximumNumberOfDecoders = std::max(maximumNumberOfDecoders, 1u);
+  while (this->Decoders.size() > this->MaximumNumberOfDecoders)
+  {
+    this->Decoders.pop_back();
+  }
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkIGSIODecodedFrameCache::GetMaximumNumberOfDecoders()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  return this->MaximumNumberOfDecoders;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIODecodedFrameCache::GetCachedBytes()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  return this->CachedBytes;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkIGSIODecodedFrameCache::GetNumberOfCachedImages()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  return static_cast<unsigned int>(this->CacheEntries.size());
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIODecodedFrameCache::GetNumberOfHits()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  return this->NumberOfHits;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIODecodedFrameCache::GetNumberOfMisses()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  return this->NumberOfMisses;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIODecodedFrameCache::GetNumberOfDecodedFrames()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  return this->NumberOfDecodedFrames;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIODecodedFrameCache::ResetStatistics()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> cacheGuard(this->Mutex);
+  this->NumberOfHits = 0;
+  this->NumberOfMisses = 0;
+  this->NumberOfDecodedFrames = 0;
+}
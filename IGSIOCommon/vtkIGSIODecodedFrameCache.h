@@ -0,0 +1,169 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkIGSIODecodedFrameCache_h
+#define __vtkIGSIODecodedFrameCache_h
+
+#include "vtkigsiocommon_export.h"
+
+// IGSIO includes
+#include "igsioCommon.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// vtkAddon includes
+#include <vtkStreamingVolumeFrame.h>
+
+// STL includes
+#include <list>
+#include <map>
+#include <string>
+
+#ifndef VTK_OVERRIDE
+#define VTK_OVERRIDE override
+#endif
+
+class vtkIGSIOSimpleRecursiveCriticalSection;
+class vtkStreamingVolumeCodec;
+
+/*!
+  \class vtkIGSIODecodedFrameCache
+  \brief Decodes encoded video frames on demand and keeps the most recently used decoded images
+
+  igsioVideoFrame::GetImage() uses this cache to decode frames that only contain encoded data
+  (e.g., frames read from MKV files), so frames are only decoded when their pixels are actually needed.
+
+  Decoded images are kept in a least recently used cache until their total size reaches MaximumCachedBytes.
+  Images are reference counted, so an evicted image remains valid for everyone who still holds a reference to it.
+  The returned images are shared and must not be modified.
+
+  The cache does not keep references to the encoded frames, so it does not keep their PreviousFrame chains
+  alive either: only the decoded images are counted against MaximumCachedBytes. Frames are identified by their
+  address and modification time, so a frame that has been modified or deleted (and its address reused) is not
+  matched by a cached image. The codec of each decoder keeps a reference to the last frame that it has decoded,
+  so at most MaximumNumberOfDecoders chains are kept alive by the cache.
+
+  Decoding a P-frame requires decoding its PreviousFrame chain. The cache keeps a separate decoder (codec instance)
+  for each stream that is being decoded (up to MaximumNumberOfDecoders) and remembers the last frame that each
+  decoder has decoded. If that frame is in the chain of the requested frame then decoding continues from there,
+  so sequential access decodes each frame only once instead of starting from the keyframe each time.
+  Frames that are decoded along the chain are added to the cache as well.
+
+  By default frames use the cache returned by GetDefaultInstance().
+
+  The class is thread-safe. Frames are decoded one at a time.
+
+  \ingroup PlusLibCommon
+*/
+class VTKIGSIOCOMMON_EXPORT vtkIGSIODecodedFrameCache : public vtkObject
+{
+public:
+  static vtkIGSIODecodedFrameCache* New();
+  vtkTypeMacro(vtkIGSIODecodedFrameCache, vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /*! Get the cache that is used by video frames by default */
+  static vtkIGSIODecodedFrameCache* GetDefaultInstance();
+
+  /*!
+    Get the decoded image of an encoded frame. The frame is decoded if it is not in the cache.
+    Returns NULL if no codec is available for the frame or decoding fails.
+  */
+  vtkSmartPointer<vtkImageData> GetDecodedImage(vtkStreamingVolumeFrame* encodedFrame);
+
+  /*! Release all cached images and decoders */
+  void Clear();
+
+  /*! Set the maximum total size of cached decoded images. Setting 0 disables caching (decoders are still reused). */
+  void SetMaximumCachedBytes(unsigned long long maximumCachedBytes);
+  unsigned long long GetMaximumCachedBytes();
+
+  /*! Set the maximum number of streams that are decoded in parallel without restarting from the keyframe */
+  void SetMaximumNumberOfDecoders(unsigned int maximumNumberOfDecoders);
+  unsigned int GetMaximumNumberOfDecoders();
+
+  /*! Total size of images currently kept in the cache */
+  unsigned long long GetCachedBytes();
+  /*! Number of images currently kept in the cache */
+  unsigned int GetNumberOfCachedImages();
+
+  /*! Number of GetDecodedImage calls that were served from the cache */
+  unsigned long long GetNumberOfHits();
+  /*! Number of GetDecodedImage calls that required decoding */
+  unsigned long long GetNumberOfMisses();
+  /*! Number of frames decoded, including the frames decoded along the PreviousFrame chain */
+  unsigned long long GetNumberOfDecodedFrames();
+  /*! Reset hit, miss and decoded frame counters */
+  void ResetStatistics();
+
+protected:
+  vtkIGSIODecodedFrameCache();
+  virtual ~vtkIGSIODecodedFrameCache();
+
+  /*! Codec instance that decodes one stream and the last frame that it has decoded (not referenced, only compared) */
+  struct Decoder
+  {
+    std::string FourCC;
+    vtkSmartPointer<vtkStreamingVolumeCodec> Codec;
+    vtkStreamingVolumeFrame* LastDecodedFrame;
+    vtkMTimeType LastDecodedFrameMTime;
+  };
+  /*! Most recently used decoder first */
+  typedef std::list<Decoder> DecoderListType;
+
+  /*!
+    Decoded image of a frame. The frame is not referenced (it is only used as a key), the entry only matches the frame
+    if its modification time has not changed since it was decoded.
+  */
+  struct CacheEntry
+  {
+    vtkStreamingVolumeFrame* Frame;
+    vtkMTimeType FrameMTime;
+    vtkSmartPointer<vtkImageData> Image;
+    unsigned long long SizeInBytes;
+  };
+  /*! Most recently used image first */
+  typedef std::list<CacheEntry> CacheEntryListType;
+  typedef std::map<vtkStreamingVolumeFrame*, CacheEntryListType::iterator> CacheEntryMapType;
+
+  /*! Decode the frame and the frames that it depends on. Must be called with the mutex locked. */
+  vtkSmartPointer<vtkImageData> DecodeFrame(vtkStreamingVolumeFrame* encodedFrame);
+
+  /*! Find the decoder that decoded the frame last. Returns Decoders.end() if there is no such decoder. */
+  DecoderListType::iterator FindDecoder(vtkStreamingVolumeFrame* lastDecodedFrame);
+
+  /*! Create a decoder for a new stream. If the maximum number of decoders is reached then the least recently used one is reused. */
+  DecoderListType::iterator CreateDecoder(const std::string& fourCC);
+
+  /*! Find the cached image of the frame. Outdated entries of the same address are removed. Returns CacheEntries.end() if not found. */
+  CacheEntryListType::iterator FindCacheEntry(vtkStreamingVolumeFrame* encodedFrame);
+
+  void AddToCache(vtkStreamingVolumeFrame* encodedFrame, vtkImageData* image);
+  void RemoveFromCache(CacheEntryMapType::iterator entryIt);
+  void EvictImages(unsigned long long maximumCachedBytes);
+
+  DecoderListType Decoders;
+  CacheEntryListType CacheEntries;
+  CacheEntryMapType CacheEntryMap;
+
+  unsigned long long MaximumCachedBytes;
+  unsigned int MaximumNumberOfDecoders;
+  unsigned long long CachedBytes;
+  unsigned long long NumberOfHits;
+  unsigned long long NumberOfMisses;
+  unsigned long long NumberOfDecodedFrames;
+
+  vtkIGSIOSimpleRecursiveCriticalSection* Mutex;
+
+private:
+  vtkIGSIODecodedFrameCache(const vtkIGSIODecodedFrameCache&);
+  void operator=(const vtkIGSIODecodedFrameCache&);
+};
+
+#endif
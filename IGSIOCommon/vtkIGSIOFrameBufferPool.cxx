@@ -0,0 +1,352 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// IGSIO includes
+#include "vtkIGSIOFrameBufferPool.h"
+#include "vtkIGSIORecursiveCriticalSection.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+#include <vtkVersion.h>
+
+// STL includes
+#include <cstdlib>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// VTK_DATA_ARRAY_ALIGNED_FREE is available since VTK 8.1. Memory from posix_memalign can be released
+// by free() on older versions as well, but _aligned_malloc memory can't, so on Windows with older VTK
+// aligned buffers are not supported and buffers are allocated by VTK.
+#if VTK_MAJOR_VERSION > 8 || (VTK_MAJOR_VERSION == 8 && VTK_MINOR_VERSION >= 1)
+#define IGSIO_ALIGNED_ARRAY_DELETE_METHOD vtkDataArray::VTK_DATA_ARRAY_ALIGNED_FREE
+#elif !defined(_WIN32)
+#define IGSIO_ALIGNED_ARRAY_DELETE_METHOD vtkDataArray::VTK_DATA_ARRAY_FREE
+#endif
+
+namespace
+{
+  // Default limit of the pooled buffer size of new pools (a few seconds of typical ultrasound frames)
+  const unsigned long long DEFAULT_MAXIMUM_POOLED_BYTES = 64 * 1024 * 1024;
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkIGSIOFrameBufferPool> CreateDefaultInstance()
+  {
+    // Pooling is opt-in for the process-wide pool, returned buffers are released by default
+    vtkSmartPointer<vtkIGSIOFrameBufferPool> pool = vtkSmartPointer<vtkIGSIOFrameBufferPool>::New();
+    pool->SetMaximumPooledBytes(0);
+    return pool;
+  }
+
+#if defined(IGSIO_ALIGNED_ARRAY_DELETE_METHOD)
+  //----------------------------------------------------------------------------
+  // The memory must be released by free() (_aligned_free() on Windows),
+  // which is what VTK uses for arrays with IGSIO_ALIGNED_ARRAY_DELETE_METHOD
+  void* AllocateAlignedMemory(size_t sizeInBytes, size_t alignment)
+  {
+#if defined(_WIN32)
+    return _aligned_malloc(sizeInBytes, alignment);
+#else
+    void* memory = NULL;
+    if (posix_memalign(&memory, alignment, sizeInBytes) != 0)
+    {
+      return NULL;
+    }
+    return memory;
+#endif
+  }
+#endif
+}
+
+vtkStandardNewMacro(vtkIGSIOFrameBufferPool);
+
+//----------------------------------------------------------------------------
+bool vtkIGSIOFrameBufferPool::SizeClass::operator<(const SizeClass& other) const
+{
+  if (this->PixelType != other.PixelType)
+  {
+    return this->PixelType < other.PixelType;
+  }
+  if (this->NumberOfScalarComponents != other.NumberOfScalarComponents)
+  {
+    return this->NumberOfScalarComponents < other.NumberOfScalarComponents;
+  }
+  return this->NumberOfPixels < other.NumberOfPixels;
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIOFrameBufferPool::vtkIGSIOFrameBufferPool()
+  : AllocationMode(ALLOCATION_DEFAULT)
+  , HugePageThresholdBytes(HUGE_PAGE_SIZE)
+  , MaximumPooledBytes(DEFAULT_MAXIMUM_POOLED_BYTES)
+  , PooledBytes(0)
+  , NumberOfPooledBuffers(0)
+  , NumberOfHits(0)
+  , NumberOfMisses(0)
+  , NumberOfDiscardedBuffers(0)
+  , Mutex(vtkIGSIOSimpleRecursiveCriticalSection::New())
+{
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIOFrameBufferPool::~vtkIGSIOFrameBufferPool()
+{
+  this->Clear();
+  this->Mutex->Delete();
+  this->Mutex = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOFrameBufferPool::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  os << indent << "AllocationMode: " << this->AllocationMode << std::endl;
+  os << indent << "HugePageThresholdBytes: " << this->HugePageThresholdBytes << std::endl;
+  os << indent << "MaximumPooledBytes: " << this->MaximumPooledBytes << std::endl;
+  os << indent << "PooledBytes: " << this->PooledBytes << std::endl;
+  os << indent << "NumberOfPooledBuffers: " << this->NumberOfPooledBuffers << std::endl;
+  os << indent << "NumberOfHits: " << this->NumberOfHits << std::endl;
+  os << indent << "NumberOfMisses: " << this->NumberOfMisses << std::endl;
+  os << indent << "NumberOfDiscardedBuffers: " << this->NumberOfDiscardedBuffers << std::endl;
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIOFrameBufferPool* vtkIGSIOFrameBufferPool::GetDefaultInstance()
+{
+  static vtkSmartPointer<vtkIGSIOFrameBufferPool> defaultInstance = CreateDefaultInstance();
+  return defaultInstance;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkDataArray> vtkIGSIOFrameBufferPool::AcquireBuffer(igsioCommon::VTKScalarPixelType pixelType, unsigned int numberOfScalarComponents, vtkIdType numberOfPixels)
+{
+  SizeClass sizeClass;
+  sizeClass.PixelType = pixelType;
+  sizeClass.NumberOfScalarComponents = static_cast<int>(numberOfScalarComponents);
+  sizeClass.NumberOfPixels = numberOfPixels;
+
+  AllocationModeType allocationMode = ALLOCATION_DEFAULT;
+  unsigned long long hugePageThresholdBytes = 0;
+  {
+    igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+    allocationMode = this->AllocationMode;
+    hugePageThresholdBytes = this->HugePageThresholdBytes;
+    BufferMapType::iterator buffersIt = this->Buffers.find(sizeClass);
+    if (buffersIt != this->Buffers.end() && !buffersIt->second.empty())
+    {
+      vtkSmartPointer<vtkDataArray> buffer = buffersIt->second.back();
+      buffersIt->second.pop_back();
+      this->PooledBytes -= GetBufferSizeInBytes(buffer);
+      this->NumberOfPooledBuffers--;
+      this->NumberOfHits++;
+      return buffer;
+    }
+    this->NumberOfMisses++;
+  }
+
+  // Allocate outside of the lock, this may take a while for large frames
+  return this->AllocateBuffer(pixelType, numberOfScalarComponents, numberOfPixels, allocationMode, hugePageThresholdBytes);
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkDataArray> vtkIGSIOFrameBufferPool::AllocateBuffer(igsioCommon::VTKScalarPixelType pixelType, unsigned int numberOfScalarComponents, vtkIdType numberOfPixels,
+    AllocationModeType allocationMode, unsigned long long hugePageThresholdBytes)
+{
+  vtkSmartPointer<vtkDataArray> buffer = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(pixelType));
+  if (buffer == NULL)
+  {
+    LOG_ERROR("Failed to create pixel buffer of type " << pixelType);
+    return NULL;
+  }
+  buffer->SetNumberOfComponents(static_cast<int>(numberOfScalarComponents));
+
+#if defined(IGSIO_ALIGNED_ARRAY_DELETE_METHOD)
+  const vtkIdType numberOfValues = numberOfPixels * static_cast<vtkIdType>(numberOfScalarComponents);
+  if (allocationMode == ALLOCATION_DEFAULT || numberOfValues <= 0)
+#else
+  // Aligned memory can't be handed over to VTK arrays with this VTK version
+#endif
+  {
+    buffer->SetNumberOfTuples(numberOfPixels);
+    return buffer;
+  }
+
+#if defined(IGSIO_ALIGNED_ARRAY_DELETE_METHOD)
+  const size_t sizeInBytes = static_cast<size_t>(numberOfValues) * buffer->GetDataTypeSize();
+  const bool useHugePages = (allocationMode == ALLOCATION_HUGE_PAGES && sizeInBytes >= hugePageThresholdBytes);
+  size_t alignment = BUFFER_ALIGNMENT;
+  if (useHugePages)
+  {
+    alignment = HUGE_PAGE_SIZE;
+  }
+  // Round up the size to whole cache lines (or huge pages), so no other allocation shares them
+  const size_t allocatedSizeInBytes = (sizeInBytes + alignment - 1) / alignment * alignment;
+  void* memory = AllocateAlignedMemory(allocatedSizeInBytes, alignment);
+  if (memory == NULL)
+  {
+    LOG_ERROR("Failed to allocate " << allocatedSizeInBytes << " bytes aligned to " << alignment << " bytes for the pixel buffer");
+    return NULL;
+  }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (useHugePages && madvise(memory, allocatedSizeInBytes, MADV_HUGEPAGE) != 0)
+  {
+    // Transparent huge pages are not available (e.g., disabled in the kernel), regular pages are used
+    LOG_DEBUG("Failed to enable huge pages for the pixel buffer");
+  }
+#endif
+
+  // The array takes ownership of the memory
+  buffer->SetVoidArray(memory, numberOfValues, 0, IGSIO_ALIGNED_ARRAY_DELETE_METHOD);
+  return buffer;
+#endif
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOFrameBufferPool::ReleaseBuffer(vtkDataArray* buffer)
+{
+  if (buffer == NULL)
+  {
+    return;
+  }
+
+  SizeClass sizeClass;
+  sizeClass.PixelType = buffer->GetDataType();
+  sizeClass.NumberOfScalarComponents = buffer->GetNumberOfComponents();
+  sizeClass.NumberOfPixels = buffer->GetNumberOfTuples();
+  unsigned long long bufferSizeInBytes = GetBufferSizeInBytes(buffer);
+
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  if (this->PooledBytes + bufferSizeInBytes > this->MaximumPooledBytes)
+  {
+    this->NumberOfDiscardedBuffers++;
+    return;
+  }
+  this->Buffers[sizeClass].push_back(buffer);
+  this->PooledBytes += bufferSizeInBytes;
+  this->NumberOfPooledBuffers++;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOFrameBufferPool::Clear()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  this->Buffers.clear();
+  this->PooledBytes = 0;
+  this->NumberOfPooledBuffers = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOFrameBufferPool::SetMaximumPooledBytes(unsigned long long maximumPooledBytes)
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  this->MaximumPooledBytes = maximumPooledBytes;
+
+  // Drop buffers until the pool fits into the new limit
+  for (BufferMapType::iterator buffersIt = this->Buffers.begin(); buffersIt != this->Buffers.end() && this->PooledBytes > this->MaximumPooledBytes; ++buffersIt)
+  {
+    while (!buffersIt->second.empty() && this->PooledBytes > this->MaximumPooledBytes)
+    {
+      this->PooledBytes -= GetBufferSizeInBytes(buffersIt->second.back());
+      this->NumberOfPooledBuffers--;
+      buffersIt->second.pop_back();
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOFrameBufferPool::GetMaximumPooledBytes()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  return this->MaximumPooledBytes;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOFrameBufferPool::SetAllocationMode(AllocationModeType allocationMode)
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  if (this->AllocationMode == allocationMode)
+  {
+    return;
+  }
+  this->AllocationMode = allocationMode;
+  this->Clear();
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIOFrameBufferPool::AllocationModeType vtkIGSIOFrameBufferPool::GetAllocationMode()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  return this->AllocationMode;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOFrameBufferPool::SetHugePageThresholdBytes(unsigned long long hugePageThresholdBytes)
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  this->HugePageThresholdBytes = hugePageThresholdBytes;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOFrameBufferPool::GetHugePageThresholdBytes()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  return this->HugePageThresholdBytes;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOFrameBufferPool::GetPooledBytes()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  return this->PooledBytes;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkIGSIOFrameBufferPool::GetNumberOfPooledBuffers()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  return this->NumberOfPooledBuffers;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOFrameBufferPool::GetNumberOfHits()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  return this->NumberOfHits;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOFrameBufferPool::GetNumberOfMisses()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  return this->NumberOfMisses;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOFrameBufferPool::GetNumberOfDiscardedBuffers()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  return this->NumberOfDiscardedBuffers;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOFrameBufferPool::ResetStatistics()
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> poolGuard(this->Mutex);
+  this->NumberOfHits = 0;
+  this->NumberOfMisses = 0;
+  this->NumberOfDiscardedBuffers = 0;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOFrameBufferPool::GetBufferSizeInBytes(vtkDataArray* buffer)
+{
+  return static_cast<unsigned long long>(buffer->GetNumberOfTuples()) * buffer->GetNumberOfComponents() * buffer->GetDataTypeSize();
+}
@@ -0,0 +1,164 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkIGSIOFrameBufferPool_h
+#define __vtkIGSIOFrameBufferPool_h
+
+#include "vtkigsiocommon_export.h"
+
+// IGSIO includes
+#include "igsioCommon.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STL includes
+#include <map>
+#include <vector>
+
+#ifndef VTK_OVERRIDE
+#define VTK_OVERRIDE override
+#endif
+
+class vtkIGSIOSimpleRecursiveCriticalSection;
+
+/*!
+  \class vtkIGSIOFrameBufferPool
+  \brief Pool of pixel buffers (scalar arrays) of video frames
+
+  Allocating a new pixel buffer for each acquired or read frame is expensive for large frames
+  (memory allocation and page faults on first access). igsioVideoFrame::AllocateFrame takes
+  buffers from a pool and the buffers are returned to the pool when the frame is deleted or reallocated,
+  so buffers of the same size are reused.
+
+  Buffers are grouped into size classes by pixel type, number of scalar components and number of pixels.
+  Returned buffers are kept until the total size of the pooled buffers reaches MaximumPooledBytes,
+  further returned buffers are released.
+
+  By default frames use the pool returned by GetDefaultInstance(). The default pool does not keep any buffers
+  (its MaximumPooledBytes is 0), so applications that don't use pooling don't hold memory after frames are freed.
+  Pooling is enabled by setting MaximumPooledBytes of the default pool, or by assigning a dedicated pool
+  to a frame (igsioVideoFrame::SetBufferPool) or a frame list (vtkIGSIOTrackedFrameList::SetFrameBufferPool).
+  Pools created by New() keep up to 64 MB of buffers by default.
+
+  New buffers are allocated by VTK by default. In aligned allocation mode buffers are aligned to cache lines
+  (BUFFER_ALIGNMENT bytes), so SIMD kernels don't load across cache lines. In huge page allocation mode
+  buffers of at least HugePageThresholdBytes are aligned to HUGE_PAGE_SIZE and on Linux marked for transparent
+  huge pages (madvise), which reduces TLB misses when processing large (3D) frames. The aligned memory
+  is owned by the VTK array, it is not copied. On Windows aligned allocation requires VTK 8.1 or later,
+  with older VTK versions buffers are allocated by VTK in all modes.
+
+  The class is thread-safe.
+
+  \ingroup PlusLibCommon
+*/
+class VTKIGSIOCOMMON_EXPORT vtkIGSIOFrameBufferPool : public vtkObject
+{
+public:
+  static vtkIGSIOFrameBufferPool* New();
+  vtkTypeMacro(vtkIGSIOFrameBufferPool, vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  enum AllocationModeType
+  {
+    ALLOCATION_DEFAULT,         //!< Buffers are allocated by VTK
+    ALLOCATION_ALIGNED,         //!< Buffers are aligned to BUFFER_ALIGNMENT
+    ALLOCATION_HUGE_PAGES       //!< Large buffers are aligned to HUGE_PAGE_SIZE and backed by huge pages if possible
+  };
+
+  /*! Alignment of buffers in aligned allocation modes (cache line size) */
+  static const size_t BUFFER_ALIGNMENT = 64;
+  /*! Alignment of large buffers in huge page allocation mode (transparent huge page size on x86-64 and ARM64) */
+  static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /*! Get the pool that is used by video frames that have no dedicated pool. Pooling is disabled in this pool by default. */
+  static vtkIGSIOFrameBufferPool* GetDefaultInstance();
+
+  /*!
+    Get a buffer from the pool. If there is no pooled buffer in the requested size class
+    then a new buffer is allocated.
+  */
+  vtkSmartPointer<vtkDataArray> AcquireBuffer(igsioCommon::VTKScalarPixelType pixelType, unsigned int numberOfScalarComponents, vtkIdType numberOfPixels);
+
+  /*!
+    Return a buffer to the pool. The buffer must not be used by anyone else after this call.
+    If the pool is full then the buffer is not kept.
+  */
+  void ReleaseBuffer(vtkDataArray* buffer);
+
+  /*! Release all pooled buffers */
+  void Clear();
+
+  /*! Set the maximum total size of buffers kept in the pool. Setting 0 disables pooling. */
+  void SetMaximumPooledBytes(unsigned long long maximumPooledBytes);
+  unsigned long long GetMaximumPooledBytes();
+
+  /*!
+    Set how new buffers are allocated. Pooled buffers are released when the mode is changed,
+    so that all buffers returned by the pool are allocated the same way.
+  */
+  void SetAllocationMode(AllocationModeType allocationMode);
+  AllocationModeType GetAllocationMode();
+
+  /*! Minimum buffer size for using huge pages in huge page allocation mode. Default: HUGE_PAGE_SIZE. */
+  void SetHugePageThresholdBytes(unsigned long long hugePageThresholdBytes);
+  unsigned long long GetHugePageThresholdBytes();
+
+  /*! Total size of buffers currently kept in the pool */
+  unsigned long long GetPooledBytes();
+  /*! Number of buffers currently kept in the pool */
+  unsigned int GetNumberOfPooledBuffers();
+
+  /*! Number of AcquireBuffer calls that were served from the pool */
+  unsigned long long GetNumberOfHits();
+  /*! Number of AcquireBuffer calls that required allocation of a new buffer */
+  unsigned long long GetNumberOfMisses();
+  /*! Number of returned buffers that were not kept because the pool was full */
+  unsigned long long GetNumberOfDiscardedBuffers();
+  /*! Reset hit, miss and discarded buffer counters */
+  void ResetStatistics();
+
+protected:
+  vtkIGSIOFrameBufferPool();
+  virtual ~vtkIGSIOFrameBufferPool();
+
+  /*! Size class of a buffer: pixel type, number of scalar components, number of pixels */
+  struct SizeClass
+  {
+    int PixelType;
+    int NumberOfScalarComponents;
+    vtkIdType NumberOfPixels;
+    bool operator<(const SizeClass& other) const;
+  };
+  typedef std::vector<vtkSmartPointer<vtkDataArray> > BufferListType;
+  typedef std::map<SizeClass, BufferListType> BufferMapType;
+
+  static unsigned long long GetBufferSizeInBytes(vtkDataArray* buffer);
+
+  /*! Allocate a new buffer according to the allocation mode */
+  vtkSmartPointer<vtkDataArray> AllocateBuffer(igsioCommon::VTKScalarPixelType pixelType, unsigned int numberOfScalarComponents, vtkIdType numberOfPixels,
+      AllocationModeType allocationMode, unsigned long long hugePageThresholdBytes);
+
+  BufferMapType Buffers;
+  AllocationModeType AllocationMode;
+  unsigned long long HugePageThresholdBytes;
+  unsigned long long MaximumPooledBytes;
+  unsigned long long PooledBytes;
+  unsigned int NumberOfPooledBuffers;
+  unsigned long long NumberOfHits;
+  unsigned long long NumberOfMisses;
+  unsigned long long NumberOfDiscardedBuffers;
+
+  vtkIGSIOSimpleRecursiveCriticalSection* Mutex;
+
+private:
+  vtkIGSIOFrameBufferPool(const vtkIGSIOFrameBufferPool&);
+  void operator=(const vtkIGSIOFrameBufferPool&);
+};
+
+#endif
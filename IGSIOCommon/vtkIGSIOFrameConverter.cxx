@@ -37,48 +37,13 @@ void vtkIGSIOFrameConverter::PrintSelf(std::ostream& os, vtkIndent indent)
 //----------------------------------------------------------------------------
 vtkSmartPointer<vtkImageData> vtkIGSIOFrameConverter::GetImageData(igsioVideoFrame* frame)
 {
-  vtkSmartPointer<vtkImageData> uncompressedImage = NULL;
-  if (!frame->IsFrameEncoded())
-  {
-    uncompressedImage = frame->GetImage();
-  }
-  else
+  if (frame == NULL)
   {
-    vtkStreamingVolumeFrame* compressedFrame = frame->GetEncodedFrame();
-    vtkSmartPointer<vtkStreamingVolumeCodec> codec = nullptr;
-    if (compressedFrame)
-    {
-      std::string fourCC = compressedFrame->GetCodecFourCC();
-      CodecList::iterator codecIt = this->Codecs.find(fourCC);
-      if (codecIt != this->Codecs.end())
-      {
-        codec = codecIt->second;
-      }
-      else
-      {
-        vtkStreamingVolumeCodecFactory* factory = vtkStreamingVolumeCodecFactory::GetInstance();
-        codec = factory->CreateCodecByFourCC(fourCC);
-        if (codec)
-        {
-          this->Codecs[fourCC] = codec;
-        }
-      }
-    }
-
-    if (codec == nullptr)
-    {
-      return nullptr;
-    }
-
-    if (compressedFrame && codec)
-    {
-      uncompressedImage = vtkSmartPointer<vtkImageData>::New();
-      uncompressedImage->SetDimensions(compressedFrame->GetDimensions());
-      uncompressedImage->AllocateScalars(compressedFrame->GetVTKScalarType(), compressedFrame->GetNumberOfComponents());
-      codec->DecodeFrame(compressedFrame, uncompressedImage);
-    }
+    return NULL;
   }
-  return uncompressedImage;
+  // Encoded frames are decoded by the decoded frame cache of the frame, which continues decoding
+  // from the last decoded frame of the stream instead of the keyframe
+  return frame->GetImage();
 }
 
 //----------------------------------------------------------------------------
@@ -32,6 +32,10 @@ public:
   vtkTypeMacro(vtkIGSIOFrameConverter, vtkObject);
   virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
 
+  /*!
+    Get the image of the frame. Encoded frames are decoded using the decoded frame cache of the frame
+    (see igsioVideoFrame::GetImage), the returned image is shared and must not be modified.
+  */
   vtkSmartPointer<vtkImageData> GetImageData(igsioVideoFrame* frame);
   vtkSmartPointer<vtkStreamingVolumeFrame> GetEncodedFrame(igsioVideoFrame* frame, std::string codecFourCC, std::map<std::string, std::string> parameters);
 
@@ -8,6 +8,7 @@
 #include "igsioMath.h"
 #include <iostream>
 #include "igsioTrackedFrame.h"
+#include "vtkIGSIORecursiveCriticalSection.h"
 #include "vtkIGSIOTrackedFrameList.h"
 #include "vtkIGSIOTransformRepository.h"
 
@@ -22,6 +23,25 @@
 // STD includes
 #include <algorithm>
 #include <math.h>
+#include <utility>
+
+namespace
+{
+  /*! Shared data of the threads that validate the frames in AddTrackedFrameList */
+  struct BatchValidationThreadFunctionInfoStruct
+  {
+    vtkIGSIOTrackedFrameList* TrackedFrameList;
+    vtkIGSIOTrackedFrameList* InputTrackedFrameList;
+    void* Results;
+    unsigned int NumberOfFrames;
+  };
+
+  //----------------------------------------------------------------------------
+  bool TimestampLess(const std::pair<double, unsigned int>& itemA, const std::pair<double, unsigned int>& itemB)
+  {
+    return itemA.first < itemB.first;
+  }
+}
 
 //----------------------------------------------------------------------------
 // ************************* vtkIGSIOTrackedFrameList *****************************
@@ -38,13 +58,32 @@ vtkIGSIOTrackedFrameList::vtkIGSIOTrackedFrameList()
   this->MaxAllowedTranslationSpeedMmPerSec = 0.0;
   this->MaxAllowedRotationSpeedDegPerSec = 0.0;
   this->ValidationRequirements = 0;
-
+  this->TimestampIndexValid = false;
+  this->SortedTimestampIndexValid = false;
+  this->SortedTimestampIndexOffset = 0;
+  this->TimestampIndexChangeCount = 0;
+  this->SortedTimestampIndexChangeCount = 0;
+  this->SortedTimestampIndexMutex = vtkIGSIOSimpleRecursiveCriticalSection::New();
+  this->TimestampChangeCount = std::make_shared<std::atomic<unsigned long> >(0);
+  this->MaximumNumberOfFrames = 0;
+  this->MaximumFrameMemoryBytes = 0;
+  this->FrameMemoryBytes = std::make_shared<std::atomic<unsigned long long> >(0);
+  this->NumberOfEvictedFrames = 0;
+  this->RecycledTrackedFrame = NULL;
+  this->ValidatePoseAgainstAllFrames = false;
+  this->TransformPoseIndexValid = false;
+  this->EncoderPoseIndexValid = false;
+  this->NumberOfValidationThreads = 0;
 }
 
 //----------------------------------------------------------------------------
 vtkIGSIOTrackedFrameList::~vtkIGSIOTrackedFrameList()
 {
   this->Clear();
+  delete this->RecycledTrackedFrame;
+  this->RecycledTrackedFrame = NULL;
+  this->SortedTimestampIndexMutex->Delete();
+  this->SortedTimestampIndexMutex = NULL;
 }
 
 //----------------------------------------------------------------------------
@@ -56,9 +95,16 @@ igsioStatus vtkIGSIOTrackedFrameList::RemoveTrackedFrame(int frameNumber)
     return IGSIO_FAIL;
   }
 
+  this->RemoveFromTimestampIndex(this->TrackedFrameList[frameNumber]);
+  this->RemoveFromPoseIndex(this->TrackedFrameList[frameNumber]);
   delete this->TrackedFrameList[frameNumber];
   this->TrackedFrameList.erase(this->TrackedFrameList.begin() + frameNumber);
 
+  // Frame indices change, the sorted index has to be rebuilt
+  this->SortedTimestampIndex.clear();
+  this->SortedTimestampIndexValid = false;
+  this->SortedTimestampIndexOffset = 0;
+
   return IGSIO_SUCCESS;
 }
 
@@ -73,11 +119,18 @@ igsioStatus vtkIGSIOTrackedFrameList::RemoveTrackedFrameRange(unsigned int frame
 
   for (unsigned int i = frameNumberFrom; i <= frameNumberTo; ++i)
   {
+    this->RemoveFromTimestampIndex(this->TrackedFrameList[i]);
+    this->RemoveFromPoseIndex(this->TrackedFrameList[i]);
     delete this->TrackedFrameList[i];
   }
 
   this->TrackedFrameList.erase(this->TrackedFrameList.begin() + frameNumberFrom, this->TrackedFrameList.begin() + frameNumberTo + 1);
 
+  // Frame indices change, the sorted index has to be rebuilt
+  this->SortedTimestampIndex.clear();
+  this->SortedTimestampIndexValid = false;
+  this->SortedTimestampIndexOffset = 0;
+
   return IGSIO_SUCCESS;
 }
 
@@ -94,6 +147,299 @@ void vtkIGSIOTrackedFrameList::Clear()
   }
   this->TrackedFrameList.clear();
   this->CustomFields.clear();
+  this->TimestampIndex.clear();
+  this->SortedTimestampIndex.clear();
+  this->SortedTimestampIndexOffset = 0;
+  this->TransformPoseIndex.Clear();
+  this->EncoderPoseIndex.Clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::InvalidateTimestampIndex()
+{
+  this->TimestampIndex.clear();
+  this->TimestampIndexValid = false;
+  this->SortedTimestampIndex.clear();
+  this->SortedTimestampIndexValid = false;
+  this->SortedTimestampIndexOffset = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::AddToTimestampIndex(igsioTrackedFrame* trackedFrame)
+{
+  if (trackedFrame == NULL)
+  {
+    return;
+  }
+  this->InvalidateOutdatedTimestampIndex();
+  if (this->SortedTimestampIndexValid)
+  {
+    // Frames are usually added in increasing timestamp order, then the sorted index can be simply extended
+    if (this->SortedTimestampIndex.empty() || this->SortedTimestampIndex.back().first <= trackedFrame->GetTimestamp())
+    {
+      this->SortedTimestampIndex.push_back(std::make_pair(trackedFrame->GetTimestamp(),
+                                           static_cast<unsigned int>(this->TrackedFrameList.size() - 1) + this->SortedTimestampIndexOffset));
+    }
+    else
+    {
+      this->SortedTimestampIndex.clear();
+      this->SortedTimestampIndexValid = false;
+    }
+  }
+  if (this->TimestampIndexValid)
+  {
+    this->TimestampIndex[trackedFrame->GetTimestamp()]++;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::RemoveFromTimestampIndex(igsioTrackedFrame* trackedFrame)
+{
+  this->InvalidateOutdatedTimestampIndex();
+  if (!this->TimestampIndexValid || trackedFrame == NULL)
+  {
+    return;
+  }
+  TimestampIndexType::iterator timestampIt = this->TimestampIndex.find(trackedFrame->GetTimestamp());
+  if (timestampIt == this->TimestampIndex.end())
+  {
+    // The frame timestamp was modified after the frame was added, the index cannot be trusted anymore
+    this->InvalidateTimestampIndex();
+    return;
+  }
+  if (--timestampIt->second == 0)
+  {
+    this->TimestampIndex.erase(timestampIt);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::InvalidateOutdatedTimestampIndex()
+{
+  if (this->TimestampIndexValid && this->TimestampIndexChangeCount != *this->TimestampChangeCount)
+  {
+    this->TimestampIndex.clear();
+    this->TimestampIndexValid = false;
+  }
+  if (this->SortedTimestampIndexValid && this->SortedTimestampIndexChangeCount != *this->TimestampChangeCount)
+  {
+    this->SortedTimestampIndex.clear();
+    this->SortedTimestampIndexValid = false;
+    this->SortedTimestampIndexOffset = 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkIGSIOTrackedFrameList::GetValidationTransform(igsioTrackedFrame* trackedFrame, double matrix[16])
+{
+  return trackedFrame->IsFrameTransformNameDefined(this->FrameTransformNameForValidation)
+         && trackedFrame->GetFrameTransform(this->FrameTransformNameForValidation, matrix) == IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+bool vtkIGSIOTrackedFrameList::GetEncoderValues(igsioTrackedFrame* trackedFrame, double& probePosition, double& probeRotation, double& templatePosition)
+{
+  if (!trackedFrame->IsFrameFieldDefined("ProbePosition") || !trackedFrame->IsFrameFieldDefined("ProbeRotation") || !trackedFrame->IsFrameFieldDefined("TemplatePosition"))
+  {
+    return false;
+  }
+  return igsioTrackedFrameEncoderPositionFinder::GetStepperEncoderValues(trackedFrame, probePosition, probeRotation, templatePosition) == IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::UpdatePoseIndex(igsioPoseIndex::PoseType poseType)
+{
+  igsioPoseIndex& poseIndex = (poseType == igsioPoseIndex::TRANSFORM_POSE ? this->TransformPoseIndex : this->EncoderPoseIndex);
+  bool& poseIndexValid = (poseType == igsioPoseIndex::TRANSFORM_POSE ? this->TransformPoseIndexValid : this->EncoderPoseIndexValid);
+  if (poseIndexValid
+      && poseIndex.GetTranslationToleranceMm() == this->MinRequiredTranslationDifferenceMm
+      && poseIndex.GetAngleToleranceDeg() == this->MinRequiredAngleDifferenceDeg
+      && (poseType != igsioPoseIndex::TRANSFORM_POSE || this->TransformPoseIndexTransformName == this->FrameTransformNameForValidation))
+  {
+    return;
+  }
+
+  poseIndex.Initialize(poseType, this->MinRequiredTranslationDifferenceMm, this->MinRequiredAngleDifferenceDeg);
+  if (poseType == igsioPoseIndex::TRANSFORM_POSE)
+  {
+    this->TransformPoseIndexTransformName = this->FrameTransformNameForValidation;
+  }
+  poseIndexValid = true;
+  for (TrackedFrameListType::iterator frameIt = this->TrackedFrameList.begin(); frameIt != this->TrackedFrameList.end(); ++frameIt)
+  {
+    if (poseType == igsioPoseIndex::TRANSFORM_POSE)
+    {
+      double matrix[16] = { 0 };
+      if (this->GetValidationTransform(*frameIt, matrix))
+      {
+        poseIndex.AddTransformPose(*frameIt, matrix);
+      }
+    }
+    else
+    {
+      double probePosition(0), probeRotation(0), templatePosition(0);
+      if (this->GetEncoderValues(*frameIt, probePosition, probeRotation, templatePosition))
+      {
+        poseIndex.AddEncoderPose(*frameIt, probePosition, probeRotation, templatePosition);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::AddToPoseIndex(igsioTrackedFrame* trackedFrame)
+{
+  if (this->TransformPoseIndexValid)
+  {
+    double matrix[16] = { 0 };
+    if (this->GetValidationTransform(trackedFrame, matrix))
+    {
+      this->TransformPoseIndex.AddTransformPose(trackedFrame, matrix);
+    }
+  }
+  if (this->EncoderPoseIndexValid)
+  {
+    double probePosition(0), probeRotation(0), templatePosition(0);
+    if (this->GetEncoderValues(trackedFrame, probePosition, probeRotation, templatePosition))
+    {
+      this->EncoderPoseIndex.AddEncoderPose(trackedFrame, probePosition, probeRotation, templatePosition);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::RemoveFromPoseIndex(igsioTrackedFrame* trackedFrame)
+{
+  if (this->TransformPoseIndexValid)
+  {
+    this->TransformPoseIndex.RemovePose(trackedFrame);
+  }
+  if (this->EncoderPoseIndexValid)
+  {
+    this->EncoderPoseIndex.RemovePose(trackedFrame);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::PushBackTrackedFrame(igsioTrackedFrame* trackedFrame)
+{
+  if (this->FrameBufferPool != NULL)
+  {
+    trackedFrame->GetImageData()->SetBufferPool(this->FrameBufferPool);
+  }
+  this->TrackedFrameList.push_back(trackedFrame);
+  trackedFrame->TimestampChangeCounter = this->TimestampChangeCount;
+  trackedFrame->GetImageData()->SetFrameMemoryCounter(this->FrameMemoryBytes);
+  this->AddToTimestampIndex(trackedFrame);
+  this->AddToPoseIndex(trackedFrame);
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::EvictOldestFrames(unsigned int numberOfNewFrames, unsigned long long newFrameBytes)
+{
+  // At least the most recent frame is kept if no new frame is added
+  while (this->TrackedFrameList.size() > (numberOfNewFrames > 0 ? 0 : 1))
+  {
+    bool frameCountExceeded = (this->MaximumNumberOfFrames > 0 && this->TrackedFrameList.size() + numberOfNewFrames > this->MaximumNumberOfFrames);
+    bool memoryExceeded = (this->MaximumFrameMemoryBytes > 0 && *this->FrameMemoryBytes + newFrameBytes > this->MaximumFrameMemoryBytes);
+    if (!frameCountExceeded && !memoryExceeded)
+    {
+      break;
+    }
+
+    igsioTrackedFrame* oldestFrame = this->TrackedFrameList.front();
+    this->TrackedFrameList.pop_front();
+    this->RemoveFromTimestampIndex(oldestFrame);
+    this->RemoveFromPoseIndex(oldestFrame);
+    oldestFrame->TimestampChangeCounter.reset();
+    oldestFrame->GetImageData()->SetFrameMemoryCounter(NULL);
+
+    // The oldest frame has the smallest timestamp if frames are added in order,
+    // then the sorted index remains valid by just removing its first item
+    this->InvalidateOutdatedTimestampIndex();
+    if (this->SortedTimestampIndexValid)
+    {
+      if (!this->SortedTimestampIndex.empty() && this->SortedTimestampIndex.front().second == this->SortedTimestampIndexOffset)
+      {
+        this->SortedTimestampIndex.pop_front();
+        this->SortedTimestampIndexOffset++;
+      }
+      else
+      {
+        this->SortedTimestampIndex.clear();
+        this->SortedTimestampIndexValid = false;
+      }
+    }
+
+    this->NumberOfEvictedFrames++;
+
+    // Keep the frame object (and so its pixel buffer) for the next frame
+    delete this->RecycledTrackedFrame;
+    this->RecycledTrackedFrame = oldestFrame;
+  }
+}
+
+//----------------------------------------------------------------------------
+igsioTrackedFrame* vtkIGSIOTrackedFrameList::CreateTrackedFrameForList(igsioTrackedFrame* sourceFrame)
+{
+  if (this->RecycledTrackedFrame == NULL)
+  {
+    return new igsioTrackedFrame();
+  }
+  igsioTrackedFrame* trackedFrame = this->RecycledTrackedFrame;
+  this->RecycledTrackedFrame = NULL;
+
+  // Frame assignment keeps the pixel data of the target if the source has no decoded pixel data,
+  // so the recycled frame is only used if its pixel data is overwritten with a copy of the same size and type
+  igsioVideoFrame* sourceImage = sourceFrame->GetImageData();
+  igsioVideoFrame* recycledImage = trackedFrame->GetImageData();
+  FrameSizeType sourceFrameSize = { 0, 0, 0 };
+  FrameSizeType recycledFrameSize = { 0, 0, 0 };
+  unsigned int sourceNumberOfComponents(0);
+  unsigned int recycledNumberOfComponents(0);
+  if (sourceImage->IsFrameEncoded() || recycledImage->IsFrameEncoded()
+      || sourceImage->GetFrameSizeInBytes() == 0
+      || sourceImage->GetFrameSize(sourceFrameSize) != IGSIO_SUCCESS || recycledImage->GetFrameSize(recycledFrameSize) != IGSIO_SUCCESS
+      || sourceFrameSize != recycledFrameSize
+      || sourceImage->GetVTKScalarPixelType() != recycledImage->GetVTKScalarPixelType()
+      || sourceImage->GetNumberOfScalarComponents(sourceNumberOfComponents) != IGSIO_SUCCESS
+      || recycledImage->GetNumberOfScalarComponents(recycledNumberOfComponents) != IGSIO_SUCCESS
+      || sourceNumberOfComponents != recycledNumberOfComponents)
+  {
+    delete trackedFrame;
+    return new igsioTrackedFrame();
+  }
+  return trackedFrame;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOTrackedFrameList::GetFrameMemoryBytes() const
+{
+  return *this->FrameMemoryBytes;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::SetMaximumNumberOfFrames(unsigned int maximumNumberOfFrames)
+{
+  if (this->MaximumNumberOfFrames == maximumNumberOfFrames)
+  {
+    return;
+  }
+  this->MaximumNumberOfFrames = maximumNumberOfFrames;
+  this->EvictOldestFrames(0, 0);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::SetMaximumFrameMemoryBytes(unsigned long long maximumFrameMemoryBytes)
+{
+  if (this->MaximumFrameMemoryBytes == maximumFrameMemoryBytes)
+  {
+    return;
+  }
+  this->MaximumFrameMemoryBytes = maximumFrameMemoryBytes;
+  this->EvictOldestFrames(0, 0);
+  this->Modified();
 }
 
 //----------------------------------------------------------------------------
@@ -144,28 +490,144 @@ unsigned int vtkIGSIOTrackedFrameList::Size()
 }
 
 //----------------------------------------------------------------------------
-vtkIGSIOTrackedFrameList::TrackedFrameListType vtkIGSIOTrackedFrameList::GetTrackedFrameList()
+const vtkIGSIOTrackedFrameList::TrackedFrameListType& vtkIGSIOTrackedFrameList::GetTrackedFrameList() const
 {
   return this->TrackedFrameList;
 }
 
+//----------------------------------------------------------------------------
+vtkIGSIOTrackedFrameList::FrameView vtkIGSIOTrackedFrameList::GetFrameView() const
+{
+  return FrameView(&this->TrackedFrameList, 0, static_cast<unsigned int>(this->TrackedFrameList.size()), 1);
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIOTrackedFrameList::FrameView vtkIGSIOTrackedFrameList::GetFrameView(unsigned int firstFrameIndex, unsigned int numberOfFrames, unsigned int stride /*=1*/) const
+{
+  return this->GetFrameView().GetSubRange(firstFrameIndex, numberOfFrames).GetSubsampled(stride);
+}
+
 //----------------------------------------------------------------------------
 igsioStatus vtkIGSIOTrackedFrameList::AddTrackedFrameList(vtkIGSIOTrackedFrameList* inTrackedFrameList, InvalidFrameAction action /*=ADD_INVALID_FRAME_AND_REPORT_ERROR*/)
 {
+  if (inTrackedFrameList == NULL)
+  {
+    LOG_ERROR("Failed to add tracked frame list - input list is NULL");
+    return IGSIO_FAIL;
+  }
+
   igsioStatus status = IGSIO_SUCCESS;
-  for (unsigned int i = 0; i < inTrackedFrameList->GetNumberOfTrackedFrames(); ++i)
+  const unsigned int numberOfFrames = inTrackedFrameList->GetNumberOfTrackedFrames();
+  if (action == ADD_INVALID_FRAME || this->ValidationRequirements == 0 || inTrackedFrameList == this)
+  {
+    for (unsigned int i = 0; i < numberOfFrames; ++i)
+    {
+      if (this->AddTrackedFrame(inTrackedFrameList->GetTrackedFrame(i), action) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("Failed to add tracked frame to the list!");
+        status = IGSIO_FAIL;
+        continue;
+      }
+    }
+    return status;
+  }
+
+  // Perform the checks that only depend on the input frames in parallel
+  std::vector<PrecomputedValidationResult> precomputedResults(numberOfFrames);
+  if ((this->ValidationRequirements & (REQUIRE_TRACKING_OK | REQUIRE_SPEED_BELOW_THRESHOLD)) && numberOfFrames > 0)
+  {
+    BatchValidationThreadFunctionInfoStruct str;
+    str.TrackedFrameList = this;
+    str.InputTrackedFrameList = inTrackedFrameList;
+    str.Results = &precomputedResults[0];
+    str.NumberOfFrames = numberOfFrames;
+
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    int numberOfThreads = this->NumberOfValidationThreads;
+    if (numberOfThreads <= 0)
+    {
+      numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+    numberOfThreads = std::min(numberOfThreads, static_cast<int>(numberOfFrames));
+    threader->SetNumberOfThreads(std::max(numberOfThreads, 1));
+    threader->SetSingleMethod(BatchValidationThreadFunction, &str);
+    threader->SingleMethodExecute();
+  }
+
+  // Perform the checks that depend on the frames already in the list and add the frames in order
+  bool previousFrameAdded = false;
+  for (unsigned int i = 0; i < numberOfFrames; ++i)
   {
-    if (this->AddTrackedFrame(inTrackedFrameList->GetTrackedFrame(i), action) != IGSIO_SUCCESS)
+    igsioTrackedFrame* trackedFrame = inTrackedFrameList->GetTrackedFrame(i);
+    PrecomputedValidationResult& precomputedResult = precomputedResults[i];
+    precomputedResult.SpeedValidAvailable = precomputedResult.SpeedValidAvailable && previousFrameAdded;
+    previousFrameAdded = false;
+
+    long failedRequirement = this->GetFailedValidationRequirement(trackedFrame, &precomputedResult);
+    if (failedRequirement != 0)
+    {
+      this->NumberOfFailedValidations[failedRequirement]++;
+      if (action == SKIP_INVALID_FRAME_AND_REPORT_ERROR)
+      {
+        LOG_ERROR("Validation failed on frame, the frame is ignored");
+        LOG_ERROR("Failed to add tracked frame to the list!");
+        status = IGSIO_FAIL;
+        continue;
+      }
+      if (action == SKIP_INVALID_FRAME)
+      {
+        LOG_DEBUG("Validation failed on frame, the frame is ignored");
+        continue;
+      }
+      LOG_ERROR("Validation failed on frame, the frame is added to the list anyway");
+    }
+
+    // Validation is already done
+    if (this->AddTrackedFrame(trackedFrame, ADD_INVALID_FRAME) != IGSIO_SUCCESS)
     {
       LOG_ERROR("Failed to add tracked frame to the list!");
       status = IGSIO_FAIL;
       continue;
     }
+    previousFrameAdded = true;
   }
 
   return status;
 }
 
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkIGSIOTrackedFrameList::BatchValidationThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  BatchValidationThreadFunctionInfoStruct* str = static_cast<BatchValidationThreadFunctionInfoStruct*>(threadInfo->UserData);
+  PrecomputedValidationResult* results = static_cast<PrecomputedValidationResult*>(str->Results);
+  vtkIGSIOTrackedFrameList* self = str->TrackedFrameList;
+
+  unsigned int firstFrameIndex(0);
+  unsigned int lastFrameIndex(0);
+  igsioCommon::GetThreadItemRange(threadInfo->ThreadID, threadInfo->NumberOfThreads, str->NumberOfFrames, firstFrameIndex, lastFrameIndex);
+
+  for (unsigned int frameIndex = firstFrameIndex; frameIndex < lastFrameIndex; ++frameIndex)
+  {
+    igsioTrackedFrame* trackedFrame = str->InputTrackedFrameList->GetTrackedFrame(frameIndex);
+    PrecomputedValidationResult& result = results[frameIndex];
+    result.StatusValid = true;
+    result.SpeedValid = true;
+    result.SpeedValidAvailable = false;
+    if (self->ValidationRequirements & REQUIRE_TRACKING_OK)
+    {
+      result.StatusValid = self->ValidateStatus(trackedFrame);
+    }
+    if ((self->ValidationRequirements & REQUIRE_SPEED_BELOW_THRESHOLD) && frameIndex > 0)
+    {
+      result.SpeedValid = self->ValidateSpeed(trackedFrame, str->InputTrackedFrameList->GetTrackedFrame(frameIndex - 1));
+      result.SpeedValidAvailable = true;
+    }
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
 igsioStatus vtkIGSIOTrackedFrameList::AddTrackedFrame(igsioTrackedFrame* trackedFrame, InvalidFrameAction action /*=ADD_INVALID_FRAME_AND_REPORT_ERROR*/)
 {
@@ -194,9 +656,52 @@ igsioStatus vtkIGSIOTrackedFrameList::AddTrackedFrame(igsioTrackedFrame* tracked
     }
   }
 
+  this->EvictOldestFrames(1, trackedFrame->GetImageData()->GetFrameSizeInBytes());
+
   // Make a copy and add frame to the list
-  igsioTrackedFrame* pTrackedFrame = new igsioTrackedFrame(*trackedFrame);
-  this->TrackedFrameList.push_back(pTrackedFrame);
+  igsioTrackedFrame* pTrackedFrame = this->CreateTrackedFrameForList(trackedFrame);
+  if (this->FrameBufferPool != NULL)
+  {
+    pTrackedFrame->GetImageData()->SetBufferPool(this->FrameBufferPool);
+  }
+  *pTrackedFrame = *trackedFrame;
+  this->PushBackTrackedFrame(pTrackedFrame);
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTrackedFrameList::AddTrackedFrame(igsioTrackedFrame&& trackedFrame, InvalidFrameAction action /*=ADD_INVALID_FRAME_AND_REPORT_ERROR*/)
+{
+  bool isFrameValid = true;
+  if (action != ADD_INVALID_FRAME)
+  {
+    isFrameValid = this->ValidateData(&trackedFrame);
+  }
+
+  if (!isFrameValid)
+  {
+    switch (action)
+    {
+      case ADD_INVALID_FRAME_AND_REPORT_ERROR:
+        LOG_ERROR("Validation failed on frame, the frame is added to the list anyway");
+        break;
+      case ADD_INVALID_FRAME:
+        LOG_DEBUG("Validation failed on frame, the frame is added to the list anyway");
+        break;
+      case SKIP_INVALID_FRAME_AND_REPORT_ERROR:
+        LOG_ERROR("Validation failed on frame, the frame is ignored");
+        return IGSIO_FAIL;
+      case SKIP_INVALID_FRAME:
+        LOG_DEBUG("Validation failed on frame, the frame is ignored");
+        return IGSIO_SUCCESS;
+    }
+  }
+
+  this->EvictOldestFrames(1, trackedFrame.GetImageData()->GetFrameSizeInBytes());
+
+  // Move the frame content into a new list item, pixel data is not copied
+  igsioTrackedFrame* pTrackedFrame = new igsioTrackedFrame(std::move(trackedFrame));
+  this->PushBackTrackedFrame(pTrackedFrame);
   return IGSIO_SUCCESS;
 }
 
@@ -229,19 +734,33 @@ igsioStatus vtkIGSIOTrackedFrameList::TakeTrackedFrame(igsioTrackedFrame* tracke
     }
   }
 
-  // Make a copy and add frame to the list
-  this->TrackedFrameList.push_back(trackedFrame);
+  this->EvictOldestFrames(1, trackedFrame->GetImageData()->GetFrameSizeInBytes());
+
+  // Add frame to the list
+  this->PushBackTrackedFrame(trackedFrame);
   return IGSIO_SUCCESS;
 }
 
 
 //----------------------------------------------------------------------------
 bool vtkIGSIOTrackedFrameList::ValidateData(igsioTrackedFrame* trackedFrame)
+{
+  long failedRequirement = this->GetFailedValidationRequirement(trackedFrame, NULL);
+  if (failedRequirement != 0)
+  {
+    this->NumberOfFailedValidations[failedRequirement]++;
+    return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+long vtkIGSIOTrackedFrameList::GetFailedValidationRequirement(igsioTrackedFrame* trackedFrame, const PrecomputedValidationResult* precomputedResult)
 {
   if (this->ValidationRequirements == 0)
   {
     // If we don't want to validate return immediately
-    return true;
+    return 0;
   }
 
   if (this->ValidationRequirements & REQUIRE_UNIQUE_TIMESTAMP)
@@ -249,16 +768,17 @@ bool vtkIGSIOTrackedFrameList::ValidateData(igsioTrackedFrame* trackedFrame)
     if (! this->ValidateTimestamp(trackedFrame))
     {
       LOG_DEBUG("Validation failed - timestamp is not unique: " << trackedFrame->GetTimestamp());
-      return false;
+      return REQUIRE_UNIQUE_TIMESTAMP;
     }
   }
 
   if (this->ValidationRequirements & REQUIRE_TRACKING_OK)
   {
-    if (! this->ValidateStatus(trackedFrame))
+    bool isStatusValid = (precomputedResult != NULL ? precomputedResult->StatusValid : this->ValidateStatus(trackedFrame));
+    if (! isStatusValid)
     {
       LOG_DEBUG("Validation failed - tracking status in not OK");
-      return false;
+      return REQUIRE_TRACKING_OK;
     }
   }
 
@@ -267,7 +787,7 @@ bool vtkIGSIOTrackedFrameList::ValidateData(igsioTrackedFrame* trackedFrame)
     if (! this->ValidateTransform(trackedFrame))
     {
       LOG_DEBUG("Validation failed - transform is not changed");
-      return false;
+      return REQUIRE_CHANGED_TRANSFORM;
     }
   }
 
@@ -276,21 +796,35 @@ bool vtkIGSIOTrackedFrameList::ValidateData(igsioTrackedFrame* trackedFrame)
     if (! this->ValidateEncoderPosition(trackedFrame))
     {
       LOG_DEBUG("Validation failed - encoder position is not changed");
-      return false;
+      return REQUIRE_CHANGED_ENCODER_POSITION;
     }
   }
 
 
   if (this->ValidationRequirements & REQUIRE_SPEED_BELOW_THRESHOLD)
   {
-    if (! this->ValidateSpeed(trackedFrame))
+    bool isSpeedValid = (precomputedResult != NULL && precomputedResult->SpeedValidAvailable ? precomputedResult->SpeedValid : this->ValidateSpeed(trackedFrame));
+    if (! isSpeedValid)
     {
       LOG_DEBUG("Validation failed - speed is higher than threshold");
-      return false;
+      return REQUIRE_SPEED_BELOW_THRESHOLD;
     }
   }
 
-  return true;
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkIGSIOTrackedFrameList::GetNumberOfFailedValidations(long requirement) const
+{
+  std::map<long, unsigned int>::const_iterator countIt = this->NumberOfFailedValidations.find(requirement);
+  return (countIt == this->NumberOfFailedValidations.end() ? 0 : countIt->second);
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::ResetValidationStatistics()
+{
+  this->NumberOfFailedValidations.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -301,7 +835,19 @@ bool vtkIGSIOTrackedFrameList::ValidateTimestamp(igsioTrackedFrame* trackedFrame
     // the existing list is empty, so any frame has unique timestamp and therefore valid
     return true;
   }
-  const bool isTimestampUnique = std::find_if(this->TrackedFrameList.begin(), this->TrackedFrameList.end(), TrackedFrameTimestampFinder(trackedFrame)) == this->TrackedFrameList.end();
+  this->InvalidateOutdatedTimestampIndex();
+  if (!this->TimestampIndexValid)
+  {
+    // Build the index on first use, from then on it is updated when frames are added or removed
+    this->TimestampIndex.clear();
+    for (TrackedFrameListType::iterator frameIt = this->TrackedFrameList.begin(); frameIt != this->TrackedFrameList.end(); ++frameIt)
+    {
+      this->TimestampIndex[(*frameIt)->GetTimestamp()]++;
+    }
+    this->TimestampIndexValid = true;
+    this->TimestampIndexChangeCount = *this->TimestampChangeCount;
+  }
+  const bool isTimestampUnique = (this->TimestampIndex.find(trackedFrame->GetTimestamp()) == this->TimestampIndex.end());
   // validation passed if the timestamp is unique
   return isTimestampUnique;
 }
@@ -309,6 +855,23 @@ bool vtkIGSIOTrackedFrameList::ValidateTimestamp(igsioTrackedFrame* trackedFrame
 //----------------------------------------------------------------------------
 bool vtkIGSIOTrackedFrameList::ValidateEncoderPosition(igsioTrackedFrame* trackedFrame)
 {
+  if (this->ValidatePoseAgainstAllFrames)
+  {
+    this->UpdatePoseIndex(igsioPoseIndex::ENCODER_POSE);
+    double probePosition(0), probeRotation(0), templatePosition(0);
+    if (igsioTrackedFrameEncoderPositionFinder::GetStepperEncoderValues(trackedFrame, probePosition, probeRotation, templatePosition) != IGSIO_SUCCESS)
+    {
+      LOG_WARNING("Unable to get raw encoder values from tracked frame!");
+      return true;
+    }
+    if (this->EncoderPoseIndex.ContainsSimilarEncoderPose(probePosition, probeRotation, templatePosition))
+    {
+      LOG_DEBUG("Tracked frame encoder position validation result: we've already inserted this frame to container!");
+      return false;
+    }
+    return true;
+  }
+
   TrackedFrameListType::iterator searchIndex;
   const size_t containerSize = this->TrackedFrameList.size();
   if (containerSize < this->NumberOfUniqueFrames)
@@ -333,6 +896,23 @@ bool vtkIGSIOTrackedFrameList::ValidateEncoderPosition(igsioTrackedFrame* tracke
 //----------------------------------------------------------------------------
 bool vtkIGSIOTrackedFrameList::ValidateTransform(igsioTrackedFrame* trackedFrame)
 {
+  if (this->ValidatePoseAgainstAllFrames)
+  {
+    this->UpdatePoseIndex(igsioPoseIndex::TRANSFORM_POSE);
+    double matrix[16] = { 0 };
+    if (!this->GetValidationTransform(trackedFrame, matrix))
+    {
+      LOG_ERROR("Unable to find frame transform name for new tracked frame validation!");
+      return true;
+    }
+    if (this->TransformPoseIndex.ContainsSimilarTransformPose(matrix))
+    {
+      LOG_DEBUG("Tracked frame transform validation result: we've already inserted this frame to container!");
+      return false;
+    }
+    return true;
+  }
+
   TrackedFrameListType::iterator searchIndex;
   const size_t containerSize = this->TrackedFrameList.size();
   if (containerSize < this->NumberOfUniqueFrames)
@@ -378,10 +958,14 @@ bool vtkIGSIOTrackedFrameList::ValidateSpeed(igsioTrackedFrame* trackedFrame)
     return true;
   }
 
-  TrackedFrameListType::iterator latestFrameInList = this->TrackedFrameList.end() - 1;
+  return this->ValidateSpeed(trackedFrame, this->TrackedFrameList.back());
+}
 
+//----------------------------------------------------------------------------
+bool vtkIGSIOTrackedFrameList::ValidateSpeed(igsioTrackedFrame* trackedFrame, igsioTrackedFrame* previousTrackedFrame)
+{
   // Compute difference between the last two timestamps
-  double diffTimeSec = fabs(trackedFrame->GetTimestamp() - (*latestFrameInList)->GetTimestamp());
+  double diffTimeSec = fabs(trackedFrame->GetTimestamp() - previousTrackedFrame->GetTimestamp());
   if (diffTimeSec < 0.0001)
   {
     // the frames are almost acquired at the same time, cannot compute speed reliably
@@ -405,7 +989,7 @@ bool vtkIGSIOTrackedFrameList::ValidateSpeed(igsioTrackedFrame* trackedFrame)
 
   vtkSmartPointer<vtkMatrix4x4> latestTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
   double latestTransformVector[16] = {0};
-  if ((*latestFrameInList)->GetFrameTransform(this->FrameTransformNameForValidation, latestTransformVector))
+  if (previousTrackedFrame->GetFrameTransform(this->FrameTransformNameForValidation, latestTransformVector))
   {
     latestTransformMatrix->DeepCopy(latestTransformVector);
   }
@@ -448,6 +1032,18 @@ igsioTransformName vtkIGSIOTrackedFrameList::GetFrameTransformNameForValidation(
   return this->FrameTransformNameForValidation;
 }
 
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::SetFrameBufferPool(vtkIGSIOFrameBufferPool* bufferPool)
+{
+  this->FrameBufferPool = bufferPool;
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIOFrameBufferPool* vtkIGSIOTrackedFrameList::GetFrameBufferPool()
+{
+  return this->FrameBufferPool;
+}
+
 //----------------------------------------------------------------------------
 int vtkIGSIOTrackedFrameList::GetNumberOfBitsPerScalar()
 {
@@ -736,6 +1332,174 @@ igsioStatus vtkIGSIOTrackedFrameList::GetTransform(const igsioTransformName& nam
   return IGSIO_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameList::UpdateSortedTimestampIndex() const
+{
+  if (this->SortedTimestampIndexValid && this->SortedTimestampIndexChangeCount == *this->TimestampChangeCount)
+  {
+    return;
+  }
+  this->SortedTimestampIndex.clear();
+  this->SortedTimestampIndexOffset = 0;
+  for (unsigned int frameIndex = 0; frameIndex < this->TrackedFrameList.size(); ++frameIndex)
+  {
+    this->SortedTimestampIndex.push_back(std::make_pair(this->TrackedFrameList[frameIndex]->GetTimestamp(), frameIndex));
+  }
+  // Stable sort keeps the list order of frames with the same timestamp
+  std::stable_sort(this->SortedTimestampIndex.begin(), this->SortedTimestampIndex.end(), TimestampLess);
+  this->SortedTimestampIndexValid = true;
+  this->SortedTimestampIndexChangeCount = *this->TimestampChangeCount;
+}
+
+//----------------------------------------------------------------------------
+bool vtkIGSIOTrackedFrameList::IsSortedTimestampIndexItemUpToDate(const std::pair<double, unsigned int>& item) const
+{
+  if (item.second < this->SortedTimestampIndexOffset || item.second - this->SortedTimestampIndexOffset >= this->TrackedFrameList.size())
+  {
+    return false;
+  }
+  return this->TrackedFrameList[item.second - this->SortedTimestampIndexOffset]->GetTimestamp() == item.first;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTrackedFrameList::FindFrameIndicesAroundTimestamp(double timestamp, unsigned int& frameIndexBefore, unsigned int& frameIndexAfter) const
+{
+  igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> indexGuard(this->SortedTimestampIndexMutex);
+  for (int attempt = 0; ; ++attempt)
+  {
+    this->UpdateSortedTimestampIndex();
+    if (this->SortedTimestampIndex.empty())
+    {
+      return IGSIO_FAIL;
+    }
+
+    // First item that is not earlier than the requested time
+    SortedTimestampIndexType::const_iterator afterIt = std::lower_bound(this->SortedTimestampIndex.begin(), this->SortedTimestampIndex.end(),
+        std::make_pair(timestamp, 0u), TimestampLess);
+    SortedTimestampIndexType::const_iterator beforeIt = afterIt;
+    if (afterIt != this->SortedTimestampIndex.end() && afterIt->first != timestamp && afterIt != this->SortedTimestampIndex.begin())
+    {
+      beforeIt = afterIt - 1;
+    }
+
+    // The found items must refer to frames that still have the indexed timestamps, otherwise the index is rebuilt
+    bool indexUpToDate = this->IsSortedTimestampIndexItemUpToDate(this->SortedTimestampIndex.front())
+                         && this->IsSortedTimestampIndexItemUpToDate(this->SortedTimestampIndex.back())
+                         && (afterIt == this->SortedTimestampIndex.end()
+                             || (this->IsSortedTimestampIndexItemUpToDate(*afterIt) && this->IsSortedTimestampIndexItemUpToDate(*beforeIt)));
+    if (!indexUpToDate && attempt == 0)
+    {
+      this->SortedTimestampIndex.clear();
+      this->SortedTimestampIndexValid = false;
+      continue;
+    }
+
+    if (timestamp < this->SortedTimestampIndex.front().first || timestamp > this->SortedTimestampIndex.back().first)
+    {
+      return IGSIO_FAIL;
+    }
+    frameIndexAfter = afterIt->second - this->SortedTimestampIndexOffset;
+    frameIndexBefore = beforeIt->second - this->SortedTimestampIndexOffset;
+    return IGSIO_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTrackedFrameList::FindFrameIndexByTimestamp(double timestamp, unsigned int& frameIndex) const
+{
+  if (this->TrackedFrameList.empty())
+  {
+    LOG_ERROR("Unable to find frame by timestamp - the tracked frame list is empty");
+    return IGSIO_FAIL;
+  }
+
+  unsigned int frameIndexBefore(0);
+  unsigned int frameIndexAfter(0);
+  {
+    igsioLockGuard<vtkIGSIOSimpleRecursiveCriticalSection> indexGuard(this->SortedTimestampIndexMutex);
+    if (this->FindFrameIndicesAroundTimestamp(timestamp, frameIndexBefore, frameIndexAfter) != IGSIO_SUCCESS)
+    {
+      // Out of the time range of the list, the first or last frame is the closest
+      // (FindFrameIndicesAroundTimestamp has just made sure that the index is up-to-date)
+      const std::pair<double, unsigned int>& closestItem = (timestamp < this->SortedTimestampIndex.front().first
+          ? this->SortedTimestampIndex.front() : this->SortedTimestampIndex.back());
+      frameIndex = closestItem.second - this->SortedTimestampIndexOffset;
+      return IGSIO_SUCCESS;
+    }
+  }
+
+  double timeBefore = this->TrackedFrameList[frameIndexBefore]->GetTimestamp();
+  double timeAfter = this->TrackedFrameList[frameIndexAfter]->GetTimestamp();
+  frameIndex = (timestamp - timeBefore <= timeAfter - timestamp) ? frameIndexBefore : frameIndexAfter;
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTrackedFrameList::GetInterpolatedTransform(const igsioTransformName& name, double timestamp, double* outMatrix, ToolStatus* outStatus /*=NULL*/) const
+{
+  if (outMatrix == NULL)
+  {
+    LOG_ERROR("Invalid call to vtkIGSIOTrackedFrameList::GetInterpolatedTransform - output matrix is NULL");
+    return IGSIO_FAIL;
+  }
+
+  unsigned int frameIndexBefore(0);
+  unsigned int frameIndexAfter(0);
+  if (this->FindFrameIndicesAroundTimestamp(timestamp, frameIndexBefore, frameIndexAfter) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Unable to interpolate transform " << name.GetTransformName() << " at time " << std::fixed << timestamp << " - time is out of the range of the tracked frame list");
+    return IGSIO_FAIL;
+  }
+
+  igsioTrackedFrame* frameBefore = this->TrackedFrameList[frameIndexBefore];
+  igsioTrackedFrame* frameAfter = this->TrackedFrameList[frameIndexAfter];
+  double matrixBefore[16] = { 0 };
+  double matrixAfter[16] = { 0 };
+  if (frameBefore->GetFrameTransform(name, matrixBefore) != IGSIO_SUCCESS || frameAfter->GetFrameTransform(name, matrixAfter) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Unable to interpolate transform " << name.GetTransformName() << " - transform is missing from a frame");
+    return IGSIO_FAIL;
+  }
+
+  if (outStatus != NULL)
+  {
+    ToolStatus statusBefore(TOOL_OK);
+    ToolStatus statusAfter(TOOL_OK);
+    frameBefore->GetFrameTransformStatus(name, statusBefore);
+    frameAfter->GetFrameTransformStatus(name, statusAfter);
+    *outStatus = (statusBefore != TOOL_OK ? statusBefore : statusAfter);
+  }
+
+  double timeBefore = frameBefore->GetTimestamp();
+  double timeAfter = frameAfter->GetTimestamp();
+  if (frameIndexBefore == frameIndexAfter || timeAfter - timeBefore <= 0)
+  {
+    memcpy(outMatrix, matrixBefore, sizeof(double) * 16);
+    return IGSIO_SUCCESS;
+  }
+  double weightAfter = (timestamp - timeBefore) / (timeAfter - timeBefore);
+  igsioMath::InterpolateRigidTransform(matrixBefore, matrixAfter, weightAfter, outMatrix);
+
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTrackedFrameList::GetInterpolatedTransform(const igsioTransformName& name, double timestamp, vtkMatrix4x4* outMatrix, ToolStatus* outStatus /*=NULL*/) const
+{
+  if (outMatrix == NULL)
+  {
+    LOG_ERROR("Invalid call to vtkIGSIOTrackedFrameList::GetInterpolatedTransform - output matrix is NULL");
+    return IGSIO_FAIL;
+  }
+  double matrix[16] = { 0 };
+  if (this->GetInterpolatedTransform(name, timestamp, matrix, outStatus) != IGSIO_SUCCESS)
+  {
+    return IGSIO_FAIL;
+  }
+  outMatrix->DeepCopy(matrix);
+  return IGSIO_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 igsioStatus vtkIGSIOTrackedFrameList::SetCustomTransform(const char* frameTransformName, vtkMatrix4x4* transformMatrix)
 {
@@ -11,12 +11,25 @@
 
 // IGSIO includes
 #include <igsioCommon.h> // for US_IMAGE_ORIENTATION
+#include "igsioPoseIndex.h"
+#include "vtkIGSIOFrameBufferPool.h"
 
 // VTK includes
+#include <vtkMultiThreader.h>
 #include <vtkObject.h>
+#include <vtkSmartPointer.h>
 
 // STL includes
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <deque>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #ifndef VTK_OVERRIDE
 #define VTK_OVERRIDE override
@@ -25,6 +38,7 @@
 class vtkXMLDataElement;
 class igsioTrackedFrame;
 class vtkMatrix4x4;
+class vtkIGSIOSimpleRecursiveCriticalSection;
 
 /*!
   \class vtkIGSIOTrackedFrameList
@@ -44,6 +58,80 @@ class VTKIGSIOCOMMON_EXPORT vtkIGSIOTrackedFrameList : public vtkObject
 public:
   typedef std::deque<igsioTrackedFrame*> TrackedFrameListType;
 
+  /*!
+    \class FrameView
+    \brief Non-owning view of a range of frames in the list, optionally subsampled (every Nth frame)
+
+    The view refers to the frames of the list without copying the frame pointers, so it is cheap to create
+    and pass by value. The view is valid until frames are added to or removed from the list.
+  */
+  class FrameView
+  {
+  public:
+    /*! Forward iterator over the frames of the view */
+    class const_iterator
+    {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef igsioTrackedFrame* value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef igsioTrackedFrame* const* pointer;
+      typedef igsioTrackedFrame* const& reference;
+
+      const_iterator(const TrackedFrameListType* frames, unsigned int frameIndex, unsigned int stride) : Frames(frames), FrameIndex(frameIndex), Stride(stride) {}
+      reference operator*() const { return (*this->Frames)[this->FrameIndex]; }
+      pointer operator->() const { return &(*this->Frames)[this->FrameIndex]; }
+      const_iterator& operator++() { this->FrameIndex += this->Stride; return *this; }
+      const_iterator operator++(int) { const_iterator previous(*this); this->FrameIndex += this->Stride; return previous; }
+      bool operator==(const const_iterator& other) const { return this->FrameIndex == other.FrameIndex; }
+      bool operator!=(const const_iterator& other) const { return this->FrameIndex != other.FrameIndex; }
+
+    private:
+      // Frame index is used instead of a list iterator, as the end position of a subsampled view may be past the end of the list
+      const TrackedFrameListType* Frames;
+      unsigned int FrameIndex;
+      unsigned int Stride;
+    };
+
+    FrameView() : Frames(NULL), FirstFrameIndex(0), NumberOfFrames(0), Stride(1) {}
+    FrameView(const TrackedFrameListType* frames, unsigned int firstFrameIndex, unsigned int numberOfFrames, unsigned int stride)
+      : Frames(frames), FirstFrameIndex(firstFrameIndex), NumberOfFrames(numberOfFrames), Stride(stride) {}
+
+    /*! Number of frames in the view */
+    unsigned int size() const { return this->NumberOfFrames; }
+    bool empty() const { return this->NumberOfFrames == 0; }
+
+    /*! Get the i-th frame of the view (no bounds checking) */
+    igsioTrackedFrame* operator[](unsigned int i) const { return (*this->Frames)[this->GetFrameIndexInList(i)]; }
+
+    /*! Index of the i-th frame of the view in the list */
+    unsigned int GetFrameIndexInList(unsigned int i) const { return this->FirstFrameIndex + i * this->Stride; }
+
+    const_iterator begin() const { return const_iterator(this->Frames, this->FirstFrameIndex, this->Stride); }
+    const_iterator end() const { return const_iterator(this->Frames, this->GetFrameIndexInList(this->NumberOfFrames), this->Stride); }
+
+    /*! Get a view of a sub-range of this view. The range is clamped to the size of this view. */
+    FrameView GetSubRange(unsigned int first, unsigned int count) const
+    {
+      first = std::min(first, this->NumberOfFrames);
+      count = std::min(count, this->NumberOfFrames - first);
+      return FrameView(this->Frames, this->GetFrameIndexInList(first), count, this->Stride);
+    }
+
+    /*! Get a view of every Nth frame of this view, starting with the first frame */
+    FrameView GetSubsampled(unsigned int step) const
+    {
+      step = std::max(step, 1u);
+      return FrameView(this->Frames, this->FirstFrameIndex, (this->NumberOfFrames + step - 1) / step, this->Stride * step);
+    }
+
+  private:
+    const TrackedFrameListType* Frames;
+    unsigned int FirstFrameIndex;
+    unsigned int NumberOfFrames;
+    unsigned int Stride;
+  };
+
   static vtkIGSIOTrackedFrameList* New();
   vtkTypeMacro(vtkIGSIOTrackedFrameList, vtkObject);
   virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
@@ -63,10 +151,20 @@ public:
   /*! Add tracked frame to container. If the frame is invalid then it may not actually add it to the list. */
   virtual igsioStatus AddTrackedFrame(igsioTrackedFrame* trackedFrame, InvalidFrameAction action = ADD_INVALID_FRAME_AND_REPORT_ERROR);
 
+  /*!
+    Add tracked frame to container by moving its content (image buffer, fields, transforms) into a new list item.
+    Pixel data is not copied. If the frame is not added then the passed frame is left unchanged.
+  */
+  virtual igsioStatus AddTrackedFrame(igsioTrackedFrame&& trackedFrame, InvalidFrameAction action = ADD_INVALID_FRAME_AND_REPORT_ERROR);
+
   /*! Add tracked frame to container by taking ownership of the passed pointer. If the frame is invalid then it may not actually add it to the list (it will be deleted immediately). */
   virtual igsioStatus TakeTrackedFrame(igsioTrackedFrame* trackedFrame, InvalidFrameAction action = ADD_INVALID_FRAME_AND_REPORT_ERROR);
 
-  /*! Add all frames from a tracked frame list to the container. It adds all invalid frames as well, but an error is reported. */
+  /*!
+    Add all frames from a tracked frame list to the container. It adds all invalid frames as well, but an error is reported.
+    Validation checks that do not depend on the frames already in the list are performed in parallel for all input frames,
+    then the remaining checks are performed and the frames are added in a sequential pass.
+  */
   virtual igsioStatus AddTrackedFrameList(vtkIGSIOTrackedFrameList* inTrackedFrameList, InvalidFrameAction action = ADD_INVALID_FRAME_AND_REPORT_ERROR);
 
   /*! Get tracked frame from container */
@@ -77,8 +175,19 @@ public:
   virtual unsigned int GetNumberOfTrackedFrames();
   virtual unsigned int Size();
 
-  /*! Get the tracked frame list */
-  TrackedFrameListType GetTrackedFrameList();
+  /*! Get the tracked frame list. The returned reference is valid while the list object exists. */
+  const TrackedFrameListType& GetTrackedFrameList() const;
+
+  /*! Get a non-copying view of all frames of the list */
+  FrameView GetFrameView() const;
+
+  /*!
+    Get a non-copying view of a range of frames of the list
+    \param firstFrameIndex Index of the first frame of the range
+    \param numberOfFrames Number of frames in the range (before subsampling), clamped to the end of the list
+    \param stride Include only every stride-th frame of the range, starting with the first frame
+  */
+  FrameView GetFrameView(unsigned int firstFrameIndex, unsigned int numberOfFrames, unsigned int stride = 1) const;
 
   /* Retrieve the latest timestamp in the tracked frame list */
   double GetMostRecentTimestamp();
@@ -97,12 +206,29 @@ public:
   /*! Clear tracked frame list and free memory */
   virtual void Clear();
 
+  /*!
+    Discard the timestamp index that is used for REQUIRE_UNIQUE_TIMESTAMP validation. The index is rebuilt when it is needed next time.
+    The index is kept up-to-date when frames are added or removed. It is also discarded automatically when the timestamp
+    of a frame that is already in the list is modified (e.g., by GetTrackedFrame(i)->SetTimestamp(...)).
+  */
+  void InvalidateTimestampIndex();
+
   /*! Set the number of following unique frames needed in the tracked frame list */
   vtkSetMacro(NumberOfUniqueFrames, int);
 
   /*! Get the number of following unique frames needed in the tracked frame list */
   vtkGetMacro(NumberOfUniqueFrames, int);
 
+  /*!
+    If enabled then REQUIRE_CHANGED_TRANSFORM and REQUIRE_CHANGED_ENCODER_POSITION validation compares the new frame
+    with all frames in the list, not just with the last NumberOfUniqueFrames frames. Frame poses are stored in a spatial
+    index that is updated as frames are added and removed, so the validation time does not grow with the number of frames.
+    Disabled by default.
+  */
+  vtkSetMacro(ValidatePoseAgainstAllFrames, bool);
+  vtkGetMacro(ValidatePoseAgainstAllFrames, bool);
+  vtkBooleanMacro(ValidatePoseAgainstAllFrames, bool);
+
   /*! Set the threshold of acceptable speed of position change */
   vtkSetMacro(MinRequiredTranslationDifferenceMm, double);
 
@@ -137,6 +263,25 @@ public:
   */
   vtkGetMacro(ValidationRequirements, long);
 
+  /*!
+    Set the number of threads used by AddTrackedFrameList for the validation checks that do not depend on
+    the frames already in the list (tracking status, speed between neighbor frames of the input list).
+    0 means the VTK default number of threads.
+  */
+  vtkSetMacro(NumberOfValidationThreads, int);
+  vtkGetMacro(NumberOfValidationThreads, int);
+
+  /*!
+    Get the number of frames that failed the validation check of the specified requirement since the last
+    ResetValidationStatistics call. Each invalid frame is counted only at the first failed check (checks are performed
+    in this order: unique timestamp, tracking status, changed transform, changed encoder position, speed).
+    \param requirement One of the TrackedFrameValidationRequirements values
+  */
+  unsigned int GetNumberOfFailedValidations(long requirement) const;
+
+  /*! Reset the number of failed validations for all requirements */
+  void ResetValidationStatistics();
+
   /*! Set frame transform name used for transform validation */
   void SetFrameTransformNameForValidation(const igsioTransformName& aTransformName)
   {
@@ -146,6 +291,37 @@ public:
   /*! Get frame transform name used for transform validation */
   igsioTransformName GetFrameTransformNameForValidation();
 
+  /*!
+    Set the pool that pixel buffers of the frames in this list are allocated from. Frames that are added
+    to the list after this call use this pool. If NULL (default) then frames use the default pool.
+  */
+  void SetFrameBufferPool(vtkIGSIOFrameBufferPool* bufferPool);
+  vtkIGSIOFrameBufferPool* GetFrameBufferPool();
+
+  /*!
+    Set the maximum number of frames kept in the list (ring buffer mode).
+    When a frame is added to a full list then the oldest frames are removed to make room for it.
+    The removed frame object and its pixel buffer are reused for the next copied frame. 0 means no limit (default).
+  */
+  void SetMaximumNumberOfFrames(unsigned int maximumNumberOfFrames);
+  vtkGetMacro(MaximumNumberOfFrames, unsigned int);
+
+  /*!
+    Set the maximum total size of pixel data of frames kept in the list (ring buffer mode).
+    When a frame is added and the limit would be exceeded then the oldest frames are removed. At least the most
+    recent frame is always kept. 0 means no limit (default).
+    The total size is updated by the frames of the list whenever their pixel data is (re)allocated through igsioVideoFrame,
+    so frames whose pixel data is allocated after they are added (e.g., by sequence file readers) are taken into account.
+  */
+  void SetMaximumFrameMemoryBytes(unsigned long long maximumFrameMemoryBytes);
+  vtkGetMacro(MaximumFrameMemoryBytes, unsigned long long);
+
+  /*! Get the total size of pixel data of frames in the list */
+  unsigned long long GetFrameMemoryBytes() const;
+
+  /*! Get the number of frames that were removed from the list because the frame count or memory limit was reached */
+  vtkGetMacro(NumberOfEvictedFrames, unsigned long long);
+
   /*! Get tracked frame scalar size in bits */
   virtual int GetNumberOfBitsPerScalar();
 
@@ -192,6 +368,31 @@ public:
   virtual igsioStatus GetCustomTransform(const char* frameTransformName, double* transformMatrix) const;
   virtual igsioStatus GetTransform(const igsioTransformName& name, double* outMatrix) const;
 
+  /*!
+    Find the frame that has the timestamp closest to the requested time.
+    Frames are looked up by binary search in a timestamp-sorted index, which is maintained when frames
+    are added in increasing timestamp order and rebuilt once otherwise.
+    The index is protected by a lock, so this method can be called from multiple threads at the same time
+    (but not while the list is being modified).
+    \param timestamp Requested time
+    \param frameIndex Index of the frame with the closest timestamp
+    \return IGSIO_FAIL if the list is empty
+  */
+  igsioStatus FindFrameIndexByTimestamp(double timestamp, unsigned int& frameIndex) const;
+
+  /*!
+    Get the frame transform at an arbitrary time by interpolating between the frames acquired
+    right before and after the requested time. Rotation is interpolated by spherical linear interpolation
+    of quaternions, translation is interpolated linearly.
+    \param name Name of the frame transform
+    \param timestamp Requested time, must be between the first and last frame timestamp
+    \param outMatrix Interpolated transform matrix (16 elements, row-major)
+    \param outStatus If not NULL, it is set to TOOL_OK if the transform is valid in both frames, otherwise to the invalid status
+    Can be called from multiple threads at the same time, see FindFrameIndexByTimestamp.
+  */
+  igsioStatus GetInterpolatedTransform(const igsioTransformName& name, double timestamp, double* outMatrix, ToolStatus* outStatus = NULL) const;
+  igsioStatus GetInterpolatedTransform(const igsioTransformName& name, double timestamp, vtkMatrix4x4* outMatrix, ToolStatus* outStatus = NULL) const;
+
   /*! Set the custom transformation matrix from metafile by frame transform name
   * It will search for a field like: Seq_Frame[frameNumber]_[frameTransformName] */
   virtual igsioStatus SetCustomTransform(const char* frameTransformName, vtkMatrix4x4* transformMatrix);
@@ -244,11 +445,86 @@ protected:
   */
   virtual bool ValidateData(igsioTrackedFrame* trackedFrame);
 
+  /*! Results of the validation checks that do not depend on the frames already in the list */
+  struct PrecomputedValidationResult
+  {
+    bool StatusValid;
+    /*! Result of the speed check against the previous frame of the input list */
+    bool SpeedValid;
+    /*! SpeedValid can only be used if the previous frame of the input list is the latest frame in the list */
+    bool SpeedValidAvailable;
+  };
+
+  /*!
+    Perform the validation checks on a tracked frame.
+    \param trackedFrame Input tracked frame
+    \param precomputedResult Results of the order-independent checks. If NULL then all checks are performed.
+    \return The first requirement that is not fulfilled, 0 if the frame is valid
+  */
+  long GetFailedValidationRequirement(igsioTrackedFrame* trackedFrame, const PrecomputedValidationResult* precomputedResult);
+
+  /*! Thread function of AddTrackedFrameList that performs the order-independent validation checks on a block of frames */
+  static VTK_THREAD_RETURN_TYPE BatchValidationThreadFunction(void* arg);
+
   bool ValidateTimestamp(igsioTrackedFrame* trackedFrame);
+
+  /*!
+    Find the frames acquired right before and after the requested time (using the timestamp-sorted index).
+    If the list contains a frame at the requested time then both indices refer to that frame.
+    \return IGSIO_FAIL if the requested time is out of the time range of the list
+  */
+  igsioStatus FindFrameIndicesAroundTimestamp(double timestamp, unsigned int& frameIndexBefore, unsigned int& frameIndexAfter) const;
+
+  /*! Make sure the timestamp-sorted index is up-to-date. SortedTimestampIndexMutex must be locked by the caller. */
+  void UpdateSortedTimestampIndex() const;
+
+  /*! Returns true if the frame that a sorted timestamp index item refers to is in the list and still has the indexed timestamp */
+  bool IsSortedTimestampIndexItemUpToDate(const std::pair<double, unsigned int>& item) const;
+
+  /*! Update the timestamp index after a frame is added to or removed from the list */
+  void AddToTimestampIndex(igsioTrackedFrame* trackedFrame);
+  void RemoveFromTimestampIndex(igsioTrackedFrame* trackedFrame);
+
+  /*! Discard the timestamp indices if the timestamp of any frame in the list has been modified since they were built */
+  void InvalidateOutdatedTimestampIndex();
+
+  /*!
+    Make sure the pose index of the requested type contains all frames of the list, using the current validation
+    transform name and tolerances. The index is rebuilt if any of these changed.
+  */
+  void UpdatePoseIndex(igsioPoseIndex::PoseType poseType);
+
+  /*! Update the pose indices after a frame is added to or removed from the list */
+  void AddToPoseIndex(igsioTrackedFrame* trackedFrame);
+  void RemoveFromPoseIndex(igsioTrackedFrame* trackedFrame);
+
+  /*! Get the validation transform of a frame. Returns false if the transform is not defined in the frame. */
+  bool GetValidationTransform(igsioTrackedFrame* trackedFrame, double matrix[16]);
+
+  /*! Get the stepper encoder values of a frame. Returns false if the values are not defined in the frame. */
+  bool GetEncoderValues(igsioTrackedFrame* trackedFrame, double& probePosition, double& probeRotation, double& templatePosition);
+
+  /*! Append a frame to the list and update the indices */
+  void PushBackTrackedFrame(igsioTrackedFrame* trackedFrame);
+
+  /*!
+    Remove the oldest frames until the specified number of new frames of the specified total size fit into the
+    frame count and memory limits. The last removed frame object is kept for reuse.
+  */
+  void EvictOldestFrames(unsigned int numberOfNewFrames, unsigned long long newFrameBytes);
+
+  /*!
+    Get a frame object for a new list item that will be assigned a copy of sourceFrame. The recycled frame object is
+    returned if the source frame has decoded pixel data of the same size and type as the recycled frame (so that its
+    pixel buffer can be reused), otherwise a new object.
+  */
+  igsioTrackedFrame* CreateTrackedFrameForList(igsioTrackedFrame* sourceFrame);
   bool ValidateTransform(igsioTrackedFrame* trackedFrame);
   bool ValidateStatus(igsioTrackedFrame* trackedFrame);
   bool ValidateEncoderPosition(igsioTrackedFrame* trackedFrame);
   bool ValidateSpeed(igsioTrackedFrame* trackedFrame);
+  /*! Check the speed between a frame and the frame acquired before it */
+  bool ValidateSpeed(igsioTrackedFrame* trackedFrame, igsioTrackedFrame* previousTrackedFrame);
 
   TrackedFrameListType TrackedFrameList;
   igsioFieldMapType CustomFields;
@@ -267,6 +543,56 @@ protected:
   long ValidationRequirements;
   igsioTransformName FrameTransformNameForValidation;
 
+  int NumberOfValidationThreads;
+  /*! Number of failed validations for each requirement */
+  std::map<long, unsigned int> NumberOfFailedValidations;
+
+  vtkSmartPointer<vtkIGSIOFrameBufferPool> FrameBufferPool;
+
+  /*! Number of frames in the list for each timestamp. Only built when timestamp uniqueness is validated. */
+  typedef std::unordered_map<double, unsigned int> TimestampIndexType;
+  TimestampIndexType TimestampIndex;
+  bool TimestampIndexValid;
+  /*! Value of TimestampChangeCount when TimestampIndex was built */
+  unsigned long TimestampIndexChangeCount;
+
+  /*! Frame timestamps and frame indices, sorted by timestamp. Built on first use, appended to while frames are added in order. */
+  typedef std::deque<std::pair<double, unsigned int> > SortedTimestampIndexType;
+  mutable SortedTimestampIndexType SortedTimestampIndex;
+  mutable bool SortedTimestampIndexValid;
+  /*! Number of frames evicted from the front of the list since the sorted index was built, stored frame indices are offset by this value */
+  mutable unsigned int SortedTimestampIndexOffset;
+  /*! Value of TimestampChangeCount when SortedTimestampIndex was built */
+  mutable unsigned long SortedTimestampIndexChangeCount;
+  /*! Lock for building and searching the sorted index from const methods, which may be called from multiple threads */
+  vtkIGSIOSimpleRecursiveCriticalSection* SortedTimestampIndexMutex;
+
+  /*!
+    Incremented by the frames of the list whenever their timestamp is modified, used for detecting outdated timestamp indices.
+    Shared with the frames of the list (igsioTrackedFrame::TimestampChangeCounter).
+  */
+  std::shared_ptr<std::atomic<unsigned long> > TimestampChangeCount;
+
+  bool ValidatePoseAgainstAllFrames;
+  /*! Spatial index of the validation transform and the encoder values of the frames, only built if ValidatePoseAgainstAllFrames is enabled */
+  igsioPoseIndex TransformPoseIndex;
+  igsioPoseIndex EncoderPoseIndex;
+  bool TransformPoseIndexValid;
+  bool EncoderPoseIndexValid;
+  igsioTransformName TransformPoseIndexTransformName;
+
+  /*! Ring buffer mode limits, 0 means no limit */
+  unsigned int MaximumNumberOfFrames;
+  unsigned long long MaximumFrameMemoryBytes;
+
+  /*! Total pixel data size of the frames in the list, kept up to date by the frames (igsioVideoFrame::FrameMemoryCounter) */
+  igsioVideoFrame::FrameMemoryCounterType FrameMemoryBytes;
+
+  unsigned long long NumberOfEvictedFrames;
+
+  /*! Frame object removed from the front of the list, reused for the next copied frame to avoid reallocation of its pixel buffer */
+  igsioTrackedFrame* RecycledTrackedFrame;
+
 private:
   vtkIGSIOTrackedFrameList(const vtkIGSIOTrackedFrameList&);
   void operator=(const vtkIGSIOTrackedFrameList&);
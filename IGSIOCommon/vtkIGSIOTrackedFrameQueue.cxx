@@ -0,0 +1,374 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+// IGSIO includes
+#include "igsioTrackedFrame.h"
+#include "vtkIGSIOTrackedFrameList.h"
+#include "vtkIGSIOTrackedFrameQueue.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STL includes
+#include <chrono>
+#include <utility>
+
+namespace
+{
+  const unsigned int DEFAULT_CAPACITY = 100;
+
+  //----------------------------------------------------------------------------
+  // Wait on the condition until the predicate is true. Negative timeout means infinite wait. Returns the predicate value.
+  template<class Predicate>
+  bool WaitFor(std::condition_variable& condition, std::unique_lock<std::mutex>& lock, double timeoutSec, Predicate predicate)
+  {
+    if (timeoutSec < 0)
+    {
+      condition.wait(lock, predicate);
+      return true;
+    }
+    return condition.wait_for(lock, std::chrono::duration<double>(timeoutSec), predicate);
+  }
+}
+
+vtkStandardNewMacro(vtkIGSIOTrackedFrameQueue);
+
+//----------------------------------------------------------------------------
+vtkIGSIOTrackedFrameQueue::vtkIGSIOTrackedFrameQueue()
+  : Frames(DEFAULT_CAPACITY, static_cast<igsioTrackedFrame*>(NULL))
+  , Head(0)
+  , NumberOfFrames(0)
+  , Policy(BLOCK_PRODUCER)
+  , Closed(false)
+  , HighWaterMark(0)
+  , NumberOfPushedFrames(0)
+  , NumberOfPoppedFrames(0)
+  , NumberOfDroppedFrames(0)
+  , NumberOfProducerWaits(0)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIOTrackedFrameQueue::~vtkIGSIOTrackedFrameQueue()
+{
+  this->Clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameQueue::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  os << indent << "Capacity: " << this->Frames.size() << std::endl;
+  os << indent << "NumberOfFrames: " << this->NumberOfFrames << std::endl;
+  os << indent << "BackPressurePolicy: " << this->Policy << std::endl;
+  os << indent << "Closed: " << (this->Closed ? "true" : "false") << std::endl;
+  os << indent << "HighWaterMark: " << this->HighWaterMark << std::endl;
+  os << indent << "NumberOfPushedFrames: " << this->NumberOfPushedFrames << std::endl;
+  os << indent << "NumberOfPoppedFrames: " << this->NumberOfPoppedFrames << std::endl;
+  os << indent << "NumberOfDroppedFrames: " << this->NumberOfDroppedFrames << std::endl;
+  os << indent << "NumberOfProducerWaits: " << this->NumberOfProducerWaits << std::endl;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameQueue::PushBackLocked(igsioTrackedFrame* trackedFrame)
+{
+  this->Frames[(this->Head + this->NumberOfFrames) % this->Frames.size()] = trackedFrame;
+  this->NumberOfFrames++;
+  this->NumberOfPushedFrames++;
+  if (this->NumberOfFrames > this->HighWaterMark)
+  {
+    this->HighWaterMark = this->NumberOfFrames;
+  }
+}
+
+//----------------------------------------------------------------------------
+igsioTrackedFrame* vtkIGSIOTrackedFrameQueue::PopFrontLocked()
+{
+  igsioTrackedFrame* trackedFrame = this->Frames[this->Head];
+  this->Frames[this->Head] = NULL;
+  this->Head = (this->Head + 1) % this->Frames.size();
+  this->NumberOfFrames--;
+  return trackedFrame;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTrackedFrameQueue::Push(igsioTrackedFrame* trackedFrame, double timeoutSec /*=-1.0*/)
+{
+  if (trackedFrame == NULL)
+  {
+    LOG_ERROR("vtkIGSIOTrackedFrameQueue::Push failed: invalid frame");
+    return IGSIO_FAIL;
+  }
+
+  igsioTrackedFrame* droppedFrame = NULL;
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    if (!this->Closed && this->NumberOfFrames == this->Frames.size())
+    {
+      switch (this->Policy)
+      {
+        case BLOCK_PRODUCER:
+          this->NumberOfProducerWaits++;
+          WaitFor(this->SpaceAvailable, lock, timeoutSec, [this]() { return this->Closed || this->NumberOfFrames < this->Frames.size(); });
+          break;
+        case DROP_NEWEST:
+          droppedFrame = trackedFrame;
+          break;
+        case DROP_OLDEST:
+          droppedFrame = this->PopFrontLocked();
+          break;
+      }
+    }
+
+    if (droppedFrame != NULL)
+    {
+      this->NumberOfDroppedFrames++;
+    }
+    if (this->Closed || this->NumberOfFrames == this->Frames.size())
+    {
+      // Closed, timed out, or the new frame is dropped
+      lock.unlock();
+      if (droppedFrame != trackedFrame)
+      {
+        delete droppedFrame;
+      }
+      delete trackedFrame;
+      return IGSIO_FAIL;
+    }
+
+    this->PushBackLocked(trackedFrame);
+  }
+  this->FrameAvailable.notify_one();
+
+  // Delete outside of the lock
+  delete droppedFrame;
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTrackedFrameQueue::Push(igsioTrackedFrame&& trackedFrame, double timeoutSec /*=-1.0*/)
+{
+  return this->Push(new igsioTrackedFrame(std::move(trackedFrame)), timeoutSec);
+}
+
+//----------------------------------------------------------------------------
+igsioTrackedFrame* vtkIGSIOTrackedFrameQueue::Pop(double timeoutSec /*=-1.0*/)
+{
+  igsioTrackedFrame* trackedFrame = NULL;
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    if (!WaitFor(this->FrameAvailable, lock, timeoutSec, [this]() { return this->Closed || this->NumberOfFrames > 0; })
+        || this->NumberOfFrames == 0)
+    {
+      return NULL;
+    }
+    trackedFrame = this->PopFrontLocked();
+    this->NumberOfPoppedFrames++;
+  }
+  this->SpaceAvailable.notify_one();
+  return trackedFrame;
+}
+
+//----------------------------------------------------------------------------
+igsioTrackedFrame* vtkIGSIOTrackedFrameQueue::TryPop()
+{
+  return this->Pop(0.0);
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTrackedFrameQueue::PopAllToTrackedFrameList(vtkIGSIOTrackedFrameList* trackedFrameList)
+{
+  if (trackedFrameList == NULL)
+  {
+    LOG_ERROR("vtkIGSIOTrackedFrameQueue::PopAllToTrackedFrameList failed: invalid tracked frame list");
+    return IGSIO_FAIL;
+  }
+
+  std::vector<igsioTrackedFrame*> trackedFrames;
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    trackedFrames.reserve(this->NumberOfFrames);
+    while (this->NumberOfFrames > 0)
+    {
+      trackedFrames.push_back(this->PopFrontLocked());
+    }
+    this->NumberOfPoppedFrames += trackedFrames.size();
+  }
+  this->SpaceAvailable.notify_all();
+
+  // Frames are validated by the list outside of the lock
+  igsioStatus status = IGSIO_SUCCESS;
+  for (std::vector<igsioTrackedFrame*>::iterator frameIt = trackedFrames.begin(); frameIt != trackedFrames.end(); ++frameIt)
+  {
+    if (trackedFrameList->TakeTrackedFrame(*frameIt, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME) != IGSIO_SUCCESS)
+    {
+      status = IGSIO_FAIL;
+    }
+  }
+  return status;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameQueue::Close()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Closed = true;
+  }
+  this->FrameAvailable.notify_all();
+  this->SpaceAvailable.notify_all();
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameQueue::Open()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->Closed = false;
+}
+
+//----------------------------------------------------------------------------
+bool vtkIGSIOTrackedFrameQueue::IsClosed()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->Closed;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameQueue::Clear()
+{
+  std::vector<igsioTrackedFrame*> trackedFrames;
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    while (this->NumberOfFrames > 0)
+    {
+      trackedFrames.push_back(this->PopFrontLocked());
+    }
+  }
+  this->SpaceAvailable.notify_all();
+
+  for (std::vector<igsioTrackedFrame*>::iterator frameIt = trackedFrames.begin(); frameIt != trackedFrames.end(); ++frameIt)
+  {
+    delete *frameIt;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameQueue::SetCapacity(unsigned int capacity)
+{
+  if (capacity == 0)
+  {
+    LOG_ERROR("vtkIGSIOTrackedFrameQueue::SetCapacity failed: capacity must be at least 1");
+    return;
+  }
+
+  std::vector<igsioTrackedFrame*> droppedFrames;
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    if (capacity == this->Frames.size())
+    {
+      return;
+    }
+    while (this->NumberOfFrames > capacity)
+    {
+      droppedFrames.push_back(this->PopFrontLocked());
+      this->NumberOfDroppedFrames++;
+    }
+    std::vector<igsioTrackedFrame*> frames(capacity, static_cast<igsioTrackedFrame*>(NULL));
+    for (unsigned int i = 0; i < this->NumberOfFrames; ++i)
+    {
+      frames[i] = this->Frames[(this->Head + i) % this->Frames.size()];
+    }
+    this->Frames.swap(frames);
+    this->Head = 0;
+  }
+  this->SpaceAvailable.notify_all();
+  this->Modified();
+
+  for (std::vector<igsioTrackedFrame*>::iterator frameIt = droppedFrames.begin(); frameIt != droppedFrames.end(); ++frameIt)
+  {
+    delete *frameIt;
+  }
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkIGSIOTrackedFrameQueue::GetCapacity()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return static_cast<unsigned int>(this->Frames.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameQueue::SetBackPressurePolicy(BackPressurePolicy policy)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Policy = policy;
+  }
+  // Producers waiting for space are not affected by the policy change
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIOTrackedFrameQueue::BackPressurePolicy vtkIGSIOTrackedFrameQueue::GetBackPressurePolicy()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->Policy;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkIGSIOTrackedFrameQueue::GetNumberOfFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->NumberOfFrames;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkIGSIOTrackedFrameQueue::GetHighWaterMark()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->HighWaterMark;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOTrackedFrameQueue::GetNumberOfPushedFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->NumberOfPushedFrames;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOTrackedFrameQueue::GetNumberOfPoppedFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->NumberOfPoppedFrames;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOTrackedFrameQueue::GetNumberOfDroppedFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->NumberOfDroppedFrames;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkIGSIOTrackedFrameQueue::GetNumberOfProducerWaits()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->NumberOfProducerWaits;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTrackedFrameQueue::ResetStatistics()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->HighWaterMark = this->NumberOfFrames;
+  this->NumberOfPushedFrames = 0;
+  this->NumberOfPoppedFrames = 0;
+  this->NumberOfDroppedFrames = 0;
+  this->NumberOfProducerWaits = 0;
+}
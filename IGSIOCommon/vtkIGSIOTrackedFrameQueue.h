@@ -0,0 +1,154 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkIGSIOTrackedFrameQueue_h
+#define __vtkIGSIOTrackedFrameQueue_h
+
+#include "vtkigsiocommon_export.h"
+
+// IGSIO includes
+#include "igsioCommon.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+// STL includes
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#ifndef VTK_OVERRIDE
+#define VTK_OVERRIDE override
+#endif
+
+class igsioTrackedFrame;
+class vtkIGSIOTrackedFrameList;
+
+/*!
+  \class vtkIGSIOTrackedFrameQueue
+  \brief Bounded queue for passing tracked frames between threads
+
+  Frames are passed between an acquisition (producer) thread and processing (consumer) threads,
+  such as file writing or volume reconstruction, without copying: the queue stores frame pointers
+  and ownership of the frame is transferred to the queue by Push and to the caller by Pop.
+
+  The queue is a fixed-capacity ring buffer protected by a mutex. Frames are only moved in and out
+  while the lock is held, so the critical sections are short. Any number of producers and consumers may use the queue.
+
+  When the queue is full, the behavior of Push is defined by the back-pressure policy: the producer
+  waits for free space, the new frame is dropped, or the oldest queued frame is dropped.
+
+  \ingroup PlusLibCommon
+*/
+class VTKIGSIOCOMMON_EXPORT vtkIGSIOTrackedFrameQueue : public vtkObject
+{
+public:
+  static vtkIGSIOTrackedFrameQueue* New();
+  vtkTypeMacro(vtkIGSIOTrackedFrameQueue, vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /*! Action performed by Push when the queue is full */
+  enum BackPressurePolicy
+  {
+    BLOCK_PRODUCER = 0, /*!< Wait until a consumer removes a frame from the queue */
+    DROP_NEWEST, /*!< Discard the pushed frame */
+    DROP_OLDEST /*!< Discard the oldest frame in the queue to make room for the pushed frame */
+  };
+
+  /*!
+    Add a frame to the end of the queue. The queue takes ownership of the frame, it is deleted if it is not added.
+    \param trackedFrame Frame allocated with new
+    \param timeoutSec Maximum time to wait for free space in BLOCK_PRODUCER mode. Negative value means no time limit.
+    \return IGSIO_FAIL if the frame was dropped, the wait timed out, or the queue is closed
+  */
+  igsioStatus Push(igsioTrackedFrame* trackedFrame, double timeoutSec = -1.0);
+
+  /*! Add a frame to the end of the queue by moving its content into a new queue item (pixel data is not copied). The content is discarded if the frame is not added. */
+  igsioStatus Push(igsioTrackedFrame&& trackedFrame, double timeoutSec = -1.0);
+
+  /*!
+    Remove the oldest frame from the queue. Waits until a frame is available.
+    \param timeoutSec Maximum time to wait. Negative value means no time limit.
+    \return Frame that is owned by the caller, NULL if the wait timed out or the queue is closed and empty
+  */
+  igsioTrackedFrame* Pop(double timeoutSec = -1.0);
+
+  /*! Remove the oldest frame from the queue without waiting. Returns NULL if the queue is empty. The caller owns the returned frame. */
+  igsioTrackedFrame* TryPop();
+
+  /*!
+    Move all queued frames to the end of a tracked frame list without copying. Does not wait.
+    \return IGSIO_FAIL if any of the frames was rejected by the list validation
+  */
+  igsioStatus PopAllToTrackedFrameList(vtkIGSIOTrackedFrameList* trackedFrameList);
+
+  /*!
+    Close the queue: subsequent pushes fail and waiting producers and consumers are released.
+    Consumers can still pop the frames that are in the queue.
+  */
+  void Close();
+  /*! Reopen a closed queue */
+  void Open();
+  bool IsClosed();
+
+  /*! Delete all frames in the queue */
+  void Clear();
+
+  /*! Set the maximum number of frames in the queue. If the queue contains more frames then the oldest frames are dropped. */
+  void SetCapacity(unsigned int capacity);
+  unsigned int GetCapacity();
+
+  void SetBackPressurePolicy(BackPressurePolicy policy);
+  BackPressurePolicy GetBackPressurePolicy();
+
+  /*! Get the number of frames currently in the queue */
+  unsigned int GetNumberOfFrames();
+
+  /*! Maximum number of frames that were in the queue at the same time */
+  unsigned int GetHighWaterMark();
+  /*! Number of frames added to the queue */
+  unsigned long long GetNumberOfPushedFrames();
+  /*! Number of frames removed from the queue by consumers */
+  unsigned long long GetNumberOfPoppedFrames();
+  /*! Number of frames discarded because the queue was full */
+  unsigned long long GetNumberOfDroppedFrames();
+  /*! Number of Push calls that had to wait for free space */
+  unsigned long long GetNumberOfProducerWaits();
+  /*! Reset high-water mark and frame counters */
+  void ResetStatistics();
+
+protected:
+  vtkIGSIOTrackedFrameQueue();
+  virtual ~vtkIGSIOTrackedFrameQueue();
+
+  /*! Append a frame to the ring buffer. The queue must be locked and must not be full. */
+  void PushBackLocked(igsioTrackedFrame* trackedFrame);
+  /*! Remove the oldest frame from the ring buffer. The queue must be locked and must not be empty. */
+  igsioTrackedFrame* PopFrontLocked();
+
+  std::vector<igsioTrackedFrame*> Frames;
+  /*! Position of the oldest frame in Frames */
+  unsigned int Head;
+  unsigned int NumberOfFrames;
+  BackPressurePolicy Policy;
+  bool Closed;
+
+  unsigned int HighWaterMark;
+  unsigned long long NumberOfPushedFrames;
+  unsigned long long NumberOfPoppedFrames;
+  unsigned long long NumberOfDroppedFrames;
+  unsigned long long NumberOfProducerWaits;
+
+  std::mutex Mutex;
+  std::condition_variable FrameAvailable;
+  std::condition_variable SpaceAvailable;
+
+private:
+  vtkIGSIOTrackedFrameQueue(const vtkIGSIOTrackedFrameQueue&);
+  void operator=(const vtkIGSIOTrackedFrameQueue&);
+};
+
+#endif
@@ -5,7 +5,9 @@
 =========================================================Plus=header=end*/
 
 //#include "PlusConfigure.h"
+#include "igsioMath.h"
 #include "igsioTrackedFrame.h"
+#include "vtkIGSIOTrackedFrameList.h"
 #include "vtkObjectFactory.h"
 #include "vtkIGSIORecursiveCriticalSection.h"
 #include "vtkTransform.h"
@@ -14,19 +16,109 @@
 #include <vtkSmartPointer.h>
 #include "igsioXmlUtils.h"
 
+#include <algorithm>
+#include <cmath>
+#include <set>
+
 //----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkIGSIOTransformRepository);
 
+namespace
+{
+  const double RIGID_TRANSFORM_TOLERANCE = 1e-6;
+
+  //----------------------------------------------------------------------------
+  /*! Compute c = a * b for row-major 4x4 matrices. c must not be the same as a or b. */
+  void MultiplyMatrices(const double a[16], const double b[16], double c[16])
+  {
+    for (int row = 0; row < 4; ++row)
+    {
+      for (int col = 0; col < 4; ++col)
+      {
+        c[row * 4 + col] = a[row * 4] * b[col] + a[row * 4 + 1] * b[4 + col] + a[row * 4 + 2] * b[8 + col] + a[row * 4 + 3] * b[12 + col];
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Check if the matrix is a rotation and translation (orthonormal rotation part, no projection) */
+  bool IsRigidMatrix(const double m[16])
+  {
+    if (m[12] != 0.0 || m[13] != 0.0 || m[14] != 0.0 || m[15] != 1.0)
+    {
+      return false;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = i; j < 3; ++j)
+      {
+        double dot = m[i * 4] * m[j * 4] + m[i * 4 + 1] * m[j * 4 + 1] + m[i * 4 + 2] * m[j * 4 + 2];
+        if (fabs(dot - (i == j ? 1.0 : 0.0)) > RIGID_TRANSFORM_TOLERANCE)
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Invert a row-major 4x4 matrix. Rigid transforms are inverted by transposing the rotation. */
+  void InvertMatrix(const double m[16], double inverse[16])
+  {
+    if (!IsRigidMatrix(m))
+    {
+      vtkMatrix4x4::Invert(m, inverse);
+      return;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+      inverse[i * 4] = m[i];
+      inverse[i * 4 + 1] = m[4 + i];
+      inverse[i * 4 + 2] = m[8 + i];
+      inverse[i * 4 + 3] = -(m[i] * m[3] + m[4 + i] * m[7] + m[8 + i] * m[11]);
+    }
+    inverse[12] = 0.0;
+    inverse[13] = 0.0;
+    inverse[14] = 0.0;
+    inverse[15] = 1.0;
+  }
+
+  //----------------------------------------------------------------------------
+  void SetIdentity(double m[16])
+  {
+    for (int i = 0; i < 16; ++i)
+    {
+      m[i] = (i % 5 == 0 ? 1.0 : 0.0);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  bool TimestampLess(const std::pair<double, unsigned int>& itemA, const std::pair<double, unsigned int>& itemB)
+  {
+    return itemA.first < itemB.first;
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkIGSIOTransformRepository::TransformQuery::TransformQuery()
+  : Repository(NULL)
+  , TopologyVersion(0)
+{
+
+}
+
 //----------------------------------------------------------------------------
 vtkIGSIOTransformRepository::TransformInfo::TransformInfo()
   : m_Transform(vtkTransform::New())
+  , m_TransformIndex(-1)
   , m_ToolStatus(TOOL_OK)
   , m_IsComputed(false)
   , m_IsPersistent(false)
   , m_Error(-1.0)
 {
-
+  SetIdentity(m_OriginalMatrix);
 }
 
 //----------------------------------------------------------------------------
@@ -52,6 +144,8 @@ vtkIGSIOTransformRepository::TransformInfo::TransformInfo(const TransformInfo& o
   m_IsPersistent = obj.m_IsPersistent;
   m_Date = obj.m_Date;
   m_Error = obj.m_Error;
+  std::copy(obj.m_OriginalMatrix, obj.m_OriginalMatrix + 16, m_OriginalMatrix);
+  m_TransformIndex = obj.m_TransformIndex;
 
 }
 //----------------------------------------------------------------------------
@@ -72,14 +166,21 @@ vtkIGSIOTransformRepository::TransformInfo& vtkIGSIOTransformRepository::Transfo
   m_IsPersistent = obj.m_IsPersistent;
   m_Date = obj.m_Date;
   m_Error = obj.m_Error;
+  std::copy(obj.m_OriginalMatrix, obj.m_OriginalMatrix + 16, m_OriginalMatrix);
+  m_TransformIndex = obj.m_TransformIndex;
   return *this;
 }
 
 //----------------------------------------------------------------------------
 vtkIGSIOTransformRepository::vtkIGSIOTransformRepository()
-  : CriticalSection(vtkIGSIORecursiveCriticalSection::New())
+  : TransformPathCacheEnabled(true)
+  , TopologyVersion(0)
+  , SnapshotPublishingSuspendCount(0)
+  , SnapshotPublishingPending(false)
+  , SnapshotTopologyChangePending(false)
+  , CriticalSection(vtkIGSIORecursiveCriticalSection::New())
 {
-
+  this->PublishSnapshot(true);
 }
 
 //----------------------------------------------------------------------------
@@ -120,13 +221,25 @@ void vtkIGSIOTransformRepository::PrintSelf(ostream& os, vtkIndent indent)
 }
 
 //----------------------------------------------------------------------------
-vtkIGSIOTransformRepository::TransformInfo* vtkIGSIOTransformRepository::GetOriginalTransform(const igsioTransformName& aTransformName) const
+vtkIGSIOTransformRepository::TransformInfo* vtkIGSIOTransformRepository::GetOriginalTransform(const igsioTransformName& aTransformName)
 {
-  CoordFrameToTransformMapType& fromCoordFrame = this->CoordinateFrames[aTransformName.From()];
+  const vtkIGSIOTransformRepository* constThis = this;
+  return const_cast<TransformInfo*>(constThis->GetOriginalTransform(aTransformName));
+}
+
+//----------------------------------------------------------------------------
+const vtkIGSIOTransformRepository::TransformInfo* vtkIGSIOTransformRepository::GetOriginalTransform(const igsioTransformName& aTransformName) const
+{
+  CoordFrameToCoordFrameToTransformMapType::const_iterator fromCoordFrameIt = this->CoordinateFrames.find(aTransformName.From());
+  if (fromCoordFrameIt == this->CoordinateFrames.end())
+  {
+    // no transforms from this coordinate frame
+    return NULL;
+  }
 
   // Check if the transform already exist
-  CoordFrameToTransformMapType::iterator fromToTransformInfoIt = fromCoordFrame.find(aTransformName.To());
-  if (fromToTransformInfoIt != fromCoordFrame.end())
+  CoordFrameToTransformMapType::const_iterator fromToTransformInfoIt = fromCoordFrameIt->second.find(aTransformName.To());
+  if (fromToTransformInfoIt != fromCoordFrameIt->second.end())
   {
     // transform is found
     return &(fromToTransformInfoIt->second);
@@ -141,6 +254,10 @@ igsioStatus vtkIGSIOTransformRepository::SetTransforms(igsioTrackedFrame& tracke
   std::vector<igsioTransformName> transformNames;
   trackedFrame.GetFrameTransformNameList(transformNames);
 
+  // Publish all transforms of the frame at once
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> accessGuard(this->CriticalSection);
+  this->SuspendSnapshotPublishing();
+
   int numberOfErrors(0);
 
   for (std::vector<igsioTransformName>::iterator it = transformNames.begin(); it != transformNames.end(); ++it)
@@ -178,6 +295,7 @@ igsioStatus vtkIGSIOTransformRepository::SetTransforms(igsioTrackedFrame& tracke
     }
   }
 
+  this->ResumeSnapshotPublishing();
   return (numberOfErrors == 0 ? IGSIO_SUCCESS : IGSIO_FAIL);
 }
 
@@ -217,6 +335,7 @@ igsioStatus vtkIGSIOTransformRepository::SetTransform(const igsioTransformName&
     if (matrix != NULL)
     {
       fromToTransformInfo->m_Transform->SetMatrix(matrix);
+      vtkMatrix4x4::DeepCopy(fromToTransformInfo->m_OriginalMatrix, matrix);
     }
     // Set the status of the original transform
     fromToTransformInfo->m_ToolStatus = toolStatus;
@@ -231,6 +350,7 @@ igsioStatus vtkIGSIOTransformRepository::SetTransform(const igsioTransformName&
       return IGSIO_FAIL;
     }
     toFromTransformInfo->m_ToolStatus = toolStatus;
+    this->PublishSnapshot(false);
     return IGSIO_SUCCESS;
   }
   // The transform does not exist yet, add it now
@@ -251,6 +371,7 @@ igsioStatus vtkIGSIOTransformRepository::SetTransform(const igsioTransformName&
   if (matrix != NULL)
   {
     fromCoordFrame[aTransformName.To()].m_Transform->SetMatrix(matrix);
+    vtkMatrix4x4::DeepCopy(fromCoordFrame[aTransformName.To()].m_OriginalMatrix, matrix);
   }
 
   fromCoordFrame[aTransformName.To()].m_ToolStatus = toolStatus;
@@ -261,6 +382,9 @@ igsioStatus vtkIGSIOTransformRepository::SetTransform(const igsioTransformName&
   toCoordFrame[aTransformName.From()].m_Transform->SetInput(fromCoordFrame[aTransformName.To()].m_Transform);
   toCoordFrame[aTransformName.From()].m_Transform->Inverse();
   toCoordFrame[aTransformName.From()].m_ToolStatus = toolStatus;
+
+  // Cached paths and compiled queries are only valid for the previous topology
+  this->PublishSnapshot(true);
   return IGSIO_SUCCESS;
 }
 
@@ -290,33 +414,37 @@ igsioStatus vtkIGSIOTransformRepository::GetTransform(const igsioTransformName&
     {
       matrix->Identity();
     }
+    if (toolStatus != NULL)
+    {
+      *toolStatus = TOOL_OK;
+    }
     return IGSIO_SUCCESS;
   }
 
-  igsioLockGuard<vtkIGSIORecursiveCriticalSection> accessGuard(this->CriticalSection);
+  // Readers use the current snapshot, without locking the repository
+  std::shared_ptr<const Snapshot> snapshot = this->GetSnapshot();
 
   // Check if we can find the transform by combining the input transforms
-  // To improve performance the already found paths could be stored in a map of transform name -> transformInfoList
-  TransformInfoListType transformInfoList;
-  if (FindPath(aTransformName, transformInfoList) != IGSIO_SUCCESS)
+  PathType pathBuffer;
+  const PathType* path = GetGraphPath(*snapshot->Graph, aTransformName, pathBuffer);
+  if (path == NULL)
   {
-    // the transform cannot be computed, error has been already logged by FindPath
-    *toolStatus = TOOL_PATH_NOT_FOUND;
+    LogPathNotFound(*snapshot, aTransformName);
+    if (toolStatus != NULL)
+    {
+      *toolStatus = TOOL_PATH_NOT_FOUND;
+    }
     return IGSIO_FAIL;
   }
 
-  // Create transform chain and compute transform status
-  vtkSmartPointer<vtkTransform> combinedTransform = vtkSmartPointer<vtkTransform>::New();
+  double matrixElements[16];
   ToolStatus combinedToolStatus(TOOL_OK);
-  for (TransformInfoListType::iterator transformInfo = transformInfoList.begin(); transformInfo != transformInfoList.end(); ++transformInfo)
-  {
-    combinedTransform->Concatenate((*transformInfo)->m_Transform);
-    combinedToolStatus = (ToolStatus)std::max(combinedToolStatus, (*transformInfo)->m_ToolStatus); // Not a perfect solution, as one error would overwrite another, but at least it provides some error information
-  }
+  ComputeTransform(*snapshot, *path, matrixElements, combinedToolStatus);
+
   // Save the results
   if (matrix != NULL)
   {
-    matrix->DeepCopy(combinedTransform->GetMatrix());
+    matrix->DeepCopy(matrixElements);
   }
 
   if (toolStatus != NULL)
@@ -327,10 +455,104 @@ igsioStatus vtkIGSIOTransformRepository::GetTransform(const igsioTransformName&
   return IGSIO_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::CompileTransformQuery(const igsioTransformName& aTransformName, TransformQuery& query) const
+{
+  if (!aTransformName.IsValid())
+  {
+    LOG_ERROR("Transform name is invalid");
+    return IGSIO_FAIL;
+  }
+
+  std::shared_ptr<const Snapshot> snapshot = this->GetSnapshot();
+  return this->CompileTransformQueryInternal(*snapshot, aTransformName, query, false);
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::CompileTransformQueryInternal(const Snapshot& snapshot, const igsioTransformName& aTransformName, TransformQuery& query, bool silent) const
+{
+  query.TransformName = aTransformName;
+  query.Steps.clear();
+  query.Repository = this;
+  query.TopologyVersion = 0;
+
+  if (aTransformName.From() != aTransformName.To())
+  {
+    PathType pathBuffer;
+    const PathType* path = GetGraphPath(*snapshot.Graph, aTransformName, pathBuffer);
+    if (path == NULL)
+    {
+      if (!silent)
+      {
+        LogPathNotFound(snapshot, aTransformName);
+      }
+      return IGSIO_FAIL;
+    }
+    query.Steps = *path;
+  }
+
+  query.TopologyVersion = snapshot.Graph->Version;
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::GetTransform(TransformQuery& query, double matrixElements[16], ToolStatus* toolStatus /*=NULL*/) const
+{
+  if (query.Repository != NULL && query.Repository != this)
+  {
+    LOG_ERROR("Transform query " << query.TransformName.GetTransformName() << " was compiled by another transform repository");
+    return IGSIO_FAIL;
+  }
+
+  std::shared_ptr<const Snapshot> snapshot = this->GetSnapshot();
+
+  if (query.TopologyVersion != snapshot->Graph->Version)
+  {
+    // Transforms have been added or deleted since the query was compiled
+    if (!query.TransformName.IsValid() || this->CompileTransformQueryInternal(*snapshot, query.TransformName, query, false) != IGSIO_SUCCESS)
+    {
+      if (toolStatus != NULL)
+      {
+        *toolStatus = TOOL_PATH_NOT_FOUND;
+      }
+      return IGSIO_FAIL;
+    }
+  }
+
+  double combined[16];
+  ToolStatus combinedToolStatus(TOOL_OK);
+  ComputeTransform(*snapshot, query.Steps, combined, combinedToolStatus);
+
+  if (matrixElements != NULL)
+  {
+    std::copy(combined, combined + 16, matrixElements);
+  }
+  if (toolStatus != NULL)
+  {
+    (*toolStatus) = combinedToolStatus;
+  }
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::GetTransform(TransformQuery& query, vtkMatrix4x4* matrix, ToolStatus* toolStatus /*=NULL*/) const
+{
+  double matrixElements[16];
+  if (this->GetTransform(query, matrixElements, toolStatus) != IGSIO_SUCCESS)
+  {
+    return IGSIO_FAIL;
+  }
+  if (matrix != NULL)
+  {
+    matrix->DeepCopy(matrixElements);
+  }
+  return IGSIO_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 igsioStatus vtkIGSIOTransformRepository::GetTransformValid(const igsioTransformName& aTransformName, bool& isValid)
 {
-  ToolStatus status;
+  ToolStatus status(TOOL_UNKNOWN);
   if (GetTransform(aTransformName, NULL, &status) != IGSIO_SUCCESS)
   {
     return IGSIO_FAIL;
@@ -354,6 +576,7 @@ igsioStatus vtkIGSIOTransformRepository::SetTransformPersistent(const igsioTrans
   if (fromToTransformInfo != NULL)
   {
     fromToTransformInfo->m_IsPersistent = isPersistent;
+    this->PublishSnapshot(false);
     return IGSIO_SUCCESS;
   }
   LOG_ERROR("The original " << aTransformName.From() << "To" << aTransformName.To() <<
@@ -487,7 +710,7 @@ igsioStatus vtkIGSIOTransformRepository::FindPath(const igsioTransformName& aTra
     return IGSIO_FAIL;
   }
 
-  TransformInfo* fromToTransformInfo = GetOriginalTransform(aTransformName);
+  const TransformInfo* fromToTransformInfo = GetOriginalTransform(aTransformName);
   if (fromToTransformInfo != NULL)
   {
     // found a transform
@@ -495,8 +718,13 @@ igsioStatus vtkIGSIOTransformRepository::FindPath(const igsioTransformName& aTra
     return IGSIO_SUCCESS;
   }
   // not found, so try to find a path through all the connected coordinate frames
-  CoordFrameToTransformMapType& fromCoordFrame = this->CoordinateFrames[aTransformName.From()];
-  for (CoordFrameToTransformMapType::iterator transformInfoIt = fromCoordFrame.begin(); transformInfoIt != fromCoordFrame.end(); ++transformInfoIt)
+  CoordFrameToCoordFrameToTransformMapType::const_iterator fromCoordFrameIt = this->CoordinateFrames.find(aTransformName.From());
+  if (fromCoordFrameIt == this->CoordinateFrames.end())
+  {
+    return IGSIO_FAIL;
+  }
+  const CoordFrameToTransformMapType& fromCoordFrame = fromCoordFrameIt->second;
+  for (CoordFrameToTransformMapType::const_iterator transformInfoIt = fromCoordFrame.begin(); transformInfoIt != fromCoordFrame.end(); ++transformInfoIt)
   {
     if (skipCoordFrameName != NULL && transformInfoIt->first.compare(skipCoordFrameName) == 0)
     {
@@ -513,48 +741,667 @@ igsioStatus vtkIGSIOTransformRepository::FindPath(const igsioTransformName& aTra
   }
   if (!silent)
   {
-    // Print available transforms into a string, for troubleshooting information
-    std::ostringstream osAvailableTransforms;
-    bool firstPrintedTransform = true;
+    LogPathNotFound(*this->GetSnapshot(), aTransformName);
+  }
+  return IGSIO_FAIL;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::IsExistingTransform(igsioTransformName aTransformName, bool aSilent/* = true*/)
+{
+  if (aTransformName.From() == aTransformName.To())
+  {
+    return IGSIO_SUCCESS;
+  }
+  std::shared_ptr<const Snapshot> snapshot = this->GetSnapshot();
+  PathType pathBuffer;
+  if (GetGraphPath(*snapshot->Graph, aTransformName, pathBuffer) == NULL)
+  {
+    if (!aSilent)
+    {
+      LogPathNotFound(*snapshot, aTransformName);
+    }
+    return IGSIO_FAIL;
+  }
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int vtkIGSIOTransformRepository::GetCoordinateFrameId(const std::string& coordinateFrameName) const
+{
+  std::shared_ptr<const Snapshot> snapshot = this->GetSnapshot();
+  return GetGraphCoordinateFrameId(*snapshot->Graph, coordinateFrameName);
+}
+
+//----------------------------------------------------------------------------
+std::string vtkIGSIOTransformRepository::GetCoordinateFrameName(int coordinateFrameId) const
+{
+  std::shared_ptr<const Snapshot> snapshot = this->GetSnapshot();
+  if (coordinateFrameId < 0 || coordinateFrameId >= static_cast<int>(snapshot->Graph->CoordinateFrameNames.size()))
+  {
+    return "";
+  }
+  return snapshot->Graph->CoordinateFrameNames[coordinateFrameId];
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::GetTransform(int fromCoordinateFrameId, int toCoordinateFrameId, double matrixElements[16], ToolStatus* toolStatus /*=NULL*/) const
+{
+  std::shared_ptr<const Snapshot> snapshot = this->GetSnapshot();
+  const TransformGraph& graph = *snapshot->Graph;
+  int numberOfCoordFrames = static_cast<int>(graph.CoordinateFrameNames.size());
+  if (fromCoordinateFrameId < 0 || fromCoordinateFrameId >= numberOfCoordFrames
+      || toCoordinateFrameId < 0 || toCoordinateFrameId >= numberOfCoordFrames)
+  {
+    LOG_ERROR("Invalid coordinate frame ID: " << fromCoordinateFrameId << " or " << toCoordinateFrameId);
+    if (toolStatus != NULL)
+    {
+      *toolStatus = TOOL_PATH_NOT_FOUND;
+    }
+    return IGSIO_FAIL;
+  }
+
+  if (fromCoordinateFrameId == toCoordinateFrameId)
+  {
+    SetIdentity(matrixElements);
+    if (toolStatus != NULL)
+    {
+      *toolStatus = TOOL_OK;
+    }
+    return IGSIO_SUCCESS;
+  }
+
+  PathType pathBuffer;
+  const PathType* path = GetGraphPath(graph, fromCoordinateFrameId, toCoordinateFrameId, pathBuffer);
+  if (path == NULL)
+  {
+    LogPathNotFound(*snapshot, igsioTransformName(graph.CoordinateFrameNames[fromCoordinateFrameId], graph.CoordinateFrameNames[toCoordinateFrameId]));
+    if (toolStatus != NULL)
+    {
+      *toolStatus = TOOL_PATH_NOT_FOUND;
+    }
+    return IGSIO_FAIL;
+  }
+
+  ToolStatus combinedToolStatus(TOOL_OK);
+  ComputeTransform(*snapshot, *path, matrixElements, combinedToolStatus);
+  if (toolStatus != NULL)
+  {
+    (*toolStatus) = combinedToolStatus;
+  }
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+std::shared_ptr<const vtkIGSIOTransformRepository::Snapshot> vtkIGSIOTransformRepository::GetSnapshot() const
+{
+  return std::atomic_load(&this->CurrentSnapshot);
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTransformRepository::PublishSnapshot(bool topologyChanged)
+{
+  if (this->SnapshotPublishingSuspendCount > 0)
+  {
+    this->SnapshotPublishingPending = true;
+    this->SnapshotTopologyChangePending = this->SnapshotTopologyChangePending || topologyChanged;
+    return;
+  }
+
+  std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+  std::shared_ptr<const Snapshot> previousSnapshot = this->GetSnapshot();
+  if (topologyChanged || previousSnapshot == NULL)
+  {
+    // Number the original transforms and create a new graph, with an empty path cache
+    std::shared_ptr<TransformGraph> graph = std::make_shared<TransformGraph>();
+    graph->Version = ++this->TopologyVersion;
+    graph->PathCacheEnabled = this->TransformPathCacheEnabled;
+    std::vector<std::pair<int, int> > transformCoordFrameIds;
     for (CoordFrameToCoordFrameToTransformMapType::iterator coordFrame = this->CoordinateFrames.begin(); coordFrame != this->CoordinateFrames.end(); ++coordFrame)
     {
       for (CoordFrameToTransformMapType::iterator transformInfo = coordFrame->second.begin(); transformInfo != coordFrame->second.end(); ++transformInfo)
       {
         if (transformInfo->second.m_IsComputed)
         {
-          // only print original transforms
           continue;
         }
-        // don't print separator before the first transform
-        if (firstPrintedTransform)
-        {
-          firstPrintedTransform = false;
-        }
-        else
+        int transformIndex = static_cast<int>(graph->TransformNames.size());
+        transformInfo->second.m_TransformIndex = transformIndex;
+        graph->TransformNames.push_back(std::make_pair(coordFrame->first, transformInfo->first));
+        std::map<std::pair<std::string, std::string>, std::shared_ptr<const TransformHistory> >::const_iterator historyIt =
+          this->TransformHistories.find(graph->TransformNames.back());
+        graph->TransformHistories.push_back(historyIt != this->TransformHistories.end() ? historyIt->second : std::shared_ptr<const TransformHistory>());
+        transformCoordFrameIds.push_back(std::make_pair(this->InternCoordinateFrame(coordFrame->first), this->InternCoordinateFrame(transformInfo->first)));
+      }
+    }
+    graph->CoordinateFrameIds = this->CoordinateFrameIds;
+    graph->CoordinateFrameNames = this->CoordinateFrameNames;
+
+    // Store the transform (from coordinate frame to) and its inverse (to coordinate frame from) in adjacency arrays
+    int numberOfCoordFrames = static_cast<int>(graph->CoordinateFrameNames.size());
+    graph->AdjacencyOffsets.assign(numberOfCoordFrames + 1, 0);
+    for (std::vector<std::pair<int, int> >::const_iterator coordFrameIds = transformCoordFrameIds.begin(); coordFrameIds != transformCoordFrameIds.end(); ++coordFrameIds)
+    {
+      graph->AdjacencyOffsets[coordFrameIds->first + 1]++;
+      graph->AdjacencyOffsets[coordFrameIds->second + 1]++;
+    }
+    for (int coordFrameId = 0; coordFrameId < numberOfCoordFrames; ++coordFrameId)
+    {
+      graph->AdjacencyOffsets[coordFrameId + 1] += graph->AdjacencyOffsets[coordFrameId];
+    }
+    graph->AdjacentCoordinateFrameIds.resize(graph->AdjacencyOffsets[numberOfCoordFrames]);
+    graph->AdjacentSteps.resize(graph->AdjacencyOffsets[numberOfCoordFrames]);
+    std::vector<int> nextAdjacencyIndex(graph->AdjacencyOffsets.begin(), graph->AdjacencyOffsets.end() - 1);
+    for (int transformIndex = 0; transformIndex < static_cast<int>(transformCoordFrameIds.size()); ++transformIndex)
+    {
+      int fromCoordFrameId = transformCoordFrameIds[transformIndex].first;
+      int toCoordFrameId = transformCoordFrameIds[transformIndex].second;
+      PathStep forwardStep = { transformIndex, false };
+      PathStep inverseStep = { transformIndex, true };
+      int forwardIndex = nextAdjacencyIndex[fromCoordFrameId]++;
+      graph->AdjacentCoordinateFrameIds[forwardIndex] = toCoordFrameId;
+      graph->AdjacentSteps[forwardIndex] = forwardStep;
+      int inverseIndex = nextAdjacencyIndex[toCoordFrameId]++;
+      graph->AdjacentCoordinateFrameIds[inverseIndex] = fromCoordFrameId;
+      graph->AdjacentSteps[inverseIndex] = inverseStep;
+    }
+    snapshot->Graph = graph;
+  }
+  else
+  {
+    snapshot->Graph = previousSnapshot->Graph;
+  }
+
+  // Copy the matrices of the original transforms
+  snapshot->Transforms.resize(snapshot->Graph->TransformNames.size());
+  for (CoordFrameToCoordFrameToTransformMapType::const_iterator coordFrame = this->CoordinateFrames.begin(); coordFrame != this->CoordinateFrames.end(); ++coordFrame)
+  {
+    for (CoordFrameToTransformMapType::const_iterator transformInfo = coordFrame->second.begin(); transformInfo != coordFrame->second.end(); ++transformInfo)
+    {
+      if (transformInfo->second.m_IsComputed)
+      {
+        continue;
+      }
+      TransformState& state = snapshot->Transforms[transformInfo->second.m_TransformIndex];
+      std::copy(transformInfo->second.m_OriginalMatrix, transformInfo->second.m_OriginalMatrix + 16, state.Matrix);
+      state.Status = transformInfo->second.m_ToolStatus;
+      state.IsPersistent = transformInfo->second.m_IsPersistent;
+    }
+  }
+
+  std::atomic_store(&this->CurrentSnapshot, std::shared_ptr<const Snapshot>(snapshot));
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTransformRepository::SuspendSnapshotPublishing()
+{
+  this->SnapshotPublishingSuspendCount++;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTransformRepository::ResumeSnapshotPublishing()
+{
+  if (this->SnapshotPublishingSuspendCount <= 0)
+  {
+    LOG_ERROR("vtkIGSIOTransformRepository::ResumeSnapshotPublishing called without SuspendSnapshotPublishing");
+    return;
+  }
+  this->SnapshotPublishingSuspendCount--;
+  if (this->SnapshotPublishingSuspendCount == 0 && this->SnapshotPublishingPending)
+  {
+    bool topologyChanged = this->SnapshotTopologyChangePending;
+    this->SnapshotPublishingPending = false;
+    this->SnapshotTopologyChangePending = false;
+    this->PublishSnapshot(topologyChanged);
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkIGSIOTransformRepository::InternCoordinateFrame(const std::string& coordFrameName)
+{
+  std::map<std::string, int>::const_iterator coordFrameIdIt = this->CoordinateFrameIds.find(coordFrameName);
+  if (coordFrameIdIt != this->CoordinateFrameIds.end())
+  {
+    return coordFrameIdIt->second;
+  }
+  int coordFrameId = static_cast<int>(this->CoordinateFrameNames.size());
+  this->CoordinateFrameNames.push_back(coordFrameName);
+  this->CoordinateFrameIds[coordFrameName] = coordFrameId;
+  return coordFrameId;
+}
+
+//----------------------------------------------------------------------------
+int vtkIGSIOTransformRepository::GetGraphCoordinateFrameId(const TransformGraph& graph, const std::string& coordFrameName)
+{
+  std::map<std::string, int>::const_iterator coordFrameIdIt = graph.CoordinateFrameIds.find(coordFrameName);
+  if (coordFrameIdIt == graph.CoordinateFrameIds.end())
+  {
+    return -1;
+  }
+  return coordFrameIdIt->second;
+}
+
+//----------------------------------------------------------------------------
+const vtkIGSIOTransformRepository::PathType* vtkIGSIOTransformRepository::GetGraphPath(const TransformGraph& graph, const igsioTransformName& aTransformName, PathType& pathBuffer)
+{
+  int fromCoordFrameId = GetGraphCoordinateFrameId(graph, aTransformName.From());
+  int toCoordFrameId = GetGraphCoordinateFrameId(graph, aTransformName.To());
+  if (fromCoordFrameId < 0 || toCoordFrameId < 0)
+  {
+    return NULL;
+  }
+  return GetGraphPath(graph, fromCoordFrameId, toCoordFrameId, pathBuffer);
+}
+
+//----------------------------------------------------------------------------
+const vtkIGSIOTransformRepository::PathType* vtkIGSIOTransformRepository::GetGraphPath(const TransformGraph& graph, int fromCoordFrameId, int toCoordFrameId, PathType& pathBuffer)
+{
+  std::pair<int, int> fromTo(fromCoordFrameId, toCoordFrameId);
+  if (graph.PathCacheEnabled)
+  {
+    std::shared_ptr<const TransformGraph::PathMapType> cachedPaths = std::atomic_load(&graph.PathCache);
+    TransformGraph::PathMapType::const_iterator cachedPathIt = cachedPaths->find(fromTo);
+    if (cachedPathIt != cachedPaths->end())
+    {
+      // Cached paths are never removed from the graph (the current map contains all paths that have been added),
+      // so the path remains valid while the graph exists
+      return cachedPathIt->second.get();
+    }
+  }
+
+  pathBuffer.clear();
+  if (!FindGraphPath(graph, fromCoordFrameId, toCoordFrameId, -1, pathBuffer))
+  {
+    // Failed searches are not cached, the graph is replaced when a transform is added
+    return NULL;
+  }
+  if (!graph.PathCacheEnabled)
+  {
+    return &pathBuffer;
+  }
+
+  std::lock_guard<std::mutex> lock(graph.PathCacheInsertMutex);
+  std::shared_ptr<const TransformGraph::PathMapType> cachedPaths = std::atomic_load(&graph.PathCache);
+  TransformGraph::PathMapType::const_iterator cachedPathIt = cachedPaths->find(fromTo);
+  if (cachedPathIt != cachedPaths->end())
+  {
+    // Another reader has added the same path in the meantime, then that one is kept
+    return cachedPathIt->second.get();
+  }
+  std::shared_ptr<TransformGraph::PathMapType> updatedPaths = std::make_shared<TransformGraph::PathMapType>(*cachedPaths);
+  std::shared_ptr<const PathType> cachedPath = std::make_shared<const PathType>(pathBuffer);
+  updatedPaths->insert(std::make_pair(fromTo, cachedPath));
+  std::atomic_store(&graph.PathCache, std::shared_ptr<const TransformGraph::PathMapType>(updatedPaths));
+  return cachedPath.get();
+}
+
+//----------------------------------------------------------------------------
+bool vtkIGSIOTransformRepository::FindGraphPath(const TransformGraph& graph, int fromCoordFrameId, int toCoordFrameId, int skipCoordFrameId, PathType& path)
+{
+  int firstAdjacencyIndex = graph.AdjacencyOffsets[fromCoordFrameId];
+  int lastAdjacencyIndex = graph.AdjacencyOffsets[fromCoordFrameId + 1];
+  for (int adjacencyIndex = firstAdjacencyIndex; adjacencyIndex < lastAdjacencyIndex; ++adjacencyIndex)
+  {
+    if (graph.AdjacentCoordinateFrameIds[adjacencyIndex] == toCoordFrameId)
+    {
+      path.push_back(graph.AdjacentSteps[adjacencyIndex]);
+      return true;
+    }
+  }
+  // Try to find a path through all the connected coordinate frames (the graph has no cycles, so the path is unique)
+  for (int adjacencyIndex = firstAdjacencyIndex; adjacencyIndex < lastAdjacencyIndex; ++adjacencyIndex)
+  {
+    int adjacentCoordFrameId = graph.AdjacentCoordinateFrameIds[adjacencyIndex];
+    if (adjacentCoordFrameId == skipCoordFrameId)
+    {
+      // don't go back to the coordinate frame where we come from
+      continue;
+    }
+    if (FindGraphPath(graph, adjacentCoordFrameId, toCoordFrameId, fromCoordFrameId, path))
+    {
+      path.push_back(graph.AdjacentSteps[adjacencyIndex]);
+      return true;
+    }
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTransformRepository::ComputeTransform(const Snapshot& snapshot, const PathType& path, double matrixElements[16], ToolStatus& toolStatus)
+{
+  // Multiply the matrices in the same order as FindPath lists them (as a vtkTransform would concatenate them)
+  double inverse[16];
+  double product[16];
+  SetIdentity(matrixElements);
+  toolStatus = TOOL_OK;
+  for (PathType::const_iterator step = path.begin(); step != path.end(); ++step)
+  {
+    const TransformState& state = snapshot.Transforms[step->TransformIndex];
+    const double* stepMatrix = state.Matrix;
+    if (step->Inverse)
+    {
+      InvertMatrix(stepMatrix, inverse);
+      stepMatrix = inverse;
+    }
+    MultiplyMatrices(matrixElements, stepMatrix, product);
+    std::copy(product, product + 16, matrixElements);
+    toolStatus = (ToolStatus)std::max(toolStatus, state.Status); // Not a perfect solution, as one error would overwrite another, but at least it provides some error information
+  }
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::ComputeTransform(const Snapshot& snapshot, const PathType& path, double timestamp, bool interpolate, double matrixElements[16], ToolStatus& toolStatus)
+{
+  double stepMatrixAtTime[16];
+  double inverse[16];
+  double product[16];
+  SetIdentity(matrixElements);
+  toolStatus = TOOL_OK;
+  for (PathType::const_iterator step = path.begin(); step != path.end(); ++step)
+  {
+    const TransformState& state = snapshot.Transforms[step->TransformIndex];
+    const double* stepMatrix = state.Matrix;
+    ToolStatus stepStatus = state.Status;
+    const TransformHistory* history = snapshot.Graph->TransformHistories[step->TransformIndex].get();
+    if (history != NULL)
+    {
+      if (GetTransformFromHistory(*history, timestamp, interpolate, stepMatrixAtTime, stepStatus) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("Unable to get " << snapshot.Graph->TransformNames[step->TransformIndex].first << "To" << snapshot.Graph->TransformNames[step->TransformIndex].second
+                  << " transform at time " << std::fixed << timestamp << " - time is out of the range of the transform history");
+        return IGSIO_FAIL;
+      }
+      stepMatrix = stepMatrixAtTime;
+    }
+    if (step->Inverse)
+    {
+      InvertMatrix(stepMatrix, inverse);
+      stepMatrix = inverse;
+    }
+    MultiplyMatrices(matrixElements, stepMatrix, product);
+    std::copy(product, product + 16, matrixElements);
+    toolStatus = (ToolStatus)std::max(toolStatus, stepStatus);
+  }
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::GetTransformFromHistory(const TransformHistory& history, double timestamp, bool interpolate, double matrixElements[16], ToolStatus& toolStatus)
+{
+  if (history.Timestamps.empty() || timestamp < history.Timestamps.front() || timestamp > history.Timestamps.back())
+  {
+    return IGSIO_FAIL;
+  }
+
+  // First frame that is not earlier than the requested time
+  size_t indexAfter = std::lower_bound(history.Timestamps.begin(), history.Timestamps.end(), timestamp) - history.Timestamps.begin();
+  size_t indexBefore = (indexAfter > 0 && history.Timestamps[indexAfter] != timestamp ? indexAfter - 1 : indexAfter);
+  double timeBefore = history.Timestamps[indexBefore];
+  double timeAfter = history.Timestamps[indexAfter];
+  const double* matrixBefore = &history.Matrices[16 * indexBefore];
+  const double* matrixAfter = &history.Matrices[16 * indexAfter];
+
+  if (indexBefore == indexAfter || timeAfter - timeBefore <= 0)
+  {
+    std::copy(matrixAfter, matrixAfter + 16, matrixElements);
+    toolStatus = history.Statuses[indexAfter];
+    return IGSIO_SUCCESS;
+  }
+
+  if (!interpolate)
+  {
+    // Closest frame
+    size_t closestIndex = (timestamp - timeBefore <= timeAfter - timestamp ? indexBefore : indexAfter);
+    std::copy(&history.Matrices[16 * closestIndex], &history.Matrices[16 * closestIndex] + 16, matrixElements);
+    toolStatus = history.Statuses[closestIndex];
+    return IGSIO_SUCCESS;
+  }
+
+  double weightAfter = (timestamp - timeBefore) / (timeAfter - timeBefore);
+  igsioMath::InterpolateRigidTransform(matrixBefore, matrixAfter, weightAfter, matrixElements);
+  toolStatus = (history.Statuses[indexBefore] != TOOL_OK ? history.Statuses[indexBefore] : history.Statuses[indexAfter]);
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTransformRepository::LogPathNotFound(const Snapshot& snapshot, const igsioTransformName& aTransformName)
+{
+  // Print available transforms into a string, for troubleshooting information
+  std::ostringstream osAvailableTransforms;
+  for (size_t transformIndex = 0; transformIndex < snapshot.Graph->TransformNames.size(); ++transformIndex)
+  {
+    // don't print separator before the first transform
+    if (transformIndex > 0)
+    {
+      osAvailableTransforms << ", ";
+    }
+    const TransformState& state = snapshot.Transforms[transformIndex];
+    osAvailableTransforms << snapshot.Graph->TransformNames[transformIndex].first << "To" << snapshot.Graph->TransformNames[transformIndex].second << " ("
+                          << (state.Status == TOOL_OK ? "valid" : "invalid") << ", "
+                          << (state.IsPersistent ? "persistent" : "non-persistent") << ")";
+  }
+  LOG_ERROR("Transform path not found from " << aTransformName.From() << " to " << aTransformName.To() << " coordinate system."
+            << " Available transforms in the repository (including the inverse of these transforms): " << osAvailableTransforms.str());
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::SetTransformHistory(vtkIGSIOTrackedFrameList* trackedFrameList)
+{
+  if (trackedFrameList == NULL)
+  {
+    LOG_ERROR("Unable to set transform history - tracked frame list is NULL");
+    return IGSIO_FAIL;
+  }
+
+  // Frames sorted by time and the names of all frame transforms
+  std::vector<std::pair<double, unsigned int> > frameTimes;
+  std::set<std::pair<std::string, std::string> > frameTransformNames;
+  for (unsigned int frameIndex = 0; frameIndex < trackedFrameList->GetNumberOfTrackedFrames(); ++frameIndex)
+  {
+    igsioTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(frameIndex);
+    frameTimes.push_back(std::make_pair(trackedFrame->GetTimestamp(), frameIndex));
+    std::vector<igsioTransformName> transformNames;
+    trackedFrame->GetFrameTransformNameList(transformNames);
+    for (std::vector<igsioTransformName>::iterator transformName = transformNames.begin(); transformName != transformNames.end(); ++transformName)
+    {
+      frameTransformNames.insert(std::make_pair(transformName->From(), transformName->To()));
+    }
+  }
+  std::stable_sort(frameTimes.begin(), frameTimes.end(), TimestampLess);
+
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> accessGuard(this->CriticalSection);
+  this->SuspendSnapshotPublishing();
+
+  int numberOfErrors(0);
+  std::map<std::pair<std::string, std::string>, std::shared_ptr<const TransformHistory> > transformHistories;
+  for (std::set<std::pair<std::string, std::string> >::iterator frameTransformName = frameTransformNames.begin(); frameTransformName != frameTransformNames.end(); ++frameTransformName)
+  {
+    igsioTransformName transformName(frameTransformName->first, frameTransformName->second);
+    if (!transformName.IsValid() || transformName.From() == transformName.To())
+    {
+      continue;
+    }
+
+    // The history is stored for the original transform, so the frame values have to be inverted if the inverse is the original
+    std::pair<std::string, std::string> originalTransformName = *frameTransformName;
+    bool invert = false;
+    TransformInfo* transformInfo = this->GetOriginalTransform(transformName);
+    if (transformInfo == NULL)
+    {
+      // Add the transform with its first value, so that it becomes part of the coordinate frame graph
+      double firstMatrixElements[16];
+      ToolStatus firstStatus(TOOL_INVALID);
+      igsioTrackedFrame* firstFrame = trackedFrameList->GetTrackedFrame(frameTimes.front().second);
+      vtkSmartPointer<vtkMatrix4x4> firstMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      if (firstFrame->GetFrameTransform(transformName, firstMatrixElements) == IGSIO_SUCCESS)
+      {
+        firstMatrix->DeepCopy(firstMatrixElements);
+        firstFrame->GetFrameTransformStatus(transformName, firstStatus);
+      }
+      if (this->SetTransform(transformName, firstMatrix, firstStatus) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("Unable to add " << transformName.GetTransformName() << " transform history to the repository");
+        numberOfErrors++;
+        continue;
+      }
+    }
+    else if (transformInfo->m_IsComputed)
+    {
+      originalTransformName = std::make_pair(transformName.To(), transformName.From());
+      invert = true;
+    }
+
+    std::shared_ptr<TransformHistory> history = std::make_shared<TransformHistory>();
+    history->Timestamps.reserve(frameTimes.size());
+    history->Matrices.resize(16 * frameTimes.size());
+    history->Statuses.reserve(frameTimes.size());
+    for (size_t i = 0; i < frameTimes.size(); ++i)
+    {
+      igsioTrackedFrame* trackedFrame = trackedFrameList->GetTrackedFrame(frameTimes[i].second);
+      double* matrixElements = &history->Matrices[16 * i];
+      ToolStatus status(TOOL_INVALID);
+      if (trackedFrame->GetFrameTransform(transformName, matrixElements) == IGSIO_SUCCESS)
+      {
+        trackedFrame->GetFrameTransformStatus(transformName, status);
+        if (invert)
         {
-          osAvailableTransforms << ", ";
+          double frameMatrixElements[16];
+          std::copy(matrixElements, matrixElements + 16, frameMatrixElements);
+          InvertMatrix(frameMatrixElements, matrixElements);
         }
-        osAvailableTransforms << coordFrame->first << "To" << transformInfo->first << " ("
-                              << (transformInfo->second.IsValid() ? "valid" : "invalid") << ", "
-                              << (transformInfo->second.m_IsPersistent ? "persistent" : "non-persistent") << ")";
       }
+      else
+      {
+        // The transform is not defined in this frame
+        SetIdentity(matrixElements);
+      }
+      history->Timestamps.push_back(frameTimes[i].first);
+      history->Statuses.push_back(status);
+    }
+    transformHistories[originalTransformName] = history;
+  }
+
+  this->TransformHistories.swap(transformHistories);
+  this->PublishSnapshot(true);
+  this->ResumeSnapshotPublishing();
+  return (numberOfErrors == 0 ? IGSIO_SUCCESS : IGSIO_FAIL);
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTransformRepository::ClearTransformHistory()
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> accessGuard(this->CriticalSection);
+  this->TransformHistories.clear();
+  this->PublishSnapshot(true);
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::GetTransformHistoryTimeRange(double& startTime, double& endTime) const
+{
+  std::shared_ptr<const Snapshot> snapshot = this->GetSnapshot();
+  for (size_t transformIndex = 0; transformIndex < snapshot->Graph->TransformHistories.size(); ++transformIndex)
+  {
+    const TransformHistory* history = snapshot->Graph->TransformHistories[transformIndex].get();
+    if (history != NULL && !history->Timestamps.empty())
+    {
+      // All histories are from the same frames
+      startTime = history->Timestamps.front();
+      endTime = history->Timestamps.back();
+      return IGSIO_SUCCESS;
     }
-    LOG_ERROR("Transform path not found from " << aTransformName.From() << " to " << aTransformName.To() << " coordinate system."
-              << " Available transforms in the repository (including the inverse of these transforms): " << osAvailableTransforms.str());
   }
   return IGSIO_FAIL;
 }
 
 //----------------------------------------------------------------------------
-igsioStatus vtkIGSIOTransformRepository::IsExistingTransform(igsioTransformName aTransformName, bool aSilent/* = true*/)
+igsioStatus vtkIGSIOTransformRepository::GetTransformAtTime(const igsioTransformName& aTransformName, double timestamp, double matrixElements[16], ToolStatus* toolStatus /*=NULL*/, bool interpolate /*=false*/) const
 {
+  if (!aTransformName.IsValid())
+  {
+    LOG_ERROR("Transform name is invalid");
+    return IGSIO_FAIL;
+  }
+
+  double combined[16];
+  ToolStatus combinedToolStatus(TOOL_OK);
   if (aTransformName.From() == aTransformName.To())
   {
-    return IGSIO_SUCCESS;
+    SetIdentity(combined);
   }
+  else
+  {
+    std::shared_ptr<const Snapshot> snapshot = this->GetSnapshot();
+    PathType pathBuffer;
+    const PathType* path = GetGraphPath(*snapshot->Graph, aTransformName, pathBuffer);
+    if (path == NULL)
+    {
+      LogPathNotFound(*snapshot, aTransformName);
+      if (toolStatus != NULL)
+      {
+        *toolStatus = TOOL_PATH_NOT_FOUND;
+      }
+      return IGSIO_FAIL;
+    }
+    if (ComputeTransform(*snapshot, *path, timestamp, interpolate, combined, combinedToolStatus) != IGSIO_SUCCESS)
+    {
+      if (toolStatus != NULL)
+      {
+        *toolStatus = TOOL_INVALID;
+      }
+      return IGSIO_FAIL;
+    }
+  }
+
+  if (matrixElements != NULL)
+  {
+    std::copy(combined, combined + 16, matrixElements);
+  }
+  if (toolStatus != NULL)
+  {
+    (*toolStatus) = combinedToolStatus;
+  }
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkIGSIOTransformRepository::GetTransformAtTime(const igsioTransformName& aTransformName, double timestamp, vtkMatrix4x4* matrix, ToolStatus* toolStatus /*=NULL*/, bool interpolate /*=false*/) const
+{
+  double matrixElements[16];
+  if (this->GetTransformAtTime(aTransformName, timestamp, matrixElements, toolStatus, interpolate) != IGSIO_SUCCESS)
+  {
+    return IGSIO_FAIL;
+  }
+  if (matrix != NULL)
+  {
+    matrix->DeepCopy(matrixElements);
+  }
+  return IGSIO_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkIGSIOTransformRepository::SetTransformPathCacheEnabled(bool enabled)
+{
   igsioLockGuard<vtkIGSIORecursiveCriticalSection> accessGuard(this->CriticalSection);
-  TransformInfoListType transformInfoList;
-  return FindPath(aTransformName, transformInfoList, NULL, aSilent);
+  this->TransformPathCacheEnabled = enabled;
+  // Start with a new, empty path cache
+  this->PublishSnapshot(true);
+}
+
+//----------------------------------------------------------------------------
+bool vtkIGSIOTransformRepository::GetTransformPathCacheEnabled() const
+{
+  return this->TransformPathCacheEnabled;
+}
+
+//----------------------------------------------------------------------------
+int vtkIGSIOTransformRepository::GetNumberOfCachedTransformPaths() const
+{
+  std::shared_ptr<const Snapshot> snapshot = this->GetSnapshot();
+  if (!snapshot->Graph->PathCacheEnabled)
+  {
+    return 0;
+  }
+  return static_cast<int>(std::atomic_load(&snapshot->Graph->PathCache)->size());
 }
 
 //----------------------------------------------------------------------------
@@ -568,31 +1415,37 @@ igsioStatus vtkIGSIOTransformRepository::DeleteTransform(const igsioTransformNam
 
   igsioLockGuard<vtkIGSIORecursiveCriticalSection> accessGuard(this->CriticalSection);
 
-  CoordFrameToTransformMapType& fromCoordFrame = this->CoordinateFrames[aTransformName.From()];
-  CoordFrameToTransformMapType::iterator fromToTransformInfoIt = fromCoordFrame.find(aTransformName.To());
-
-  if (fromToTransformInfoIt != fromCoordFrame.end())
+  // Look up the coordinate frames without inserting them, unknown frames must not appear in the repository
+  CoordFrameToCoordFrameToTransformMapType::iterator fromCoordFrameIt = this->CoordinateFrames.find(aTransformName.From());
+  CoordFrameToCoordFrameToTransformMapType::iterator toCoordFrameIt = this->CoordinateFrames.find(aTransformName.To());
+  if (fromCoordFrameIt == this->CoordinateFrames.end() || toCoordFrameIt == this->CoordinateFrames.end())
   {
-    // from->to transform is found
-    if (fromToTransformInfoIt->second.m_IsComputed)
-    {
-      // this is not an original transform (has not been set by the user)
-      LOG_ERROR("The " << aTransformName.From() << " to " << aTransformName.To()
-                << " transform cannot be deleted, only the inverse of the transform has been set in the repository ("
-                << aTransformName.From() << " to " << aTransformName.To() << ")");
-      return IGSIO_FAIL;
-    }
-    fromCoordFrame.erase(fromToTransformInfoIt);
+    LOG_ERROR("Delete transform failed: could not find the " << aTransformName.From() << " to " << aTransformName.To() << " transform");
+    return IGSIO_FAIL;
   }
-  else
+
+  CoordFrameToTransformMapType& fromCoordFrame = fromCoordFrameIt->second;
+  CoordFrameToTransformMapType::iterator fromToTransformInfoIt = fromCoordFrame.find(aTransformName.To());
+  if (fromToTransformInfoIt == fromCoordFrame.end())
   {
     LOG_ERROR("Delete transform failed: could not find the " << aTransformName.From() << " to " << aTransformName.To() << " transform");
-    // don't return yet, try to delete the inverse
     return IGSIO_FAIL;
   }
+  // from->to transform is found
+  if (fromToTransformInfoIt->second.m_IsComputed)
+  {
+    // this is not an original transform (has not been set by the user)
+    LOG_ERROR("The " << aTransformName.From() << " to " << aTransformName.To()
+              << " transform cannot be deleted, only the inverse of the transform has been set in the repository ("
+              << aTransformName.From() << " to " << aTransformName.To() << ")");
+    return IGSIO_FAIL;
+  }
+  fromCoordFrame.erase(fromToTransformInfoIt);
+  this->TransformHistories.erase(std::make_pair(aTransformName.From(), aTransformName.To()));
 
-  CoordFrameToTransformMapType& toCoordFrame = this->CoordinateFrames[aTransformName.To()];
+  CoordFrameToTransformMapType& toCoordFrame = toCoordFrameIt->second;
   CoordFrameToTransformMapType::iterator toFromTransformInfoIt = toCoordFrame.find(aTransformName.From());
+  igsioStatus status = IGSIO_SUCCESS;
   if (toFromTransformInfoIt != toCoordFrame.end())
   {
     // to->from transform is found
@@ -601,15 +1454,21 @@ igsioStatus vtkIGSIOTransformRepository::DeleteTransform(const igsioTransformNam
   else
   {
     LOG_ERROR("Delete transform failed: could not find the " << aTransformName.To() << " to " << aTransformName.From() << " transform");
-    return IGSIO_FAIL;
+    status = IGSIO_FAIL;
   }
-  return IGSIO_SUCCESS;
+
+  // Cached paths and compiled queries may refer to the deleted transforms
+  this->PublishSnapshot(true);
+  return status;
 }
 
 //----------------------------------------------------------------------------
 void vtkIGSIOTransformRepository::Clear()
 {
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> accessGuard(this->CriticalSection);
   this->CoordinateFrames.clear();
+  this->TransformHistories.clear();
+  this->PublishSnapshot(true);
 }
 
 //----------------------------------------------------------------------------
@@ -628,6 +1487,9 @@ igsioStatus vtkIGSIOTransformRepository::ReadConfiguration(vtkXMLDataElement* co
     return IGSIO_SUCCESS;
   }
 
+  // Publish all transforms at once
+  this->SuspendSnapshotPublishing();
+
   int numberOfErrors(0);
   for (int nestedElementIndex = 0; nestedElementIndex < coordinateDefinitions->GetNumberOfNestedElements(); ++nestedElementIndex)
   {
@@ -714,6 +1576,7 @@ igsioStatus vtkIGSIOTransformRepository::ReadConfiguration(vtkXMLDataElement* co
       continue;
     }
   }
+  this->ResumeSnapshotPublishing();
   return (numberOfErrors == 0 ? IGSIO_SUCCESS : IGSIO_FAIL);
 }
 
@@ -740,6 +1603,8 @@ igsioStatus vtkIGSIOTransformRepository::WriteConfigurationGeneric(vtkXMLDataEle
     configRootElement->AddNestedElement(coordinateDefinitions);
   }
 
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> accessGuard(this->CriticalSection);
+
   int numberOfErrors(0);
   for (CoordFrameToCoordFrameToTransformMapType::iterator coordFrame = this->CoordinateFrames.begin(); coordFrame != this->CoordinateFrames.end(); ++coordFrame)
   {
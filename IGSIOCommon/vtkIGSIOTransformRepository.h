@@ -19,8 +19,13 @@ See License.txt for details.
 // STL includes
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 class igsioTrackedFrame;
+class vtkIGSIOTrackedFrameList;
 class vtkMatrix4x4;
 class vtkIGSIORecursiveCriticalSection;
 class vtkTransform;
@@ -50,11 +55,88 @@ The following coordinate frames are used commonly:
   \li Tracker: coordinate system of the tracker, unit is mm
   \li World: world coordinate system, orientation is usually patient RAS, unit is mm
 
+Transform paths found by GetTransform are cached, so repeated queries of the same transform
+(e.g., ImageToReference for each frame) don't have to search the coordinate frame graph.
+The cache is cleared when a transform is added or deleted. Updating the matrix or status of an existing
+transform does not change the path, so the cache is kept.
+
+Methods that get transforms (GetTransform, GetTransformValid, IsExistingTransform, CompileTransformQuery) never lock
+the repository and never block the thread that sets the transforms. Every change is published as a new immutable
+snapshot of the transforms, and readers compute the result from the snapshot that was current when they started.
+SetTransforms publishes all transforms of the tracked frame in one snapshot, so readers never see a partially updated frame.
+Other methods (setting transforms, reading and writing the configuration, etc.) are serialized by a critical section.
+
+A recorded sequence can be processed without calling SetTransforms for each frame: SetTransformHistory stores the
+frame transforms of a whole tracked frame list as time series, then GetTransformAtTime computes any transform
+at any time of the recording (optionally interpolated), without modifying the repository.
+
+Loops that query the same transform many times (e.g., volume reconstruction, calibration) can compile
+the query into a TransformQuery once and then get the transform from that. Getting a transform from a compiled
+query only multiplies the stored matrices, without creating or updating any VTK objects:
+\code
+  vtkIGSIOTransformRepository::TransformQuery imageToReferenceQuery;
+  transformRepository->CompileTransformQuery(igsioTransformName("Image", "Reference"), imageToReferenceQuery);
+  for (...)
+  {
+    transformRepository->SetTransforms(trackedFrame);
+    transformRepository->GetTransform(imageToReferenceQuery, mxImageToReference, &status);
+  }
+\endcode
+
+Coordinate frame names are interned into integer IDs, and the coordinate frame graph that readers search is stored
+as adjacency arrays of these IDs. Code that gets transforms in a tight loop can look up the IDs once
+(GetCoordinateFrameId) and then get the transforms by ID, without any string comparison or allocation:
+\code
+  int imageId = transformRepository->GetCoordinateFrameId("Image");
+  int referenceId = transformRepository->GetCoordinateFrameId("Reference");
+  for (...)
+  {
+    transformRepository->SetTransforms(trackedFrame);
+    transformRepository->GetTransform(imageId, referenceId, imageToReferenceElements, &status);
+  }
+\endcode
+
 \ingroup PlusLibCommon
 */
 class VTKIGSIOCOMMON_EXPORT vtkIGSIOTransformRepository : public vtkObject
 {
+protected:
+  /*! A transform in a transform path: index of the original transform in the snapshot and if its inverse is used */
+  struct PathStep
+  {
+    int TransformIndex;
+    bool Inverse;
+  };
+  typedef std::vector<PathStep> PathType;
+
 public:
+  /*!
+    \class TransformQuery
+    \brief Transform path resolved by CompileTransformQuery: the ordered list of original transform matrices and inverse flags
+    If a transform is added to or deleted from the repository then the query is recompiled automatically on the next GetTransform call.
+    A query can only be used with the repository that compiled it.
+    \ingroup PlusLibCommon
+  */
+  class VTKIGSIOCOMMON_EXPORT TransformQuery
+  {
+  public:
+    TransformQuery();
+
+    /*! Name of the transform that the query computes */
+    const igsioTransformName& GetTransformName() const { return this->TransformName; }
+
+    /*! Number of transforms that are multiplied to compute the transform (0 for identity) */
+    int GetNumberOfTransforms() const { return static_cast<int>(this->Steps.size()); }
+
+  protected:
+    friend class vtkIGSIOTransformRepository;
+
+    igsioTransformName TransformName;
+    PathType Steps;
+    const vtkIGSIOTransformRepository* Repository;
+    unsigned long TopologyVersion;
+  };
+
   static vtkIGSIOTransformRepository* New();
   vtkTypeMacro(vtkIGSIOTransformRepository, vtkObject);
   virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
@@ -144,12 +226,87 @@ public:
   /*! Removes all the transforms from the repository */
   void Clear();
 
+  /*!
+    Resolve the transform path between two coordinate frames once, for fast repeated GetTransform calls.
+    The method fails if the transform cannot be constructed from the stored transforms.
+  */
+  igsioStatus CompileTransformQuery(const igsioTransformName& aTransformName, TransformQuery& query) const;
+
+  /*!
+    Get a transform matrix using a compiled query. The result is the same as GetTransform with the transform name,
+    but no VTK objects are created or updated and the transform path is not searched.
+    Inverse of rigid transforms is computed by transposing the rotation.
+    \param query compiled transform query, it is recompiled if the transforms in the repository have been added or deleted since it was compiled
+    \param matrixElements the retrieved transform is copied into this row-major array
+    \param toolStatus if this parameter is not NULL then the transforms' status is returned at that memory address
+  */
+  igsioStatus GetTransform(TransformQuery& query, double matrixElements[16], ToolStatus* toolStatus = NULL) const;
+  /*! Get a transform matrix using a compiled query. See GetTransform(TransformQuery&, double*, ToolStatus*) */
+  igsioStatus GetTransform(TransformQuery& query, vtkMatrix4x4* matrix, ToolStatus* toolStatus = NULL) const;
+
+  /*!
+    Get the ID of a coordinate frame, for getting transforms by coordinate frame IDs. An ID is assigned when the coordinate frame
+    first appears in a transform of the repository and it is never changed or reused, not even if the transforms of the coordinate frame are deleted.
+    \return the coordinate frame ID or -1 if the coordinate frame has never been in the repository
+  */
+  int GetCoordinateFrameId(const std::string& coordinateFrameName) const;
+
+  /*! Get the name of a coordinate frame from its ID. Returns an empty string if the ID is unknown. */
+  std::string GetCoordinateFrameName(int coordinateFrameId) const;
+
+  /*!
+    Get a transform matrix between two coordinate frames specified by their IDs. The result is the same as GetTransform with the transform name,
+    but coordinate frame names are not looked up and no VTK objects are created or updated.
+    \param fromCoordinateFrameId ID of the 'From' coordinate frame, see GetCoordinateFrameId
+    \param toCoordinateFrameId ID of the 'To' coordinate frame, see GetCoordinateFrameId
+    \param matrixElements the retrieved transform is copied into this row-major array
+    \param toolStatus if this parameter is not NULL then the transforms' status is returned at that memory address
+  */
+  igsioStatus GetTransform(int fromCoordinateFrameId, int toCoordinateFrameId, double matrixElements[16], ToolStatus* toolStatus = NULL) const;
+
   /*! Checks if a transform exist */
   virtual igsioStatus IsExistingTransform(const igsioTransformName aTransformName, bool aSilent = true);
 
+  /*!
+    Store the frame transforms of all frames of a tracked frame list as time series, for getting transforms at any
+    time of the recording by GetTransformAtTime. Frame transforms that are not in the repository yet are added
+    (with their value in the first frame). Transforms that are not in the frames (e.g., calibration transforms) are constant,
+    their current value is used at all times. The previously stored history is replaced.
+  */
+  igsioStatus SetTransformHistory(vtkIGSIOTrackedFrameList* trackedFrameList);
+
+  /*! Remove the stored transform history */
+  void ClearTransformHistory();
+
+  /*! Get the time range of the stored transform history. Fails if no history is stored. */
+  igsioStatus GetTransformHistoryTimeRange(double& startTime, double& endTime) const;
+
+  /*!
+    Get a transform matrix between two coordinate frames at the specified time, using the transform history
+    stored by SetTransformHistory. The repository is not modified.
+    \param aTransformName name of the transform to retrieve from the repository
+    \param timestamp requested time, must be in the time range of the history
+    \param matrixElements the retrieved transform is copied into this row-major array
+    \param toolStatus if this parameter is not NULL then the transforms' status is returned at that memory address
+    \param interpolate if true then the transforms are interpolated between the frames before and after the requested time
+      (spherical linear interpolation of the rotation, linear interpolation of the translation), otherwise the transforms of
+      the frame closest to the requested time are used
+  */
+  igsioStatus GetTransformAtTime(const igsioTransformName& aTransformName, double timestamp, double matrixElements[16], ToolStatus* toolStatus = NULL, bool interpolate = false) const;
+  /*! Get a transform matrix at the specified time. See GetTransformAtTime(const igsioTransformName&, double, double*, ToolStatus*, bool) */
+  igsioStatus GetTransformAtTime(const igsioTransformName& aTransformName, double timestamp, vtkMatrix4x4* matrix, ToolStatus* toolStatus = NULL, bool interpolate = false) const;
+
   /*! Copies the persistent and non-persistent contents if boolean is true, only persistent contents if fase */
   virtual igsioStatus DeepCopy(vtkIGSIOTransformRepository* sourceRepositoryName, bool copyAllTransforms);
 
+  /*! Enable caching of transform paths (enabled by default). Disabling clears the cache. */
+  void SetTransformPathCacheEnabled(bool enabled);
+  bool GetTransformPathCacheEnabled() const;
+  vtkBooleanMacro(TransformPathCacheEnabled, bool);
+
+  /*! Number of transform paths currently stored in the cache */
+  int GetNumberOfCachedTransformPaths() const;
+
 protected:
   vtkIGSIOTransformRepository();
   ~vtkIGSIOTransformRepository();
@@ -171,6 +328,10 @@ protected:
 
     /*! TransformInfo storing the transformation matrix between two coordinate frames */
     vtkTransform* m_Transform;
+    /*! Row-major elements of the transform matrix that are published to readers (only set for original transforms) */
+    double m_OriginalMatrix[16];
+    /*! Index of the original transform in the published snapshots */
+    int m_TransformIndex;
     /*! Describes the state of the tool status */
     ToolStatus m_ToolStatus;
     /*!
@@ -196,10 +357,11 @@ protected:
   typedef std::map<std::string, CoordFrameToTransformMapType> CoordFrameToCoordFrameToTransformMapType;
 
   /*! List of transforms */
-  typedef std::list<TransformInfo*> TransformInfoListType;
+  typedef std::list<const TransformInfo*> TransformInfoListType;
 
   /*! Get a user-defined original input transform (or its inverse). Does not combine user-defined input transforms. */
-  TransformInfo* GetOriginalTransform(const igsioTransformName& aTransformName) const;
+  TransformInfo* GetOriginalTransform(const igsioTransformName& aTransformName);
+  const TransformInfo* GetOriginalTransform(const igsioTransformName& aTransformName) const;
 
   /*!
     Find a transform path between the specified coordinate frames.
@@ -211,7 +373,141 @@ protected:
   */
   igsioStatus FindPath(const igsioTransformName& aTransformName, TransformInfoListType& transformInfoList, const char* skipCoordFrameName = NULL, bool silent = false) const;
 
-  mutable CoordFrameToCoordFrameToTransformMapType CoordinateFrames;
+  /*! Matrix and status of an original transform, as published to readers */
+  struct TransformState
+  {
+    double Matrix[16];
+    ToolStatus Status;
+    bool IsPersistent;
+  };
+
+  /*! Values of an original transform in all frames of a tracked frame list, sorted by time */
+  struct TransformHistory
+  {
+    std::vector<double> Timestamps;
+    /*! 16 values (row-major 4x4 matrix) per frame */
+    std::vector<double> Matrices;
+    std::vector<ToolStatus> Statuses;
+  };
+
+  /*!
+    \struct TransformGraph
+    \brief Coordinate frames and transforms between them. Shared by all snapshots until a transform is added or deleted.
+    The graph is not modified after it is published, except for the path cache, which is filled by the readers.
+    \ingroup PlusLibCommon
+  */
+  struct TransformGraph
+  {
+    /*! Paths for each "from" coordinate frame ID (first) and "to" coordinate frame ID (second) */
+    typedef std::map<std::pair<int, int>, std::shared_ptr<const PathType> > PathMapType;
+
+    TransformGraph() : Version(0), PathCacheEnabled(true), PathCache(std::make_shared<const PathMapType>()) {}
+
+    unsigned long Version;
+    /*! Coordinate frame IDs (second) of the coordinate frame names (first) */
+    std::map<std::string, int> CoordinateFrameIds;
+    /*! Coordinate frame names, indexed by the coordinate frame ID */
+    std::vector<std::string> CoordinateFrameNames;
+    /*!
+      Adjacency arrays of the coordinate frames: the transforms (or their inverse) from coordinate frame i
+      are stored in AdjacentSteps from index AdjacencyOffsets[i] to AdjacencyOffsets[i+1]-1,
+      with the IDs of the coordinate frames they transform to in AdjacentCoordinateFrameIds
+    */
+    std::vector<int> AdjacencyOffsets;
+    std::vector<int> AdjacentCoordinateFrameIds;
+    std::vector<PathStep> AdjacentSteps;
+    /*! Names of the original transforms, indexed by the transform index */
+    std::vector<std::pair<std::string, std::string> > TransformNames;
+    /*! History of the original transforms, indexed by the transform index (NULL for transforms without history) */
+    std::vector<std::shared_ptr<const TransformHistory> > TransformHistories;
+
+    bool PathCacheEnabled;
+    /*!
+      Serializes adding paths to the path cache. Cached paths are looked up without locking: the map is never modified,
+      a path is added by replacing the map with a copy that contains the new path (copies share the paths).
+    */
+    mutable std::mutex PathCacheInsertMutex;
+    /*! Cached paths. Accessed with std::atomic_load and std::atomic_store. */
+    mutable std::shared_ptr<const PathMapType> PathCache;
+  };
+
+  /*! Immutable state of the repository that readers compute the transforms from */
+  struct Snapshot
+  {
+    std::shared_ptr<const TransformGraph> Graph;
+    /*! Original transforms, indexed by the transform index */
+    std::vector<TransformState> Transforms;
+  };
+
+  /*! Get the most recently published snapshot. Does not lock the repository. */
+  std::shared_ptr<const Snapshot> GetSnapshot() const;
+
+  /*!
+    Publish the current transforms to readers. If the topology has changed (a transform was added or deleted)
+    then a new graph is created, which invalidates cached paths and compiled queries.
+    Must be called with the critical section locked. Publishing is deferred while snapshot publishing is suspended.
+  */
+  void PublishSnapshot(bool topologyChanged);
+
+  /*! Defer publishing snapshots (e.g., to publish all transforms of a tracked frame at once). Must be called with the critical section locked. */
+  void SuspendSnapshotPublishing();
+  /*! Publish the changes made since SuspendSnapshotPublishing was called. Must be called with the critical section locked. */
+  void ResumeSnapshotPublishing();
+
+  /*!
+    Get the transform path between the specified coordinate frames of the graph, from the path cache if enabled.
+    \param pathBuffer the path is stored here if it is not cached
+    \return the path or NULL if the path cannot be found
+  */
+  static const PathType* GetGraphPath(const TransformGraph& graph, int fromCoordFrameId, int toCoordFrameId, PathType& pathBuffer);
+  /*! Get the transform path between the specified coordinate frames of the graph. Returns NULL if a coordinate frame is not in the graph. */
+  static const PathType* GetGraphPath(const TransformGraph& graph, const igsioTransformName& aTransformName, PathType& pathBuffer);
+
+  /*! Get the ID of a coordinate frame of the graph. Returns -1 if the coordinate frame is unknown. */
+  static int GetGraphCoordinateFrameId(const TransformGraph& graph, const std::string& coordFrameName);
+
+  /*! Find a transform path in the graph by depth-first search. skipCoordFrameId is the coordinate frame where the search comes from (-1 if none). */
+  static bool FindGraphPath(const TransformGraph& graph, int fromCoordFrameId, int toCoordFrameId, int skipCoordFrameId, PathType& path);
+
+  /*! Multiply the matrices of the path. The status is the worst status of the transforms. */
+  static void ComputeTransform(const Snapshot& snapshot, const PathType& path, double matrixElements[16], ToolStatus& toolStatus);
+
+  /*! Multiply the matrices of the path at the specified time. Transforms that have no history are constant. */
+  static igsioStatus ComputeTransform(const Snapshot& snapshot, const PathType& path, double timestamp, bool interpolate, double matrixElements[16], ToolStatus& toolStatus);
+
+  /*! Get the value of a transform at the specified time from its history. Fails if the time is out of the range of the history. */
+  static igsioStatus GetTransformFromHistory(const TransformHistory& history, double timestamp, bool interpolate, double matrixElements[16], ToolStatus& toolStatus);
+
+  /*! Log the error that the transform path cannot be found, with the list of available transforms */
+  static void LogPathNotFound(const Snapshot& snapshot, const igsioTransformName& aTransformName);
+
+  /*! Resolve the transform path of the query in the snapshot */
+  igsioStatus CompileTransformQueryInternal(const Snapshot& snapshot, const igsioTransformName& aTransformName, TransformQuery& query, bool silent) const;
+
+  /*! Get the ID of a coordinate frame, a new ID is assigned if the coordinate frame has no ID yet. Must be called with the critical section locked. */
+  int InternCoordinateFrame(const std::string& coordFrameName);
+
+  CoordFrameToCoordFrameToTransformMapType CoordinateFrames;
+
+  /*! Coordinate frame IDs (second) of all coordinate frame names (first) that have been in the repository. IDs are never reused. */
+  std::map<std::string, int> CoordinateFrameIds;
+  /*! Names of all coordinate frames that have been in the repository, indexed by the coordinate frame ID */
+  std::vector<std::string> CoordinateFrameNames;
+
+  /*! For each original transform (from and to coordinate frame names) stores its history */
+  std::map<std::pair<std::string, std::string>, std::shared_ptr<const TransformHistory> > TransformHistories;
+
+  bool TransformPathCacheEnabled;
+
+  /*! Incremented whenever a transform is added or deleted. Compiled queries of an older topology are recompiled. */
+  unsigned long TopologyVersion;
+
+  /*! Most recently published snapshot. Accessed with std::atomic_load and std::atomic_store. */
+  std::shared_ptr<const Snapshot> CurrentSnapshot;
+
+  int SnapshotPublishingSuspendCount;
+  bool SnapshotPublishingPending;
+  bool SnapshotTopologyChangePending;
 
   vtkIGSIORecursiveCriticalSection* CriticalSection;
 
@@ -6,6 +6,7 @@ See License.txt for details.
 
 //#include "itksys/SystemTools.hxx"
 #include "vtkIGSIOMetaImageSequenceIO.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <vector>
@@ -60,6 +61,99 @@ namespace
 
   static std::string SEQMETA_FIELD_FRAME_FIELD_PREFIX = "Seq_Frame";
   static std::string SEQMETA_FIELD_IMG_STATUS = "ImageStatus";
+
+  /*!
+    Uncompresses zlib compressed pixel data from a file in chunks, so that neither the compressed
+    nor the uncompressed data of the whole sequence has to be kept in memory.
+  */
+  class PixelDataInflater
+  {
+  public:
+    PixelDataInflater(FILE* stream)
+      : Stream(stream)
+      , RemainingCompressedBytes(0)
+      , Initialized(false)
+    {
+    }
+
+    ~PixelDataInflater()
+    {
+      if (this->Initialized)
+      {
+        inflateEnd(&this->ZStream);
+      }
+    }
+
+    /*! Prepare for reading compressed data from the current position of the file */
+    igsioStatus Initialize(unsigned long long compressedSizeInBytes)
+    {
+      this->RemainingCompressedBytes = compressedSizeInBytes;
+      this->InputBuffer.resize(INFLATE_CHUNK_SIZE);
+      this->ZStream.zalloc = Z_NULL;
+      this->ZStream.zfree = Z_NULL;
+      this->ZStream.opaque = Z_NULL;
+      this->ZStream.next_in = Z_NULL;
+      this->ZStream.avail_in = 0;
+      if (inflateInit(&this->ZStream) != Z_OK)
+      {
+        return IGSIO_FAIL;
+      }
+      this->Initialized = true;
+      return IGSIO_SUCCESS;
+    }
+
+    /*! Uncompress the next numberOfBytes bytes into the buffer */
+    igsioStatus Read(unsigned char* buffer, unsigned int numberOfBytes)
+    {
+      if (!this->Initialized)
+      {
+        return IGSIO_FAIL;
+      }
+      this->ZStream.next_out = reinterpret_cast<Bytef*>(buffer);
+      this->ZStream.avail_out = numberOfBytes;
+      while (this->ZStream.avail_out > 0)
+      {
+        if (this->ZStream.avail_in == 0)
+        {
+          if (this->RemainingCompressedBytes == 0)
+          {
+            LOG_ERROR("Cannot uncompress the pixel data: uncompressed data is less than expected");
+            return IGSIO_FAIL;
+          }
+          size_t chunkSize = static_cast<size_t>(std::min<unsigned long long>(this->RemainingCompressedBytes, this->InputBuffer.size()));
+          if (fread(&(this->InputBuffer[0]), 1, chunkSize, this->Stream) != chunkSize)
+          {
+            LOG_ERROR("Could not read " << chunkSize << " bytes of compressed pixel data");
+            return IGSIO_FAIL;
+          }
+          this->RemainingCompressedBytes -= chunkSize;
+          this->ZStream.next_in = &(this->InputBuffer[0]);
+          this->ZStream.avail_in = static_cast<uInt>(chunkSize);
+        }
+        int ret = inflate(&this->ZStream, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END && this->ZStream.avail_out > 0)
+        {
+          LOG_ERROR("Cannot uncompress the pixel data: uncompressed data is less than expected");
+          return IGSIO_FAIL;
+        }
+        if (ret != Z_OK && ret != Z_STREAM_END)
+        {
+          return IGSIO_FAIL;
+        }
+      }
+      return IGSIO_SUCCESS;
+    }
+
+  protected:
+    /*! Size of compressed data that is read from the file at once */
+    static const size_t INFLATE_CHUNK_SIZE = 1024 * 1024;
+
+    FILE* Stream;
+    unsigned long long RemainingCompressedBytes;
+    std::vector<unsigned char> InputBuffer;
+    z_stream ZStream;
+    bool Initialized;
+  };
 }
 
 //----------------------------------------------------------------------------
@@ -346,6 +440,17 @@ igsioStatus vtkIGSIOMetaImageSequenceIO::ReadImagePixels()
     return IGSIO_SUCCESS;
   }
 
+  igsioVideoFrame::FlipInfoType flipInfo;
+  if (igsioVideoFrame::GetFlipAxes(this->ImageOrientationInFile, this->ImageType, this->ImageOrientationInMemory, flipInfo) != IGSIO_SUCCESS)
+  {
+    LOG_ERROR("Failed to convert image data to the requested orientation, from " << igsioCommon::GetStringFromUsImageOrientation(this->ImageOrientationInFile) <<
+              " to " << igsioCommon::GetStringFromUsImageOrientation(this->ImageOrientationInMemory));
+    return IGSIO_FAIL;
+  }
+  // If no reordering is needed then the pixel data is read (or uncompressed) directly into the frame,
+  // otherwise it is read into an intermediate buffer and then reordered into the frame.
+  const bool isReorderingNeeded = (flipInfo.hFlip || flipInfo.vFlip || flipInfo.eFlip || flipInfo.tranpose != igsioVideoFrame::TRANSPOSE_NONE);
+
   int numberOfErrors = 0;
 
   FILE* stream = NULL;
@@ -356,59 +461,29 @@ igsioStatus vtkIGSIOMetaImageSequenceIO::ReadImagePixels()
     return IGSIO_FAIL;
   }
 
-  std::vector<unsigned char> allFramesPixelBuffer;
+  // Compressed pixel data of all frames is uncompressed frame by frame, while the frames are filled
+  PixelDataInflater inflater(stream);
   if (this->UseCompression)
   {
-    unsigned int allFramesPixelBufferSize = frameCount * frameSizeInBytes;
-
-    try
-    {
-      allFramesPixelBuffer.resize(allFramesPixelBufferSize);
-    }
-    catch (std::bad_alloc& e)
-    {
-      std::cerr << e.what() << endl;
-      LOG_ERROR("vtkIGSIOMetaImageSequenceIO::ReadImagePixels failed due to out of memory. Try to reduce image buffer sizes or use a 64-bit build of Plus.");
-      return IGSIO_FAIL;
-    }
-
     unsigned int allFramesCompressedPixelBufferSize = 0;
     igsioCommon::StringToInt(this->TrackedFrameList->GetCustomString(SEQMETA_FIELD_COMPRESSED_DATA_SIZE), allFramesCompressedPixelBufferSize);
-    std::vector<unsigned char> allFramesCompressedPixelBuffer;
-    allFramesCompressedPixelBuffer.resize(allFramesCompressedPixelBufferSize);
-
     FSEEK(stream, this->PixelDataFileOffset, SEEK_SET);
-    if (fread(&(allFramesCompressedPixelBuffer[0]), 1, allFramesCompressedPixelBufferSize, stream) != allFramesCompressedPixelBufferSize)
-    {
-      LOG_ERROR("Could not read " << allFramesCompressedPixelBufferSize << " bytes from " << GetPixelDataFilePath());
-      fclose(stream);
-      return IGSIO_FAIL;
-    }
-
-    uLongf unCompSize = allFramesPixelBufferSize;
-    if (uncompress((Bytef*) & (allFramesPixelBuffer[0]), &unCompSize, (const Bytef*) & (allFramesCompressedPixelBuffer[0]), allFramesCompressedPixelBufferSize) != Z_OK)
+    if (inflater.Initialize(allFramesCompressedPixelBufferSize) != IGSIO_SUCCESS)
     {
       LOG_ERROR("Cannot uncompress the pixel data");
       fclose(stream);
       return IGSIO_FAIL;
     }
-    if (unCompSize != allFramesPixelBufferSize)
-    {
-      LOG_ERROR("Cannot uncompress the pixel data: uncompressed data is less than expected");
-      fclose(stream);
-      return IGSIO_FAIL;
-    }
-
   }
 
   std::vector<unsigned char> pixelBuffer;
-  pixelBuffer.resize(frameSizeInBytes);
   for (int frameNumber = 0; frameNumber < frameCount; frameNumber++)
   {
     CreateTrackedFrameIfNonExisting(frameNumber);
     igsioTrackedFrame* trackedFrame = this->TrackedFrameList->GetTrackedFrame(frameNumber);
 
     // Allocate frame only if it is valid
+    bool isFrameValid = true;
     std::string imgStatus = trackedFrame->GetFrameField(SEQMETA_FIELD_IMG_STATUS);
     if (!imgStatus.empty())    // Found the image status field
     {
@@ -422,59 +497,75 @@ igsioStatus vtkIGSIOMetaImageSequenceIO::ReadImagePixels()
       if (STRCASECMP(strImgStatus.c_str(), "OK") != 0)     // Image status _not_ OK
       {
         LOG_DEBUG("Frame #" << frameNumber << " image data is invalid, no need to allocate data in the tracked frame list.");
-        continue;
+        isFrameValid = false;
       }
     }
 
-    trackedFrame->GetImageData()->SetImageOrientation(this->ImageOrientationInMemory);
-    trackedFrame->GetImageData()->SetImageType(this->ImageType);
-
     FrameSizeType frameSize = { this->Dimensions[0], this->Dimensions[1], this->Dimensions[2] };
-    if (trackedFrame->GetImageData()->AllocateFrame(frameSize, this->PixelType, this->NumberOfScalarComponents) != IGSIO_SUCCESS)
+    if (isFrameValid)
     {
-      LOG_ERROR("Cannot allocate memory for frame " << frameNumber);
-      numberOfErrors++;
-      continue;
+      trackedFrame->GetImageData()->SetImageOrientation(this->ImageOrientationInMemory);
+      trackedFrame->GetImageData()->SetImageType(this->ImageType);
+
+      if (trackedFrame->GetImageData()->AllocateFrame(frameSize, this->PixelType, this->NumberOfScalarComponents) != IGSIO_SUCCESS)
+      {
+        LOG_ERROR("Cannot allocate memory for frame " << frameNumber);
+        numberOfErrors++;
+        isFrameValid = false;
+      }
     }
 
-    std::array<int, 3> clipRectOrigin = {igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP};
-    std::array<int, 3> clipRectSize = {igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP};
+    if (!isFrameValid && !this->UseCompression)
+    {
+      continue;
+    }
 
-    igsioVideoFrame::FlipInfoType flipInfo;
-    if (igsioVideoFrame::GetFlipAxes(this->ImageOrientationInFile, this->ImageType, this->ImageOrientationInMemory, flipInfo) != IGSIO_SUCCESS)
+    // Get the destination of the pixel data of this frame
+    unsigned char* frameReadBuffer = NULL;
+    if (isFrameValid && !isReorderingNeeded)
     {
-      LOG_ERROR("Failed to convert image data to the requested orientation, from " << igsioCommon::GetStringFromUsImageOrientation(this->ImageOrientationInFile) <<
-                " to " << igsioCommon::GetStringFromUsImageOrientation(this->ImageOrientationInMemory));
-      return IGSIO_FAIL;
+      frameReadBuffer = static_cast<unsigned char*>(trackedFrame->GetImageData()->GetScalarPointer());
+    }
+    else
+    {
+      // Compressed data of invalid frames still has to be uncompressed to get to the next frame
+      pixelBuffer.resize(frameSizeInBytes);
+      frameReadBuffer = &(pixelBuffer[0]);
     }
 
     if (!this->UseCompression)
     {
       FilePositionOffsetType offset = PixelDataFileOffset + frameNumber * frameSizeInBytes;
       FSEEK(stream, offset, SEEK_SET);
-      if (fread(&(pixelBuffer[0]), 1, frameSizeInBytes, stream) != frameSizeInBytes)
+      if (fread(frameReadBuffer, 1, frameSizeInBytes, stream) != frameSizeInBytes)
       {
         LOG_ERROR("Could not read " << frameSizeInBytes << " bytes from " << GetPixelDataFilePath());
         numberOfErrors++;
       }
-      FrameSizeType frameSize = { this->Dimensions[0], this->Dimensions[1], this->Dimensions[2] };
-      if (igsioVideoFrame::GetOrientedClippedImage(&(pixelBuffer[0]), flipInfo, this->ImageType, this->PixelType, this->NumberOfScalarComponents, frameSize, *trackedFrame->GetImageData(), clipRectOrigin, clipRectSize) != IGSIO_SUCCESS)
-      {
-        LOG_ERROR("Failed to get oriented image from sequence metafile (frame number: " << frameNumber << ")!");
-        numberOfErrors++;
-        continue;
-      }
     }
     else
     {
-      FrameSizeType frameSize = { this->Dimensions[0], this->Dimensions[1], this->Dimensions[2] };
-      if (igsioVideoFrame::GetOrientedClippedImage(&(allFramesPixelBuffer[0]) + frameNumber * frameSizeInBytes, flipInfo, this->ImageType, this->PixelType, this->NumberOfScalarComponents, frameSize, *trackedFrame->GetImageData(), clipRectOrigin, clipRectSize) != IGSIO_SUCCESS)
+      if (inflater.Read(frameReadBuffer, frameSizeInBytes) != IGSIO_SUCCESS)
       {
-        LOG_ERROR("Failed to get oriented image from sequence metafile (frame number: " << frameNumber << ")!");
-        numberOfErrors++;
-        continue;
+        LOG_ERROR("Cannot uncompress the pixel data (frame number: " << frameNumber << ")");
+        fclose(stream);
+        return IGSIO_FAIL;
       }
     }
+
+    if (!isFrameValid || !isReorderingNeeded)
+    {
+      continue;
+    }
+
+    std::array<int, 3> clipRectOrigin = {igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP};
+    std::array<int, 3> clipRectSize = {igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP};
+    if (igsioVideoFrame::GetOrientedClippedImage(frameReadBuffer, flipInfo, this->ImageType, this->PixelType, this->NumberOfScalarComponents, frameSize, *trackedFrame->GetImageData(), clipRectOrigin, clipRectSize, true) != IGSIO_SUCCESS)
+    {
+      LOG_ERROR("Failed to get oriented image from sequence metafile (frame number: " << frameNumber << ")!");
+      numberOfErrors++;
+      continue;
+    }
   }
 
   fclose(stream);
@@ -509,17 +509,17 @@ igsioStatus vtkIGSIOMkvSequenceIO::WriteImages()
         }
       }
 
-      igsioFieldMapType customFields = trackedFrame->GetCustomFields();
-      for (igsioFieldMapType::const_iterator customFieldIt = customFields.begin(); customFieldIt != customFields.end(); ++customFieldIt)
+      const igsioFrameFieldContainer& customFields = trackedFrame->GetFrameFieldContainer();
+      for (igsioFrameFieldContainer::const_iterator customFieldIt = customFields.begin(); customFieldIt != customFields.end(); ++customFieldIt)
       {
-        uint64_t trackID = this->Internal->FrameFieldTracks[customFieldIt->first];
+        uint64_t trackID = this->Internal->FrameFieldTracks[customFieldIt->GetName()];
         if (trackID == 0)
         {
-          LOG_ERROR("Could not find metadata track for: " << customFieldIt->first);
+          LOG_ERROR("Could not find metadata track for: " << customFieldIt->GetName());
           continue;
         }
 
-        this->Internal->WriteMetadata(customFieldIt->second.second, trackID, trackedFrame->GetTimestamp() - this->Internal->InitialTimestamp);
+        this->Internal->WriteMetadata(customFieldIt->Value, trackID, trackedFrame->GetTimestamp() - this->Internal->InitialTimestamp);
       }
     }
   }